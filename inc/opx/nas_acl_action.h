@@ -33,6 +33,8 @@
 #include <vector>
 #include <unordered_map>
 
+class nas_acl_mem_account;
+
 using ndi_acl_action_list_t = std::vector<ndi_acl_entry_action_t>;
 
 typedef enum _nas_acl_obj_key_type_t {
@@ -103,11 +105,14 @@ class nas_acl_action_t
         const char* name () const noexcept;
 
         void dbg_dump () const;
+        // Heap held by the action, the action itself is counted by its entry
+        void mem_usage (nas_acl_mem_account& acct) const noexcept;
 
         nas_acl_action_t (BASE_ACL_ACTION_TYPE_t t);
 
         BASE_ACL_ACTION_TYPE_t action_type () const noexcept {return _a_info.action_type;}
-        void set_values_type (ndi_acl_action_values_type_t type) {_a_info.values_type = type;};
+        void set_values_type (ndi_acl_action_values_type_t type)
+            {_a_info.values_type = type; _update_hash ();}
 
         const nas::ifindex_list_t& get_action_if_list () const noexcept;
 
@@ -152,6 +157,10 @@ class nas_acl_action_t
 
         bool operator!= (const nas_acl_action_t& second) const;
 
+        // Hash of the action value, refreshed by every set routine.
+        // Actions with different hashes are never equal.
+        uint64_t content_hash () const noexcept {return _content_hash;}
+
         bool match_opaque_data_by_nexthop_id(ndi_obj_id_t ndi_obj_id);
 
         // If action is related to port, check if it is bound to physical interface
@@ -174,6 +183,7 @@ class nas_acl_action_t
                                     nas::mem_alloc_helper_t& mem_trakr) const;
         bool _ndi_copy_nh_obj_id (ndi_acl_entry_action_t& ndi_action,
                                   npu_id_t npu_id) const;
+        void _update_hash () noexcept;
 
         // Value for In/Out port/port-list Action and
         // Value for Redirect_port action
@@ -202,6 +212,8 @@ class nas_acl_action_t
 
         // Indicate mapping status if Action is port related
         mutable bool _action_port_mapped = false;
+
+        uint64_t _content_hash = 0;
 };
 
 inline const nas::ifindex_list_t&
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_audit.h
+ * \brief  Audit of the NAS ACL object cache against the NPU
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_AUDIT_H_
+#define _NAS_ACL_AUDIT_H_
+
+#include "std_error_codes.h"
+#include "nas_types.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Objects checked per hold of the NAS ACL lock
+#define NAS_ACL_AUDIT_BATCH_SIZE    128
+
+typedef enum {
+    NAS_ACL_AUDIT_REPORT,       // Only report what differs
+    NAS_ACL_AUDIT_REPAIR,       // Also fix entry mismatches the NPU count backs
+} nas_acl_audit_mode_t;
+
+typedef enum {
+    // Read back from the NPU, never repaired
+    NAS_ACL_AUDIT_TABLE_MISSING,    // NPU has no table for the cached NDI id
+    NAS_ACL_AUDIT_TABLE_COUNT,      // NPU holds a different number of entries
+    NAS_ACL_AUDIT_COUNTER_MISSING,  // NPU has no counter for the cached NDI id
+    // Self-consistency of the cache, see nas_acl_audit_run
+    NAS_ACL_AUDIT_ENTRY_MISSING,    // Cache has no NDI id in an NPU the entry is for
+    NAS_ACL_AUDIT_ENTRY_EXTRA,      // Cache has an NDI id in an NPU the entry is not for
+    NAS_ACL_AUDIT_MISMATCH_MAX,
+} nas_acl_audit_mismatch_type_t;
+
+typedef struct _nas_acl_audit_mismatch_t {
+    nas_acl_audit_mismatch_type_t   type;
+    nas_switch_id_t                 switch_id;
+    nas_obj_id_t                    table_id;
+    nas_obj_id_t                    obj_id;     // Entry or counter, table id for tables
+    npu_id_t                        npu_id;
+    uint64_t                        cached;     // Count expected from the cache
+    uint64_t                        npu;        // Count read back from the NPU
+    bool                            repaired;
+} nas_acl_audit_mismatch_t;
+
+typedef struct _nas_acl_audit_info_t {
+    bool        running;
+    uint64_t    runs;
+    uint64_t    tables_checked;     // Of the last run
+    uint64_t    entries_checked;
+    uint64_t    counters_checked;
+    uint64_t    mismatches;
+    uint64_t    repaired;
+    uint64_t    batches;            // Lock holds taken
+    uint64_t    run_time_us;
+    uint64_t    max_batch_us;       // Longest lock hold
+    uint64_t    objs_per_sec;
+} nas_acl_audit_info_t;
+
+const char* nas_acl_audit_mismatch_name (nas_acl_audit_mismatch_type_t type) noexcept;
+
+/*
+ * Walks all tables, their entries and counters in batches of batch_size
+ * objects, taking the NAS ACL lock for one batch at a time. Mismatches
+ * found are appended to the list if one is given. Only one audit runs
+ * at a time.
+ * NDI has no read back of entries. Tables and counters are checked
+ * against the NPU, and so is the entry count of each table. The entry
+ * checks only compare the NDI ids in the cache with the NPUs each entry
+ * should be in. In repair mode an entry mismatch is fixed only in an
+ * NPU where the table entry count the NPU reports agrees with the cache.
+ * If the counts differ, the cache cannot tell whether the NPU holds the
+ * entry, and the mismatch is only reported.
+ */
+t_std_error nas_acl_audit_run (nas_acl_audit_mode_t mode, size_t batch_size,
+                               std::vector<nas_acl_audit_mismatch_t>* mismatches) noexcept;
+
+void nas_acl_audit_info_get (nas_acl_audit_info_t* info) noexcept;
+
+#endif /* _NAS_ACL_AUDIT_H_ */
@@ -28,6 +28,7 @@
 #include "nas_types.h"
 #include "nas_base_utils.h"
 #include "nas_ndi_obj_id_table.h"
+#include <string.h>
 
 #define NAS_ACL_COMMON_DATA_ARR_LEN    128
 
@@ -39,6 +40,7 @@
 /** NAS ACL Error codes */
 #define    NAS_ACL_E_NONE           (int)STD_ERR_OK
 #define    NAS_ACL_E_MEM            (int)STD_ERR (ACL, NOMEM, 0)
+#define    NAS_ACL_E_TABLE_FULL     (int)STD_ERR (ACL, NOMEM, 1) // No room in ACL table for entries
 
 #define    NAS_ACL_E_MISSING_KEY    (int)STD_ERR (ACL, CFG, 1)
 #define    NAS_ACL_E_MISSING_ATTR   (int)STD_ERR (ACL, CFG, 2)
@@ -92,6 +94,32 @@ typedef enum NAS_ACL_DATA_TYPE_t {
 
 inline constexpr nas_switch_id_t NAS_ACL_DEFAULT_SWITCH_ID () { return 0;}
 
+// Mix a value into a running 64-bit content hash
+inline uint64_t nas_acl_hash_combine (uint64_t seed, uint64_t val) noexcept
+{
+    val *= 0x9e3779b97f4a7c15ULL;
+    val ^= (val >> 32);
+    return seed ^ (val + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Mix a raw memory block into a running 64-bit content hash
+inline uint64_t nas_acl_hash_bytes (uint64_t seed, const void* buf, size_t len) noexcept
+{
+    auto p = static_cast<const uint8_t*>(buf);
+    uint64_t word;
+
+    for (; len >= sizeof (word); p += sizeof (word), len -= sizeof (word)) {
+        memcpy (&word, p, sizeof (word));
+        seed = nas_acl_hash_combine (seed, word);
+    }
+    if (len > 0) {
+        word = 0;
+        memcpy (&word, p, len);
+        seed = nas_acl_hash_combine (seed, word);
+    }
+    return seed;
+}
+
 const char* nas_acl_obj_data_type_to_str (NAS_ACL_DATA_TYPE_t obj_data_type);
 const char* nas_acl_filter_type_name (BASE_ACL_MATCH_TYPE_t type) noexcept;
 bool nas_acl_filter_is_type_valid (BASE_ACL_MATCH_TYPE_t f_type) noexcept;
@@ -33,10 +33,24 @@
 
 class nas_acl_switch;
 class nas_acl_table;
+class nas_acl_mem_account;
 
 #ifndef NAS_ACL_COUNTER_H_
 #define NAS_ACL_COUNTER_H_
 
+/*
+ * Read the byte and packet counts of count counters in one request.
+ * It is weak because no NDI library provides it yet - only the unit
+ * test NDI stub defines it. Until NDI does, it is NULL and NAS-ACL
+ * reads counters one at a time, so bulk reads are inactive in a real
+ * system.
+ */
+extern "C" t_std_error ndi_acl_counter_get_count_bulk (npu_id_t npu_id, size_t count,
+                                                       const ndi_obj_id_t* ndi_counter_ids,
+                                                       uint64_t* byte_counts,
+                                                       uint64_t* pkt_counts)
+    __attribute__ ((weak));
+
 class nas_acl_counter_t final : public nas::base_obj_t
 {
 public:
@@ -60,6 +74,10 @@ public:
 
     bool is_pkt_count_enabled() const noexcept {return _enable_pkt_count;}
     bool is_byte_count_enabled() const noexcept {return _enable_byte_count;}
+    // Entries referring to this counter
+    const std::set<nas_obj_id_t>& refs () const noexcept {return _refs;}
+    // Heap held by the counter, the counter itself is counted by its table
+    void mem_usage (nas_acl_mem_account& acct) const noexcept;
 
     //////// Modifiers ////////
     void set_counter_id (nas_obj_id_t id);
@@ -68,6 +86,8 @@ public:
     void add_npu (npu_id_t npu_id, bool reset=true) override;
     void add_ref (nas_obj_id_t entry_id);
     void del_ref (nas_obj_id_t entry_id);
+    // Re-point counter to a different generation of its table
+    void rebind_table (const nas_acl_table* table_p) noexcept {_table_p = table_p;}
 
     void set_pkt_count_ndi (npu_id_t,  uint64_t) const;
     void set_byte_count_ndi (npu_id_t, uint64_t) const;
@@ -143,6 +143,123 @@ cps_api_return_code_t nas_acl_profile_cps_api_rollback (void * context,
                                                         cps_api_transaction_params_t * param,
                                                         size_t index_of_element_being_updated) noexcept;
 
+t_std_error nas_acl_entry_table_sync (cps_api_transaction_params_t *param,
+                                      size_t                        index) noexcept;
+
+// Undo the table sync applied for the prev object of an Entry ACTION
+t_std_error nas_acl_entry_table_sync_rollback (cps_api_object_t prev) noexcept;
+
+// Drop the undo logs of the table syncs once the transaction is over
+void nas_acl_entry_table_sync_done () noexcept;
+
+/* Entry write counters. Elided writes were identical to the cached entry
+ * and completed without any NDI call. Prepared creates were parsed ahead
+ * of the write by nas_acl_entry_batch_prepare */
+typedef struct _nas_acl_write_stats_t {
+    uint64_t    create_count;
+    uint64_t    create_elided;
+    uint64_t    modify_count;
+    uint64_t    modify_elided;
+    uint64_t    create_prepared;
+} nas_acl_write_stats_t;
+
+void nas_acl_entry_write_stats_get (nas_acl_write_stats_t* stats_p) noexcept;
+
+/*
+ * Check that entry_count new entries fit in the table on all its NPUs.
+ * The check is advisory, a passed request can still fail in NDI.
+ * Estimated free entry count is returned in free_p if not NULL.
+ * Called with the NAS ACL lock held.
+ */
+t_std_error nas_acl_table_fit_check (nas_switch_id_t switch_id,
+                                     nas_obj_id_t    table_id,
+                                     size_t          entry_count,
+                                     size_t*         free_p) noexcept;
+
+void nas_acl_table_fit_forget (nas_switch_id_t switch_id, nas_obj_id_t table_id) noexcept;
+
+t_std_error nas_acl_entry_batch_fit_check (cps_api_transaction_params_t *param) noexcept;
+
+/*
+ * Parse the Entry Creates of a large transaction in parallel, without the
+ * NAS ACL lock, before the first object is written. The Create handler
+ * then only applies the parsed filters and actions under the lock. Objects
+ * that could not be parsed up front are parsed by the handler as before,
+ * so are those with interfaces, which are resolved to ports under the lock.
+ */
+void nas_acl_entry_batch_prepare (cps_api_transaction_params_t *param) noexcept;
+
+// Drop what the transaction did not use once it is over or has failed
+void nas_acl_entry_batch_done () noexcept;
+
+/*
+ * Paged GET of Entry, Counter and Stats objects, with the CPS filter
+ * count and get-next flag (cps_api_filter_set_count/set_getnext).
+ * Objects are returned in (Switch Id, Table Id, Entry or Counter Id)
+ * order, at most count of them. The next page is asked for with get-next
+ * set and the keys of the last object returned; it starts right after
+ * that object, in the same or a later table, even if that object was
+ * deleted in between. A page with fewer objects than the count is the
+ * last one.
+ */
+typedef struct _nas_acl_page_t {
+    size_t          limit;          // 0 if the GET is not limited
+    size_t          count;          // Objects added to the response
+    bool            has_cursor;
+    nas_switch_id_t switch_id;
+    nas_obj_id_t    table_id;
+    nas_obj_id_t    obj_id;
+} nas_acl_page_t;
+
+// Count of the GET filter. Returns true if the filter asks for get-next,
+// the caller then sets the cursor from the filter keys.
+bool nas_acl_page_filter (cps_api_object_t filter_obj, nas_acl_page_t* page_p) noexcept;
+
+inline void nas_acl_page_cursor_set (nas_acl_page_t& page, nas_switch_id_t switch_id,
+                                     nas_obj_id_t table_id, nas_obj_id_t obj_id) noexcept
+{
+    page.has_cursor = true;
+    page.switch_id = switch_id;
+    page.table_id = table_id;
+    page.obj_id = obj_id;
+}
+
+inline bool nas_acl_page_full (const nas_acl_page_t& page) noexcept
+{
+    return (page.limit != 0 && page.count >= page.limit);
+}
+
+// First table of a switch that goes in the page
+template <typename list_t>
+typename list_t::const_iterator
+nas_acl_page_first_table (const list_t& tables, const nas_acl_page_t& page,
+                          nas_switch_id_t switch_id) noexcept
+{
+    if (!page.has_cursor || switch_id > page.switch_id) {
+        return tables.begin ();
+    }
+    if (switch_id < page.switch_id) {
+        return tables.end ();
+    }
+    return tables.lower_bound (page.table_id);
+}
+
+// First object of a table's Entry or Counter list that goes in the page
+template <typename list_t>
+typename list_t::const_iterator
+nas_acl_page_first (const list_t& list, const nas_acl_page_t& page,
+                    nas_switch_id_t switch_id, nas_obj_id_t table_id) noexcept
+{
+    if (!page.has_cursor || switch_id > page.switch_id ||
+        (switch_id == page.switch_id && table_id > page.table_id)) {
+        return list.begin ();
+    }
+    if (switch_id < page.switch_id || table_id < page.table_id) {
+        return list.end ();
+    }
+    return list.upper_bound (page.obj_id);
+}
+
 cps_api_object_attr_t nas_acl_get_attr (const cps_api_object_it_t& it,
                                         cps_api_attr_id_t attr_id, bool* is_dupl) noexcept;
 
@@ -166,7 +283,8 @@ t_std_error           nas_acl_get_counter (cps_api_get_params_t *param, size_t i
 
 t_std_error           nas_acl_stats_info_get (cps_api_get_params_t *param,
                                               size_t                index,
-                                              const nas_acl_counter_t&  counter) noexcept;
+                                              const nas_acl_counter_t&  counter,
+                                              uint32_t              max_age_ms) noexcept;
 
 t_std_error           nas_acl_pool_info_get (cps_api_get_params_t *param,
                                              size_t index,
@@ -207,6 +325,21 @@ void nas_acl_set_match_attr (const cps_api_object_t     obj,
                              nas::attr_list_t           parent_attr_id_list,
                              bool                       reset);
 
+/*
+ * Parse the Match list or Actions of an Entry object without touching the
+ * Entry or the switch cache. A null table is enough for all but UDF
+ * filters, which need the table UDF groups.
+ */
+void nas_acl_parse_match_list (const cps_api_object_t         obj,
+                               const cps_api_object_it_t&     it,
+                               const nas_acl_table*           table_p,
+                               std::vector<nas_acl_filter_t>& filters);
+
+nas_acl_filter_t nas_acl_parse_match_attr (const cps_api_object_t     obj,
+                                           const nas_acl_table*       table_p,
+                                           BASE_ACL_MATCH_TYPE_t      match_type_val,
+                                           nas::attr_list_t           parent_attr_id_list);
+
 bool
 nas_acl_fill_match_attr_list (cps_api_object_t obj, const nas_acl_entry& entry);
 
@@ -230,6 +363,14 @@ void nas_acl_set_action_attr (const cps_api_object_t     obj,
                               nas::attr_list_t&          parent_attr_id_list,
                               bool                       reset);
 
+void nas_acl_parse_action_list (const cps_api_object_t         obj,
+                                const cps_api_object_it_t&     it,
+                                std::vector<nas_acl_action_t>& actions);
+
+nas_acl_action_t nas_acl_parse_action_attr (const cps_api_object_t     obj,
+                                            BASE_ACL_ACTION_TYPE_t     action_type_val,
+                                            nas::attr_list_t&          parent_attr_id_list);
+
 bool
 nas_acl_fill_action_attr_list (cps_api_object_t obj, const nas_acl_entry& entry);
 
@@ -247,10 +388,55 @@ nas_acl_copy_data_from_obj (cps_api_object_t                obj,
                             const nas_acl_map_data_list_t&  child_list,
                             const std::string&              name);
 
-int nas_acl_lock () noexcept;
+/*
+ * Staged table reload under a stable table ID.
+ * Shadow create clones the table and returns the ID of the clone, which is
+ * then populated with entries and counters through the regular CPS objects.
+ * The shadow is a second NPU table at the same stage and priority. Its
+ * entries are kept in cache only and match no traffic while it is filled.
+ * Commit installs them, moves the original table ID to the shadow content
+ * and deletes the old content before it returns, releasing the NAS ACL
+ * lock between batches. From the install to the end of that teardown both
+ * generations are in hardware, so the switch is not atomic. If the install
+ * fails the shadow stays staged and can be committed again or aborted.
+ * Abort deletes the shadow table the same way. If the teardown keeps
+ * failing, the error is returned and what is left of the old content
+ * stays a shadow of the table, to be deleted by an abort.
+ */
+t_std_error nas_acl_table_shadow_create (nas_switch_id_t switch_id,
+                                         nas_obj_id_t    table_id,
+                                         nas_obj_id_t*   shadow_id_p) noexcept;
+
+t_std_error nas_acl_table_shadow_commit (nas_switch_id_t switch_id,
+                                         nas_obj_id_t    shadow_id) noexcept;
+
+t_std_error nas_acl_table_shadow_abort (nas_switch_id_t switch_id,
+                                        nas_obj_id_t    shadow_id) noexcept;
+
+// Site defaults to the calling function, for lock contention accounting
+int nas_acl_lock (const char* site = __builtin_FUNCTION ()) noexcept;
 
 int nas_acl_unlock () noexcept;
 
+// Interface event handler, registered with CPS at init
+bool nas_acl_if_set_handler (cps_api_object_t obj, void *context);
+
+// Port mapping change of an interface, as the event handler applies it.
+// Takes the NAS ACL lock.
+void nas_acl_if_mapping_notify (uint32_t ifidx, npu_id_t npu_id, npu_port_t npu_port);
+
+// Per pipeline used and available entry counts of a table in one NPU
+bool nas_acl_read_table_usage (npu_id_t npu_id, nas_obj_id_t acl_table_id,
+                               nas_acl_switch& s, ndi_acl_table_attr_t& table_attr,
+                               std::vector<uint32_t>& acl_table_used_entry_count,
+                               std::vector<uint32_t>& acl_table_avail_entry_count);
+
+// Same, for an NDI table that need not be in the cache
+bool nas_acl_read_ndi_table_usage (npu_id_t npu_id, ndi_obj_id_t ndi_acl_table_id,
+                                   ndi_acl_table_attr_t& table_attr,
+                                   std::vector<uint32_t>& acl_table_used_entry_count,
+                                   std::vector<uint32_t>& acl_table_avail_entry_count);
+
 t_std_error           nas_udf_get_group (cps_api_get_params_t *param, size_t index,
                                          cps_api_object_t filter_obj) noexcept;
 
@@ -37,6 +37,7 @@
 
 class nas_acl_switch;
 class nas_acl_table;
+class nas_acl_mem_account;
 
 typedef struct _nas_acl_filter_key_t
 {
@@ -122,8 +123,18 @@ class nas_acl_entry final : public nas::base_obj_t
         bool get_range_list(std::vector<nas_acl_range*>& range_list) const;
 
         bool is_npu_set (npu_id_t npu_id) const noexcept;
+        // True if priority, filters, actions and NPUs are all the same
+        bool is_same_rule (const nas_acl_entry& other) const noexcept;
+        bool is_same_filter_list (const nas_acl_entry& other) const noexcept;
+        bool is_same_action_list (const nas_acl_entry& other) const noexcept;
+        bool is_same_npu_list (const nas_acl_entry& other) const noexcept;
+        // Content fingerprint over priority, filters, actions and NPUs.
+        // Equal entries have equal fingerprints, but not the other way round.
+        uint64_t fingerprint () const noexcept;
         bool following_table_npus  () const noexcept {return _following_table_npus;}
         void dbg_dump () const;
+        // Heap held by the entry and its filters and actions
+        void mem_usage (nas_acl_mem_account& acct) const noexcept;
 
         //////// Modifiers ////////
         void set_entry_id (nas_obj_id_t id);
@@ -136,6 +147,8 @@ class nas_acl_entry final : public nas::base_obj_t
         void reset_filter ();
         void reset_action ();
         void copy_table_npus ();
+        // Re-point entry and its filters to a different generation of its table
+        void rebind_table (const nas_acl_table* table_p) noexcept;
 
         /// Overriding base object virtual functions
         const nas::npu_set_t&         npu_list () const override;
@@ -152,6 +165,7 @@ class nas_acl_entry final : public nas::base_obj_t
         void commit_create (bool rolling_back) override;
         nas::attr_set_t commit_modify (base_obj_t& entry_orig,
                                        bool rolling_back) override;
+        void commit_delete (bool rolling_back) override;
 
         bool push_create_obj_to_npu (npu_id_t npu_id, void* ndi_obj) override;
 
@@ -222,6 +236,15 @@ class nas_acl_entry final : public nas::base_obj_t
         nas_obj_id_t                 _counter_id = 0;
         bool                         _enable_counter = false;
 
+        // Cached fingerprint and content hashes, recomputed on demand
+        mutable uint64_t             _filter_hash = 0;
+        mutable uint64_t             _action_hash = 0;
+        mutable uint64_t             _fingerprint = 0;
+        mutable bool                 _hash_valid = false;
+
+        void _invalidate_hash () noexcept {_hash_valid = false;}
+        void _compute_hash () const noexcept;
+
         void _validate_counter_npus () const;
         bool _copy_all_filters_ndi (ndi_acl_entry_t &ndi_acl_entry,
                                     npu_id_t npu_id,
@@ -273,12 +296,6 @@ nas_acl_entry::get_action_from_itr (action_iter_t itr_old) noexcept
     return itr_old->second;
 }
 
-inline void nas_acl_entry::set_entry_id (nas_obj_id_t id)
-{
-    STD_ASSERT (_entry_id == 0); // Something wrong .. Entry already has a ID
-    _entry_id = id;
-}
-
 inline nas_obj_id_t nas_acl_entry::counter_id () const noexcept
 {
     auto it = _alist.find(BASE_ACL_ACTION_TYPE_SET_COUNTER);
@@ -33,6 +33,8 @@
 #include <vector>
 #include <unordered_map>
 
+class nas_acl_mem_account;
+
 class nas_acl_filter_t
 {
     public:
@@ -55,6 +57,8 @@ class nas_acl_filter_t
 
         const char* name () const noexcept;
         void dbg_dump () const;
+        // Heap held by the filter, the filter itself is counted by its entry
+        void mem_usage (nas_acl_mem_account& acct) const noexcept;
 
         nas_acl_filter_t (const nas_acl_table* table, BASE_ACL_MATCH_TYPE_t t);
 
@@ -106,6 +110,13 @@ class nas_acl_filter_t
 
         bool operator!= (const nas_acl_filter_t& second) const noexcept;
 
+        // Hash of the filter value, refreshed by every set routine.
+        // Filters with different hashes are never equal.
+        uint64_t content_hash () const noexcept {return _content_hash;}
+
+        // Re-point filter to a different generation of its table
+        void rebind_table (const nas_acl_table* table_p) noexcept {_table_p = table_p;}
+
         const std::vector<nas_obj_id_t>& range_id_list() const noexcept {return _range_oid_list;}
         bool is_range() const noexcept
             {return filter_type() == BASE_ACL_MATCH_TYPE_RANGE_CHECK;}
@@ -124,6 +135,7 @@ class nas_acl_filter_t
     private:
         bool _ndi_copy_one_obj_id(ndi_acl_entry_filter_t* ndi_filter_p,
                                   npu_id_t npu_id) const;
+        void _update_hash () noexcept;
         // Estimated number of ports in a filter of type In ports or Out ports
         static constexpr size_t port_count_estm = 5;
 
@@ -148,6 +160,8 @@ class nas_acl_filter_t
 
         // For port type filter, indicate if matching port is mapped
         mutable bool _match_port_mapped = false;
+
+        uint64_t _content_hash = 0;
 };
 
 inline const nas::ifindex_list_t&
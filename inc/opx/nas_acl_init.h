@@ -34,6 +34,14 @@ extern "C" {
  */
 t_std_error nas_acl_init(void);
 
+/**
+ * Stops the stats poller and saves the warm restart snapshot. It joins
+ * threads and takes the NAS ACL lock, so the NAS daemon calls it from its
+ * own shutdown path once a stop was requested - never from a signal
+ * handler or at process exit.
+ */
+void nas_acl_deinit(void);
+
 
 #ifdef __cplusplus
 }
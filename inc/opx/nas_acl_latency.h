@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_latency.h
+ * \brief  Latency histograms of NAS ACL CPS handlers and NDI calls
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_LATENCY_H_
+#define _NAS_ACL_LATENCY_H_
+
+#include "nas_acl_trace.h"
+#include <stdint.h>
+#include <chrono>
+#include <utility>
+
+typedef enum {
+    // CPS handlers, timed from the handler entry including the lock wait
+    NAS_ACL_LAT_TABLE_CREATE,
+    NAS_ACL_LAT_TABLE_MODIFY,
+    NAS_ACL_LAT_TABLE_DELETE,
+    NAS_ACL_LAT_TABLE_GET,
+    NAS_ACL_LAT_ENTRY_CREATE,
+    NAS_ACL_LAT_ENTRY_MODIFY,
+    NAS_ACL_LAT_ENTRY_DELETE,
+    NAS_ACL_LAT_ENTRY_GET,
+    NAS_ACL_LAT_ENTRY_SYNC,
+    NAS_ACL_LAT_COUNTER_CREATE,
+    NAS_ACL_LAT_COUNTER_MODIFY,
+    NAS_ACL_LAT_COUNTER_DELETE,
+    NAS_ACL_LAT_COUNTER_GET,
+    NAS_ACL_LAT_STATS_SET,
+    NAS_ACL_LAT_STATS_GET,
+    NAS_ACL_LAT_INTF_EVENT,
+
+    // NDI calls
+    NAS_ACL_LAT_NDI_TABLE_CREATE,
+    NAS_ACL_LAT_NDI_TABLE_DELETE,
+    NAS_ACL_LAT_NDI_TABLE_SET_PRIORITY,
+    NAS_ACL_LAT_NDI_ENTRY_CREATE,
+    NAS_ACL_LAT_NDI_ENTRY_DELETE,
+    NAS_ACL_LAT_NDI_ENTRY_SET_PRIORITY,
+    NAS_ACL_LAT_NDI_ENTRY_SET_FILTER,
+    NAS_ACL_LAT_NDI_ENTRY_DISABLE_FILTER,
+    NAS_ACL_LAT_NDI_ENTRY_SET_ACTION,
+    NAS_ACL_LAT_NDI_ENTRY_DISABLE_ACTION,
+    NAS_ACL_LAT_NDI_COUNTER_CREATE,
+    NAS_ACL_LAT_NDI_COUNTER_DELETE,
+    NAS_ACL_LAT_NDI_COUNTER_GET,
+    NAS_ACL_LAT_NDI_COUNTER_GET_BULK,
+    NAS_ACL_LAT_NDI_COUNTER_SET,
+    NAS_ACL_LAT_NDI_RANGE_CREATE,
+    NAS_ACL_LAT_NDI_RANGE_DELETE,
+
+    NAS_ACL_LAT_OP_MAX,
+} nas_acl_lat_op_t;
+
+/*
+ * Bucket 0 holds calls under 1 usec, bucket i those from 2^(i-1)
+ * up to 2^i usec. The last bucket takes everything above.
+ */
+#define NAS_ACL_LAT_BUCKETS  32
+
+typedef struct _nas_acl_lat_summary_t {
+    uint64_t    count;
+    uint64_t    sum_us;
+    uint64_t    max_us;
+    uint64_t    p50_us;     // Upper bound of the bucket of the percentile
+    uint64_t    p90_us;
+    uint64_t    p99_us;
+} nas_acl_lat_summary_t;
+
+const char* nas_acl_lat_op_name (nas_acl_lat_op_t op) noexcept;
+
+// Lock free, the histograms are per thread and merged when read
+void nas_acl_lat_record (nas_acl_lat_op_t op, uint64_t elapsed_ns) noexcept;
+
+// Histogram of the op summed over all threads, buckets_p is optional
+void nas_acl_lat_get (nas_acl_lat_op_t op, nas_acl_lat_summary_t* summary_p,
+                      uint64_t* buckets_p = nullptr) noexcept;
+
+// Records the time from its construction to its destruction
+class nas_acl_lat_scope
+{
+public:
+    explicit nas_acl_lat_scope (nas_acl_lat_op_t op) noexcept
+        : _op (op), _start (std::chrono::steady_clock::now ()) {}
+
+    ~nas_acl_lat_scope ()
+    {
+        if (_op >= NAS_ACL_LAT_OP_MAX) return;
+
+        uint64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+                                std::chrono::steady_clock::now () - _start).count ();
+        nas_acl_lat_record (_op, elapsed_ns);
+
+        if (nas_acl_trace_enabled ()) {
+            uint64_t start_ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+                                    _start.time_since_epoch ()).count ();
+            nas_acl_trace_record (nas_acl_lat_op_name (_op), start_ns, elapsed_ns, 0);
+        }
+    }
+
+    // Operation becomes known only after the scope started
+    void set_op (nas_acl_lat_op_t op) noexcept {_op = op;}
+
+private:
+    nas_acl_lat_op_t                       _op;
+    std::chrono::steady_clock::time_point  _start;
+};
+
+// Time one NDI call: nas_acl_lat_call (op, ndi_fn, args...)
+template <typename F, typename... Args>
+inline auto nas_acl_lat_call (nas_acl_lat_op_t op, F fn, Args&&... args)
+    -> decltype (fn (std::forward<Args> (args)...))
+{
+    nas_acl_lat_scope lat (op);
+    return fn (std::forward<Args> (args)...);
+}
+
+#endif /* _NAS_ACL_LATENCY_H_ */
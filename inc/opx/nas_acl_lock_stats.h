@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_lock_stats.h
+ * \brief  Wait and hold time accounting of the NAS ACL locks
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_LOCK_STATS_H_
+#define _NAS_ACL_LOCK_STATS_H_
+
+#include <stdint.h>
+#include <vector>
+
+typedef enum {
+    NAS_ACL_LOCK_ACL,           // nas_acl_lock ()
+    NAS_ACL_LOCK_INTF_BIND,     // Interface bind mutex
+    NAS_ACL_LOCK_MAX,
+} nas_acl_lock_id_t;
+
+#define NAS_ACL_LOCK_LONG_HOLD_US   1000    // Holds at least this long go to the ring
+#define NAS_ACL_LOCK_RING_SIZE      64
+
+// One acquisition of a lock, times are CLOCK_MONOTONIC nanoseconds
+typedef struct _nas_acl_lock_hold_t {
+    nas_acl_lock_id_t   lock;
+    const char*         site;           // Function that took the lock
+    uint64_t            start_ns;       // Lock requested
+    uint64_t            acquired_ns;
+    uint64_t            released_ns;
+} nas_acl_lock_hold_t;
+
+typedef struct _nas_acl_lock_site_stats_t {
+    nas_acl_lock_id_t   lock;
+    const char*         site;
+    uint64_t            count;
+    uint64_t            wait_ns;        // Total over all acquisitions
+    uint64_t            wait_max_ns;
+    uint64_t            hold_ns;
+    uint64_t            hold_max_ns;
+} nas_acl_lock_site_stats_t;
+
+const char* nas_acl_lock_name (nas_acl_lock_id_t lock) noexcept;
+
+/*
+ * Hooks of the lock functions. Acquired and releasing are called with the
+ * lock held, record after it was released. Recursive locks call them only
+ * for the outermost acquisition. Start time is 0 while accounting is off.
+ */
+uint64_t nas_acl_lock_stats_start (void) noexcept;
+void nas_acl_lock_stats_acquired (nas_acl_lock_id_t lock, const char* site,
+                                  uint64_t start_ns) noexcept;
+nas_acl_lock_hold_t nas_acl_lock_stats_releasing (nas_acl_lock_id_t lock) noexcept;
+void nas_acl_lock_stats_record (const nas_acl_lock_hold_t& hold) noexcept;
+
+// Accounting is on by default
+void nas_acl_lock_stats_enable (bool enable) noexcept;
+void nas_acl_lock_stats_clear (void) noexcept;
+
+// Per lock and call site, ordered by total hold time
+void nas_acl_lock_stats_get (std::vector<nas_acl_lock_site_stats_t>& stats) noexcept;
+
+// Recent holds of at least NAS_ACL_LOCK_LONG_HOLD_US, oldest first
+void nas_acl_lock_long_holds_get (std::vector<nas_acl_lock_hold_t>& holds) noexcept;
+
+#endif /* _NAS_ACL_LOCK_STATS_H_ */
@@ -26,23 +26,145 @@
 
 #include "event_log_types.h"
 #include "event_log.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <atomic>
+#include <chrono>
+#endif
+
+/*
+ * Log levels by verbosity. Levels above NAS_ACL_LOG_MAX_LEVEL are compiled
+ * out, e.g. -DNAS_ACL_LOG_MAX_LEVEL=NAS_ACL_LOG_LVL_BRIEF drops the detail
+ * logs. Levels above the runtime level are skipped with one relaxed load.
+ * Either way the log arguments are not evaluated.
+ */
+#define NAS_ACL_LOG_LVL_ERR         1
+#define NAS_ACL_LOG_LVL_WARNING     2
+#define NAS_ACL_LOG_LVL_NOTICE      3
+#define NAS_ACL_LOG_LVL_BRIEF       4
+#define NAS_ACL_LOG_LVL_DETAIL      5
+
+#ifndef NAS_ACL_LOG_MAX_LEVEL
+#define NAS_ACL_LOG_MAX_LEVEL       NAS_ACL_LOG_LVL_DETAIL
+#endif
+
+// Repeats of a rate limited log allowed per interval, per call site
+#define NAS_ACL_LOG_RL_INTERVAL_MS  5000
+#define NAS_ACL_LOG_RL_BURST        10
+
+#ifdef __cplusplus
+
+extern std::atomic<int> g_nas_acl_log_level;
+
+// Runtime level, everything up to NAS_ACL_LOG_MAX_LEVEL is on by default.
+// Levels below NAS_ACL_LOG_LVL_ERR are taken as ERR.
+void nas_acl_log_level_set (int level) noexcept;
+
+// True if logs of the level are emitted, to guard work done only for a log
+#define NAS_ACL_LOG_ENABLED(lvl) \
+        (NAS_ACL_LOG_LVL_##lvl <= NAS_ACL_LOG_MAX_LEVEL && \
+         NAS_ACL_LOG_LVL_##lvl <= g_nas_acl_log_level.load (std::memory_order_relaxed))
+
+#else
+
+// C users get the compile time level only
+#define NAS_ACL_LOG_ENABLED(lvl) \
+        (NAS_ACL_LOG_LVL_##lvl <= NAS_ACL_LOG_MAX_LEVEL)
+
+#endif
+
+#define NAS_ACL_LOG_AT(lvl, ev_lvl, vararg...) \
+        do { \
+            if (NAS_ACL_LOG_ENABLED (lvl)) { \
+                EV_LOGGING (ACL, ev_lvl, "NAS-ACL", ## vararg); \
+            } \
+        } while (0)
 
 #define NAS_ACL_LOG_BRIEF(vararg...) \
-        EV_LOGGING (ACL, INFO, "NAS-ACL", ## vararg)
+        NAS_ACL_LOG_AT (BRIEF, INFO, ## vararg)
 
 #define NAS_ACL_LOG_DETAIL(vararg...) \
-        EV_LOGGING (ACL, DEBUG, "NAS-ACL", ## vararg)
+        NAS_ACL_LOG_AT (DETAIL, DEBUG, ## vararg)
 
 #define NAS_ACL_LOG_NOTICE(vararg...) \
-        EV_LOGGING (ACL, NOTICE, "NAS-ACL", ## vararg)
+        NAS_ACL_LOG_AT (NOTICE, NOTICE, ## vararg)
 
 #define NAS_ACL_LOG_WARNING(vararg...) \
-        EV_LOGGING (ACL, WARNING, "NAS-ACL", ## vararg)
+        NAS_ACL_LOG_AT (WARNING, WARNING, ## vararg)
 
 #define NAS_ACL_LOG_ERR(vararg...) \
-        EV_LOGGING (ACL, ERR, "NAS-ACL", ## vararg)
+        NAS_ACL_LOG_AT (ERR, ERR, ## vararg)
 
+// Output of debug dump routines, never filtered
 #define NAS_ACL_LOG_DUMP(vararg...) \
         EV_LOGGING (ACL, DEBUG, "NAS-ACL", ## vararg)
 
+#ifdef __cplusplus
+
+// State of one rate limited call site
+struct nas_acl_log_rl_t {
+    std::atomic<uint64_t>  window_ms {0};
+    std::atomic<uint32_t>  count {0};
+    std::atomic<uint32_t>  suppressed {0};
+};
+
+/*
+ * True if the call site may log now. Suppressed is set to the number of
+ * logs dropped since the last one that passed. Races between threads at
+ * the window boundary can let a few extra logs through.
+ */
+inline bool nas_acl_log_rl_pass (nas_acl_log_rl_t& rl, uint32_t& suppressed) noexcept
+{
+    uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds> (
+                        std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+    uint64_t window_ms = rl.window_ms.load (std::memory_order_relaxed);
+
+    if (now_ms - window_ms >= NAS_ACL_LOG_RL_INTERVAL_MS &&
+        rl.window_ms.compare_exchange_strong (window_ms, now_ms,
+                                              std::memory_order_relaxed)) {
+        rl.count.store (0, std::memory_order_relaxed);
+    }
+
+    if (rl.count.fetch_add (1, std::memory_order_relaxed) >= NAS_ACL_LOG_RL_BURST) {
+        rl.suppressed.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    suppressed = rl.suppressed.exchange (0, std::memory_order_relaxed);
+    return true;
+}
+
+// For logs in per-object loops or repeated failure paths
+#define NAS_ACL_LOG_AT_RL(lvl, ev_lvl, vararg...) \
+        do { \
+            static nas_acl_log_rl_t _nas_acl_log_rl; \
+            uint32_t _nas_acl_log_suppressed = 0; \
+            if (NAS_ACL_LOG_ENABLED (lvl) && \
+                nas_acl_log_rl_pass (_nas_acl_log_rl, _nas_acl_log_suppressed)) { \
+                if (_nas_acl_log_suppressed > 0) { \
+                    EV_LOGGING (ACL, ev_lvl, "NAS-ACL", "%u similar logs suppressed", \
+                                _nas_acl_log_suppressed); \
+                } \
+                EV_LOGGING (ACL, ev_lvl, "NAS-ACL", ## vararg); \
+            } \
+        } while (0)
+
+#define NAS_ACL_LOG_BRIEF_RL(vararg...) \
+        NAS_ACL_LOG_AT_RL (BRIEF, INFO, ## vararg)
+
+#define NAS_ACL_LOG_DETAIL_RL(vararg...) \
+        NAS_ACL_LOG_AT_RL (DETAIL, DEBUG, ## vararg)
+
+#define NAS_ACL_LOG_ERR_RL(vararg...) \
+        NAS_ACL_LOG_AT_RL (ERR, ERR, ## vararg)
+
+#else
+
+#define NAS_ACL_LOG_BRIEF_RL    NAS_ACL_LOG_BRIEF
+#define NAS_ACL_LOG_DETAIL_RL   NAS_ACL_LOG_DETAIL
+#define NAS_ACL_LOG_ERR_RL      NAS_ACL_LOG_ERR
+
+#endif /* __cplusplus */
+
 #endif /* _NAS_ACL_LOG_H_ */
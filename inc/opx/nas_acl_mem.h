@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_mem.h
+ * \brief  Memory footprint of the NAS ACL object caches
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_MEM_H_
+#define _NAS_ACL_MEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <set>
+#include <map>
+#include <unordered_map>
+
+typedef enum {
+    NAS_ACL_MEM_TABLE,
+    NAS_ACL_MEM_ENTRY,          // Entry itself, without its filters and actions
+    NAS_ACL_MEM_FILTER,
+    NAS_ACL_MEM_ACTION,
+    NAS_ACL_MEM_PORT_LIST,      // Interface and NPU port lists of filters and actions
+    NAS_ACL_MEM_COUNTER,
+    NAS_ACL_MEM_INTF_BIND,
+    NAS_ACL_MEM_PBR_CACHE,
+    NAS_ACL_MEM_UDF,            // UDF groups, matches and UDFs
+    NAS_ACL_MEM_TYPE_MAX,
+} nas_acl_mem_type_t;
+
+typedef struct _nas_acl_mem_usage_t {
+    uint64_t    objs;
+    uint64_t    bytes;
+    uint64_t    allocs;     // Heap blocks the bytes are spread over
+} nas_acl_mem_usage_t;
+
+/*
+ * Bytes are estimated from the size of the objects and the node layout
+ * of the libstdc++ containers holding them. Allocator overhead per block
+ * is not included, it can be derived from the allocation count.
+ */
+class nas_acl_mem_account
+{
+    public:
+        static constexpr size_t TREE_NODE_BYTES = 4 * sizeof (void*);  // Color and links
+        static constexpr size_t LIST_NODE_BYTES = 2 * sizeof (void*);
+        static constexpr size_t HASH_NODE_BYTES = sizeof (void*) + sizeof (size_t);
+        static constexpr size_t STRING_SSO_LEN  = 15;
+
+        void add_obj (nas_acl_mem_type_t type, size_t count = 1) noexcept
+        {_usage[type].objs += count;}
+
+        void add_bytes (nas_acl_mem_type_t type, size_t bytes, size_t allocs = 1) noexcept
+        {
+            _usage[type].bytes += bytes;
+            _usage[type].allocs += allocs;
+        }
+
+        void add (nas_acl_mem_type_t type, const std::string& s) noexcept
+        {
+            if (s.capacity () > STRING_SSO_LEN) add_bytes (type, s.capacity () + 1);
+        }
+
+        template <typename T, typename A>
+        void add (nas_acl_mem_type_t type, const std::vector<T, A>& v) noexcept
+        {
+            if (v.capacity () > 0) add_bytes (type, v.capacity () * sizeof (T));
+        }
+
+        template <typename T, typename A>
+        void add (nas_acl_mem_type_t type, const std::list<T, A>& l) noexcept
+        {
+            add_bytes (type, l.size () * (LIST_NODE_BYTES + sizeof (T)), l.size ());
+        }
+
+        template <typename K, typename C, typename A>
+        void add (nas_acl_mem_type_t type, const std::set<K, C, A>& s) noexcept
+        {
+            add_bytes (type, s.size () * (TREE_NODE_BYTES + sizeof (K)), s.size ());
+        }
+
+        template <typename K, typename V, typename C, typename A>
+        void add (nas_acl_mem_type_t type, const std::map<K, V, C, A>& m) noexcept
+        {
+            using value_t = typename std::map<K, V, C, A>::value_type;
+            add_bytes (type, m.size () * (TREE_NODE_BYTES + sizeof (value_t)), m.size ());
+        }
+
+        // Values are counted in place, not what they hold on the heap
+        template <typename K, typename V, typename H, typename E, typename A>
+        void add (nas_acl_mem_type_t type, const std::unordered_map<K, V, H, E, A>& m) noexcept
+        {
+            using value_t = typename std::unordered_map<K, V, H, E, A>::value_type;
+            add_bytes (type, m.size () * (HASH_NODE_BYTES + sizeof (value_t)), m.size ());
+            // Single bucket is embedded in the container
+            if (m.bucket_count () > 1) {
+                add_bytes (type, m.bucket_count () * sizeof (void*));
+            }
+        }
+
+        const nas_acl_mem_usage_t& usage (nas_acl_mem_type_t type) const noexcept
+        {return _usage[type];}
+
+    private:
+        nas_acl_mem_usage_t  _usage[NAS_ACL_MEM_TYPE_MAX] {};
+};
+
+const char* nas_acl_mem_type_name (nas_acl_mem_type_t type) noexcept;
+
+// Walks the caches of all switches, takes the NAS ACL lock
+void nas_acl_mem_usage_get (nas_acl_mem_usage_t usage[NAS_ACL_MEM_TYPE_MAX]) noexcept;
+
+#endif /* _NAS_ACL_MEM_H_ */
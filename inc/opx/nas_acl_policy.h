@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_policy.h
+ * \brief  Binary ACL policy files and their bulk loader
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_POLICY_H_
+#define _NAS_ACL_POLICY_H_
+
+#include "std_error_codes.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Objects created per transaction by the loader
+#define NAS_ACL_POLICY_BATCH_SIZE   256
+
+typedef struct _nas_acl_policy_info_t {
+    uint64_t    file_bytes;
+    uint64_t    objs;           // Objects in the file
+    uint64_t    loaded;         // Objects created
+    uint64_t    batches;
+    uint64_t    load_us;
+    uint64_t    objs_per_sec;
+} nas_acl_policy_info_t;
+
+/*
+ * Writes the ranges, tables, counters and entries of all switches to a
+ * policy file, in the order they have to be created. Each object is kept
+ * in the CPS object wire format, so the file is exactly what the CPS
+ * write handlers take and is read back without any text parsing.
+ */
+t_std_error nas_acl_policy_save (const char* path) noexcept;
+
+/*
+ * Maps a policy file and creates its objects through the CPS write
+ * handlers, batch_size objects per transaction. Each batch is fit checked
+ * as a whole and rolled back as a whole on failure, then loading stops.
+ * Batches created before the failure are kept. Info may be null.
+ */
+t_std_error nas_acl_policy_load (const char* path, size_t batch_size,
+                                 nas_acl_policy_info_t* info) noexcept;
+
+#endif /* _NAS_ACL_POLICY_H_ */
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_stats.h
+ * \brief  ACL counter stats cache, poller, rates, top-N, software clear
+ *         and shared memory export
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_STATS_H_
+#define _NAS_ACL_STATS_H_
+
+#include "std_error_codes.h"
+#include "cps_api_operation.h"
+#include "nas_base_utils.h"
+#include "nas_acl_switch_list.h"
+#include "nas_acl_stats_shm.h"
+#include <sys/types.h>
+#include <stdint.h>
+#include <vector>
+
+/*
+ * A background poller refreshes a cache of counter values every poll
+ * interval without the NAS ACL lock. Stats GET takes values from the
+ * cache that are no older than the max age, or that the same GET read
+ * in bulk for its table, and reads the others from hardware. The default
+ * max age of 0 keeps GET values fresh.
+ */
+#define NAS_ACL_STATS_POLL_INTERVAL_MS  5000
+#define NAS_ACL_STATS_MAX_AGE_MS        0
+#define NAS_ACL_STATS_BULK_SIZE         256     // Counters per bulk NDI read, if NDI has it
+#define NAS_ACL_STATS_RATE_TAU_MS       30000   // Time constant of smoothed rates
+#define NAS_ACL_STATS_RATE_MIN_MS       500     // Shortest sample interval for rates
+#define NAS_ACL_STATS_TOP_WINDOW        12      // Polls the top-N rates are taken over
+#define NAS_ACL_STATS_EVENT_BATCH       128     // Counters per change event
+
+typedef struct _nas_acl_stats_cache_info_t {
+    uint64_t    poll_count;     // Poll cycles completed
+    uint64_t    poll_errors;    // NDI reads that failed during poll
+    uint64_t    hit_count;      // Counts served from the cache
+    uint64_t    miss_count;     // Counts read from hardware on GET
+    uint64_t    bulk_read_count; // Bulk NDI reads done
+    uint64_t    stream_events;  // Stats change events published
+    uint64_t    delta_count;    // Counters seen moving between polls
+    uint64_t    delta_skipped;  // Counters left out of a poll after a failed read
+    uint64_t    baselines;      // Counts cleared in software, per NPU
+} nas_acl_stats_cache_info_t;
+
+// Counts of a counter that moved between two polls
+typedef struct _nas_acl_stats_delta_t {
+    nas_switch_id_t switch_id;
+    nas_obj_id_t    table_id;
+    nas_obj_id_t    counter_id;
+    uint64_t        byte_count;     // Summed over the NPUs
+    uint64_t        pkt_count;
+    uint64_t        byte_delta;     // Change since the previous poll
+    uint64_t        pkt_delta;
+} nas_acl_stats_delta_t;
+
+// Must not be called with the NAS ACL lock held
+t_std_error nas_acl_stats_poller_start (void) noexcept;
+void nas_acl_stats_poller_stop (void) noexcept;
+void nas_acl_stats_poll_now (void) noexcept;
+
+/*
+ * When enabled, each poll publishes OBSERVED Stats object events for the
+ * counters whose counts changed since the previous poll. An event is keyed
+ * with the Switch Id and Table Id and lists the counters of that table under
+ * {BASE_ACL_STATS_OBJ, index, attr}, with the Counter Id and the packet
+ * and byte totals. Enabling connects to the CPS event service.
+ */
+t_std_error nas_acl_stats_stream_enable (bool enable) noexcept;
+
+t_std_error nas_acl_stats_event_connect (void) noexcept;
+
+// Returns the number of events published
+size_t nas_acl_stats_publish_deltas (const std::vector<nas_acl_stats_delta_t>& deltas) noexcept;
+
+/*
+ * Export the polled counter totals to a shared memory region that
+ * collectors read with the nas_acl_stats_shm reader API. The export is
+ * off by default. A capacity set before init turns it on, NAS-ACL init
+ * then opens NAS_ACL_STATS_SHM_NAME with NAS_ACL_STATS_SHM_MODE, owned
+ * by the group set with nas_acl_stats_shm_group_set if any.
+ */
+#define NAS_ACL_STATS_SHM_CAPACITY      0       // Counters exported, 0 is off
+#define NAS_ACL_STATS_SHM_MODE          0640
+
+void nas_acl_stats_shm_capacity_set (uint32_t capacity) noexcept;
+void nas_acl_stats_shm_group_set (gid_t gid) noexcept;
+t_std_error nas_acl_stats_shm_init (void) noexcept;
+t_std_error nas_acl_stats_shm_open (const char* name, uint32_t capacity) noexcept;
+void nas_acl_stats_shm_close (void) noexcept;
+bool nas_acl_stats_shm_is_open (void) noexcept;
+void nas_acl_stats_shm_publish (const nas_acl_stats_shm_rec_t* recs,
+                                size_t count, size_t total,
+                                uint64_t update_ms) noexcept;
+
+// Interval of 0 pauses the poller
+void nas_acl_stats_poll_interval_set (uint32_t interval_ms) noexcept;
+void nas_acl_stats_max_age_set (uint32_t max_age_ms) noexcept;
+uint32_t nas_acl_stats_max_age_get (void) noexcept;
+
+/*
+ * Max age for a GET that read its counts in bulk at since_ms: the
+ * configured max age, or the time since the bulk read if longer.
+ * A since_ms of 0 gives the configured max age.
+ */
+uint64_t nas_acl_stats_now_ms (void) noexcept;
+uint32_t nas_acl_stats_req_max_age (uint64_t since_ms) noexcept;
+
+/*
+ * Get the counts of the counter in the NPU, from the cache if they were
+ * read no more than max_age_ms ago, else from hardware. Counts are
+ * reported relative to the last software clear.
+ * Called with the NAS ACL lock held.
+ */
+t_std_error nas_acl_stats_cached_get (const nas_acl_counter_t& counter,
+                                      npu_id_t  npu_id,
+                                      uint32_t  max_age_ms,
+                                      bool&     byte_valid,
+                                      uint64_t* byte_count_p,
+                                      bool&     pkt_valid,
+                                      uint64_t* pkt_count_p) noexcept;
+
+/*
+ * Read all counters of the table that are not in the cache or older
+ * than max_age_ms, with one bulk NDI read per NPU if NDI has the bulk
+ * read, one read per counter otherwise.
+ * Called with the NAS ACL lock held.
+ */
+t_std_error nas_acl_stats_table_refresh (const nas_acl_table& table,
+                                         uint32_t max_age_ms) noexcept;
+
+/*
+ * Software clear: the current hardware counts become the baseline that
+ * later reads are reported against, no NDI write is made. A table is
+ * cleared for all its counters at once.
+ * Called with the NAS ACL lock held.
+ */
+void nas_acl_stats_soft_clear_set (bool enable) noexcept;
+bool nas_acl_stats_soft_clear_get (void) noexcept;
+
+t_std_error nas_acl_stats_counter_clear (const nas_acl_counter_t& counter,
+                                         const nas::npu_set_t& npu_list,
+                                         bool clear_pkt, bool clear_byte) noexcept;
+
+t_std_error nas_acl_stats_table_clear (const nas_acl_table& table) noexcept;
+
+// Drop cached counts and the baseline after they were changed in
+// hardware, or after the counter was deleted
+void nas_acl_stats_cache_forget (const nas_acl_counter_t& counter) noexcept;
+
+/*
+ * Exponentially smoothed bytes/sec and packets/sec of the counter,
+ * summed over its NPUs. Rates are 0 until two samples were taken.
+ * Called with the NAS ACL lock held.
+ */
+t_std_error nas_acl_stats_rate_get (const nas_acl_counter_t& counter,
+                                    double* bps_p, double* pps_p) noexcept;
+
+// Average rates of a counter over the top-N window
+typedef struct _nas_acl_stats_top_t {
+    nas_switch_id_t switch_id;
+    nas_obj_id_t    table_id;
+    nas_obj_id_t    counter_id;
+    double          pps;
+    double          bps;
+} nas_acl_stats_top_t;
+
+/*
+ * The count counters with the highest packet (or byte) rate over the
+ * last NAS_ACL_STATS_TOP_WINDOW polls, highest first. Counters that did
+ * not move in the window are left out. Counters may since have been
+ * deleted.
+ */
+t_std_error nas_acl_stats_top_get (size_t count, bool by_bytes,
+                                   std::vector<nas_acl_stats_top_t>& top) noexcept;
+
+/*
+ * A Stats GET without Table Id is a top-N query when its filter has one
+ * of these attributes with a non-zero u32 N. The ACL model has no such
+ * query, so their ids are kept in a NAS ACL range of their own, well
+ * away from the model ids and the CPS reserved range at the top.
+ */
+#define NAS_ACL_ATTR_RANGE_START        0x4e41434c00000000ULL   // "NACL"
+#define NAS_ACL_STATS_TOP_PKTS_ATTR     (NAS_ACL_ATTR_RANGE_START + 1)  // N by packet rate
+#define NAS_ACL_STATS_TOP_BYTES_ATTR    (NAS_ACL_ATTR_RANGE_START + 2)  // N by byte rate
+
+bool nas_acl_stats_top_filter (cps_api_object_t filter_obj,
+                               size_t* count_p, bool* by_bytes_p) noexcept;
+
+// Add Stats objects of the top-N counters to the GET response, highest first
+t_std_error nas_acl_get_stats_top (cps_api_get_params_t *param, size_t index,
+                                   size_t count, bool by_bytes) noexcept;
+
+void nas_acl_stats_cache_info_get (nas_acl_stats_cache_info_t* info_p) noexcept;
+
+#endif /* _NAS_ACL_STATS_H_ */
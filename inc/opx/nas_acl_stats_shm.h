@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_stats_shm.h
+ * \brief  Layout of the shared memory ACL counter export and its reader API
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_STATS_SHM_H_
+#define _NAS_ACL_STATS_SHM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NAS_ACL_STATS_SHM_NAME      "/nas_acl_stats"
+#define NAS_ACL_STATS_SHM_MAGIC     0x4e414353  /* "NACS" */
+#define NAS_ACL_STATS_SHM_VERSION   1
+
+/*
+ * The region is a header followed by capacity records. NAS-ACL rewrites
+ * all records after every stats poll. Readers copy them out under the
+ * seq counter, which is odd while an update is in progress.
+ */
+typedef struct _nas_acl_stats_shm_rec_t {
+    uint64_t    table_id;
+    uint64_t    counter_id;
+    uint64_t    pkt_count;      /* Summed over the NPUs */
+    uint64_t    byte_count;
+    uint64_t    timestamp_ms;   /* CLOCK_MONOTONIC time of the hardware read */
+} nas_acl_stats_shm_rec_t;
+
+typedef struct _nas_acl_stats_shm_hdr_t {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    capacity;       /* Records the region can hold */
+    uint32_t    seq;
+    uint32_t    count;          /* Valid records */
+    uint32_t    total;          /* Counters in NAS-ACL, above count if truncated */
+    uint64_t    update_ms;      /* CLOCK_MONOTONIC time of the last update */
+} nas_acl_stats_shm_hdr_t;
+
+#define NAS_ACL_STATS_SHM_SIZE(_capacity) \
+    (sizeof (nas_acl_stats_shm_hdr_t) + (_capacity) * sizeof (nas_acl_stats_shm_rec_t))
+
+/* Retries of a read that overlapped an update before it gives up */
+#define NAS_ACL_STATS_SHM_READ_RETRIES  1000
+
+typedef struct _nas_acl_stats_shm_reader_t nas_acl_stats_shm_reader_t;
+
+/* Map the region published by NAS-ACL. Returns NULL if it is not there. */
+nas_acl_stats_shm_reader_t* nas_acl_stats_shm_reader_open (const char* name);
+
+void nas_acl_stats_shm_reader_close (nas_acl_stats_shm_reader_t* reader);
+
+/*
+ * Copy a consistent snapshot of up to max_recs records.
+ * Returns the number of records copied, or -1 if the region kept
+ * changing under the reader.
+ */
+int nas_acl_stats_shm_reader_read (nas_acl_stats_shm_reader_t* reader,
+                                   nas_acl_stats_shm_rec_t* recs,
+                                   size_t max_recs,
+                                   uint64_t* update_ms_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NAS_ACL_STATS_SHM_H_ */
@@ -34,10 +34,12 @@
 #include "nas_udf_group.h"
 #include "nas_udf_match.h"
 #include "nas_udf.h"
+#include "nas_acl_mem.h"
 #include "std_mutex_lock.h"
 #include <map>
 #include <unordered_map>
 #include <vector>
+#include <string>
 
 struct acl_pool_id_t
 {
@@ -209,6 +211,24 @@ class nas_acl_switch : public nas::base_switch_t
         bool save_acl_pool(npu_id_t npu_id, nas_obj_id_t id) noexcept;
         void remove_acl_pool(npu_id_t npu_id, nas_obj_id_t id) noexcept;
 
+        ///// Staged table reload
+        // Shadow table is a clone of the live table with its own NPU tables.
+        // Its entries stay out of hardware until the shadow is committed.
+        void add_shadow_table (nas_obj_id_t live_id, nas_obj_id_t shadow_id) noexcept
+        {_shadow_tables[shadow_id] = live_id;}
+        void del_shadow_table (nas_obj_id_t shadow_id) noexcept
+        {_shadow_tables.erase (shadow_id);}
+        // Returns 0 if the given table is not a shadow table
+        nas_obj_id_t shadow_table_owner (nas_obj_id_t shadow_id) const noexcept;
+        void swap_table_generation (nas_obj_id_t live_id,
+                                    nas_obj_id_t shadow_id) noexcept;
+        // Tear down up to max_objs objects of a table that is no longer live.
+        // Sets pending if there is more left to be removed. On an NDI failure
+        // the objects not yet removed stay in cache and the error is returned.
+        t_std_error retire_table_generation (nas_obj_id_t table_id,
+                                             size_t max_objs,
+                                             bool* pending_p) noexcept;
+
         void delete_pbr_action_by_nh_obj (ndi_obj_id_t nh_obj_id) noexcept;
         void add_pbr_entry_to_cache(nas_obj_id_t tbl_id, nas_obj_id_t entry_id);
         void del_pbr_entry_from_cache(nas_obj_id_t tbl_id, nas_obj_id_t entry_id);
@@ -224,6 +244,13 @@ class nas_acl_switch : public nas::base_switch_t
         void if_delete_notify(hal_ifindex_t ifindex);
 
         void dump_rule_intf_bind(void) const noexcept;
+
+        // Cross-check of the object caches, called with the NAS ACL lock held.
+        // Appends a description of each violation found and returns their count.
+        size_t check_invariants (std::vector<std::string>& violations) const noexcept;
+
+        // Heap held by the object caches, called with the NAS ACL lock held
+        void mem_usage (nas_acl_mem_account& acct) const noexcept;
     private:
 
         struct acl_table_container_t
@@ -262,6 +289,11 @@ class nas_acl_switch : public nas::base_switch_t
         // cache content: <table-id, entry-id>
         std::vector<pbr_entry_id_t> _cached_pbr_entries;
 
+        // cache content: <shadow-table-id, live-table-id>
+        std::unordered_map<nas_obj_id_t, nas_obj_id_t> _shadow_tables;
+
+        void rebind_table_container (nas_obj_id_t table_id) noexcept;
+
         struct acl_rule_item_info_t {
             nas_obj_id_t table_id;
             nas_obj_id_t entry_id;
@@ -309,4 +341,15 @@ class nas_acl_switch : public nas::base_switch_t
 
 std_mutex_type_t& nas_acl_intf_bind_mutex() noexcept;
 
+// Scoped hold of the interface bind mutex with contention accounting
+class nas_acl_intf_bind_guard
+{
+public:
+    explicit nas_acl_intf_bind_guard (const char* site = __builtin_FUNCTION ()) noexcept;
+    ~nas_acl_intf_bind_guard ();
+
+    nas_acl_intf_bind_guard (const nas_acl_intf_bind_guard&) = delete;
+    nas_acl_intf_bind_guard& operator= (const nas_acl_intf_bind_guard&) = delete;
+};
+
 #endif
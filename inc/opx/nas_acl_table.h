@@ -31,6 +31,7 @@
 #include <set>
 
 class nas_acl_switch;
+class nas_acl_mem_account;
 
 /**
 * @class NAS ACL Table
@@ -79,6 +80,10 @@ class nas_acl_table final : public nas::base_obj_t
         size_t       udf_group_list_count() const noexcept {return _udf_group_list.size();}
         const udf_group_list_t& udf_group_list() const noexcept {return _udf_group_list;}
         ndi_obj_id_t  get_ndi_obj_id (npu_id_t  npu_id) const;
+        // Entries of a staged table are kept out of hardware
+        bool          is_staged () const noexcept {return _staged;}
+        // Heap held by the table, the table itself is counted by its switch
+        void          mem_usage (nas_acl_mem_account& acct) const noexcept;
 
         //////// Modifiers ////////
         void set_table_id (nas_obj_id_t id);
@@ -89,6 +94,9 @@ class nas_acl_table final : public nas::base_obj_t
         void set_allowed_action (uint_t action_id);
         void set_udf_group_id (nas_obj_id_t udf_grp_id);
         void set_table_name(const char* name);
+        // Exchange hardware tables with another generation of this table
+        void swap_ndi_obj_ids (nas_acl_table& other) noexcept;
+        void set_staged (bool staged) noexcept {_staged = staged;}
 
         nas_obj_id_t get_udf_group_from_pos(size_t udf_grp_pos) const;
         size_t get_udf_group_pos(nas_obj_id_t udf_grp_id) const;
@@ -138,6 +146,9 @@ class nas_acl_table final : public nas::base_obj_t
         // Read-write attributes
         ndi_acl_priority_t    _priority = 0;
 
+        // Shadow table that is still being filled
+        bool                  _staged = false;
+
         // List of mapped NDI IDs one for each NPU
         // managed by this NAS component
         nas::ndi_obj_id_table_t   _ndi_obj_ids;
@@ -149,6 +160,11 @@ inline void nas_acl_table::set_table_id (nas_obj_id_t id)
     _table_id = id;
 }
 
+inline void nas_acl_table::swap_ndi_obj_ids (nas_acl_table& other) noexcept
+{
+    std::swap (_ndi_obj_ids, other._ndi_obj_ids);
+}
+
 inline size_t nas_acl_table::allowed_filters_count () const noexcept
 {
     return _allowed_filters.size();
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_trace.h
+ * \brief  Timestamped trace of ACL object lifecycle steps
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_TRACE_H_
+#define _NAS_ACL_TRACE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+/*
+ * Spans are recorded into a ring per thread, the oldest are overwritten.
+ * Recording is off by default and costs one relaxed load per span then.
+ */
+#define NAS_ACL_TRACE_RING_SIZE     4096
+#define NAS_ACL_TRACE_MAX_EXITED    16      // Rings of exited threads kept for dump
+
+extern std::atomic<bool> g_nas_acl_trace_enabled;
+
+inline bool nas_acl_trace_enabled () noexcept
+{
+    return g_nas_acl_trace_enabled.load (std::memory_order_relaxed);
+}
+
+inline uint64_t nas_acl_trace_now_ns () noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+void nas_acl_trace_enable (bool enable) noexcept;
+void nas_acl_trace_clear (void) noexcept;
+
+// Name must be a string literal, it is kept by pointer
+void nas_acl_trace_record (const char* name, uint64_t start_ns, uint64_t dur_ns,
+                           uint64_t id) noexcept;
+
+// Write all rings to the file in Chrome trace event JSON format
+bool nas_acl_trace_dump (const char* path) noexcept;
+
+// Records the time from its construction to end () or its destruction
+class nas_acl_trace_span
+{
+public:
+    explicit nas_acl_trace_span (const char* name, uint64_t id = 0) noexcept
+        : _name (name), _id (id),
+          _start_ns (nas_acl_trace_enabled () ? nas_acl_trace_now_ns () : 0) {}
+
+    ~nas_acl_trace_span () {end ();}
+
+    void set_id (uint64_t id) noexcept {_id = id;}
+
+    void end () noexcept
+    {
+        if (_start_ns == 0) return;
+
+        nas_acl_trace_record (_name, _start_ns, nas_acl_trace_now_ns () - _start_ns, _id);
+        _start_ns = 0;
+    }
+
+private:
+    const char*  _name;
+    uint64_t     _id;
+    uint64_t     _start_ns;
+};
+
+#endif /* _NAS_ACL_TRACE_H_ */
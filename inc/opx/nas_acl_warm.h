@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_warm.h
+ * \brief  Warm restart snapshot and reconcile of the NAS ACL hardware objects
+ * \date   10-2026
+ */
+
+#ifndef _NAS_ACL_WARM_H_
+#define _NAS_ACL_WARM_H_
+
+#include "std_error_codes.h"
+#include "nas_types.h"
+#include "nas_ndi_obj_id_table.h"
+#include <stdint.h>
+#include <atomic>
+
+/*
+ * Default snapshot location. It is on tmpfs so that it survives a restart
+ * of the NAS process but never a reboot, where the NPU starts out empty.
+ */
+#define NAS_ACL_WARM_SNAPSHOT_PATH  "/run/nas_acl_warm.snap"
+
+/*
+ * Reconcile ends on its own once the replay has been quiet for the idle
+ * time, or at the latest after the max time, if the application does not
+ * end it first.
+ */
+#define NAS_ACL_WARM_REPLAY_IDLE_MS (30 * 1000)
+#define NAS_ACL_WARM_REPLAY_MAX_MS  (10 * 60 * 1000)
+
+typedef enum {
+    NAS_ACL_WARM_OBJ_TABLE = 1,
+    NAS_ACL_WARM_OBJ_COUNTER,
+    NAS_ACL_WARM_OBJ_RANGE,
+    NAS_ACL_WARM_OBJ_ENTRY,
+} nas_acl_warm_obj_t;
+
+typedef struct _nas_acl_warm_info_t {
+    bool        reconciling;
+    uint64_t    loaded;         // Snapshot records loaded
+    uint64_t    rejected;       // Snapshot records NDI does not back, never adopted
+    uint64_t    adopted;        // NPU objects taken over without reprogramming
+    uint64_t    programmed;     // NPU objects created during reconcile
+    uint64_t    stale_deleted;  // Snapshot objects nobody claimed, removed at the end
+    uint64_t    stale_failed;   // Stale objects that could not be removed
+} nas_acl_warm_info_t;
+
+class nas_acl_table;
+class nas_acl_counter_t;
+class nas_acl_range;
+class nas_acl_entry;
+
+/*
+ * Writes the tables, counters, ranges and entries of all switches with
+ * their NDI ids per NPU. Takes the NAS ACL lock. The file is written
+ * aside and renamed, so a reader never sees a partial snapshot.
+ */
+t_std_error nas_acl_warm_snapshot_save (const char* path) noexcept;
+
+/*
+ * Loads a snapshot and enters reconcile mode, to be called before the
+ * CPS handlers are registered. The snapshot is removed once loaded so a
+ * second restart does not adopt objects the first one has deleted.
+ * Tables and counters are checked against NDI, and so is the entry count
+ * of each table. Records NDI does not back are never adopted. Ranges have
+ * no NDI read and are taken as saved. Starts the reconcile timer.
+ */
+t_std_error nas_acl_warm_snapshot_load (const char* path) noexcept;
+
+/*
+ * Ends reconcile mode once the application has replayed its config.
+ * Snapshot objects that were not adopted by the replay are deleted from
+ * the NPU, entries first, then counters and ranges, then tables.
+ * Called by the reconcile timer if the application does not call it.
+ */
+t_std_error nas_acl_warm_reconcile_end (void) noexcept;
+
+void nas_acl_warm_replay_timeout_set (uint32_t idle_ms, uint32_t max_ms) noexcept;
+
+/*
+ * Stops the reconcile timer and saves the snapshot, for NAS shutdown.
+ * CPS writes after this are not in the snapshot.
+ */
+t_std_error nas_acl_warm_shutdown (const char* path) noexcept;
+
+void nas_acl_warm_info_get (nas_acl_warm_info_t* info) noexcept;
+
+extern std::atomic<bool> g_nas_acl_warm_reconciling;
+
+inline bool nas_acl_warm_reconciling (void) noexcept
+{
+    return g_nas_acl_warm_reconciling.load (std::memory_order_relaxed);
+}
+
+/*
+ * Called from the create path of each object for every NPU. Returns true
+ * with the NDI id of the snapshot object if the NPU already holds the same
+ * object, on the same parents, and the NDI create must be skipped.
+ */
+bool nas_acl_warm_adopt (const nas_acl_table& table, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept;
+bool nas_acl_warm_adopt (const nas_acl_counter_t& counter, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept;
+bool nas_acl_warm_adopt (const nas_acl_range& range, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept;
+bool nas_acl_warm_adopt (const nas_acl_entry& entry, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept;
+
+#endif /* _NAS_ACL_WARM_H_ */
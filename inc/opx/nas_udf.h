@@ -31,6 +31,7 @@
 #include <set>
 
 class nas_acl_switch;
+class nas_acl_mem_account;
 
 /**
 * @class NAS UDF
@@ -60,6 +61,7 @@ public:
     void hash_mask(uint8_t* byte_list, size_t& byte_cnt) const noexcept;
 
     ndi_obj_id_t get_ndi_obj_id(npu_id_t npu_id) const;
+    void mem_usage(nas_acl_mem_account& acct) const noexcept;
 
     // Modifiers
     void set_udf_id(nas_obj_id_t id);
@@ -30,6 +30,7 @@
 #include <set>
 
 class nas_acl_switch;
+class nas_acl_mem_account;
 
 /**
 * @class NAS UDF Group
@@ -59,6 +60,7 @@ public:
     const udf_set_t& udf_ids() const noexcept {return _udf_ids;}
 
     ndi_obj_id_t get_ndi_obj_id(npu_id_t npu_id) const;
+    void mem_usage(nas_acl_mem_account& acct) const noexcept;
 
     // Modifiers
     void set_group_id(nas_obj_id_t id);
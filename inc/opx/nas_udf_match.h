@@ -31,6 +31,7 @@
 #include <set>
 
 class nas_acl_switch;
+class nas_acl_mem_account;
 
 /**
 * @class NAS UDF Match
@@ -64,6 +65,7 @@ public:
     {inner = _inner_ip_type; outer = _outer_ip_type;}
 
     ndi_obj_id_t get_ndi_obj_id(npu_id_t npu_id) const;
+    void mem_usage(nas_acl_mem_account& acct) const noexcept;
 
     // Modifiers
     void set_match_id(nas_obj_id_t id);
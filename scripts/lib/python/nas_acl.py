@@ -185,6 +185,38 @@ def create_entry(table_id, prio, filter_map, action_map, name=None, switch_id=0)
     return entry_id
 
 
+# Replace all entries in the table with the given desired set in one
+# transaction. Each item is (prio, filter_map, action_map, name).
+# Entries already in place are not touched in hardware.
+def sync_entries(table_id, entries, switch_id=0):
+    upd = [('rpc', EntryCPSObj(table_id=table_id, switch_id=switch_id).data())]
+    for prio, filter_map, action_map, name in entries:
+        e = EntryCPSObj(table_id=table_id, priority=prio, entry_id=name,
+                        switch_id=switch_id)
+        for ftype, fval in filter_map.items():
+            e.add_match_filter(filter_type=ftype, filter_val=fval)
+
+        for atype, aval in action_map.items():
+            e.add_action(action_type=atype, action_val=aval)
+        upd.append(('rpc', e.data()))
+
+    r = cps_utils.CPSTransaction(upd).commit()
+    if r == False:
+        raise RuntimeError("Entry sync failed")
+
+
+# Check whether count more entries fit in the table.
+# Returns the estimated number of free entries.
+def table_fit_check(table_id, count, switch_id=0):
+    t = TableCPSObj(table_id=table_id, size=count, switch_id=switch_id)
+    r = cps_utils.CPSTransaction([('rpc', t.data())]).commit()
+    if r == False:
+        raise RuntimeError("Table does not have room for %d entries" % count)
+
+    t = TableCPSObj(cps_data=r[0])
+    return t.extract('size')
+
+
 def create_counter(table_id, types=['BYTE'], name=None, switch_id=0):
     c = CounterCPSObj(table_id=table_id, types=types, counter_id=name,
                       switch_id=switch_id)
@@ -358,6 +390,34 @@ def print_stats(table_id=None, counter_id=None):
         c.print_obj()
 
 
+# Zero the counts of one counter, or of every counter in the table if
+# counter_id is not given. With software clear on, a whole table is
+# cleared at once without hardware writes.
+def clear_stats(table_id, counter_id=None, pkt=True, byte=True):
+    c = StatsCPSObj(table_id=table_id, counter_id=counter_id,
+                    pkt_count=0 if pkt else None,
+                    byte_count=0 if byte else None)
+
+    upd = ('set', c.data())
+    r = cps_utils.CPSTransaction([upd]).commit()
+
+    if r == False:
+        raise RuntimeError("Stats clear failed")
+
+
+# Print the n counters with the highest packet (or byte) rate
+# over the last few stats polls, highest first
+def top_stats(n, by_bytes=False):
+    c = StatsCPSObj(top_n=n, top_by_bytes=by_bytes)
+    r = []
+    if not cps.get([c.data()], r):
+        print 'CPS Get failed for top ACL Counter Stats'
+        return
+    for c_cps in r:
+        c = StatsCPSObj(cps_data=c_cps)
+        c.print_obj()
+
+
 # Clean up
 def delete_entry(table_id, entry_id):
     e = EntryCPSObj(table_id=table_id, entry_id=entry_id)
@@ -15,6 +15,12 @@
 
 import nas_acl_base as nab
 import nas_acl_map
+import bytearray_utils
+
+# NAS private Stats GET attributes, see nas_acl_stats.h
+NAS_ACL_ATTR_RANGE_START = 0x4e41434c00000000
+NAS_ACL_STATS_TOP_PKTS_ATTR = NAS_ACL_ATTR_RANGE_START + 1
+NAS_ACL_STATS_TOP_BYTES_ATTR = NAS_ACL_ATTR_RANGE_START + 2
 
 
 class StatsCPSObj(nab.AclCPSObj):
@@ -32,12 +38,14 @@ class StatsCPSObj(nab.AclCPSObj):
     }
 
     def __init__(self, table_id=None, counter_id=None,
-                 pkt_count=None, byte_count=None, switch_id=0, cps_data=None):
+                 pkt_count=None, byte_count=None, switch_id=0, cps_data=None,
+                 top_n=None, top_by_bytes=False):
         """
         Initialize the CPS object Python dictionary with the input parameters.
         @table_id, @counter_id, @types, @switch_id - form the CPS object with the
                                                    corresponding attributes
         @cps_data - form the CPS object from CPS data returned from a Create or Set.
+        @top_n, @top_by_bytes - Get only the top_n counters by packet (or byte) rate
         """
 
         if cps_data is not None:
@@ -61,6 +69,11 @@ class StatsCPSObj(nab.AclCPSObj):
             self.add_attr(self.obj_dict, 'matched-packets', pkt_count)
         if byte_count is not None:
             self.add_attr(self.obj_dict, 'matched-bytes', byte_count)
+        if top_n is not None:
+            attr_id = (NAS_ACL_STATS_TOP_BYTES_ATTR if top_by_bytes
+                       else NAS_ACL_STATS_TOP_PKTS_ATTR)
+            self.obj_dict[str(attr_id)] = bytearray_utils.type_to_ba[
+                'uint32_t']('uint32_t', top_n)
 
         self.cps_obj = self.create_cps_obj(
             module=self.obj_name,
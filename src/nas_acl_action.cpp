@@ -28,6 +28,7 @@
 #include "nas_acl_action.h"
 #include "nas_acl_log.h"
 #include "nas_acl_utl.h"
+#include "nas_acl_mem.h"
 #include <unordered_map>
 #include <arpa/inet.h>
 #include <inttypes.h>
@@ -65,12 +66,14 @@ nas_acl_action_t::nas_acl_action_t (BASE_ACL_ACTION_TYPE_t t)
 
     _a_info.action_type = t;
     _a_info.values_type = NDI_ACL_ACTION_NO_VALUE;
+    _update_hash ();
 }
 
 void nas_acl_action_t::set_obj_id_action_val (const nas_acl_common_data_list_t& data_list)
 {
     _a_info.values_type = NDI_ACL_ACTION_OBJ_ID;
     _nas_oid = data_list.at(0).obj_id;
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_obj_id_action_val (nas_acl_common_data_list_t& data_list) const
@@ -84,6 +87,7 @@ void nas_acl_action_t::set_u64_action_val (const nas_acl_common_data_list_t& dat
 {
     _a_info.values_type = NDI_ACL_ACTION_U64;
     _a_info.values.u64  = data_list.at(0).u64;
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_u64_action_val (nas_acl_common_data_list_t& data_list) const
@@ -98,6 +102,7 @@ void nas_acl_action_t::set_u32_action_val (const nas_acl_common_data_list_t& dat
 {
     _a_info.values_type = NDI_ACL_ACTION_U32;
     _a_info.values.u32  = data_list.at(0).u32;
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_u32_action_val (nas_acl_common_data_list_t& data_list) const
@@ -112,6 +117,7 @@ void nas_acl_action_t::set_u16_action_val (const nas_acl_common_data_list_t& dat
 {
     _a_info.values_type = NDI_ACL_ACTION_U16;
     _a_info.values.u16  = data_list.at(0).u16;
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_u16_action_val (nas_acl_common_data_list_t& data_list) const
@@ -126,6 +132,7 @@ void nas_acl_action_t::set_u8_action_val (const nas_acl_common_data_list_t& data
 {
     _a_info.values_type = NDI_ACL_ACTION_U8;
     _a_info.values.u8   = data_list.at(0).u8;
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_u8_action_val (nas_acl_common_data_list_t& data_list) const
@@ -142,6 +149,7 @@ void nas_acl_action_t::set_ipv4_action_val (const nas_acl_common_data_list_t& da
     _a_info.values_type = NDI_ACL_ACTION_IPV4_ADDR;
     memcpy ((uint8_t*)&_a_info.values.ipv4, data_list.at(0).bytes.data(),
             sizeof (_a_info.values.ipv4));
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_ipv4_action_val (nas_acl_common_data_list_t& data_list) const
@@ -162,6 +170,7 @@ void nas_acl_action_t::set_ipv6_action_val (const nas_acl_common_data_list_t& da
     _a_info.values_type = NDI_ACL_ACTION_IPV6_ADDR;
     memcpy ((uint8_t*)&_a_info.values.ipv6, data_list.at(0).bytes.data(),
             sizeof (_a_info.values.ipv6));
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_ipv6_action_val (nas_acl_common_data_list_t& data_list) const
@@ -180,6 +189,7 @@ void nas_acl_action_t::set_mac_action_val (const nas_acl_common_data_list_t& dat
 {
     _a_info.values_type = NDI_ACL_ACTION_MAC_ADDR;
     memcpy (_a_info.values.mac, data_list.at(0).bytes.data(), HAL_MAC_ADDR_LEN);
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_mac_action_val (nas_acl_common_data_list_t& data_list) const
@@ -211,12 +221,14 @@ void nas_acl_action_t::set_opaque_data_action_val (const nas_acl_common_data_lis
 {
     _a_info.values_type = NDI_ACL_ACTION_OBJ_ID;
     _set_opaque_data (data_list);
+    _update_hash ();
 }
 
 void nas_acl_action_t::set_opaque_data_list_action_val (const nas_acl_common_data_list_t& data_list)
 {
     _a_info.values_type = NDI_ACL_ACTION_OBJ_ID_LIST;
     _set_opaque_data (data_list);
+    _update_hash ();
 }
 
 void nas_acl_action_t::set_opaque_data_nexthop_val (const nas_acl_common_data_list_t& data_list)
@@ -242,6 +254,7 @@ void nas_acl_action_t::set_opaque_data_nexthop_val (const nas_acl_common_data_li
         _nas2ndi_oid_tbl[nh_key] =
                 std::move (data_list.at (elem_num+4).ndi_obj_id_table);
     }
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_opaque_data_action_val (nas_acl_common_data_list_t& data_list) const
@@ -405,6 +418,7 @@ void nas_acl_action_t::set_action_ifindex (const nas_acl_common_data_list_t& dat
 
         update_port_mapping();
     }
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_action_ifindex (nas_acl_common_data_list_t& data_list) const
@@ -432,6 +446,7 @@ void nas_acl_action_t::set_action_ifindex_list (const nas_acl_common_data_list_t
     }
 
     update_port_mapping();
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_action_ifindex_list (nas_acl_common_data_list_t& val_list) const
@@ -467,6 +482,7 @@ void nas_acl_action_t::set_pkt_action_val (const nas_acl_common_data_list_t& val
         throw nas::base_exception {NAS_ACL_E_ATTR_VAL, __PRETTY_FUNCTION__,
             std::string {"Invalid Pkt action "} + std::to_string (_a_info.pkt_action)};
     }
+    _update_hash ();
 }
 
 void nas_acl_action_t::get_pkt_color_val (nas_acl_common_data_list_t& val_list) const
@@ -488,6 +504,7 @@ void nas_acl_action_t::set_pkt_color_val (const nas_acl_common_data_list_t& val_
         throw nas::base_exception {NAS_ACL_E_ATTR_VAL, __PRETTY_FUNCTION__,
             std::string {"Invalid Pkt color "} + std::to_string (_a_info.pkt_color)};
     }
+    _update_hash ();
 }
 
 
@@ -593,11 +610,59 @@ bool nas_acl_action_t::copy_action_ndi (ndi_acl_action_list_t& ndi_alist,
     return true;
 }
 
+// Hash covers exactly the fields compared by operator!=
+void nas_acl_action_t::_update_hash () noexcept
+{
+    uint64_t h = nas_acl_hash_combine (0, _a_info.action_type);
+    h = nas_acl_hash_combine (h, _a_info.values_type);
+
+    switch (_a_info.values_type)
+    {
+        case NDI_ACL_ACTION_PORT:
+        case NDI_ACL_ACTION_PORTLIST:
+            for (auto ifindex: _ifindex_list) {
+                h = nas_acl_hash_combine (h, ifindex);
+            }
+            break;
+
+        case NDI_ACL_ACTION_OBJ_ID:
+            h = nas_acl_hash_combine (h, _nas_oid);
+            /* Intentional Fall through */
+        case NDI_ACL_ACTION_OBJ_ID_LIST:
+        {
+            // Table is an unordered map - use an order independent sum
+            uint64_t tbl_hash = 0;
+            for (const auto& oid_pair: _nas2ndi_oid_tbl) {
+                uint64_t elem = nas_acl_hash_combine (0, _obj_key_hash()(oid_pair.first));
+                for (const auto& npu_oid: oid_pair.second) {
+                    elem += nas_acl_hash_combine (npu_oid.first, npu_oid.second);
+                }
+                tbl_hash += elem;
+            }
+            h = nas_acl_hash_combine (h, tbl_hash);
+            break;
+        }
+
+        case NDI_ACL_ACTION_NO_VALUE:
+            break;
+
+        default:
+            h = nas_acl_hash_bytes (h, &_a_info, sizeof (_a_info));
+            break;
+    }
+
+    _content_hash = h;
+}
+
 bool nas_acl_action_t::operator!= (const nas_acl_action_t& rhs) const
 {
     if (action_type() != rhs.action_type())
         return true;
 
+    // Cheap reject before comparing full values and opaque data tables
+    if (_content_hash != rhs._content_hash)
+        return true;
+
     switch (_a_info.values_type)
     {
         case NDI_ACL_ACTION_PORT:
@@ -640,6 +705,23 @@ static const char* _get_pkt_action_name (BASE_ACL_PACKET_ACTION_TYPE_t  type) no
     return it->second;
 }
 
+void nas_acl_action_t::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj (NAS_ACL_MEM_ACTION);
+
+    acct.add (NAS_ACL_MEM_ACTION, _nas2ndi_oid_tbl);
+    for (const auto& oid_pair: _nas2ndi_oid_tbl) {
+        acct.add (NAS_ACL_MEM_ACTION, oid_pair.second);
+    }
+
+    acct.add (NAS_ACL_MEM_PORT_LIST, _ifindex_list);
+    acct.add (NAS_ACL_MEM_PORT_LIST, _deleted_ifindex_list);
+    acct.add (NAS_ACL_MEM_PORT_LIST, _npu_port_list);
+    for (const auto& port_pair: _npu_port_list) {
+        acct.add (NAS_ACL_MEM_PORT_LIST, port_pair.second);
+    }
+}
+
 void nas_acl_action_t::dbg_dump () const
 {
     NAS_ACL_LOG_DUMP ("Action: %s", name ());
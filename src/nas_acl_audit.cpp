@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_audit.cpp
+ * \brief  Audit of the NAS ACL object cache against the NPU
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_audit.h"
+#include "nas_acl_switch_list.h"
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+enum class audit_phase_t {
+    TABLE,
+    ENTRIES,
+    COUNTERS,
+};
+
+// Resume point between two batches. Objects are looked up again by id
+// for each batch, since the lock is not held in between.
+struct audit_cursor_t {
+    nas_switch_id_t     switch_id = 0;
+    nas_obj_id_t        table_id = 0;   // First table at or after it in TABLE phase
+    audit_phase_t       phase = audit_phase_t::TABLE;
+    nas_obj_id_t        next_id = 0;    // First entry or counter at or after it
+    bool                done = false;
+};
+
+struct audit_run_t {
+    nas_acl_audit_mode_t                    mode;
+    std::vector<nas_acl_audit_mismatch_t>*  mismatches;
+    nas_acl_audit_info_t                    info;
+    // NPUs whose entry count for the table last checked agrees with the
+    // cache. Entry repairs are limited to those.
+    nas_obj_id_t                            count_table_id;
+    std::set<npu_id_t>                      count_agrees;
+};
+
+static std::mutex _audit_run_mutex;         // One audit at a time
+static std::mutex _audit_info_mutex;
+static nas_acl_audit_info_t _audit_info {};
+
+const char* nas_acl_audit_mismatch_name (nas_acl_audit_mismatch_type_t type) noexcept
+{
+    switch (type) {
+        case NAS_ACL_AUDIT_TABLE_MISSING:   return "Table missing";
+        case NAS_ACL_AUDIT_TABLE_COUNT:     return "Table entry count";
+        case NAS_ACL_AUDIT_ENTRY_MISSING:   return "Entry missing";
+        case NAS_ACL_AUDIT_ENTRY_EXTRA:     return "Entry extra";
+        case NAS_ACL_AUDIT_COUNTER_MISSING: return "Counter missing";
+        default:                            return "Unknown";
+    }
+}
+
+static void _audit_report (audit_run_t& run, const nas_acl_audit_mismatch_t& m) noexcept
+{
+    run.info.mismatches++;
+    if (m.repaired) run.info.repaired++;
+
+    NAS_ACL_LOG_ERR_RL ("Audit: Switch %d Table %ld Obj %ld NPU %d: %s, cache %" PRIu64
+                        " NPU %" PRIu64 "%s", m.switch_id, m.table_id, m.obj_id, m.npu_id,
+                        nas_acl_audit_mismatch_name (m.type), m.cached, m.npu,
+                        m.repaired ? ", repaired" : "");
+
+    if (run.mismatches != nullptr) {
+        try {
+            run.mismatches->push_back (m);
+        } catch (...) {
+        }
+    }
+}
+
+static nas_acl_audit_mismatch_t _audit_mismatch (nas_acl_audit_mismatch_type_t type,
+                                                 nas_switch_id_t switch_id,
+                                                 nas_obj_id_t table_id, nas_obj_id_t obj_id,
+                                                 npu_id_t npu_id) noexcept
+{
+    nas_acl_audit_mismatch_t m {};
+
+    m.type = type;
+    m.switch_id = switch_id;
+    m.table_id = table_id;
+    m.obj_id = obj_id;
+    m.npu_id = npu_id;
+    return m;
+}
+
+// Entries the cache has in each NPU against the entry count NDI reports
+static void _audit_table (audit_run_t& run, nas_acl_switch& s, const nas_acl_table& table)
+{
+    auto table_id = table.table_id ();
+    const auto& entries = s.entry_list (table_id);
+
+    run.count_table_id = table_id;
+    run.count_agrees.clear ();
+
+    for (auto npu_id: table.npu_list ()) {
+        ndi_acl_table_attr_t table_attr;
+        std::vector<uint32_t> used_count, avail_count;
+
+        if (!nas_acl_read_table_usage (npu_id, table_id, s, table_attr,
+                                       used_count, avail_count)) {
+            _audit_report (run, _audit_mismatch (NAS_ACL_AUDIT_TABLE_MISSING, s.id (),
+                                                 table_id, table_id, npu_id));
+            continue;
+        }
+        if (table_attr.acl_table_used_entry_list_count == 0) {
+            // NDI does not report usage for this table
+            continue;
+        }
+
+        uint64_t npu_count = 0;
+        for (size_t i = 0; i < table_attr.acl_table_used_entry_list_count; i++) {
+            npu_count += used_count[i];
+        }
+
+        uint64_t cached_count = 0;
+        for (const auto& entry_pair: entries) {
+            if (entry_pair.second.is_installed_to_npu (npu_id)) cached_count++;
+        }
+
+        if (npu_count != cached_count) {
+            auto m = _audit_mismatch (NAS_ACL_AUDIT_TABLE_COUNT, s.id (),
+                                      table_id, table_id, npu_id);
+            m.cached = cached_count;
+            m.npu = npu_count;
+            _audit_report (run, m);
+        } else {
+            run.count_agrees.insert (npu_id);
+        }
+    }
+    run.info.tables_checked++;
+}
+
+static bool _audit_entry_expected (const nas_acl_entry& entry, npu_id_t npu_id) noexcept
+{
+    // Same rule as the create path, see push_create_obj_to_npu_ext
+    for (const auto& flt_pair: entry.get_filter_list ()) {
+        if (!flt_pair.second.is_eligible_for_install (npu_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Entry mismatches come from the cache alone. A create or delete is only
+// pushed when the NPU entry count shows the cache to be right otherwise.
+static bool _audit_entry_repairable (const audit_run_t& run, const nas_acl_entry& entry,
+                                     npu_id_t npu_id) noexcept
+{
+    return (run.mode == NAS_ACL_AUDIT_REPAIR &&
+            run.count_table_id == entry.table_id () &&
+            run.count_agrees.find (npu_id) != run.count_agrees.end ());
+}
+
+static void _audit_entry (audit_run_t& run, nas_acl_switch& s, nas_acl_entry& entry)
+{
+    for (auto npu_id: entry.npu_list ()) {
+        if (entry.is_installed_to_npu (npu_id) ||
+            !_audit_entry_expected (entry, npu_id)) {
+            continue;
+        }
+
+        auto m = _audit_mismatch (NAS_ACL_AUDIT_ENTRY_MISSING, s.id (),
+                                  entry.table_id (), entry.entry_id (), npu_id);
+        if (_audit_entry_repairable (run, entry, npu_id)) {
+            try {
+                entry.push_create_obj_to_npu_ext (npu_id, nullptr, false);
+            } catch (nas::base_exception& e) {
+                NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s",
+                                 e.err_code, e.err_fn.c_str (), e.err_msg.c_str ());
+            }
+            m.repaired = entry.is_installed_to_npu (npu_id);
+        }
+        _audit_report (run, m);
+    }
+
+    const auto& npus = entry.npu_list ();
+    std::vector<npu_id_t> extra_npus;
+    for (const auto& ndi_pair: entry.ndi_entry_ids) {
+        if (npus.find (ndi_pair.first) == npus.end ()) {
+            extra_npus.push_back (ndi_pair.first);
+        }
+    }
+
+    for (auto npu_id: extra_npus) {
+        auto m = _audit_mismatch (NAS_ACL_AUDIT_ENTRY_EXTRA, s.id (),
+                                  entry.table_id (), entry.entry_id (), npu_id);
+        if (_audit_entry_repairable (run, entry, npu_id)) {
+            try {
+                entry.push_delete_obj_to_npu_ext (npu_id, false);
+            } catch (nas::base_exception& e) {
+                NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s",
+                                 e.err_code, e.err_fn.c_str (), e.err_msg.c_str ());
+            }
+            m.repaired = !entry.is_installed_to_npu (npu_id);
+        }
+        _audit_report (run, m);
+    }
+    run.info.entries_checked++;
+}
+
+static void _audit_counter (audit_run_t& run, nas_acl_switch& s,
+                            const nas_acl_counter_t& counter)
+{
+    if (counter.is_pkt_count_enabled () || counter.is_byte_count_enabled ()) {
+        for (auto npu_id: counter.npu_list ()) {
+            bool byte_valid = false, pkt_valid = false;
+            uint64_t byte_count = 0, pkt_count = 0;
+
+            if (counter.is_obj_in_npu (npu_id) &&
+                counter.get_count_ndi (npu_id, byte_valid, &byte_count,
+                                       pkt_valid, &pkt_count) == NAS_ACL_E_NONE) {
+                continue;
+            }
+            _audit_report (run, _audit_mismatch (NAS_ACL_AUDIT_COUNTER_MISSING, s.id (),
+                                                 counter.table_id (), counter.counter_id (),
+                                                 npu_id));
+        }
+    }
+    run.info.counters_checked++;
+}
+
+// Checks up to max_objs objects from the cursor on, with the NAS ACL lock held
+static void _audit_batch (audit_run_t& run, audit_cursor_t& cur, size_t max_objs)
+{
+    const auto& switch_list = nas_acl_get_switch_list ();
+    size_t count = 0;
+
+    while (count < max_objs && !cur.done) {
+        auto sw_it = switch_list.lower_bound (cur.switch_id);
+        if (sw_it == switch_list.end ()) {
+            cur.done = true;
+            break;
+        }
+        if (sw_it->first != cur.switch_id) {
+            cur = audit_cursor_t {};
+            cur.switch_id = sw_it->first;
+        }
+        nas_acl_switch& s = nas_acl_get_switch (cur.switch_id);
+
+        if (cur.phase == audit_phase_t::TABLE) {
+            const auto& tables = s.table_list ();
+            auto tbl_it = tables.lower_bound (cur.table_id);
+            if (tbl_it == tables.end ()) {
+                cur = audit_cursor_t {};
+                cur.switch_id = sw_it->first + 1;
+                continue;
+            }
+            cur.table_id = tbl_it->first;
+            if (tbl_it->second.is_staged ()) {
+                // Shadow entries are not in hardware until commit
+                cur.table_id++;
+                continue;
+            }
+            _audit_table (run, s, tbl_it->second);
+            cur.phase = audit_phase_t::ENTRIES;
+            cur.next_id = 0;
+            count++;
+            continue;
+        }
+
+        if (s.find_table (cur.table_id) == nullptr) {
+            // Table went away since the last batch
+            cur.phase = audit_phase_t::TABLE;
+            cur.table_id++;
+            continue;
+        }
+
+        if (cur.phase == audit_phase_t::ENTRIES) {
+            const auto& entries = s.entry_list (cur.table_id);
+            auto it = entries.lower_bound (cur.next_id);
+            for (; it != entries.end () && count < max_objs; ++it, count++) {
+                _audit_entry (run, s, *s.find_entry (cur.table_id, it->first));
+                cur.next_id = it->first + 1;
+            }
+            if (it == entries.end ()) {
+                cur.phase = audit_phase_t::COUNTERS;
+                cur.next_id = 0;
+            }
+        } else {
+            const auto& counters = s.counter_list (cur.table_id);
+            auto it = counters.lower_bound (cur.next_id);
+            for (; it != counters.end () && count < max_objs; ++it, count++) {
+                _audit_counter (run, s, it->second);
+                cur.next_id = it->first + 1;
+            }
+            if (it == counters.end ()) {
+                cur.phase = audit_phase_t::TABLE;
+                cur.table_id++;
+            }
+        }
+    }
+    run.info.batches++;
+}
+
+t_std_error nas_acl_audit_run (nas_acl_audit_mode_t mode, size_t batch_size,
+                               std::vector<nas_acl_audit_mismatch_t>* mismatches) noexcept
+{
+    using clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> run_lock {_audit_run_mutex, std::try_to_lock};
+    if (!run_lock.owns_lock ()) {
+        NAS_ACL_LOG_ERR ("ACL audit is already running");
+        return NAS_ACL_E_INCONSISTENT;
+    }
+
+    audit_run_t run {mode, mismatches, {}};
+    audit_cursor_t cur;
+    t_std_error rc = NAS_ACL_E_NONE;
+
+    if (batch_size == 0) batch_size = NAS_ACL_AUDIT_BATCH_SIZE;
+
+    {
+        std::lock_guard<std::mutex> l {_audit_info_mutex};
+        _audit_info.running = true;
+    }
+
+    auto start = clock::now ();
+    while (!cur.done) {
+        nas_acl_lock ();
+        auto batch_start = clock::now ();
+        try {
+            _audit_batch (run, cur, batch_size);
+        } catch (nas::base_exception& e) {
+            NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s",
+                             e.err_code, e.err_fn.c_str (), e.err_msg.c_str ());
+            rc = e.err_code;
+            cur.done = true;
+        } catch (...) {
+            rc = NAS_ACL_E_FAIL;
+            cur.done = true;
+        }
+        uint64_t batch_us = std::chrono::duration_cast<std::chrono::microseconds> (
+                                clock::now () - batch_start).count ();
+        nas_acl_unlock ();
+
+        run.info.max_batch_us = std::max (run.info.max_batch_us, batch_us);
+        // Let waiting CPS requests in before the next batch
+        std::this_thread::yield ();
+    }
+
+    run.info.run_time_us = std::chrono::duration_cast<std::chrono::microseconds> (
+                               clock::now () - start).count ();
+    uint64_t objs = run.info.tables_checked + run.info.entries_checked +
+                    run.info.counters_checked;
+    run.info.objs_per_sec = (run.info.run_time_us > 0) ?
+                            objs * 1000000 / run.info.run_time_us : objs;
+
+    NAS_ACL_LOG_BRIEF ("ACL audit done: %" PRIu64 " objects in %" PRIu64 " us, %" PRIu64
+                       " mismatches, %" PRIu64 " repaired", objs, run.info.run_time_us,
+                       run.info.mismatches, run.info.repaired);
+
+    std::lock_guard<std::mutex> l {_audit_info_mutex};
+    run.info.runs = _audit_info.runs + 1;
+    run.info.running = false;
+    _audit_info = run.info;
+
+    return rc;
+}
+
+void nas_acl_audit_info_get (nas_acl_audit_info_t* info) noexcept
+{
+    std::lock_guard<std::mutex> l {_audit_info_mutex};
+    *info = _audit_info;
+}
+
+void dump_acl_audit (void)
+{
+    nas_acl_audit_info_t info;
+
+    nas_acl_audit_info_get (&info);
+
+    NAS_ACL_LOG_DUMP ("ACL audit %s, %" PRIu64 " runs", info.running ? "running" : "idle",
+                      info.runs);
+    NAS_ACL_LOG_DUMP ("  Tables checked    %" PRIu64, info.tables_checked);
+    NAS_ACL_LOG_DUMP ("  Entries checked   %" PRIu64, info.entries_checked);
+    NAS_ACL_LOG_DUMP ("  Counters checked  %" PRIu64, info.counters_checked);
+    NAS_ACL_LOG_DUMP ("  Mismatches        %" PRIu64, info.mismatches);
+    NAS_ACL_LOG_DUMP ("  Repaired          %" PRIu64, info.repaired);
+    NAS_ACL_LOG_DUMP ("  Batches           %" PRIu64, info.batches);
+    NAS_ACL_LOG_DUMP ("  Run time          %" PRIu64 " us", info.run_time_us);
+    NAS_ACL_LOG_DUMP ("  Longest batch     %" PRIu64 " us", info.max_batch_us);
+    NAS_ACL_LOG_DUMP ("  Objects/sec       %" PRIu64, info.objs_per_sec);
+}
+
+// Audit in report mode from the debug shell
+void dump_acl_audit_run (void)
+{
+    nas_acl_audit_run (NAS_ACL_AUDIT_REPORT, NAS_ACL_AUDIT_BATCH_SIZE, nullptr);
+    dump_acl_audit ();
+}
@@ -28,6 +28,9 @@
 #include "nas_acl_counter.h"
 #include "nas_acl_table.h"
 #include "nas_acl_log.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_warm.h"
 #include <inttypes.h>
 
 nas_acl_counter_t::nas_acl_counter_t (const nas_acl_table* table_p)
@@ -46,6 +49,15 @@ const char*  nas_acl_counter_t::table_name() const noexcept
     return _table_p->table_name();
 }
 
+void nas_acl_counter_t::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj (NAS_ACL_MEM_COUNTER);
+    acct.add (NAS_ACL_MEM_COUNTER, _counter_name);
+    acct.add (NAS_ACL_MEM_COUNTER, _types_to_be_pushed);
+    acct.add (NAS_ACL_MEM_COUNTER, _refs);
+    acct.add (NAS_ACL_MEM_COUNTER, _ndi_obj_ids);
+}
+
 void nas_acl_counter_t::copy_table_npus ()
 {
     set_npu_list (get_table().npu_list());
@@ -149,11 +161,18 @@ bool nas_acl_counter_t::push_create_obj_to_npu (npu_id_t npu_id,
     t_std_error rc = STD_ERR_OK;
     ndi_acl_counter_t ndi_counter = {0};
 
+    if (nas_acl_warm_adopt (*this, npu_id, ndi_cntr_id)) {
+        // Already in the NPU from before a warm restart, counts are kept
+        _ndi_obj_ids[npu_id] = ndi_cntr_id;
+        return true;
+    }
+
     ndi_counter.table_id = get_table().get_ndi_obj_id(npu_id);
     ndi_counter.enable_pkt_count = _enable_pkt_count;
     ndi_counter.enable_byte_count = _enable_byte_count;
 
-    if ((rc = ndi_acl_counter_create (npu_id, &ndi_counter, &ndi_cntr_id))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_CREATE, ndi_acl_counter_create,
+                                npu_id, &ndi_counter, &ndi_cntr_id))
             != STD_ERR_OK)
     {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -173,7 +192,8 @@ bool nas_acl_counter_t::push_delete_obj_to_npu (npu_id_t npu_id)
 {
     t_std_error rc = STD_ERR_OK;
 
-    if ((rc = ndi_acl_counter_delete (npu_id, _ndi_obj_ids.at (npu_id)))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_DELETE, ndi_acl_counter_delete,
+                                npu_id, _ndi_obj_ids.at (npu_id)))
         != STD_ERR_OK)
     {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -237,9 +257,10 @@ t_std_error nas_acl_counter_t::get_count_ndi (npu_id_t npu_id,
     byte_count_valid = _validate_entry_counter (counter::BYTE, npu_id, &ndi_counter_id);
     pkt_count_valid = _validate_entry_counter (counter::PKT, npu_id, &ndi_counter_id);
 
-    if ((rc = ndi_acl_counter_get_count (npu_id, ndi_counter_id,
-                                         byte_count_valid ? byte_count_p : nullptr,
-                                         pkt_count_valid ? pkt_count_p : nullptr))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_GET, ndi_acl_counter_get_count,
+                                npu_id, ndi_counter_id,
+                                byte_count_valid ? byte_count_p : nullptr,
+                                pkt_count_valid ? pkt_count_p : nullptr))
         != STD_ERR_OK) {
 
         NAS_ACL_LOG_ERR ("NDI Packet counter Get returned error %d for NPU %d\n",
@@ -260,8 +281,8 @@ void nas_acl_counter_t::set_pkt_count_ndi (npu_id_t npu_id,
             "Packet count action not enabled for this ACL Entry"};
     }
 
-    if ((rc = ndi_acl_counter_set_pkt_count (npu_id, ndi_counter_id,
-                                             pkt_count))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_SET, ndi_acl_counter_set_pkt_count,
+                                npu_id, ndi_counter_id, pkt_count))
         != STD_ERR_OK) {
 
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -281,8 +302,8 @@ void nas_acl_counter_t::set_byte_count_ndi (npu_id_t npu_id,
             "Byte count action not enabled for this ACL Entry"};
     }
 
-    if ((rc = ndi_acl_counter_set_byte_count (npu_id, ndi_counter_id,
-                                              byte_count))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_SET, ndi_acl_counter_set_byte_count,
+                                npu_id, ndi_counter_id, byte_count))
         != STD_ERR_OK) {
 
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
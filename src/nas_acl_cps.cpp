@@ -24,6 +24,32 @@
 #include "std_error_codes.h"
 #include "nas_acl_log.h"
 #include "nas_acl_cps.h"
+#include "cps_api_object_tools.h"
+#include "nas_acl_latency.h"
+
+static nas_acl_lat_op_t nas_acl_cps_lat_op (uint32_t                  sub_category,
+                                            cps_api_operation_types_t op) noexcept
+{
+    int base;
+
+    switch (sub_category) {
+        case BASE_ACL_TABLE_OBJ:   base = NAS_ACL_LAT_TABLE_CREATE; break;
+        case BASE_ACL_ENTRY_OBJ:   base = NAS_ACL_LAT_ENTRY_CREATE; break;
+        case BASE_ACL_COUNTER_OBJ: base = NAS_ACL_LAT_COUNTER_CREATE; break;
+        case BASE_ACL_STATS_OBJ:
+            return (op == cps_api_oper_SET) ? NAS_ACL_LAT_STATS_SET : NAS_ACL_LAT_OP_MAX;
+        default:
+            return NAS_ACL_LAT_OP_MAX;
+    }
+
+    // Create, Modify and Delete follow each other for every object
+    switch (op) {
+        case cps_api_oper_CREATE: return (nas_acl_lat_op_t) base;
+        case cps_api_oper_SET:    return (nas_acl_lat_op_t) (base + 1);
+        case cps_api_oper_DELETE: return (nas_acl_lat_op_t) (base + 2);
+        default:                  return NAS_ACL_LAT_OP_MAX;
+    }
+}
 
 static inline t_std_error
 nas_acl_exec_write_op (nas_acl_write_operation_map_t *op_map,
@@ -113,6 +139,7 @@ nas_acl_cps_api_read (void                 *context,
 {
     uint32_t              sub_category;
     t_std_error rc = NAS_ACL_E_UNSUPPORTED;
+    nas_acl_lat_scope     lat (NAS_ACL_LAT_OP_MAX);
 
     cps_api_object_t filter_obj = cps_api_object_list_get (param->filters, index);
 
@@ -135,15 +162,19 @@ nas_acl_cps_api_read (void                 *context,
     switch (sub_category) {
 
         case BASE_ACL_TABLE_OBJ:
+            lat.set_op (NAS_ACL_LAT_TABLE_GET);
             rc = nas_acl_get_table (param, index, filter_obj);
             break;
 
         case BASE_ACL_ENTRY_OBJ:
+            lat.set_op (NAS_ACL_LAT_ENTRY_GET);
             rc = nas_acl_get_entry (param, index, filter_obj);
             break;
 
         case BASE_ACL_COUNTER_OBJ:
         case BASE_ACL_STATS_OBJ:
+            lat.set_op ((sub_category == BASE_ACL_STATS_OBJ) ?
+                        NAS_ACL_LAT_STATS_GET : NAS_ACL_LAT_COUNTER_GET);
             rc = nas_acl_get_counter (param, index, filter_obj,
                                       (BASE_ACL_OBJECTS_t) sub_category);
             break;
@@ -172,6 +203,8 @@ nas_acl_cps_api_write (void                         *context,
 {
     cps_api_object_t          obj;
     cps_api_operation_types_t op;
+    // Op is known once the object is parsed, timing starts here
+    nas_acl_lat_scope         lat (NAS_ACL_LAT_OP_MAX);
 
     obj = cps_api_object_list_get (param->change_list, index);
 
@@ -180,9 +213,57 @@ nas_acl_cps_api_write (void                         *context,
         return cps_api_ret_code_ERR;
     }
 
+    if (index == 0) {
+        // Parse the Entry Creates before the lock is taken for any object
+        nas_acl_entry_batch_prepare (param);
+
+        // Plan the new entries of the whole transaction against the free
+        // space in their tables before any of them is written to NDI
+        nas_acl_lock ();
+        nas_acl_entry_table_sync_done ();
+        auto rc = nas_acl_entry_batch_fit_check (param);
+        nas_acl_unlock ();
+
+        if (rc != NAS_ACL_E_NONE) {
+            nas_acl_entry_batch_done ();
+            return static_cast<cps_api_return_code_t>(rc);
+        }
+    }
+
     op = cps_api_object_type_operation (cps_api_object_key (obj));
 
-    auto rc = nas_acl_cps_api_write_internal (context, param, obj, op, false);
+    t_std_error rc;
+
+    if (op == cps_api_oper_ACTION &&
+        cps_api_key_get_subcat (cps_api_object_key (obj)) == BASE_ACL_ENTRY_OBJ) {
+        // Keep prev list aligned with change list for rollback
+        cps_api_object_t prev = cps_api_object_list_create_obj_and_append (param->prev);
+        if (prev == NULL) {
+            return cps_api_ret_code_ERR;
+        }
+        cps_api_object_set_key (prev, cps_api_object_key (obj));
+
+        lat.set_op (NAS_ACL_LAT_ENTRY_SYNC);
+        nas_acl_lock ();
+        rc = nas_acl_entry_table_sync (param, index);
+        nas_acl_unlock ();
+    } else {
+        lat.set_op (nas_acl_cps_lat_op (cps_api_key_get_subcat (cps_api_object_key (obj)), op));
+
+        rc = nas_acl_cps_api_write_internal (context, param, obj, op, false);
+    }
+
+    if (rc != NAS_ACL_E_NONE) {
+        // No later object is written, rollback parses what it needs
+        nas_acl_entry_batch_done ();
+    } else if (index + 1 == cps_api_object_list_size (param->change_list)) {
+        // Transaction is complete, there is nothing left to roll back
+        nas_acl_entry_batch_done ();
+        nas_acl_lock ();
+        nas_acl_entry_table_sync_done ();
+        nas_acl_unlock ();
+    }
+
     return static_cast<cps_api_return_code_t>(rc);
 }
 
@@ -203,10 +284,31 @@ nas_acl_cps_api_rollback (void                         *context,
 
     op = cps_api_object_type_operation (cps_api_object_key (obj));
 
-    op = ((op == cps_api_oper_CREATE) ? cps_api_oper_DELETE :
-          (op == cps_api_oper_DELETE) ? cps_api_oper_CREATE : op);
+    t_std_error rc = NAS_ACL_E_NONE;
+
+    if (op == cps_api_oper_ACTION) {
+        if (cps_api_key_get_subcat (cps_api_object_key (obj)) == BASE_ACL_ENTRY_OBJ) {
+            nas_acl_lock ();
+            rc = nas_acl_entry_table_sync_rollback (obj);
+            nas_acl_unlock ();
+        } else {
+            // Other Actions are queries that change nothing
+            NAS_ACL_LOG_BRIEF ("Skip rollback of Action operation");
+        }
+    } else {
+        op = ((op == cps_api_oper_CREATE) ? cps_api_oper_DELETE :
+              (op == cps_api_oper_DELETE) ? cps_api_oper_CREATE : op);
+
+        rc = nas_acl_cps_api_write_internal (context, param, obj, op, true);
+    }
+
+    if (index == 0) {
+        // Rollback of the transaction is complete
+        nas_acl_lock ();
+        nas_acl_entry_table_sync_done ();
+        nas_acl_unlock ();
+    }
 
-    auto rc = nas_acl_cps_api_write_internal (context, param, obj, op, true);
     return static_cast<cps_api_return_code_t>(rc);
 }
 
@@ -232,6 +334,18 @@ cps_api_object_attr_t nas_acl_get_attr (const cps_api_object_it_t& it,
     return attr;
 }
 
+bool nas_acl_page_filter (cps_api_object_t filter_obj, nas_acl_page_t* page_p) noexcept
+{
+    size_t count = 0;
+
+    *page_p = {0, 0, false, 0, 0, 0};
+
+    if (cps_api_filter_get_count (filter_obj, count)) {
+        page_p->limit = count;
+    }
+    return cps_api_filter_is_getnext (filter_obj);
+}
+
 cps_api_return_code_t
 nas_udf_cps_api_read (void                 *context,
                       cps_api_get_params_t *param,
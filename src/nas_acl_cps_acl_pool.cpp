@@ -35,7 +35,10 @@
 #include "nas_ndi_switch.h"
 #include "nas_ndi_acl.h"
 #include <string>
+#include <map>
+#include <algorithm>
 #include <inttypes.h>
+#include <stdint.h>
 
 //This is used to indicate if the acl pool cache is populated or not.
 static bool nas_acl_pool_cache_init_done = false;
@@ -331,19 +334,16 @@ nas_get_acl_pool_info_by_switch(cps_api_get_params_t* param,
     return STD_ERR_OK;
 }
 
-static bool
-nas_fill_acl_table_attr (cps_api_object_t cps_obj, npu_id_t npu_id,
-                         nas_obj_id_t acl_table_id, nas_acl_switch& s)
+// Read per pipeline used and available entry counts of ACL table from NDI.
+// The lists in table_attr point into the used/avail vectors.
+bool
+nas_acl_read_table_usage (npu_id_t npu_id, nas_obj_id_t acl_table_id,
+                          nas_acl_switch& s, ndi_acl_table_attr_t& table_attr,
+                          std::vector<uint32_t>& acl_table_used_entry_count,
+                          std::vector<uint32_t>& acl_table_avail_entry_count)
 {
-    size_t                 list_sz = 16;
     t_std_error            ret;
     ndi_obj_id_t           ndi_acl_table_id;
-    ndi_acl_table_attr_t   table_attr;
-
-    std::vector<uint32_t> acl_table_used_entry_count(list_sz);
-    std::vector<uint32_t> acl_table_avail_entry_count(list_sz);
-
-    memset (&table_attr, 0, sizeof (table_attr));
 
     ret = nas_acl_table_get_ndi_obj_id_from_nas_obj_id (npu_id,
                  acl_table_id, &ndi_acl_table_id, s);
@@ -355,6 +355,25 @@ nas_fill_acl_table_attr (cps_api_object_t cps_obj, npu_id_t npu_id,
         return false;
     }
 
+    return nas_acl_read_ndi_table_usage (npu_id, ndi_acl_table_id, table_attr,
+                                         acl_table_used_entry_count,
+                                         acl_table_avail_entry_count);
+}
+
+bool
+nas_acl_read_ndi_table_usage (npu_id_t npu_id, ndi_obj_id_t ndi_acl_table_id,
+                              ndi_acl_table_attr_t& table_attr,
+                              std::vector<uint32_t>& acl_table_used_entry_count,
+                              std::vector<uint32_t>& acl_table_avail_entry_count)
+{
+    size_t                 list_sz = 16;
+    t_std_error            ret;
+
+    acl_table_used_entry_count.assign(list_sz, 0);
+    acl_table_avail_entry_count.assign(list_sz, 0);
+
+    memset (&table_attr, 0, sizeof (table_attr));
+
     table_attr.acl_table_used_entry_list_count = list_sz;
     table_attr.acl_table_used_entry_list = &(acl_table_used_entry_count[0]);
     table_attr.acl_table_avail_entry_list_count = list_sz;
@@ -387,6 +406,24 @@ nas_fill_acl_table_attr (cps_api_object_t cps_obj, npu_id_t npu_id,
         }
     }
 
+    return true;
+}
+
+static bool
+nas_fill_acl_table_attr (cps_api_object_t cps_obj, npu_id_t npu_id,
+                         nas_obj_id_t acl_table_id, nas_acl_switch& s)
+{
+    ndi_acl_table_attr_t   table_attr;
+
+    std::vector<uint32_t> acl_table_used_entry_count;
+    std::vector<uint32_t> acl_table_avail_entry_count;
+
+    if (!nas_acl_read_table_usage (npu_id, acl_table_id, s, table_attr,
+                                   acl_table_used_entry_count,
+                                   acl_table_avail_entry_count)) {
+        return false;
+    }
+
     cps_api_attr_id_t ids[3] = {BASE_ACL_ACL_TABLE_INFO, 0,
         BASE_ACL_ACL_TABLE_INFO_PIPELINE_ID};
     const int ids_len = sizeof(ids)/sizeof(ids[0]);
@@ -631,3 +668,165 @@ nas_acl_table_info_get (cps_api_get_params_t *param, size_t index,
 
     return (rc);
 }
+
+/*
+ * ACL table free space model, used to check that new entries fit before
+ * any of them is written to NDI.
+ *
+ * Free entry count of a table on each NPU is read from NDI and then kept
+ * live by subtracting the net count of entries added on the switch since
+ * the read, since entries of other tables can take space from a shared
+ * pool. The estimate is advisory: deletes in one table hide adds in
+ * another, and an entry can take more than one hardware slot, so it can
+ * pass a request that NDI then fails - that is undone like any other
+ * write failure. It is refreshed from NDI before a request is rejected,
+ * so no request is refused on the estimate alone.
+ */
+struct acl_table_fit_key_t {
+    nas_switch_id_t switch_id;
+    nas_obj_id_t    table_id;
+    npu_id_t        npu_id;
+
+    bool operator< (const acl_table_fit_key_t& rhs) const noexcept {
+        if (switch_id != rhs.switch_id) return (switch_id < rhs.switch_id);
+        if (table_id != rhs.table_id) return (table_id < rhs.table_id);
+        return (npu_id < rhs.npu_id);
+    }
+};
+
+struct acl_table_fit_t {
+    size_t hw_avail;        // Free entries reported by NDI
+    size_t switch_entries;  // Entries in the switch at the time of NDI read
+};
+
+static std::map<acl_table_fit_key_t, acl_table_fit_t> _acl_table_fit_cache;
+
+static size_t nas_acl_switch_entry_count (const nas_acl_switch& s)
+{
+    size_t count = 0;
+
+    for (const auto& tbl_kvp: s.table_list ()) {
+        count += s.entry_list (tbl_kvp.first).size ();
+    }
+    return count;
+}
+
+// An entry takes space in every pipeline the table spans
+static bool
+nas_acl_table_hw_avail (npu_id_t npu_id, nas_obj_id_t acl_table_id,
+                        nas_acl_switch& s, size_t* avail_p)
+{
+    ndi_acl_table_attr_t   table_attr;
+    std::vector<uint32_t>  used_count;
+    std::vector<uint32_t>  avail_count;
+
+    if (!nas_acl_read_table_usage (npu_id, acl_table_id, s, table_attr,
+                                   used_count, avail_count)) {
+        return false;
+    }
+    if (table_attr.acl_table_avail_entry_list_count == 0) {
+        return false;
+    }
+
+    size_t avail = SIZE_MAX;
+    for (size_t ix = 0; ix < table_attr.acl_table_avail_entry_list_count; ix++) {
+        avail = std::min (avail, (size_t) table_attr.acl_table_avail_entry_list[ix]);
+    }
+    *avail_p = avail;
+    return true;
+}
+
+// Returns false if the free count of the table on the NPU is not known
+static bool
+nas_acl_table_npu_free_estimate (nas_acl_switch& s, nas_obj_id_t table_id,
+                                 npu_id_t npu_id, size_t switch_entries,
+                                 size_t needed, size_t* free_p)
+{
+    acl_table_fit_key_t key {s.id (), table_id, npu_id};
+    auto it = _acl_table_fit_cache.find (key);
+    size_t avail;
+
+    if (it == _acl_table_fit_cache.end ()) {
+        if (!nas_acl_table_hw_avail (npu_id, table_id, s, &avail)) {
+            return false;
+        }
+        _acl_table_fit_cache[key] = {avail, switch_entries};
+        *free_p = avail;
+        return true;
+    }
+
+    auto& fit = it->second;
+    size_t added = (switch_entries > fit.switch_entries) ?
+                   (switch_entries - fit.switch_entries) : 0;
+    *free_p = (fit.hw_avail > added) ? (fit.hw_avail - added) : 0;
+
+    if (*free_p < needed) {
+        if (!nas_acl_table_hw_avail (npu_id, table_id, s, &avail)) {
+            _acl_table_fit_cache.erase (it);
+            return false;
+        }
+        fit = {avail, switch_entries};
+        *free_p = avail;
+    }
+    return true;
+}
+
+t_std_error nas_acl_table_fit_check (nas_switch_id_t switch_id,
+                                     nas_obj_id_t    table_id,
+                                     size_t          entry_count,
+                                     size_t*         free_p) noexcept
+{
+    size_t free_cnt = SIZE_MAX;
+
+    try {
+        nas_acl_switch& s = nas_acl_get_switch (switch_id);
+        nas_acl_table&  table = s.get_table (table_id);
+        size_t          table_entries = s.entry_list (table_id).size ();
+
+        if (table.table_size () > 0) {
+            free_cnt = (table.table_size () > table_entries) ?
+                       (table.table_size () - table_entries) : 0;
+        }
+
+        size_t switch_entries = nas_acl_switch_entry_count (s);
+
+        for (auto npu_id: table.npu_list ()) {
+            size_t npu_free;
+            if (nas_acl_table_npu_free_estimate (s, table_id, npu_id, switch_entries,
+                                                 entry_count, &npu_free)) {
+                free_cnt = std::min (free_cnt, npu_free);
+            }
+        }
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                        e.err_fn.c_str(), e.err_msg.c_str());
+        return e.err_code;
+    } catch (std::out_of_range& e) {
+        NAS_ACL_LOG_ERR("Out of range exception %s", e.what());
+        return STD_ERR(ACL, FAIL, 0);
+    }
+
+    if (free_p != nullptr) {
+        *free_p = free_cnt;
+    }
+
+    if (entry_count > free_cnt) {
+        NAS_ACL_LOG_ERR("ACL Table 0x%lx has room for %ld entries, %ld requested",
+                        table_id, free_cnt, entry_count);
+        return NAS_ACL_E_TABLE_FULL;
+    }
+
+    NAS_ACL_LOG_DETAIL("ACL Table 0x%lx fit check for %ld entries passed",
+                       table_id, entry_count);
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_table_fit_forget (nas_switch_id_t switch_id, nas_obj_id_t table_id) noexcept
+{
+    auto it = _acl_table_fit_cache.lower_bound ({switch_id, table_id, 0});
+
+    while (it != _acl_table_fit_cache.end () &&
+           it->first.switch_id == switch_id && it->first.table_id == table_id) {
+        it = _acl_table_fit_cache.erase (it);
+    }
+}
@@ -26,6 +26,9 @@
 #include "nas_acl_log.h"
 #include "nas_acl_cps.h"
 #include "nas_base_utils.h"
+#include <functional>
+
+typedef std::function<void (BASE_ACL_ACTION_TYPE_t, nas::attr_list_t&)> nas_acl_action_fn_t;
 
 // Common function called for both Full ACL Entry update and Incremental update
 // In the case of Full ACL Entry update the parent_list will already have
@@ -34,14 +37,10 @@
 //
 // This function will add the Action-Value-Attr to the parent_list hieraerchy.
 //
-void nas_acl_set_action_attr (const cps_api_object_t     obj,
-                              nas_acl_entry&             entry,
-                              BASE_ACL_ACTION_TYPE_t     action_type_val,
-                              nas::attr_list_t&          parent_attr_id_list,
-                              bool                       reset)
+nas_acl_action_t nas_acl_parse_action_attr (const cps_api_object_t     obj,
+                                            BASE_ACL_ACTION_TYPE_t     action_type_val,
+                                            nas::attr_list_t&          parent_attr_id_list)
 {
-    nas_acl_common_data_list_t common_data_list;
-
     auto map_kv = nas_acl_get_action_map().find (action_type_val);
 
     if (map_kv == nas_acl_get_action_map().end ()) {
@@ -57,7 +56,6 @@ void nas_acl_set_action_attr (const cps_api_object_t     obj,
     if (map_info.val.data_type != NAS_ACL_DATA_NONE) {
 
         parent_attr_id_list.push_back (map_info.val.attr_id);
-        common_data_list.clear ();
 
         auto common_data_list =
             nas_acl_copy_data_from_obj (obj, parent_attr_id_list, map_info.val,
@@ -65,13 +63,22 @@ void nas_acl_set_action_attr (const cps_api_object_t     obj,
 
         (action.*(map_info.set_fn)) (common_data_list);
     }
+    return action;
+}
 
+void nas_acl_set_action_attr (const cps_api_object_t     obj,
+                              nas_acl_entry&             entry,
+                              BASE_ACL_ACTION_TYPE_t     action_type_val,
+                              nas::attr_list_t&          parent_attr_id_list,
+                              bool                       reset)
+{
+    auto action = nas_acl_parse_action_attr (obj, action_type_val, parent_attr_id_list);
     entry.add_action (action, reset);
 }
 
-void nas_acl_set_action_list (const cps_api_object_t     obj,
-                              const cps_api_object_it_t& it,
-                              nas_acl_entry&             entry)
+static void _action_list_walk (const cps_api_object_t     obj,
+                               const cps_api_object_it_t& it,
+                               const nas_acl_action_fn_t& fn)
 {
     /*
      * Encoding of ACL Entry Action parameters, with the following
@@ -208,11 +215,31 @@ void nas_acl_set_action_list (const cps_api_object_t     obj,
         NAS_ACL_LOG_DETAIL ("action_type_val: %d (%s)", action_type_val,
                             nas_acl_action_t::type_name (action_type_val));
 
-        nas_acl_set_action_attr (obj, entry, action_type_val,
-                                 parent_attr_id_list, true);
+        fn (action_type_val, parent_attr_id_list);
     }
 }
 
+void nas_acl_set_action_list (const cps_api_object_t     obj,
+                              const cps_api_object_it_t& it,
+                              nas_acl_entry&             entry)
+{
+    _action_list_walk (obj, it, [&obj, &entry] (BASE_ACL_ACTION_TYPE_t action_type_val,
+                                                nas::attr_list_t& parent_attr_id_list) {
+        nas_acl_set_action_attr (obj, entry, action_type_val, parent_attr_id_list, true);
+    });
+}
+
+void nas_acl_parse_action_list (const cps_api_object_t         obj,
+                                const cps_api_object_it_t&     it,
+                                std::vector<nas_acl_action_t>& actions)
+{
+    _action_list_walk (obj, it, [&obj, &actions] (BASE_ACL_ACTION_TYPE_t action_type_val,
+                                                  nas::attr_list_t& parent_attr_id_list) {
+        actions.push_back (nas_acl_parse_action_attr (obj, action_type_val,
+                                                      parent_attr_id_list));
+    });
+}
+
 bool nas_acl_fill_action_attr (cps_api_object_t obj,
                                const nas_acl_action_t& action,
                                BASE_ACL_ACTION_TYPE_t  action_type_val,
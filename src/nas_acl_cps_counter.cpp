@@ -24,6 +24,7 @@
 #include "nas_acl_log.h"
 #include "nas_acl_switch_list.h"
 #include "nas_acl_cps.h"
+#include "nas_acl_stats.h"
 #include "nas_base_utils.h"
 #include "cps_api_object_key.h"
 #include "cps_class_map.h"
@@ -185,29 +186,43 @@ static t_std_error
 nas_acl_get_counter_info_by_table (cps_api_get_params_t  *param,
                                  size_t                 index,
                                  const nas_acl_table&   table,
-                                 BASE_ACL_OBJECTS_t     obj_type) noexcept
+                                 BASE_ACL_OBJECTS_t     obj_type,
+                                 nas_acl_page_t&        page) noexcept
 {
     nas_acl_switch& s = table.get_switch ();
+    const auto& counters = s.counter_list (table.table_id());
 
-    for (const auto& counter_pair: s.counter_list (table.table_id())) {
+    uint64_t refresh_ms = 0;
+
+    if (obj_type == BASE_ACL_STATS_OBJ && page.limit == 0) {
+        // Read the whole table in bulk, the per-counter GET below is then
+        // served from the stats cache. Counters that failed the bulk read
+        // are read again one by one. A page only reads its own counters.
+        refresh_ms = nas_acl_stats_now_ms ();
+        nas_acl_stats_table_refresh (table, nas_acl_stats_max_age_get ());
+    }
+
+    for (auto it = nas_acl_page_first (counters, page, s.id (), table.table_id());
+         it != counters.end () && !nas_acl_page_full (page); ++it) {
         t_std_error  rc;
 
         switch (obj_type) {
         case BASE_ACL_COUNTER_OBJ:
             if ((rc = nas_acl_get_counter_info (param, index,
-                    counter_pair.second)) != NAS_ACL_E_NONE) {
+                    it->second)) != NAS_ACL_E_NONE) {
                 return rc;
             }
             break;
         case BASE_ACL_STATS_OBJ:
-            if ((rc = nas_acl_stats_info_get (param, index,
-                    counter_pair.second)) != NAS_ACL_E_NONE) {
+            if ((rc = nas_acl_stats_info_get (param, index, it->second,
+                    nas_acl_stats_req_max_age (refresh_ms))) != NAS_ACL_E_NONE) {
                 return rc;
             }
             break;
         default:
             break;
         }
+        page.count++;
     }
     return NAS_ACL_E_NONE;
 }
@@ -216,13 +231,18 @@ static t_std_error
 nas_acl_get_counter_info_by_switch (cps_api_get_params_t  *param,
                                   size_t                 index,
                                   const nas_acl_switch&  s,
-                                  BASE_ACL_OBJECTS_t     obj_type) noexcept
+                                  BASE_ACL_OBJECTS_t     obj_type,
+                                  nas_acl_page_t&        page) noexcept
 {
-    for (const auto& tbl_kvp: s.table_list ()) {
+    const auto& tables = s.table_list ();
+
+    // Tables before the cursor are done with
+    for (auto it = nas_acl_page_first_table (tables, page, s.id ());
+         it != tables.end () && !nas_acl_page_full (page); ++it) {
         t_std_error  rc;
 
-        if ((rc = nas_acl_get_counter_info_by_table (param, index, tbl_kvp.second,
-                obj_type)) != NAS_ACL_E_NONE) {
+        if ((rc = nas_acl_get_counter_info_by_table (param, index, it->second,
+                obj_type, page)) != NAS_ACL_E_NONE) {
             return rc;
         }
     }
@@ -232,13 +252,14 @@ nas_acl_get_counter_info_by_switch (cps_api_get_params_t  *param,
 static
 t_std_error nas_acl_get_counter_info_all (cps_api_get_params_t *param,
                                                   size_t               index,
-                                                  BASE_ACL_OBJECTS_t   obj_type) noexcept
+                                                  BASE_ACL_OBJECTS_t   obj_type,
+                                                  nas_acl_page_t&      page) noexcept
 {
     for (const auto& switch_pair: nas_acl_get_switch_list ()) {
         t_std_error  rc;
 
         if ((rc = nas_acl_get_counter_info_by_switch (param,
-                index, switch_pair.second, obj_type)) != NAS_ACL_E_NONE) {
+                index, switch_pair.second, obj_type, page)) != NAS_ACL_E_NONE) {
             return rc;
         }
     }
@@ -256,6 +277,8 @@ nas_acl_get_counter (cps_api_get_params_t *param, size_t index,
     nas_obj_id_t           counter_id;
     nas_attr_id_t          table_id_attr_id, table_name_attr_id;
     nas_attr_id_t          counter_id_attr_id, counter_name_attr_id;
+    nas_acl_page_t         page;
+    bool get_next = nas_acl_page_filter (filter_obj, &page);
 
     if (obj_type == BASE_ACL_COUNTER_OBJ) {
         table_id_attr_id  = BASE_ACL_COUNTER_TABLE_ID;
@@ -309,22 +332,41 @@ nas_acl_get_counter (cps_api_get_params_t *param, size_t index,
         }
     }
 
+    size_t top_count;
+    bool   top_by_bytes;
+
     try {
-        if (!switch_id_key) {
+        if (obj_type == BASE_ACL_STATS_OBJ && !table_id_key &&
+            nas_acl_stats_top_filter (filter_obj, &top_count, &top_by_bytes)) {
+            /* Top-N counters by rate */
+            rc = nas_acl_get_stats_top (param, index, top_count, top_by_bytes);
+        }
+        else if (get_next) {
+            /* Counters after the one given, in any later table of the switch */
+            if (!switch_id_key || !table_id_key || !counter_id_key) {
+                NAS_ACL_LOG_ERR ("Get-next needs the keys of the last Counter");
+                return NAS_ACL_E_MISSING_KEY;
+            }
+            nas_acl_page_cursor_set (page, switch_id, table_id, counter_id);
+            nas_acl_switch& s = nas_acl_get_switch (switch_id);
+            rc = nas_acl_get_counter_info_by_switch (param, index, s, obj_type, page);
+        }
+        else if (!switch_id_key) {
             /* No keys provided */
-            rc = nas_acl_get_counter_info_all (param, index, obj_type);
+            rc = nas_acl_get_counter_info_all (param, index, obj_type, page);
         }
         else if (switch_id_key && !table_id_key) {
             /* Switch Id provided */
             nas_acl_switch& s = nas_acl_get_switch (switch_id);
-            rc = nas_acl_get_counter_info_by_switch (param, index, s, obj_type);
+            rc = nas_acl_get_counter_info_by_switch (param, index, s, obj_type, page);
         }
         else if (switch_id_key && table_id_key && !counter_id_key) {
             /* Switch Id and Table Id provided */
             nas_acl_switch& s = nas_acl_get_switch (switch_id);
             nas_acl_table&  table = s.get_table (table_id);
 
-            rc = nas_acl_get_counter_info_by_table (param, index, table, obj_type);
+            rc = nas_acl_get_counter_info_by_table (param, index, table, obj_type,
+                                                    page);
         }
         else if (switch_id_key && table_id_key && counter_id_key) {
             /* Switch Id, Table Id and Counter Id provided */
@@ -332,7 +374,8 @@ nas_acl_get_counter (cps_api_get_params_t *param, size_t index,
             auto& counter = s.get_counter (table_id, counter_id);
 
             if (obj_type == BASE_ACL_STATS_OBJ) {
-                rc = nas_acl_stats_info_get (param, index, counter);
+                rc = nas_acl_stats_info_get (param, index, counter,
+                                             nas_acl_stats_max_age_get ());
             } else {
                 rc = nas_acl_get_counter_info (param, index, counter);
             }
@@ -564,6 +607,8 @@ static t_std_error nas_acl_counter_delete (cps_api_object_t obj,
         // WARNING !!! CANNOT throw error or exception beyond this point
         // since counter is already deleted in SAI
 
+        // A counter created later with the same ID starts from zero
+        nas_acl_stats_cache_forget (counter);
         s.remove_counter_from_table (table_id, counter_id);
 
         NAS_ACL_LOG_BRIEF ("Counter Deletion successful. Switch Id: %d, "
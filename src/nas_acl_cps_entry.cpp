@@ -31,7 +31,21 @@
 #include "nas_switch.h"
 #include "nas_acl_cps_key.h"
 #include "nas_acl_utl.h"
+#include "nas_acl_trace.h"
 #include <utility>
+#include <inttypes.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+
+// Entry Creates in a transaction from which they are parsed in parallel
+#define NAS_ACL_PREPARE_MIN_ENTRIES     64
+#define NAS_ACL_PREPARE_MAX_THREADS     4
 
 static t_std_error
 nas_acl_entry_create (cps_api_object_t obj,
@@ -53,6 +67,9 @@ static nas_acl_write_operation_map_t nas_acl_entry_op_map [] = {
     {cps_api_oper_DELETE, nas_acl_entry_delete},
 };
 
+// Updated by the write handlers with the NAS ACL lock held
+static nas_acl_write_stats_t _entry_write_stats = {0, 0, 0, 0, 0};
+
 /* Used by CPS Get handler */
 struct entry_key_t {
     nas_switch_id_t switch_id;
@@ -69,6 +86,22 @@ struct entry_key_t {
     bool has_action_type;
 };
 
+/* Entry Create parsed ahead of the write, without the table or the lock */
+struct entry_prepared_t {
+    bool                          has_priority = false;
+    uint32_t                      priority = 0;
+    bool                          has_name = false;
+    std::string                   name;
+    std::vector<nas_acl_filter_t> filters;
+    std::vector<nas_acl_action_t> actions;
+    std::vector<npu_id_t>         npus;
+};
+
+// Filled on the first object of a transaction and used up by its Creates,
+// dropped when the transaction ends. CPS writes all objects of a
+// transaction from the same thread.
+static thread_local std::unordered_map<cps_api_object_t, entry_prepared_t> _entry_prepared;
+
 /* Used by CPS operation (Create/Set/Del) handlers */
 struct entry_op_key_t {
     nas_acl_switch& s;
@@ -237,29 +270,38 @@ static t_std_error nas_acl_get_entry_info (cps_api_get_params_t *param,
 
 static t_std_error nas_acl_get_entry_info_by_table (cps_api_get_params_t  *param,
                                                     size_t                 index,
-                                                    const nas_acl_table&   table)
+                                                    const nas_acl_table&   table,
+                                                    nas_acl_page_t&        page)
 {
     nas_acl_switch& s = table.get_switch ();
+    const auto& entries = s.entry_list (table.table_id());
     t_std_error  rc;
 
-    for (const auto& entry_pair: s.entry_list (table.table_id())) {
+    for (auto it = nas_acl_page_first (entries, page, s.id (), table.table_id());
+         it != entries.end () && !nas_acl_page_full (page); ++it) {
 
-        if ((rc = nas_acl_get_entry_info (param, index, entry_pair.second))
+        if ((rc = nas_acl_get_entry_info (param, index, it->second))
             != NAS_ACL_E_NONE) {
             return rc;
         }
+        page.count++;
     }
     return NAS_ACL_E_NONE;
 }
 
 static t_std_error nas_acl_get_entry_info_by_switch (cps_api_get_params_t  *param,
                                                      size_t                 index,
-                                                     const nas_acl_switch&  s)
+                                                     const nas_acl_switch&  s,
+                                                     nas_acl_page_t&        page)
 {
+    const auto& tables = s.table_list ();
     t_std_error  rc;
-    for (const auto& tbl_kvp: s.table_list ()) {
 
-        if ((rc = nas_acl_get_entry_info_by_table (param, index, tbl_kvp.second))
+    // Tables before the cursor are done with
+    for (auto it = nas_acl_page_first_table (tables, page, s.id ());
+         it != tables.end () && !nas_acl_page_full (page); ++it) {
+
+        if ((rc = nas_acl_get_entry_info_by_table (param, index, it->second, page))
             != NAS_ACL_E_NONE) {
             return rc;
         }
@@ -268,13 +310,14 @@ static t_std_error nas_acl_get_entry_info_by_switch (cps_api_get_params_t  *para
 }
 
 static t_std_error nas_acl_get_entry_info_all (cps_api_get_params_t *param,
-                                               size_t               index)
+                                               size_t               index,
+                                               nas_acl_page_t&      page)
 {
     t_std_error  rc;
     for (const auto& switch_pair: nas_acl_get_switch_list ()) {
 
-        if ((rc = nas_acl_get_entry_info_by_switch (param, index, switch_pair.second))
-                != NAS_ACL_E_NONE) {
+        if ((rc = nas_acl_get_entry_info_by_switch (param, index, switch_pair.second,
+                                                    page)) != NAS_ACL_E_NONE) {
             return rc;
         }
     }
@@ -444,26 +487,37 @@ nas_acl_get_entry (cps_api_get_params_t *param, size_t index,
                    cps_api_object_t filter_obj) noexcept
 {
     t_std_error  rc = NAS_ACL_E_NONE;
-
+    nas_acl_page_t page;
+    bool get_next = nas_acl_page_filter (filter_obj, &page);
 
     try {
         auto key = _cps_extract_key (filter_obj, false);
 
-        if (!key.has_switch_id) {
+        if (get_next) {
+            /* Entries after the one given, in any later table of the switch */
+            if (!key.has_switch_id || !key.has_table_id || !key.has_entry_id) {
+                NAS_ACL_LOG_ERR ("Get-next needs the keys of the last Entry");
+                return NAS_ACL_E_MISSING_KEY;
+            }
+            nas_acl_page_cursor_set (page, key.switch_id, key.table_id, key.entry_id);
+            nas_acl_switch& s = nas_acl_get_switch (key.switch_id);
+            rc = nas_acl_get_entry_info_by_switch (param, index, s, page);
+        }
+        else if (!key.has_switch_id) {
             /* No keys provided */
-            rc = nas_acl_get_entry_info_all (param, index);
+            rc = nas_acl_get_entry_info_all (param, index, page);
         }
         else if (key.has_switch_id && !key.has_table_id) {
             /* Switch Id provided */
             nas_acl_switch& s = nas_acl_get_switch (key.switch_id);
-            rc = nas_acl_get_entry_info_by_switch (param, index, s);
+            rc = nas_acl_get_entry_info_by_switch (param, index, s, page);
         }
         else if (key.has_switch_id && key.has_table_id && !key.has_entry_id) {
             /* Switch Id and Table Id provided */
             nas_acl_switch& s = nas_acl_get_switch (key.switch_id);
             nas_acl_table&  table = s.get_table (key.table_id);
 
-            rc = nas_acl_get_entry_info_by_table (param, index, table);
+            rc = nas_acl_get_entry_info_by_table (param, index, table, page);
         }
         else if (key.has_switch_id && key.has_table_id && key.has_entry_id &&
                 !(key.has_match_type || key.has_action_type)) {
@@ -504,6 +558,7 @@ nas_acl_get_entry (cps_api_get_params_t *param, size_t index,
 
 static entry_op_key_t _cps_op_key_extract (cps_api_object_t obj, bool create)
 {
+    nas_acl_trace_span trace ("Entry Key Validate");
     auto key = _cps_extract_key (obj, create);
 
     if (!key.has_switch_id) {
@@ -695,6 +750,85 @@ static bool _cps_parse_entry_obj (cps_api_object_t obj, nas_acl_entry& tmp_entry
     return npu_modified;
 }
 
+/*
+ * Same as _cps_parse_entry_obj for a Create, but safe to run on any thread
+ * without the NAS ACL lock: filters are parsed without their table and
+ * checks against the table and the cache are left to _cps_apply_prepared.
+ * Returns false if the object is to be parsed by the Create handler, which
+ * also reports its errors.
+ */
+static bool _cps_prepare_entry_obj (cps_api_object_t obj, entry_prepared_t& prep) noexcept
+{
+    cps_api_object_it_t    it;
+
+    try {
+        for (cps_api_object_it_begin (obj, &it);
+                cps_api_object_it_valid (&it); cps_api_object_it_next (&it)) {
+
+            switch (cps_api_object_attr_id (it.attr)) {
+
+            case BASE_ACL_ENTRY_PRIORITY:
+                if (prep.has_priority) return false;
+                prep.has_priority = true;
+                prep.priority = cps_api_object_attr_data_u32 (it.attr);
+                break;
+
+            case BASE_ACL_ENTRY_NAME:
+                prep.has_name = true;
+                prep.name = (char*)cps_api_object_attr_data_bin (it.attr);
+                break;
+
+            case BASE_ACL_ENTRY_MATCH:
+                // UDF filters throw here, they need the table UDF groups
+                nas_acl_parse_match_list (obj, it, nullptr, prep.filters);
+                break;
+
+            case BASE_ACL_ENTRY_ACTION:
+                nas_acl_parse_action_list (obj, it, prep.actions);
+                break;
+
+            case BASE_ACL_ENTRY_NPU_ID_LIST:
+                prep.npus.push_back (cps_api_object_attr_data_u32 (it.attr));
+                break;
+
+            default:
+                break;
+            }
+        }
+    } catch (...) {
+        return false;
+    }
+
+    // Interfaces map to ports only under the lock, when the entry is written
+    for (const auto& filter: prep.filters) {
+        if (!filter.get_filter_if_list ().empty ()) return false;
+    }
+    for (const auto& action: prep.actions) {
+        if (!action.get_action_if_list ().empty ()) return false;
+    }
+    return true;
+}
+
+static void _cps_apply_prepared (entry_prepared_t& prep, nas_acl_entry& tmp_entry)
+{
+    if (prep.has_priority) {
+        tmp_entry.set_priority (prep.priority);
+    }
+    if (prep.has_name) {
+        tmp_entry.set_entry_name (prep.name.c_str ());
+    }
+    for (auto& filter: prep.filters) {
+        filter.rebind_table (&tmp_entry.get_table ());
+        tmp_entry.add_filter (filter, true);
+    }
+    for (auto& action: prep.actions) {
+        tmp_entry.add_action (action, true);
+    }
+    for (auto npu: prep.npus) {
+        tmp_entry.add_npu (npu);
+    }
+}
+
 static void _cps_pack_attrs (cps_api_object_t pack_obj, cps_api_object_t key_obj,
                              const nas_acl_entry& entry,
                              const nas::attr_set_t& attrs, bool npu_modified)
@@ -741,11 +875,88 @@ static void _cps_pack_key (cps_api_object_t pack_obj, cps_api_object_t key_obj,
     return _cps_pack_attrs (pack_obj, key_obj, entry, dummy, false);
 }
 
+/*
+ * True if applying the parsed request on top of the cached entry would not
+ * change anything. For Create the request must describe the entire entry,
+ * for Modify only the attributes present in the request are compared.
+ */
+static bool _cps_entry_is_noop (nas_acl_entry& req, bool npu_modified,
+                                const nas_acl_entry& cur, bool create)
+{
+    const char* req_name = req.entry_name ();
+    const char* cur_name = cur.entry_name ();
+
+    if (req_name != nullptr || create) {
+        if ((req_name == nullptr) != (cur_name == nullptr)) {
+            return false;
+        }
+        if (req_name != nullptr && strcmp (req_name, cur_name) != 0) {
+            return false;
+        }
+    }
+
+    if (create) {
+        return req.is_same_rule (cur);
+    }
+
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_PRIORITY) &&
+        req.priority () != cur.priority ()) {
+        return false;
+    }
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_MATCH) &&
+        !req.is_same_filter_list (cur)) {
+        return false;
+    }
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_ACTION) &&
+        !req.is_same_action_list (cur)) {
+        return false;
+    }
+    if (npu_modified && !req.is_same_npu_list (cur)) {
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Apply a parsed Modify request on top of a copy of the cached entry, the
+ * same way a SET parse of the request into the copy would: attributes in
+ * the request replace the cached ones, the rest are kept.
+ */
+static void _cps_entry_apply_req (nas_acl_entry& entry, nas_acl_entry& req,
+                                  bool npu_modified)
+{
+    if (req.entry_name () != nullptr) {
+        entry.set_entry_name (req.entry_name ());
+    }
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_PRIORITY)) {
+        entry.set_priority (req.priority ());
+    }
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_MATCH)) {
+        entry.reset_filter ();
+        for (const auto& f_pair: req.get_filter_list ()) {
+            nas_acl_filter_t filter (f_pair.second);
+            entry.add_filter (filter, false);
+        }
+    }
+    if (req.is_attr_dirty (BASE_ACL_ENTRY_ACTION)) {
+        entry.reset_action ();
+        for (const auto& a_pair: req.get_action_list ()) {
+            nas_acl_action_t action (a_pair.second);
+            entry.add_action (action, false);
+        }
+    }
+    if (npu_modified) {
+        for (auto npu_id: req.nas::base_obj_t::npu_list ()) {
+            entry.add_npu (npu_id);
+        }
+    }
+}
+
 static t_std_error nas_acl_entry_create (cps_api_object_t obj,
                                          cps_api_object_t prev,
                                          bool             is_rollbk_op) noexcept
 {
-    std_mutex_simple_lock_guard mutex(&nas_acl_intf_bind_mutex());
+    nas_acl_intf_bind_guard bind_guard;
 
     try {
         auto op_key = _cps_op_key_extract (obj, true);
@@ -768,15 +979,42 @@ static t_std_error nas_acl_entry_create (cps_api_object_t obj,
         NAS_ACL_LOG_BRIEF ("%sSwitch Id: %d, Table Id: %ld",
                            (is_rollbk_op) ? "** ROLLBACK **: " : "", sw.id(), table_id);
 
+        if (!is_rollbk_op) {
+            _entry_write_stats.create_count++;
+        }
+
         if (op_key.has_eid) {
-            if ((sw.find_entry (table_id, entry_id)) != NULL) {
-                NAS_ACL_LOG_ERR ("Entry ID %lu already taken", entry_id);
-                return NAS_ACL_E_KEY_VAL;
+            nas_acl_entry* cur_p = sw.find_entry (table_id, entry_id);
+            if (cur_p != NULL) {
+                nas_acl_entry req_entry (&op_key.t);
+                req_entry.set_entry_id (entry_id);
+                bool npu_modified = _cps_parse_entry_obj (obj, req_entry,
+                                                          cps_api_oper_CREATE);
+
+                if (is_rollbk_op ||
+                    !_cps_entry_is_noop (req_entry, npu_modified, *cur_p, true)) {
+                    NAS_ACL_LOG_ERR ("Entry ID %lu already taken", entry_id);
+                    return NAS_ACL_E_KEY_VAL;
+                }
+
+                // Repeated Create of an identical entry - nothing to program.
+                // Rollback of this request must not delete the existing entry
+                _entry_write_stats.create_elided++;
+                nas_acl_cps_key_set_obj_id (obj, BASE_ACL_ENTRY_ID, entry_id);
+                _cps_pack_key (prev, obj, *cur_p);
+                cps_api_object_set_type_operation (cps_api_object_key (prev),
+                                                   cps_api_oper_SET);
+
+                NAS_ACL_LOG_BRIEF ("Entry unchanged, Create elided. Switch Id: %d, "
+                                   "Table Id: %ld, Entry Id: %ld",
+                                   sw.id(), table_id, entry_id);
+                return NAS_ACL_E_NONE;
             }
             NAS_ACL_LOG_BRIEF ("Entry ID %lu provided for Entry Create", entry_id);
         }
 
         nas_acl_entry tmp_entry (&op_key.t);
+        nas_acl_trace_span trace ("Entry Parse");
 
         // Allocate a new ID for the entry beforehand
         // to avoid rolling back commit if ID allocation fails
@@ -788,17 +1026,31 @@ static t_std_error nas_acl_entry_create (cps_api_object_t obj,
         }
         tmp_entry.set_entry_id (entry_id);
 
-        _cps_parse_entry_obj (obj, tmp_entry, cps_api_oper_CREATE);
+        trace.set_id (entry_id);
+        auto prep_it = _entry_prepared.find (obj);
+        if (prep_it != _entry_prepared.end () && !is_rollbk_op) {
+            auto prep = std::move (prep_it->second);
+            _entry_prepared.erase (prep_it);
+            _cps_apply_prepared (prep, tmp_entry);
+            _entry_write_stats.create_prepared++;
+        } else {
+            _cps_parse_entry_obj (obj, tmp_entry, cps_api_oper_CREATE);
+        }
+        trace.end ();
 
         // Apply new entry to NDI and SAI
+        nas_acl_trace_span commit_trace ("Entry Commit", entry_id);
         tmp_entry.commit_create (is_rollbk_op);
+        commit_trace.end ();
 
         // WARNING !!! CANNOT throw error or exception beyond this point
         // since entry is already committed to SAI
 
         // Now save the entry in local cache. Also track references to table/counter
+        nas_acl_trace_span save_trace ("Entry Save", entry_id);
         nas_acl_entry& new_entry = sw.save_entry (std::move(tmp_entry));
         idg.unguard ();
+        save_trace.end ();
         entry_id = new_entry.entry_id ();
 
         NAS_ACL_LOG_BRIEF ("Entry Creation successful. Switch Id: %d, "
@@ -831,7 +1083,7 @@ static t_std_error nas_acl_entry_modify (cps_api_object_t obj,
                                          cps_api_object_t prev,
                                          bool             is_rollbk_op) noexcept
 {
-    std_mutex_simple_lock_guard mutex(&nas_acl_intf_bind_mutex());
+    nas_acl_intf_bind_guard bind_guard;
 
     try {
         auto op_key = _cps_op_key_extract (obj, false);
@@ -856,12 +1108,39 @@ static t_std_error nas_acl_entry_modify (cps_api_object_t obj,
                             sw.id(), table_id, entry_id);
 
         nas_acl_entry& old_entry = sw.get_entry (table_id, entry_id);
-        nas_acl_entry  new_entry (old_entry);
 
-        bool npu_modified = _cps_parse_entry_obj (obj, new_entry, cps_api_oper_SET);
+        // Parse the request on its own first, so that an update repeating
+        // the cached entry completes without copying it or calling NDI
+        nas_acl_trace_span trace ("Entry Parse", entry_id);
+        nas_acl_entry  req_entry (&op_key.t);
+        req_entry.set_entry_id (entry_id);
+        bool npu_modified = _cps_parse_entry_obj (obj, req_entry, cps_api_oper_SET);
+        trace.end ();
+
+        if (!is_rollbk_op) {
+            _entry_write_stats.modify_count++;
+        }
+
+        if (_cps_entry_is_noop (req_entry, npu_modified, old_entry, false)) {
+            if (!is_rollbk_op) {
+                _entry_write_stats.modify_elided++;
+                _cps_pack_key (prev, obj, old_entry);
+            }
+            NAS_ACL_LOG_BRIEF ("Entry unchanged, Modify elided. Switch Id: %d, "
+                               "Table Id: %ld, Entry Id: %ld",
+                               sw.id(), table_id, entry_id);
+            return NAS_ACL_E_NONE;
+        }
+
+        nas_acl_trace_span copy_trace ("Entry Copy", entry_id);
+        nas_acl_entry  new_entry (old_entry);
+        _cps_entry_apply_req (new_entry, req_entry, npu_modified);
+        copy_trace.end ();
 
         // Apply changes to NDI and SAI
+        nas_acl_trace_span commit_trace ("Entry Commit", entry_id);
         auto mod_attrs = new_entry.commit_modify (old_entry, is_rollbk_op);
+        commit_trace.end ();
 
         // WARNING !!! CANNOT throw error or exception beyond this point
         // since entry is already committed to SAI
@@ -871,7 +1150,9 @@ static t_std_error nas_acl_entry_modify (cps_api_object_t obj,
         }
 
         // Now save the entry in local cache. Also track references to table/counter
+        nas_acl_trace_span save_trace ("Entry Save", entry_id);
         sw.save_entry (std::move (new_entry));
+        save_trace.end ();
 
         NAS_ACL_LOG_BRIEF ("Entry Modification successful. Switch Id: %d, "
                            "Table Id: %ld, Entry Id: %ld",
@@ -895,7 +1176,7 @@ static t_std_error nas_acl_entry_delete (cps_api_object_t obj,
                                          cps_api_object_t prev,
                                          bool             is_rollbk_op) noexcept
 {
-    std_mutex_simple_lock_guard mutex(&nas_acl_intf_bind_mutex());
+    nas_acl_intf_bind_guard bind_guard;
 
     try {
         auto op_key = _cps_op_key_extract (obj, false);
@@ -922,7 +1203,9 @@ static t_std_error nas_acl_entry_delete (cps_api_object_t obj,
                            sw.id(), table_id, entry_id);
 
         // Apply Delete to NDI and SAI
+        nas_acl_trace_span commit_trace ("Entry Commit", entry_id);
         entry.commit_delete (is_rollbk_op);
+        commit_trace.end ();
 
         // WARNING !!! CANNOT throw error or exception beyond this point
         // since entry is already deleted in SAI
@@ -932,7 +1215,9 @@ static t_std_error nas_acl_entry_delete (cps_api_object_t obj,
         }
 
         // Now save the entry in local cache. Also remove references to table/counter
+        nas_acl_trace_span save_trace ("Entry Save", entry_id);
         sw.remove_entry_from_table (table_id, entry_id);
+        save_trace.end ();
 
         NAS_ACL_LOG_BRIEF ("Entry Deletion successful. Switch Id: %d, "
                            "Table Id: %ld, Entry Id: %ld",
@@ -951,3 +1236,519 @@ static t_std_error nas_acl_entry_delete (cps_api_object_t obj,
     NAS_ACL_LOG_BRIEF ("Successful ");
     return NAS_ACL_E_NONE;
 }
+
+static bool _cps_sync_obj_table (cps_api_object_t obj, nas_switch_id_t& switch_id,
+                                 nas_obj_id_t& table_id)
+{
+    if (cps_api_key_get_subcat (cps_api_object_key (obj)) != BASE_ACL_ENTRY_OBJ ||
+        cps_api_object_type_operation (cps_api_object_key (obj)) != cps_api_oper_ACTION) {
+        return false;
+    }
+
+    if (!nas_acl_cps_key_get_switch_id (obj, NAS_ACL_SWITCH_ATTR, &switch_id)) {
+        return false;
+    }
+
+    if (nas_acl_cps_key_get_obj_id (obj, BASE_ACL_ENTRY_TABLE_ID, &table_id)) {
+        return true;
+    }
+
+    cps_api_object_attr_t name_attr = cps_api_get_key_data (obj, BASE_ACL_ENTRY_TABLE_NAME);
+    if (name_attr == nullptr) {
+        return false;
+    }
+    char* table_name = (char*)cps_api_object_attr_data_bin (name_attr);
+    nas_acl_table* table_p = nas_acl_get_switch (switch_id).find_table_by_name (table_name);
+    if (table_p == nullptr) {
+        return false;
+    }
+    table_id = table_p->table_id ();
+
+    return true;
+}
+
+struct entry_sync_item_t {
+    cps_api_object_t obj;
+    nas_acl_entry    entry;
+    nas_obj_id_t     cur_eid;   // Matching entry in cache, 0 if none
+};
+
+/* What a table sync changed, so that it can be put back */
+struct entry_sync_undo_t {
+    nas_switch_id_t             switch_id;
+    nas_obj_id_t                table_id;
+    std::vector<nas_obj_id_t>   created;
+    std::vector<nas_acl_entry>  modified;   // As they were before the sync
+    std::vector<nas_acl_entry>  deleted;
+};
+
+// Undo logs of the syncs in the current transaction, by their prev object.
+// Accessed with the NAS ACL lock held.
+static std::unordered_map<cps_api_object_t, entry_sync_undo_t> _entry_sync_undo;
+
+// Replace the rule of an entry with that of another one. Unlike a SET
+// parse, anything the other entry leaves out is cleared, not kept.
+static void _cps_entry_copy_rule (nas_acl_entry& entry, const nas_acl_entry& other)
+{
+    entry.set_priority (other.priority ());
+    if (other.entry_name () != nullptr) {
+        entry.set_entry_name (other.entry_name ());
+    }
+
+    entry.reset_filter ();
+    for (const auto& f_pair: other.get_filter_list ()) {
+        nas_acl_filter_t filter (f_pair.second);
+        filter.rebind_table (&entry.get_table ());
+        entry.add_filter (filter, false);
+    }
+
+    entry.reset_action ();
+    for (const auto& a_pair: other.get_action_list ()) {
+        nas_acl_action_t action (a_pair.second);
+        entry.add_action (action, false);
+    }
+
+    if (other.following_table_npus ()) {
+        entry.copy_table_npus ();
+    } else {
+        for (auto npu_id: other.nas::base_obj_t::npu_list ()) {
+            entry.add_npu (npu_id);
+        }
+    }
+}
+
+static void _cps_sync_undo (entry_sync_undo_t& undo) noexcept
+{
+    size_t failed = 0;
+
+    try {
+        nas_acl_switch& sw = nas_acl_get_switch (undo.switch_id);
+        nas_acl_table&  table = sw.get_table (undo.table_id);
+
+        // Reverse order of the sync: deleted entries come back first so
+        // that the table never holds fewer rules than before the sync
+        for (auto& old_entry: undo.deleted) {
+            try {
+                nas_acl_id_guard_t  idg (sw, BASE_ACL_ENTRY_OBJ, undo.table_id);
+                idg.reserve_guarded_id (old_entry.entry_id ());
+
+                nas_acl_entry entry (&table);
+                entry.set_entry_id (old_entry.entry_id ());
+                _cps_entry_copy_rule (entry, old_entry);
+                entry.commit_create (true);
+
+                sw.save_entry (std::move (entry));
+                idg.unguard ();
+            } catch (nas::base_exception& e) {
+                NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                                 e.err_fn.c_str (), e.err_msg.c_str ());
+                failed++;
+            }
+        }
+
+        for (auto& old_entry: undo.modified) {
+            try {
+                nas_acl_entry& cur_entry = sw.get_entry (undo.table_id, old_entry.entry_id ());
+                nas_acl_entry entry (cur_entry);
+
+                _cps_entry_copy_rule (entry, old_entry);
+                entry.commit_modify (cur_entry, true);
+                sw.save_entry (std::move (entry));
+            } catch (nas::base_exception& e) {
+                NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                                 e.err_fn.c_str (), e.err_msg.c_str ());
+                failed++;
+            }
+        }
+
+        for (auto entry_id: undo.created) {
+            try {
+                sw.get_entry (undo.table_id, entry_id).commit_delete (true);
+                sw.remove_entry_from_table (undo.table_id, entry_id);
+            } catch (nas::base_exception& e) {
+                NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                                 e.err_fn.c_str (), e.err_msg.c_str ());
+                failed++;
+            }
+        }
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        failed++;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Entry sync of Table %ld undone: %ld created, %ld modified, "
+                       "%ld deleted, %ld failed", undo.table_id, undo.created.size (),
+                       undo.modified.size (), undo.deleted.size (), failed);
+}
+
+/*
+ * Desired-state sync of a whole table.
+ * All Entry objects with the ACTION operation for the same table in one
+ * transaction form the complete set of entries wanted in that table.
+ * The set is applied along with the first of those objects - entries
+ * that are already in place are left untouched, missing ones are created,
+ * changed ones are modified and all other entries in the table are deleted.
+ * An object carrying neither Match nor Action list only marks the table,
+ * so that a table can also be synced to an empty set.
+ */
+t_std_error nas_acl_entry_table_sync (cps_api_transaction_params_t *param,
+                                      size_t                        index) noexcept
+{
+    nas_acl_intf_bind_guard bind_guard;
+
+    cps_api_object_t obj = cps_api_object_list_get (param->change_list, index);
+    cps_api_object_t prev = cps_api_object_list_get (param->prev, index);
+    nas_switch_id_t  switch_id;
+    nas_obj_id_t     table_id;
+    size_t           unchanged = 0;
+    entry_sync_undo_t undo;
+
+    try {
+        if (!_cps_sync_obj_table (obj, switch_id, table_id)) {
+            NAS_ACL_LOG_ERR ("Switch ID and Table ID/Name are mandatory keys for Entry sync");
+            return NAS_ACL_E_MISSING_KEY;
+        }
+
+        nas_acl_switch& sw = nas_acl_get_switch (switch_id);
+        nas_acl_table&  table = sw.get_table (table_id);
+
+        undo.switch_id = switch_id;
+        undo.table_id = table_id;
+
+        std::vector<cps_api_object_t> sync_objs;
+        size_t count = cps_api_object_list_size (param->change_list);
+
+        for (size_t ix = 0; ix < count; ix++) {
+            cps_api_object_t sync_obj = cps_api_object_list_get (param->change_list, ix);
+            nas_switch_id_t  sync_sw_id;
+            nas_obj_id_t     sync_tbl_id;
+
+            if (!_cps_sync_obj_table (sync_obj, sync_sw_id, sync_tbl_id) ||
+                sync_sw_id != switch_id || sync_tbl_id != table_id) {
+                continue;
+            }
+            if (ix < index) {
+                // Desired set for this table was already applied
+                return NAS_ACL_E_NONE;
+            }
+            sync_objs.push_back (sync_obj);
+        }
+
+        NAS_ACL_LOG_BRIEF ("Switch Id: %d, Table Id: %ld, Entry sync with %ld objects",
+                           switch_id, table_id, sync_objs.size ());
+
+        // Parse the complete desired set before touching NDI
+        std::vector<entry_sync_item_t> desired;
+        std::set<nas_obj_id_t> claimed;
+
+        for (auto sync_obj: sync_objs) {
+            if (cps_api_object_attr_get (sync_obj, BASE_ACL_ENTRY_MATCH) == nullptr &&
+                cps_api_object_attr_get (sync_obj, BASE_ACL_ENTRY_ACTION) == nullptr) {
+                continue;
+            }
+
+            desired.push_back ({sync_obj, nas_acl_entry {&table}, 0});
+            auto& item = desired.back ();
+            _cps_parse_entry_obj (sync_obj, item.entry, cps_api_oper_CREATE);
+
+            nas_acl_entry* cur_p = nullptr;
+            nas_obj_id_t   entry_id;
+            if (nas_acl_cps_key_get_obj_id (sync_obj, BASE_ACL_ENTRY_ID, &entry_id)) {
+                cur_p = sw.find_entry (table_id, entry_id);
+            } else if (item.entry.entry_name () != nullptr) {
+                cur_p = sw.find_entry_by_name (table_id, item.entry.entry_name ());
+            } else {
+                for (auto& entry_pair: sw.entry_list (table_id)) {
+                    if (claimed.count (entry_pair.first) == 0 &&
+                        entry_pair.second.entry_name () == nullptr &&
+                        item.entry.is_same_rule (entry_pair.second)) {
+                        cur_p = sw.find_entry (table_id, entry_pair.first);
+                        break;
+                    }
+                }
+            }
+
+            if (cur_p != nullptr) {
+                if (!claimed.insert (cur_p->entry_id ()).second) {
+                    throw nas::base_exception {NAS_ACL_E_DUPLICATE, __FUNCTION__,
+                        std::string {"Entry "} + std::to_string (cur_p->entry_id ())
+                        + " appears more than once in desired set"};
+                }
+                item.cur_eid = cur_p->entry_id ();
+            }
+        }
+
+        // Make before break - new rules are programmed first,
+        // stale rules are removed last. So new rules need room
+        // while the stale ones are still in the table.
+        size_t new_count = 0;
+        for (auto& item: desired) {
+            if (item.cur_eid == 0) new_count++;
+        }
+        if (new_count > 0) {
+            auto rc = nas_acl_table_fit_check (switch_id, table_id, new_count, nullptr);
+            if (rc != NAS_ACL_E_NONE) {
+                return rc;
+            }
+        }
+
+        for (auto& item: desired) {
+            if (item.cur_eid != 0) continue;
+
+            nas_obj_id_t entry_id;
+            nas_acl_id_guard_t  idg (sw, BASE_ACL_ENTRY_OBJ, table_id);
+            if (nas_acl_cps_key_get_obj_id (item.obj, BASE_ACL_ENTRY_ID, &entry_id)) {
+                idg.reserve_guarded_id (entry_id);
+            } else {
+                entry_id = idg.alloc_guarded_id ();
+            }
+            item.entry.set_entry_id (entry_id);
+            item.entry.commit_create (false);
+
+            // Entry is in SAI from here on, the undo log deletes it on failure
+            sw.save_entry (std::move (item.entry));
+            idg.unguard ();
+            claimed.insert (entry_id);
+            undo.created.push_back (entry_id);
+            _entry_write_stats.create_count++;
+        }
+
+        for (auto& item: desired) {
+            if (item.cur_eid == 0) continue;
+
+            nas_acl_entry& old_entry = sw.get_entry (table_id, item.cur_eid);
+            _entry_write_stats.modify_count++;
+            if (old_entry.is_same_rule (item.entry)) {
+                _entry_write_stats.modify_elided++;
+                unchanged++;
+                continue;
+            }
+
+            // Target is the desired entry as a Create would build it, so
+            // that the cached entry ends up the same as the desired one
+            nas_acl_entry new_entry (old_entry);
+            _cps_entry_copy_rule (new_entry, item.entry);
+            new_entry.commit_modify (old_entry, false);
+
+            // Entry is changed in SAI, the undo log restores it on failure
+            undo.modified.push_back (old_entry);
+            sw.save_entry (std::move (new_entry));
+        }
+
+        std::vector<nas_obj_id_t> stale;
+        for (auto& entry_pair: sw.entry_list (table_id)) {
+            if (claimed.count (entry_pair.first) == 0) {
+                stale.push_back (entry_pair.first);
+            }
+        }
+        for (auto entry_id: stale) {
+            nas_acl_entry& old_entry = sw.get_entry (table_id, entry_id);
+            old_entry.commit_delete (false);
+
+            // Entry is deleted in SAI, the undo log recreates it on failure
+            undo.deleted.push_back (old_entry);
+            sw.remove_entry_from_table (table_id, entry_id);
+        }
+
+    } catch (nas::base_exception& e) {
+
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        NAS_ACL_LOG_ERR ("Entry sync stopped after %ld created, %ld modified, "
+                         "%ld deleted", undo.created.size (), undo.modified.size (),
+                         undo.deleted.size ());
+        _cps_sync_undo (undo);
+        return e.err_code;
+
+    } catch (std::out_of_range& e) {
+        NAS_ACL_LOG_ERR ("###########  Out of Range exception %s", e.what ());
+        _cps_sync_undo (undo);
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Entry sync successful. Table Id: %ld, %ld created, "
+                       "%ld modified, %ld deleted, %ld unchanged",
+                       table_id, undo.created.size (), undo.modified.size (),
+                       undo.deleted.size (), unchanged);
+
+    if (prev != NULL) {
+        // Kept for the rollback of the transaction
+        _entry_sync_undo [prev] = std::move (undo);
+    }
+    return NAS_ACL_E_NONE;
+}
+
+t_std_error nas_acl_entry_table_sync_rollback (cps_api_object_t prev) noexcept
+{
+    auto it = _entry_sync_undo.find (prev);
+    if (it == _entry_sync_undo.end ()) {
+        // Sync was applied along with an earlier object of the transaction
+        return NAS_ACL_E_NONE;
+    }
+
+    _cps_sync_undo (it->second);
+    _entry_sync_undo.erase (it);
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_entry_table_sync_done () noexcept
+{
+    _entry_sync_undo.clear ();
+}
+
+/*
+ * Count new entries per table over the complete change list of a
+ * transaction, and check them against the table free space. Deletes of
+ * entries in the same table in the transaction are counted as room.
+ */
+t_std_error nas_acl_entry_batch_fit_check (cps_api_transaction_params_t *param) noexcept
+{
+    std::map<std::pair<nas_switch_id_t, nas_obj_id_t>, long> new_entries;
+    size_t count = cps_api_object_list_size (param->change_list);
+
+    for (size_t ix = 0; ix < count; ix++) {
+        cps_api_object_t obj = cps_api_object_list_get (param->change_list, ix);
+        if (obj == NULL ||
+            cps_api_key_get_cat (cps_api_object_key (obj)) != cps_api_obj_CAT_BASE_ACL ||
+            cps_api_key_get_subcat (cps_api_object_key (obj)) != BASE_ACL_ENTRY_OBJ) {
+            continue;
+        }
+
+        auto op = cps_api_object_type_operation (cps_api_object_key (obj));
+        if (op != cps_api_oper_CREATE && op != cps_api_oper_DELETE) {
+            continue;
+        }
+
+        try {
+            auto key = _cps_extract_key (obj, (op == cps_api_oper_CREATE));
+            if (!key.has_switch_id || !key.has_table_id ||
+                key.has_match_type || key.has_action_type) {
+                continue;
+            }
+
+            nas_acl_switch& s = nas_acl_get_switch (key.switch_id);
+            bool exists = (key.has_entry_id &&
+                           s.find_entry (key.table_id, key.entry_id) != NULL);
+
+            if (op == cps_api_oper_CREATE && !exists) {
+                new_entries[{key.switch_id, key.table_id}]++;
+            } else if (op == cps_api_oper_DELETE && exists) {
+                new_entries[{key.switch_id, key.table_id}]--;
+            }
+        } catch (...) {
+            // Key errors are reported by the Create/Delete handler
+        }
+    }
+
+    for (const auto& tbl: new_entries) {
+        if (tbl.second <= 0) continue;
+
+        auto rc = nas_acl_table_fit_check (tbl.first.first, tbl.first.second,
+                                           (size_t) tbl.second, nullptr);
+        if (rc != NAS_ACL_E_NONE) {
+            return rc;
+        }
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_entry_batch_prepare (cps_api_transaction_params_t *param) noexcept
+{
+    // Whatever an earlier transaction did not use is stale
+    _entry_prepared.clear ();
+
+    std::vector<cps_api_object_t> objs;
+    size_t count = cps_api_object_list_size (param->change_list);
+
+    try {
+        for (size_t ix = 0; ix < count; ix++) {
+            cps_api_object_t obj = cps_api_object_list_get (param->change_list, ix);
+            uint32_t type;
+
+            if (obj == NULL ||
+                cps_api_key_get_cat (cps_api_object_key (obj)) != cps_api_obj_CAT_BASE_ACL ||
+                cps_api_key_get_subcat (cps_api_object_key (obj)) != BASE_ACL_ENTRY_OBJ ||
+                cps_api_object_type_operation (cps_api_object_key (obj)) != cps_api_oper_CREATE) {
+                continue;
+            }
+            // Incremental filter or action updates apply to an existing entry
+            if (nas_acl_cps_key_get_u32 (obj, BASE_ACL_ENTRY_MATCH_TYPE, &type) ||
+                nas_acl_cps_key_get_u32 (obj, BASE_ACL_ENTRY_ACTION_TYPE, &type)) {
+                continue;
+            }
+            objs.push_back (obj);
+        }
+
+        if (objs.size () < NAS_ACL_PREPARE_MIN_ENTRIES) {
+            return;
+        }
+
+        std::vector<entry_prepared_t> preps (objs.size ());
+        std::vector<char> parsed (objs.size (), 0);
+        std::atomic<size_t> next {0};
+
+        auto worker = [&objs, &preps, &parsed, &next] () {
+            size_t ix;
+            while ((ix = next.fetch_add (1, std::memory_order_relaxed)) < objs.size ()) {
+                parsed [ix] = _cps_prepare_entry_obj (objs [ix], preps [ix]);
+            }
+        };
+
+        size_t num_threads = std::min<size_t> ({std::max (std::thread::hardware_concurrency (), 1u),
+                                               NAS_ACL_PREPARE_MAX_THREADS,
+                                               objs.size () / NAS_ACL_PREPARE_MIN_ENTRIES});
+        std::vector<std::thread> threads;
+        try {
+            for (size_t t = 1; t < num_threads; t++) {
+                threads.emplace_back (worker);
+            }
+        } catch (std::exception& e) {
+            // Fewer threads only make it slower
+            NAS_ACL_LOG_BRIEF ("Entry parse runs on %zu threads: %s",
+                               threads.size () + 1, e.what ());
+        }
+        worker ();
+        for (auto& thread: threads) {
+            thread.join ();
+        }
+
+        for (size_t ix = 0; ix < objs.size (); ix++) {
+            if (parsed [ix]) {
+                _entry_prepared.emplace (objs [ix], std::move (preps [ix]));
+            }
+        }
+        NAS_ACL_LOG_DETAIL ("Parsed %zu of %zu Entry Creates on %zu threads",
+                            _entry_prepared.size (), objs.size (), threads.size () + 1);
+
+    } catch (std::exception& e) {
+        // The Create handlers parse the objects themselves
+        NAS_ACL_LOG_ERR ("Entry batch parse failed: %s", e.what ());
+        _entry_prepared.clear ();
+    }
+}
+
+void nas_acl_entry_batch_done () noexcept
+{
+    _entry_prepared.clear ();
+}
+
+void nas_acl_entry_write_stats_get (nas_acl_write_stats_t* stats_p) noexcept
+{
+    nas_acl_lock ();
+    *stats_p = _entry_write_stats;
+    nas_acl_unlock ();
+}
+
+void dump_entry_write_stats (void)
+{
+    nas_acl_write_stats_t stats;
+
+    nas_acl_entry_write_stats_get (&stats);
+    NAS_ACL_LOG_DUMP ("Entry Create: %" PRIu64 " (elided %" PRIu64 ")",
+                      stats.create_count, stats.create_elided);
+    NAS_ACL_LOG_DUMP ("Entry Modify: %" PRIu64 " (elided %" PRIu64 ")",
+                      stats.modify_count, stats.modify_elided);
+    NAS_ACL_LOG_DUMP ("Entry Create parsed ahead: %" PRIu64, stats.create_prepared);
+}
@@ -26,6 +26,9 @@
 #include "nas_acl_cps.h"
 #include "nas_base_utils.h"
 #include <netinet/in.h>
+#include <functional>
+
+typedef std::function<void (BASE_ACL_MATCH_TYPE_t, nas::attr_list_t&)> nas_acl_match_fn_t;
 
 // Common function called for both Full ACL Entry update and Incremental update
 // In the case of Full ACL Entry update the parent_list will already have
@@ -34,11 +37,10 @@
 //
 // This function will add the Match-Value-Attr to the parent_list hieraerchy.
 //
-void nas_acl_set_match_attr (const cps_api_object_t     obj,
-                             nas_acl_entry&             entry,
-                             BASE_ACL_MATCH_TYPE_t      match_type_val,
-                             nas::attr_list_t           parent_attr_id_list,
-                             bool                       reset)
+nas_acl_filter_t nas_acl_parse_match_attr (const cps_api_object_t     obj,
+                                           const nas_acl_table*       table_p,
+                                           BASE_ACL_MATCH_TYPE_t      match_type_val,
+                                           nas::attr_list_t           parent_attr_id_list)
 {
 
     auto map_kv = nas_acl_get_filter_map().find (match_type_val);
@@ -51,7 +53,7 @@ void nas_acl_set_match_attr (const cps_api_object_t     obj,
     }
 
     const nas_acl_filter_info_t& map_info = map_kv->second;
-    nas_acl_filter_t filter {&entry.get_table(), match_type_val};
+    nas_acl_filter_t filter {table_p, match_type_val};
 
     if (map_info.val.data_type != NAS_ACL_DATA_NONE) {
 
@@ -63,12 +65,23 @@ void nas_acl_set_match_attr (const cps_api_object_t     obj,
 
         (filter.*(map_info.set_fn)) (common_data_list);
     }
+    return filter;
+}
+
+void nas_acl_set_match_attr (const cps_api_object_t     obj,
+                             nas_acl_entry&             entry,
+                             BASE_ACL_MATCH_TYPE_t      match_type_val,
+                             nas::attr_list_t           parent_attr_id_list,
+                             bool                       reset)
+{
+    auto filter = nas_acl_parse_match_attr (obj, &entry.get_table(), match_type_val,
+                                            parent_attr_id_list);
     entry.add_filter (filter, reset);
 }
 
-void nas_acl_set_match_list (const cps_api_object_t     obj,
-                             const cps_api_object_it_t& it,
-                             nas_acl_entry&             entry)
+static void _match_list_walk (const cps_api_object_t     obj,
+                              const cps_api_object_it_t& it,
+                              const nas_acl_match_fn_t&  fn)
 {
     /*
      * Encoding of ACL Entry Match parameters, with the following
@@ -190,11 +203,32 @@ void nas_acl_set_match_list (const cps_api_object_t     obj,
         NAS_ACL_LOG_DETAIL ("match_type_val: %d (%s)", match_type_val,
                             nas_acl_filter_t::type_name (match_type_val));
 
-        nas_acl_set_match_attr (obj, entry, match_type_val,
-                                parent_attr_id_list, true);
+        fn (match_type_val, parent_attr_id_list);
     }
 }
 
+void nas_acl_set_match_list (const cps_api_object_t     obj,
+                             const cps_api_object_it_t& it,
+                             nas_acl_entry&             entry)
+{
+    _match_list_walk (obj, it, [&obj, &entry] (BASE_ACL_MATCH_TYPE_t match_type_val,
+                                               nas::attr_list_t& parent_attr_id_list) {
+        nas_acl_set_match_attr (obj, entry, match_type_val, parent_attr_id_list, true);
+    });
+}
+
+void nas_acl_parse_match_list (const cps_api_object_t         obj,
+                               const cps_api_object_it_t&     it,
+                               const nas_acl_table*           table_p,
+                               std::vector<nas_acl_filter_t>& filters)
+{
+    _match_list_walk (obj, it, [&obj, table_p, &filters] (BASE_ACL_MATCH_TYPE_t match_type_val,
+                                                          nas::attr_list_t& parent_attr_id_list) {
+        filters.push_back (nas_acl_parse_match_attr (obj, table_p, match_type_val,
+                                                     parent_attr_id_list));
+    });
+}
+
 bool nas_acl_fill_match_attr (cps_api_object_t obj,
                               const nas_acl_filter_t& filter,
                               BASE_ACL_MATCH_TYPE_t      match_type_val,
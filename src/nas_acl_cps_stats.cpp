@@ -25,10 +25,32 @@
 #include "nas_acl_log.h"
 #include "nas_acl_switch_list.h"
 #include "nas_acl_cps.h"
+#include "nas_acl_stats.h"
 #include "nas_base_utils.h"
 #include "cps_api_object_key.h"
 #include "cps_class_map.h"
 #include "nas_acl_cps_key.h"
+#include <mutex>
+
+// Write the counts to the counter in hardware, on all its NPUs
+// or on those of the NPU filter
+static void _stats_counter_write_ndi (const nas_acl_counter_t& counter,
+                                      const nas::npu_set_t& filt_npu_list,
+                                      bool is_pkt_count_set, uint64_t pkt_count,
+                                      bool is_byte_count_set, uint64_t byte_count)
+{
+    const nas::npu_set_t& loop_npu = (filt_npu_list.empty()) ? counter.npu_list(): filt_npu_list;
+    for (auto npu_id: loop_npu) {
+
+        if (is_pkt_count_set) {
+            counter.set_pkt_count_ndi(npu_id,  pkt_count);
+        }
+        if (is_byte_count_set) {
+            counter.set_byte_count_ndi(npu_id, byte_count);
+        }
+    }
+    nas_acl_stats_cache_forget (counter);
+}
 
 static t_std_error nas_acl_stats_set (cps_api_object_t obj,
                                       cps_api_object_t prev,
@@ -135,7 +157,8 @@ static bool _extract_stats_attrs (cps_api_object_t obj,
 
 t_std_error nas_acl_stats_info_get (cps_api_get_params_t *param,
                                     size_t                index,
-                                    const nas_acl_counter_t&  counter) noexcept
+                                    const nas_acl_counter_t&  counter,
+                                    uint32_t              max_age_ms) noexcept
 {
     cps_api_object_t obj;
     nas::npu_set_t  filtr_npu_list;
@@ -172,8 +195,8 @@ t_std_error nas_acl_stats_info_get (cps_api_get_params_t *param,
     bool byte_valid, pkt_valid;
     for (auto npu_id: loop_npu) {
 
-        if (counter.get_count_ndi(npu_id, byte_valid, &byte_count,
-                                  pkt_valid, &pkt_count) != NAS_ACL_E_NONE) {
+        if (nas_acl_stats_cached_get (counter, npu_id, max_age_ms, byte_valid, &byte_count,
+                                      pkt_valid, &pkt_count) != NAS_ACL_E_NONE) {
             return NAS_ACL_E_FAIL;
         }
 
@@ -218,6 +241,181 @@ t_std_error nas_acl_stats_info_get (cps_api_get_params_t *param,
     return NAS_ACL_E_NONE;
 }
 
+bool nas_acl_stats_top_filter (cps_api_object_t filter_obj,
+                               size_t* count_p, bool* by_bytes_p) noexcept
+{
+    if (filter_obj == NULL) return false;
+
+    for (auto attr_id: {NAS_ACL_STATS_TOP_PKTS_ATTR, NAS_ACL_STATS_TOP_BYTES_ATTR}) {
+        cps_api_object_attr_t attr = cps_api_object_attr_get (filter_obj, attr_id);
+        if (attr == NULL) continue;
+
+        if (cps_api_object_attr_len (attr) != sizeof (uint32_t)) {
+            NAS_ACL_LOG_ERR ("Top-N count of Stats GET is not u32, ignored");
+            continue;
+        }
+        uint32_t count = cps_api_object_attr_data_u32 (attr);
+        if (count == 0) continue;
+
+        *count_p = count;
+        *by_bytes_p = (attr_id == NAS_ACL_STATS_TOP_BYTES_ATTR);
+        return true;
+    }
+    return false;
+}
+
+t_std_error nas_acl_get_stats_top (cps_api_get_params_t *param, size_t index,
+                                   size_t count, bool by_bytes) noexcept
+{
+    std::vector<nas_acl_stats_top_t> top;
+
+    t_std_error rc = nas_acl_stats_top_get (count, by_bytes, top);
+    if (rc != NAS_ACL_E_NONE) return rc;
+
+    NAS_ACL_LOG_BRIEF ("GET top %ld Stats by %s: %ld counters",
+                       count, (by_bytes) ? "bytes" : "packets", top.size ());
+
+    for (const auto& t: top) {
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (t.switch_id);
+            const nas_acl_counter_t& counter = s.get_counter (t.table_id, t.counter_id);
+
+            rc = nas_acl_stats_info_get (param, index, counter,
+                                         nas_acl_stats_max_age_get ());
+            if (rc != NAS_ACL_E_NONE) return rc;
+
+        } catch (nas::base_exception& e) {
+            // Deleted since the last poll
+            continue;
+        }
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
+// Connection to the CPS event service used by the change stream
+static std::mutex                      _stats_event_mutex;
+static cps_api_event_service_handle_t  _stats_event_handle = nullptr;
+
+t_std_error nas_acl_stats_event_connect (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_event_mutex);
+
+    if (_stats_event_handle != nullptr) {
+        return NAS_ACL_E_NONE;
+    }
+
+    if (cps_api_event_service_init () != cps_api_ret_code_OK) {
+        NAS_ACL_LOG_ERR ("CPS event service init failed");
+        return NAS_ACL_E_FAIL;
+    }
+
+    if (cps_api_event_client_connect (&_stats_event_handle) != cps_api_ret_code_OK) {
+        NAS_ACL_LOG_ERR ("CPS event service connect failed for Stats events");
+        _stats_event_handle = nullptr;
+        return NAS_ACL_E_FAIL;
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
+// Start an event for the changed counters of a table
+static bool nas_acl_stats_event_init (cps_api_object_t obj, nas_switch_id_t switch_id,
+                                      nas_obj_id_t table_id) noexcept
+{
+    if (!cps_api_key_from_attr_with_qual (cps_api_object_key (obj),
+                                          BASE_ACL_STATS_OBJ,
+                                          cps_api_qualifier_OBSERVED)) {
+        NAS_ACL_LOG_ERR ("Failed to create Key from Stats Object");
+        return false;
+    }
+
+    // Subscribers on more than one switch tell the tables apart by it
+    if (!nas_acl_cps_key_set_u32 (obj, BASE_ACL_STATS_SWITCH_ID, switch_id)) {
+        NAS_ACL_LOG_ERR ("Failed to set Switch ID in Key");
+        return false;
+    }
+
+    if (!nas_acl_cps_key_set_obj_id (obj, BASE_ACL_STATS_TABLE_ID, table_id)) {
+        NAS_ACL_LOG_ERR ("Failed to set Table ID in Key");
+        return false;
+    }
+
+    return true;
+}
+
+static bool nas_acl_stats_event_add (cps_api_object_t obj, size_t index,
+                                     const nas_acl_stats_delta_t& delta) noexcept
+{
+    cps_api_attr_id_t ids[3] = {BASE_ACL_STATS_OBJ, index, BASE_ACL_STATS_COUNTER_ID};
+    const int ids_len = sizeof (ids)/sizeof (ids[0]);
+
+    if (!cps_api_object_e_add (obj, ids, ids_len, cps_api_object_ATTR_T_U64,
+                               &delta.counter_id, sizeof (uint64_t))) {
+        return false;
+    }
+
+    ids[2] = BASE_ACL_STATS_MATCHED_PACKETS;
+    if (!cps_api_object_e_add (obj, ids, ids_len, cps_api_object_ATTR_T_U64,
+                               &delta.pkt_count, sizeof (uint64_t))) {
+        return false;
+    }
+
+    ids[2] = BASE_ACL_STATS_MATCHED_BYTES;
+    return cps_api_object_e_add (obj, ids, ids_len, cps_api_object_ATTR_T_U64,
+                                 &delta.byte_count, sizeof (uint64_t));
+}
+
+// Deltas come sorted by switch and table. Each event carries the
+// changed counters of one table, at most NAS_ACL_STATS_EVENT_BATCH.
+size_t nas_acl_stats_publish_deltas (const std::vector<nas_acl_stats_delta_t>& deltas) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_event_mutex);
+    size_t published = 0;
+
+    if (_stats_event_handle == nullptr) {
+        NAS_ACL_LOG_ERR ("Stats events published without an event service connection");
+        return 0;
+    }
+
+    for (size_t start = 0; start < deltas.size ();) {
+        const auto& first = deltas[start];
+        size_t end = start;
+
+        while (end < deltas.size () && end - start < NAS_ACL_STATS_EVENT_BATCH &&
+               deltas[end].switch_id == first.switch_id &&
+               deltas[end].table_id == first.table_id) {
+            end++;
+        }
+
+        cps_api_object_t obj = cps_api_object_create ();
+
+        if (obj == NULL) {
+            NAS_ACL_LOG_ERR ("Stats event object create failed");
+            break;
+        }
+
+        cps_api_object_guard obj_guard (obj);
+        bool filled = nas_acl_stats_event_init (obj, first.switch_id, first.table_id);
+
+        for (size_t ix = start; filled && ix < end; ix++) {
+            filled = nas_acl_stats_event_add (obj, ix - start, deltas[ix]);
+        }
+
+        if (!filled) {
+            NAS_ACL_LOG_ERR ("Stats event fill failed for Table %ld", first.table_id);
+        } else if (cps_api_event_publish (_stats_event_handle, obj) != cps_api_ret_code_OK) {
+            NAS_ACL_LOG_ERR ("Stats event publish failed for Table %ld, %ld counters",
+                             first.table_id, end - start);
+        } else {
+            published++;
+        }
+        start = end;
+    }
+
+    return published;
+}
+
 static t_std_error nas_acl_stats_set (cps_api_object_t obj,
                                      cps_api_object_t prev,
                                      bool             rollback) noexcept
@@ -261,9 +459,29 @@ static t_std_error nas_acl_stats_set (cps_api_object_t obj,
             table_id = table_p->table_id();
         }
 
+        // Zero counts can be cleared in software, without NDI writes.
+        // Only a count given as zero clears, never a missing one.
+        bool is_clear = ((is_pkt_count_set || is_byte_count_set) &&
+                         (!is_pkt_count_set || pkt_count == 0) &&
+                         (!is_byte_count_set || byte_count == 0));
+
         if (!nas_acl_cps_key_get_obj_id (obj, BASE_ACL_STATS_COUNTER_ID, &counter_id)) {
             cps_api_object_attr_t cnt_name_attr = cps_api_get_key_data(obj,
                                                             BASE_ACL_STATS_COUNTER_NAME);
+            if (cnt_name_attr == nullptr && is_clear) {
+                // Table key only - clear all counters of the table
+                NAS_ACL_LOG_BRIEF ("Switch Id: %d, Table Id: %ld, Clear all Stats",
+                                   switch_id, table_id);
+                if (nas_acl_stats_soft_clear_get ()) {
+                    return nas_acl_stats_table_clear (sw.get_table (table_id));
+                }
+                for (const auto& counter_kvp: sw.counter_list (table_id)) {
+                    _stats_counter_write_ndi (counter_kvp.second, filt_npu_list,
+                                              is_pkt_count_set, 0, is_byte_count_set, 0);
+                }
+                NAS_ACL_LOG_BRIEF ("Successful ");
+                return NAS_ACL_E_NONE;
+            }
             if (cnt_name_attr == nullptr) {
                 NAS_ACL_LOG_ERR ("No Counter ID of Name found for Stats Modify");
                 return NAS_ACL_E_MISSING_KEY;
@@ -282,17 +500,14 @@ static t_std_error nas_acl_stats_set (cps_api_object_t obj,
 
         auto& counter = sw.get_counter(table_id, counter_id);
 
-        const nas::npu_set_t& loop_npu = (filt_npu_list.empty()) ? counter.npu_list(): filt_npu_list;
-        for (auto npu_id: loop_npu) {
-
-            if (is_pkt_count_set) {
-                counter.set_pkt_count_ndi(npu_id,  pkt_count);
-            }
-            if (is_byte_count_set) {
-                counter.set_byte_count_ndi(npu_id, byte_count);
-            }
+        if (is_clear && nas_acl_stats_soft_clear_get ()) {
+            return nas_acl_stats_counter_clear (counter, filt_npu_list,
+                                                is_pkt_count_set, is_byte_count_set);
         }
 
+        _stats_counter_write_ndi (counter, filt_npu_list,
+                                  is_pkt_count_set, pkt_count, is_byte_count_set, byte_count);
+
     } catch (nas::base_exception& e) {
 
         NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
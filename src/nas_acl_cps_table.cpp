@@ -30,6 +30,13 @@
 #include "nas_acl_utl.h"
 #include "nas_acl_cps_key.h"
 #include "nas_acl_switch_list.h"
+#include <stdint.h>
+
+// Number of objects torn down from a retired table generation
+// each time the ACL lock is taken
+static const size_t NAS_ACL_RETIRE_BATCH_SIZE = 64;
+// Attempts at a failing batch before the teardown is left for an abort
+static const size_t NAS_ACL_RETIRE_RETRIES = 3;
 
 static t_std_error
 nas_acl_table_create (cps_api_object_t obj,
@@ -41,9 +48,15 @@ nas_acl_table_delete (cps_api_object_t obj,
                       cps_api_object_t prev,
                       bool             is_rollbk_op) noexcept;
 
+static t_std_error
+nas_acl_table_fit_query (cps_api_object_t obj,
+                         cps_api_object_t prev,
+                         bool             is_rollbk_op) noexcept;
+
 static nas_acl_write_operation_map_t nas_acl_table_op_map [] = {
     {cps_api_oper_CREATE, nas_acl_table_create},
     {cps_api_oper_DELETE, nas_acl_table_delete},
+    {cps_api_oper_ACTION, nas_acl_table_fit_query},
 };
 
 nas_acl_write_operation_map_t *
@@ -563,6 +576,7 @@ t_std_error nas_acl_table_delete (cps_api_object_t obj,
         // since table is already deleted from SAI
 
         s.remove_table (table_id);
+        nas_acl_table_fit_forget (switch_id, table_id);
 
     } catch (nas::base_exception& e) {
 
@@ -578,3 +592,310 @@ t_std_error nas_acl_table_delete (cps_api_object_t obj,
     return NAS_ACL_E_NONE;
 }
 
+/*
+ * "Will it fit" query - Action on Table object with Table Size attribute
+ * set to the number of new entries. Fails if the entries do not fit,
+ * and returns the estimated free entry count in the Table Size attribute.
+ */
+static
+t_std_error nas_acl_table_fit_query (cps_api_object_t obj,
+                                     cps_api_object_t prev,
+                                     bool             is_rollbk_op) noexcept
+{
+    nas_switch_id_t       switch_id;
+    nas_obj_id_t          table_id;
+    size_t                entry_count = 1;
+    size_t                free_cnt = 0;
+
+    if (is_rollbk_op) {
+        // Query does not change any state
+        return NAS_ACL_E_NONE;
+    }
+
+    if (prev != NULL) {
+        cps_api_object_set_key (prev, cps_api_object_key (obj));
+    }
+
+    if (!nas_acl_cps_key_get_switch_id (obj, NAS_ACL_SWITCH_ATTR,
+                                        &switch_id)) {
+        NAS_ACL_LOG_ERR ("Switch ID is a mandatory key for Table fit query");
+        return NAS_ACL_E_MISSING_KEY;
+    }
+
+    try {
+        nas_acl_switch& s = nas_acl_get_switch (switch_id);
+
+        if (!nas_acl_cps_key_get_obj_id (obj, BASE_ACL_TABLE_ID, &table_id)) {
+            cps_api_object_attr_t name_attr = cps_api_get_key_data(obj,
+                                                                   BASE_ACL_TABLE_NAME);
+            if (name_attr == nullptr) {
+                NAS_ACL_LOG_ERR ("Table ID or Name is mandatory key for Table fit query");
+                return NAS_ACL_E_MISSING_KEY;
+            }
+            char* table_name = (char*)cps_api_object_attr_data_bin(name_attr);
+            nas_acl_table* table_p = s.find_table_by_name(table_name);
+            if (table_p == nullptr) {
+                NAS_ACL_LOG_ERR ("Could not find ACL Table");
+                return NAS_ACL_E_MISSING_KEY;
+            }
+            table_id = table_p->table_id();
+        }
+
+        cps_api_object_attr_t size_attr = cps_api_object_attr_get (obj, BASE_ACL_TABLE_SIZE);
+        if (size_attr != nullptr) {
+            entry_count = cps_api_object_attr_data_u32 (size_attr);
+        }
+
+        NAS_ACL_LOG_BRIEF ("Switch Id: %d Table Id %ld, fit query for %ld entries",
+                           switch_id, table_id, entry_count);
+
+        auto rc = nas_acl_table_fit_check (switch_id, table_id, entry_count, &free_cnt);
+
+        if (free_cnt > UINT32_MAX) {
+            free_cnt = UINT32_MAX;
+        }
+        cps_api_object_attr_delete (obj, BASE_ACL_TABLE_SIZE);
+        cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_SIZE, (uint32_t) free_cnt);
+
+        return rc;
+
+    } catch (nas::base_exception& e) {
+
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+
+        return e.err_code;
+    }
+}
+
+/*
+ * Tear down a table generation that is no longer live, releasing the lock
+ * between batches so that CPS requests are not held up by a large table.
+ * A failed batch is tried again. If it keeps failing, what is left stays
+ * registered as a shadow of its owner so that an abort can retry it.
+ */
+static t_std_error _cps_table_retire (nas_switch_id_t switch_id,
+                                      nas_obj_id_t    owner_id,
+                                      nas_obj_id_t    table_id) noexcept
+{
+    t_std_error rc = NAS_ACL_E_NONE;
+    size_t      failures = 0;
+    bool        pending = true;
+
+    while (pending) {
+        nas_acl_lock ();
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (switch_id);
+            rc = s.retire_table_generation (table_id,
+                                            NAS_ACL_RETIRE_BATCH_SIZE, &pending);
+            if (rc != NAS_ACL_E_NONE && ++failures >= NAS_ACL_RETIRE_RETRIES) {
+                s.add_shadow_table (owner_id, table_id);
+                pending = false;
+            }
+        } catch (nas::base_exception& e) {
+            NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                             e.err_fn.c_str (), e.err_msg.c_str ());
+            rc = e.err_code;
+            pending = false;
+        }
+        nas_acl_unlock ();
+    }
+
+    if (rc != NAS_ACL_E_NONE) {
+        NAS_ACL_LOG_ERR ("Switch Id: %d, Table %ld not fully deleted, "
+                         "abort it as a shadow of Table %ld to retry",
+                         switch_id, table_id, owner_id);
+    }
+    return rc;
+}
+
+/*
+ * Install the staged entries of a shadow table. On failure the entries
+ * installed so far are taken out again and the shadow stays staged.
+ */
+static void _cps_table_shadow_install (nas_acl_switch& s, nas_acl_table& shadow)
+{
+    nas_obj_id_t shadow_id = shadow.table_id ();
+
+    shadow.set_staged (false);
+
+    try {
+        for (const auto& entry_pair: s.entry_list (shadow_id)) {
+            auto& entry = s.get_entry (shadow_id, entry_pair.first);
+
+            for (auto npu_id: entry.npu_list ()) {
+                if (!entry.push_create_obj_to_npu (npu_id, nullptr)) {
+                    throw nas::base_exception {NAS_ACL_E_FAIL, __FUNCTION__,
+                        std::string {"Install failed for Entry "} +
+                        std::to_string (entry.entry_id ())};
+                }
+            }
+        }
+    } catch (nas::base_exception& e) {
+        for (const auto& entry_pair: s.entry_list (shadow_id)) {
+            auto& entry = s.get_entry (shadow_id, entry_pair.first);
+
+            for (auto npu_id: entry.npu_list ()) {
+                if (!entry.is_installed_to_npu (npu_id)) continue;
+                try {
+                    entry.push_delete_obj_to_npu (npu_id);
+                } catch (nas::base_exception& del_e) {
+                    NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", del_e.err_code,
+                                     del_e.err_fn.c_str (), del_e.err_msg.c_str ());
+                }
+            }
+        }
+        shadow.set_staged (true);
+        throw;
+    }
+}
+
+t_std_error nas_acl_table_shadow_create (nas_switch_id_t switch_id,
+                                         nas_obj_id_t    table_id,
+                                         nas_obj_id_t*   shadow_id_p) noexcept
+{
+    t_std_error rc = NAS_ACL_E_NONE;
+
+    nas_acl_lock ();
+
+    try {
+        nas_acl_switch& s = nas_acl_get_switch (switch_id);
+        nas_acl_table& live_table = s.get_table (table_id);
+
+        if (s.shadow_table_owner (table_id) != 0) {
+            throw nas::base_exception {NAS_ACL_E_INCONSISTENT, __FUNCTION__,
+                "Cannot create shadow of a shadow table"};
+        }
+
+        // Clone all create-only attributes of the live table.
+        // Name is left out since it has to stay unique to the live table.
+        nas_acl_table tmp_table (&s);
+
+        tmp_table.set_stage (live_table.stage ());
+        tmp_table.set_priority (live_table.priority ());
+        tmp_table.set_table_size (live_table.table_size ());
+        for (auto filter: live_table.allowed_filters ()) {
+            tmp_table.set_allowed_filter (filter);
+        }
+        for (auto action: live_table.allowed_actions ()) {
+            tmp_table.set_allowed_action (action);
+        }
+        for (auto grp_id: live_table.udf_group_list ()) {
+            tmp_table.set_udf_group_id (grp_id);
+        }
+        if (!live_table.following_switch_npus ()) {
+            for (auto npu_id: live_table.npu_list ()) {
+                tmp_table.add_npu (npu_id);
+            }
+        }
+
+        nas_acl_id_guard_t  idg (s, BASE_ACL_TABLE_OBJ);
+        nas_obj_id_t shadow_id = idg.alloc_guarded_id ();
+        tmp_table.set_table_id (shadow_id);
+        // Entries are kept out of hardware until commit
+        tmp_table.set_staged (true);
+
+        tmp_table.commit_create (false);
+
+        // WARNING !!! CANNOT throw error or exception beyond this point
+        // since table is already committed to SAI
+
+        s.save_table (std::move (tmp_table));
+        idg.unguard ();
+        s.add_shadow_table (table_id, shadow_id);
+
+        *shadow_id_p = shadow_id;
+
+        NAS_ACL_LOG_BRIEF ("Switch Id: %d, Shadow Table %ld created for Table %ld",
+                           switch_id, shadow_id, table_id);
+
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        rc = e.err_code;
+    }
+
+    nas_acl_unlock ();
+
+    return rc;
+}
+
+t_std_error nas_acl_table_shadow_commit (nas_switch_id_t switch_id,
+                                         nas_obj_id_t    shadow_id) noexcept
+{
+    t_std_error rc = NAS_ACL_E_NONE;
+    nas_obj_id_t table_id = 0;
+
+    nas_acl_lock ();
+
+    try {
+        nas_acl_switch& s = nas_acl_get_switch (switch_id);
+        table_id = s.shadow_table_owner (shadow_id);
+
+        if (table_id == 0 || s.find_table (table_id) == nullptr) {
+            throw nas::base_exception {NAS_ACL_E_KEY_VAL, __FUNCTION__,
+                std::string {"Not a shadow table "} + std::to_string (shadow_id)};
+        }
+
+        nas_acl_table& shadow = s.get_table (shadow_id);
+        if (!shadow.is_staged ()) {
+            // Left over from a commit whose teardown failed
+            throw nas::base_exception {NAS_ACL_E_INCONSISTENT, __FUNCTION__,
+                std::string {"Shadow table "} + std::to_string (shadow_id) +
+                " is a retired generation, it can only be aborted"};
+        }
+
+        _cps_table_shadow_install (s, shadow);
+
+        // Old generation ends up under the shadow table ID
+        s.swap_table_generation (table_id, shadow_id);
+        nas_acl_table_fit_forget (switch_id, table_id);
+        nas_acl_table_fit_forget (switch_id, shadow_id);
+
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        rc = e.err_code;
+    }
+
+    nas_acl_unlock ();
+
+    if (rc == NAS_ACL_E_NONE) {
+        rc = _cps_table_retire (switch_id, table_id, shadow_id);
+    }
+
+    return rc;
+}
+
+t_std_error nas_acl_table_shadow_abort (nas_switch_id_t switch_id,
+                                        nas_obj_id_t    shadow_id) noexcept
+{
+    t_std_error rc = NAS_ACL_E_NONE;
+    nas_obj_id_t table_id = 0;
+
+    nas_acl_lock ();
+
+    try {
+        nas_acl_switch& s = nas_acl_get_switch (switch_id);
+        table_id = s.shadow_table_owner (shadow_id);
+
+        if (table_id == 0) {
+            throw nas::base_exception {NAS_ACL_E_KEY_VAL, __FUNCTION__,
+                std::string {"Not a shadow table "} + std::to_string (shadow_id)};
+        }
+        s.del_shadow_table (shadow_id);
+
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        rc = e.err_code;
+    }
+
+    nas_acl_unlock ();
+
+    if (rc == NAS_ACL_E_NONE) {
+        rc = _cps_table_retire (switch_id, table_id, shadow_id);
+    }
+
+    return rc;
+}
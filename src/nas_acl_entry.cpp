@@ -30,6 +30,9 @@
 #include "nas_ndi_acl.h"
 #include "nas_acl_log.h"
 #include "nas_acl_utl.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_warm.h"
 #include <inttypes.h>
 
 static void _utl_push_disable_action_to_npu (nas_acl_entry& acl_entry,
@@ -63,9 +66,21 @@ const nas::npu_set_t&  nas_acl_entry::npu_list () const
     return nas::base_obj_t::npu_list();
 }
 
+void nas_acl_entry::set_entry_id (nas_obj_id_t id)
+{
+    STD_ASSERT (_entry_id == 0); // Something wrong .. Entry already has a ID
+    _entry_id = id;
+
+    // A next-hop redirect added before the ID is known is registered now
+    if (_alist.find (BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP) != _alist.end()) {
+        get_table().get_switch().add_pbr_entry_to_cache(table_id(), entry_id());
+    }
+}
+
 void nas_acl_entry::set_priority (ndi_acl_priority_t p)
 {
     _priority = p;
+    _invalidate_hash ();
     mark_attr_dirty (BASE_ACL_ENTRY_PRIORITY);
 }
 
@@ -79,14 +94,138 @@ void nas_acl_entry::copy_table_npus ()
     // Reset to the table NPU list
     set_npu_list (get_table().npu_list());
     _following_table_npus = true;
+    _invalidate_hash ();
+}
+
+void nas_acl_entry::rebind_table (const nas_acl_table* table_p) noexcept
+{
+    _table_p = table_p;
+    for (auto& f_pair: _flist) {
+        f_pair.second.rebind_table (table_p);
+    }
 }
 
 void nas_acl_entry::add_npu (npu_id_t npu_id, bool reset)
 {
     _following_table_npus = false;
+    _invalidate_hash ();
     nas::base_obj_t::add_npu (npu_id, reset);
 }
 
+void nas_acl_entry::_compute_hash () const noexcept
+{
+    // Entries are unordered maps, so fold items in with an
+    // order independent sum
+    _filter_hash = 0;
+    for (const auto& f_pair: _flist) {
+        _filter_hash += nas_acl_hash_combine (f_pair.second.content_hash (),
+                                              f_pair.first.offset);
+    }
+
+    _action_hash = 0;
+    for (const auto& a_pair: _alist) {
+        _action_hash += a_pair.second.content_hash ();
+    }
+
+    uint64_t npu_hash = 0;
+    if (!_following_table_npus) {
+        for (auto npu_id: nas::base_obj_t::npu_list ()) {
+            npu_hash += nas_acl_hash_combine (0, npu_id);
+        }
+    }
+
+    _fingerprint = nas_acl_hash_combine (0, _priority);
+    _fingerprint = nas_acl_hash_combine (_fingerprint, _following_table_npus);
+    _fingerprint = nas_acl_hash_combine (_fingerprint, npu_hash);
+    _fingerprint = nas_acl_hash_combine (_fingerprint, _filter_hash);
+    _fingerprint = nas_acl_hash_combine (_fingerprint, _action_hash);
+    _hash_valid = true;
+}
+
+uint64_t nas_acl_entry::fingerprint () const noexcept
+{
+    if (!_hash_valid) {
+        _compute_hash ();
+    }
+    return _fingerprint;
+}
+
+bool nas_acl_entry::is_same_npu_list (const nas_acl_entry& other) const noexcept
+{
+    if (_following_table_npus != other._following_table_npus) {
+        return false;
+    }
+    if (_following_table_npus) {
+        return true;
+    }
+
+    auto& npus = nas::base_obj_t::npu_list ();
+    auto& other_npus = other.nas::base_obj_t::npu_list ();
+    if (npus.size () != other_npus.size ()) {
+        return false;
+    }
+    for (auto npu_id: npus) {
+        if (!other_npus.contains (npu_id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool nas_acl_entry::is_same_filter_list (const nas_acl_entry& other) const noexcept
+{
+    if (_flist.size () != other._flist.size ()) {
+        return false;
+    }
+    // Refresh cached content hashes on both sides
+    fingerprint ();
+    other.fingerprint ();
+    if (_filter_hash != other._filter_hash) {
+        return false;
+    }
+
+    for (const auto& f_pair: _flist) {
+        auto it = other._flist.find (f_pair.first);
+        if (it == other._flist.end () || f_pair.second != it->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool nas_acl_entry::is_same_action_list (const nas_acl_entry& other) const noexcept
+{
+    if (_alist.size () != other._alist.size ()) {
+        return false;
+    }
+    // Refresh cached content hashes on both sides
+    fingerprint ();
+    other.fingerprint ();
+    if (_action_hash != other._action_hash) {
+        return false;
+    }
+
+    for (const auto& a_pair: _alist) {
+        auto it = other._alist.find (a_pair.first);
+        if (it == other._alist.end () || a_pair.second != it->second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool nas_acl_entry::is_same_rule (const nas_acl_entry& other) const noexcept
+{
+    if (fingerprint () != other.fingerprint ()) {
+        return false;
+    }
+
+    return (_priority == other._priority &&
+            is_same_npu_list (other) &&
+            is_same_filter_list (other) &&
+            is_same_action_list (other));
+}
+
 bool nas_acl_entry::is_npu_set (npu_id_t npu_id) const noexcept
 {
     if (!_following_table_npus) {
@@ -112,6 +251,7 @@ void nas_acl_entry::add_filter (nas_acl_filter_t& filter, bool reset)
         _flist.clear ();
         _filter_npus.clear();
     }
+    _invalidate_hash ();
 
     if (filter.is_npu_specific ()) {
         // Ensure that the entry has no other NPU specific filters.
@@ -148,15 +288,17 @@ void nas_acl_entry::remove_filter (BASE_ACL_MATCH_TYPE_t ftype, size_t offset)
     if (nas_acl_filter_t::is_npu_specific (ftype))
         _filter_npus.clear();
     _flist.erase ({ftype, offset});
+    _invalidate_hash ();
     mark_attr_dirty (BASE_ACL_ENTRY_MATCH);
 }
 
 void nas_acl_entry::remove_action (BASE_ACL_ACTION_TYPE_t atype)
 {
     _alist.erase (atype);
+    _invalidate_hash ();
     mark_attr_dirty (BASE_ACL_ENTRY_ACTION);
 
-    if (atype == BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP) {
+    if (atype == BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP && entry_id() != 0) {
         get_table().get_switch().del_pbr_entry_from_cache(table_id(), entry_id());
     }
 }
@@ -165,12 +307,14 @@ void nas_acl_entry::reset_filter ()
 {
     _flist.clear ();
     _filter_npus.clear();
+    _invalidate_hash ();
     mark_attr_dirty (BASE_ACL_ENTRY_MATCH);
 }
 
 void nas_acl_entry::reset_action ()
 {
     _alist.clear ();
+    _invalidate_hash ();
     mark_attr_dirty (BASE_ACL_ENTRY_ACTION);
 }
 
@@ -226,6 +370,7 @@ void nas_acl_entry::add_action (nas_acl_action_t& action, bool reset)
     if (reset && !is_attr_dirty (BASE_ACL_ENTRY_ACTION)) {
         _alist.clear ();
     }
+    _invalidate_hash ();
 
     mark_attr_dirty (BASE_ACL_ENTRY_ACTION);
     if (_alist.find (action.action_type()) != _alist.end()) {
@@ -249,7 +394,9 @@ void nas_acl_entry::add_action (nas_acl_action_t& action, bool reset)
         }
     }
 
-    if (action.action_type() == BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP) {
+    // Entry without an ID yet is registered by set_entry_id
+    if (action.action_type() == BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP &&
+        entry_id() != 0) {
         get_table().get_switch().add_pbr_entry_to_cache(table_id(), entry_id());
     }
 
@@ -316,9 +463,24 @@ nas::attr_set_t nas_acl_entry::commit_modify (base_obj_t& entry_orig,
 
     if (is_counter_enabled ()) { _validate_counter_npus (); }
 
+    if (get_table().is_staged()) {
+        // Nothing in hardware to modify, the cache is all there is
+        return set_attr_list ();
+    }
+
     return nas::base_obj_t::commit_modify (entry_orig, rolling_back);
 }
 
+void nas_acl_entry::commit_delete (bool rolling_back)
+{
+    if (get_table().is_staged()) {
+        // Entry never made it to hardware
+        return;
+    }
+
+    nas::base_obj_t::commit_delete (rolling_back);
+}
+
 const nas_acl_filter_t& nas_acl_entry::get_filter (BASE_ACL_MATCH_TYPE_t ftype,
                                                    size_t offset) const
 {
@@ -479,6 +641,13 @@ static inline bool is_intf_related_action(BASE_ACL_ACTION_TYPE_t a_type)
 bool nas_acl_entry::push_create_obj_to_npu_ext (npu_id_t npu_id,
                                                 void* ndi_obj, bool upd_intf_bind)
 {
+    if (get_table().is_staged()) {
+        // Installed when its shadow table is committed
+        NAS_ACL_LOG_DETAIL ("Switch %d Table %ld: Entry %ld: staged, not installed in NPU %d",
+                            get_switch().id(), get_table().table_id(),
+                            entry_id(), npu_id);
+        return true;
+    }
     if (is_installed_to_npu(npu_id)) {
         // already installed to NPU
         NAS_ACL_LOG_BRIEF ("Switch %d Table %ld: Entry %ld: was already installed in NPU %d",
@@ -495,7 +664,11 @@ bool nas_acl_entry::push_create_obj_to_npu_ext (npu_id_t npu_id,
             break;
         }
     }
-    if (install_entry) {
+    ndi_obj_id_t ndi_entry_id;
+    if (install_entry && nas_acl_warm_adopt (*this, npu_id, ndi_entry_id)) {
+        // Already in the NPU from before a warm restart, nothing to program
+        ndi_entry_ids[npu_id] = ndi_entry_id;
+    } else if (install_entry) {
         t_std_error rc = STD_ERR_OK;
         nas::mem_alloc_helper_t mem_trakr;
         ndi_acl_entry_t ndi_acl_entry = {};
@@ -519,10 +692,8 @@ bool nas_acl_entry::push_create_obj_to_npu_ext (npu_id_t npu_id,
         ndi_acl_entry.action_count = ndi_alist.size();
         ndi_acl_entry.action_list = ndi_alist.data();
 
-        ndi_obj_id_t ndi_entry_id;
-
-        if ((rc = ndi_acl_entry_create (npu_id, &ndi_acl_entry,
-                &ndi_entry_id)) != STD_ERR_OK) {
+        if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_CREATE, ndi_acl_entry_create,
+                npu_id, &ndi_acl_entry, &ndi_entry_id)) != STD_ERR_OK) {
             throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                 std::string {"NDI ACL Entry Create failed for NPU "} +
                 std::to_string (npu_id)};
@@ -573,7 +744,8 @@ bool nas_acl_entry::push_delete_obj_to_npu_ext (npu_id_t npu_id, bool upd_intf_b
         return false;
     }
 
-    if ((rc = ndi_acl_entry_delete (npu_id, it_ndi_eid->second))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_DELETE, ndi_acl_entry_delete,
+                                npu_id, it_ndi_eid->second))
          != STD_ERR_OK) {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                                    std::string {"NDI ACL Entry "} +
@@ -639,8 +811,10 @@ bool nas_acl_entry::push_leaf_attr_to_npu (nas_attr_id_t attr_id,
     switch (attr_id)
     {
         case BASE_ACL_ENTRY_PRIORITY:
-            if ((rc = ndi_acl_entry_set_priority (npu_id, ndi_entry_ids.at(npu_id),
-                                                  priority()))
+            if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_SET_PRIORITY,
+                                        ndi_acl_entry_set_priority,
+                                        npu_id, ndi_entry_ids.at(npu_id),
+                                        priority()))
                 != STD_ERR_OK)
             {
                 throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -703,8 +877,10 @@ static void _utl_push_disable_filter_to_npu (nas_acl_entry& acl_entry,
 {
     t_std_error rc;
 
-    if ((rc = ndi_acl_entry_disable_filter (npu_id, acl_entry.ndi_entry_ids.at (npu_id),
-                                            f_type)) != STD_ERR_OK) {
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_DISABLE_FILTER,
+                                ndi_acl_entry_disable_filter,
+                                npu_id, acl_entry.ndi_entry_ids.at (npu_id),
+                                f_type)) != STD_ERR_OK) {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                                    std::string {"NDI Filter Disable failed for "} +
                                    nas_acl_filter_t::type_name (f_type) +
@@ -739,8 +915,10 @@ static void _utl_push_filter_to_npu (nas_acl_entry& acl_entry,
 
     t_std_error rc;
 
-    if ((rc = ndi_acl_entry_set_filter (npu_id, acl_entry.ndi_entry_ids.at (npu_id),
-                                        &ndi_filter)) != STD_ERR_OK) {
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_SET_FILTER,
+                                ndi_acl_entry_set_filter,
+                                npu_id, acl_entry.ndi_entry_ids.at (npu_id),
+                                &ndi_filter)) != STD_ERR_OK) {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                                    std::string {"NDI Filter set failed for "} +
                                    f_add.name() + " for NPU " + std::to_string (npu_id)};
@@ -915,17 +1093,19 @@ static void _utl_push_disable_action_to_npu (nas_acl_entry& acl_entry,
         auto& counter = acl_entry.get_table().get_switch().get_counter(
                             acl_entry.table_id(), counter_id);
         auto ndi_counter_id = counter.ndi_obj_id(npu_id);
-        if ((rc = ndi_acl_entry_disable_counter_action (npu_id,
-                                                acl_entry.ndi_entry_ids.at (npu_id),
-                                                ndi_counter_id)) != STD_ERR_OK) {
+        if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_DISABLE_ACTION,
+                                    ndi_acl_entry_disable_counter_action,
+                                    npu_id, acl_entry.ndi_entry_ids.at (npu_id),
+                                    ndi_counter_id)) != STD_ERR_OK) {
             throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                 std::string {"NDI Set Counter Action Disable failed for NPU "} +
                 std::to_string (npu_id)};
         }
     } else {
-        if ((rc = ndi_acl_entry_disable_action (npu_id,
-                                                acl_entry.ndi_entry_ids.at (npu_id),
-                                                a_type)) != STD_ERR_OK) {
+        if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_DISABLE_ACTION,
+                                    ndi_acl_entry_disable_action,
+                                    npu_id, acl_entry.ndi_entry_ids.at (npu_id),
+                                    a_type)) != STD_ERR_OK) {
             throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                 std::string {"NDI Action Disable failed for "} +
                 nas_acl_action_t::type_name (a_type) +
@@ -957,7 +1137,8 @@ static void _utl_push_action_to_npu (nas_acl_entry& acl_entry,
     }
 
     for (auto& ndi_action: ndi_alist) {
-        if ((rc = ndi_acl_entry_set_action (npu_id,
+        if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_SET_ACTION,
+                ndi_acl_entry_set_action, npu_id,
                 acl_entry.ndi_entry_ids.at (npu_id),
                 &ndi_action)) != STD_ERR_OK) {
 
@@ -974,6 +1155,11 @@ static void _utl_push_action_to_npu (nas_acl_entry& acl_entry,
 void nas_acl_entry::update_action_to_npu(npu_id_t npu_id, const nas_acl_action_t& action,
                                          bool del_action)
 {
+    if (!is_installed_to_npu(npu_id)) {
+        // Action goes in with the entry once it is installed
+        return;
+    }
+
     if (del_action) {
         if (action.is_eligible_for_install(npu_id)) {
              NAS_ACL_LOG_BRIEF("Disable action %s from entry %d", action.name(),
@@ -1230,6 +1416,25 @@ void nas_acl_entry::rollback_delete_attr_in_npu (const nas::attr_list_t&
     }
 }
 
+void nas_acl_entry::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj (NAS_ACL_MEM_ENTRY);
+    acct.add (NAS_ACL_MEM_ENTRY, _entry_name);
+    acct.add (NAS_ACL_MEM_ENTRY, _filter_npus);
+    acct.add (NAS_ACL_MEM_ENTRY, ndi_entry_ids);
+
+    // Hash nodes hold the filter and action objects themselves
+    acct.add (NAS_ACL_MEM_FILTER, _flist);
+    for (const auto& filter_pair: _flist) {
+        filter_pair.second.mem_usage (acct);
+    }
+
+    acct.add (NAS_ACL_MEM_ACTION, _alist);
+    for (const auto& action_pair: _alist) {
+        action_pair.second.mem_usage (acct);
+    }
+}
+
 void nas_acl_entry::dbg_dump () const
 {
     NAS_ACL_LOG_DUMP ("NAS ACL Entry dump");
@@ -1304,6 +1509,7 @@ bool nas_acl_entry::filter_intf_delete(BASE_ACL_MATCH_TYPE_t f_type,
     try {
         nas_acl_filter_t& filter = const_cast<nas_acl_filter_t&>(get_filter(f_type, 0));
         filter.notify_ifindex_delete(ifindex);
+        _invalidate_hash();
         filter.update_port_mapping();
         for (auto npu_id : npu_list())
             update_filter_to_npu(npu_id, filter, false);
@@ -1324,6 +1530,7 @@ bool nas_acl_entry::action_intf_delete(BASE_ACL_ACTION_TYPE_t a_type,
     try {
         nas_acl_action_t& action = const_cast<nas_acl_action_t&>(get_action(a_type));
         action.notify_ifindex_delete(ifindex);
+        _invalidate_hash();
         action.update_port_mapping();
         for (auto npu_id : npu_list())
             update_action_to_npu(npu_id, action, false);
@@ -29,6 +29,7 @@
 #include "nas_acl_log.h"
 #include "nas_acl_filter.h"
 #include "nas_acl_utl.h"
+#include "nas_acl_mem.h"
 #include <unordered_map>
 #include <arpa/inet.h>
 
@@ -58,6 +59,7 @@ nas_acl_filter_t::nas_acl_filter_t (const nas_acl_table* table, BASE_ACL_MATCH_T
         t == BASE_ACL_MATCH_TYPE_MCAST_ROUTE_DST_HIT) {
         _f_info.values_type = NDI_ACL_FILTER_BOOL;
     }
+    _update_hash ();
 }
 
 static bool _validate_ip_type_data (uint32_t ip_type) noexcept
@@ -128,6 +130,7 @@ void nas_acl_filter_t::set_u32_filter_val (const nas_acl_common_data_list_t& val
     if (val_list.size () > 1) {
         _f_info.mask.values.u32 = val_list.at(1).u32;
     }
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_u16_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -148,6 +151,7 @@ void nas_acl_filter_t::set_u16_filter_val (const nas_acl_common_data_list_t& val
     if (val_list.size () > 1) {
         _f_info.mask.values.u16 = val_list.at(1).u16;
     }
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_u8_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -168,6 +172,7 @@ void nas_acl_filter_t::set_u8_filter_val (const nas_acl_common_data_list_t& val_
     if (val_list.size () > 1) {
         _f_info.mask.values.u8      = val_list.at(1).u8;
     }
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_ipv4_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -218,6 +223,7 @@ void nas_acl_filter_t::set_ipv4_filter_val (const nas_acl_common_data_list_t& va
             sizeof (_f_info.data.values.ipv4));
     memcpy ((uint8_t*)&_f_info.mask.values.ipv4, val_list.at(1).bytes.data(),
             sizeof (_f_info.mask.values.ipv4));
+    _update_hash ();
 }
 
 void nas_acl_filter_t::set_ipv6_filter_val (const nas_acl_common_data_list_t& val_list)
@@ -228,6 +234,7 @@ void nas_acl_filter_t::set_ipv6_filter_val (const nas_acl_common_data_list_t& va
             sizeof (_f_info.data.values.ipv6));
     memcpy ((uint8_t*)&_f_info.mask.values.ipv6, val_list.at(1).bytes.data(),
             sizeof (_f_info.mask.values.ipv6));
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_mac_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -252,6 +259,7 @@ void nas_acl_filter_t::set_mac_filter_val (const nas_acl_common_data_list_t& val
     _f_info.values_type = NDI_ACL_FILTER_MAC_ADDR;
     memcpy (_f_info.data.values.mac, val_list.at(0).bytes.data(), HAL_MAC_ADDR_LEN);
     memcpy (_f_info.mask.values.mac, val_list.at(1).bytes.data(), HAL_MAC_ADDR_LEN);
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_ip_type_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -273,6 +281,7 @@ void nas_acl_filter_t::set_ip_type_filter_val (const nas_acl_common_data_list_t&
     }
     _f_info.values_type  = NDI_ACL_FILTER_IP_TYPE;
     _f_info.data.ip_type = (BASE_ACL_MATCH_IP_TYPE_t) val;
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_ip_frag_filter_val (nas_acl_common_data_list_t& val_list) const
@@ -294,6 +303,7 @@ void nas_acl_filter_t::set_ip_frag_filter_val (const nas_acl_common_data_list_t&
     }
     _f_info.values_type  = NDI_ACL_FILTER_IP_FRAG;
     _f_info.data.ip_frag = (BASE_ACL_MATCH_IP_FRAG_t) val;
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_filter_ifindex_list (nas_acl_common_data_list_t& val_list) const
@@ -393,6 +403,7 @@ void nas_acl_filter_t::set_filter_ifindex_list (const nas_acl_common_data_list_t
     }
 
     update_port_mapping();
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_filter_ifindex (nas_acl_common_data_list_t& val_list) const
@@ -433,6 +444,7 @@ void nas_acl_filter_t::set_filter_ifindex (const nas_acl_common_data_list_t& val
         _f_info.values_type  = NDI_ACL_FILTER_PORT;
         update_port_mapping();
     }
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_udf_filter_val(nas_acl_common_data_list_t& val_list) const
@@ -488,12 +500,14 @@ void nas_acl_filter_t::set_udf_filter_val(const nas_acl_common_data_list_t& val_
         _f_info.mask.values.ndi_u8list.byte_count = byte_cnt;
         _f_info.mask.values.ndi_u8list.byte_list = byte_buf;
     }
+    _update_hash ();
 }
 
 void nas_acl_filter_t::set_obj_id_list_filter_val (const nas_acl_common_data_list_t& data_list)
 {
     _f_info.values_type = NDI_ACL_FILTER_OBJ_ID_LIST;
     _range_oid_list = std::move(data_list.at(0).obj_id_list);
+    _update_hash ();
 }
 
 void nas_acl_filter_t::get_obj_id_list_filter_val (nas_acl_common_data_list_t& data_list) const
@@ -522,6 +536,7 @@ void nas_acl_filter_t::set_bridge_type_filter_val (const nas_acl_common_data_lis
     }
     _f_info.values_type  = NDI_ACL_FILTER_BRIDGE_TYPE;
     _f_info.data.values.u32 = val;
+    _update_hash ();
 }
 
 bool nas_acl_filter_t::_ndi_copy_one_obj_id(ndi_acl_entry_filter_t* ndi_filter_p,
@@ -600,12 +615,42 @@ nas::npu_set_t nas_acl_filter_t::get_npu_list () const
     return filter_npu_list;
 }
 
+// Hash covers exactly the fields compared by operator!=
+void nas_acl_filter_t::_update_hash () noexcept
+{
+    uint64_t h = nas_acl_hash_combine (0, _f_info.filter_type);
+    h = nas_acl_hash_combine (h, _f_info.values_type);
+
+    if (_f_info.values_type == NDI_ACL_FILTER_PORTLIST ||
+        _f_info.values_type == NDI_ACL_FILTER_PORT)
+    {
+        for (auto ifindex: _ifindex_list) {
+            h = nas_acl_hash_combine (h, ifindex);
+        }
+    }
+    else if (_f_info.values_type == NDI_ACL_FILTER_OBJ_ID_LIST) {
+        for (auto oid: _range_oid_list) {
+            h = nas_acl_hash_combine (h, oid);
+        }
+    }
+    else {
+        h = nas_acl_hash_bytes (h, &_f_info, sizeof (_f_info));
+    }
+
+    _content_hash = h;
+}
+
 bool nas_acl_filter_t::operator!= (const nas_acl_filter_t& rhs) const noexcept
 {
     if (filter_type() != rhs.filter_type()) {
         return true;
     }
 
+    // Cheap reject before comparing full values and port lists
+    if (_content_hash != rhs._content_hash) {
+        return true;
+    }
+
     if (_f_info.values_type == NDI_ACL_FILTER_PORTLIST ||
         _f_info.values_type == NDI_ACL_FILTER_PORT)
     {
@@ -627,6 +672,34 @@ bool nas_acl_filter_t::operator!= (const nas_acl_filter_t& rhs) const noexcept
     return false;
 }
 
+void nas_acl_filter_t::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj (NAS_ACL_MEM_FILTER);
+
+    acct.add (NAS_ACL_MEM_FILTER, _nas2ndi_oid_tbl);
+    for (const auto& oid_pair: _nas2ndi_oid_tbl) {
+        acct.add (NAS_ACL_MEM_FILTER, oid_pair.second);
+    }
+    acct.add (NAS_ACL_MEM_FILTER, _range_oid_list);
+
+    // UDF value and mask bytes are owned by the NDI filter
+    if (_f_info.values_type == NDI_ACL_FILTER_U8LIST) {
+        if (_f_info.data.values.ndi_u8list.byte_list != NULL) {
+            acct.add_bytes (NAS_ACL_MEM_FILTER, _f_info.data.values.ndi_u8list.byte_count);
+        }
+        if (_f_info.mask.values.ndi_u8list.byte_list != NULL) {
+            acct.add_bytes (NAS_ACL_MEM_FILTER, _f_info.mask.values.ndi_u8list.byte_count);
+        }
+    }
+
+    acct.add (NAS_ACL_MEM_PORT_LIST, _ifindex_list);
+    acct.add (NAS_ACL_MEM_PORT_LIST, _deleted_ifindex_list);
+    acct.add (NAS_ACL_MEM_PORT_LIST, _npu_port_list);
+    for (const auto& port_pair: _npu_port_list) {
+        acct.add (NAS_ACL_MEM_PORT_LIST, port_pair.second);
+    }
+}
+
 void nas_acl_filter_t::dbg_dump () const
 {
     NAS_ACL_LOG_DUMP ("Filter: %s", name ());
@@ -27,20 +27,29 @@
 #include "nas_acl_log.h"
 #include "std_error_codes.h"
 #include "nas_acl_cps.h"
+#include "nas_acl_stats.h"
 #include "nas_udf_cps.h"
 #include "nas_trap_cps.h"
 #include "nas_trapgrp_cps.h"
 #include "nas_acl_init.h"
 #include "nas_acl_log.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_lock_stats.h"
+#include "nas_acl_trace.h"
+#include "nas_acl_warm.h"
 #include "nas_if_utils.h"
 #include "dell-base-if.h"
 #include "std_mutex_lock.h"
 #include "dell-base-if-phy.h"
+#include <atomic>
 
+// Interface events change entries, so they are handled under the
+// NAS ACL lock like CPS requests
 static void nas_acl_if_delete_notify(uint32_t ifidx)
 {
 
     nas_switch_id_t switch_id = NAS_ACL_DEFAULT_SWITCH_ID();
+    nas_acl_lock();
     try {
         nas_acl_switch& sw = nas_acl_get_switch(switch_id);
         sw.if_delete_notify(ifidx);
@@ -50,14 +59,33 @@ static void nas_acl_if_delete_notify(uint32_t ifidx)
     } catch (std::exception& e) {
         NAS_ACL_LOG_ERR("Unknown Err: %s", e.what());
     }
+    nas_acl_unlock();
 
     return ;
 }
 
+void nas_acl_if_mapping_notify(uint32_t ifidx, npu_id_t npu_id, npu_port_t npu_port)
+{
+    nas_switch_id_t switch_id = NAS_ACL_DEFAULT_SWITCH_ID();
+    nas_acl_lock();
+    try {
+        nas_acl_switch& sw = nas_acl_get_switch(switch_id);
+        sw.process_intf_acl_bind(ifidx, npu_id, npu_port);
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                        e.err_fn.c_str(), e.err_msg.c_str());
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR("Unknown Err: %s", e.what());
+    }
+    nas_acl_unlock();
+}
+
 
-static bool nas_acl_if_set_handler(cps_api_object_t obj, void *context)
+bool nas_acl_if_set_handler(cps_api_object_t obj, void *context)
 {
     const char *if_name = nullptr;
+    // Only deletes and mapping changes are timed, other events are ignored
+    nas_acl_lat_scope lat (NAS_ACL_LAT_OP_MAX);
     cps_api_object_attr_t name_attr = cps_api_get_key_data(obj, IF_INTERFACES_INTERFACE_NAME);
     if (name_attr != nullptr) {
         if_name = (const char *)cps_api_object_attr_data_bin(name_attr);
@@ -78,11 +106,13 @@ static bool nas_acl_if_set_handler(cps_api_object_t obj, void *context)
 
     if (op == cps_api_oper_DELETE) {
         NAS_ACL_LOG_NOTICE("ifindex %d is deleted", ifidx);
+        lat.set_op (NAS_ACL_LAT_INTF_EVENT);
         nas_acl_if_delete_notify(ifidx);
         return true;
     }
 
     if (op == cps_api_oper_SET && nas_get_phy_port_mapping_change(obj, &status)) {
+        lat.set_op (NAS_ACL_LAT_INTF_EVENT);
         NAS_ACL_LOG_BRIEF("Interface mapping changed to: %s",
                    status == nas_int_phy_port_MAPPED ? "Mapped" : "Un-mapped");
     } else {
@@ -103,16 +133,7 @@ static bool nas_acl_if_set_handler(cps_api_object_t obj, void *context)
     npu_id_t npu_id = cps_api_object_attr_data_u32(npu_attr);
     npu_port_t npu_port = cps_api_object_attr_data_u32(port_attr);
 
-    nas_switch_id_t switch_id = NAS_ACL_DEFAULT_SWITCH_ID();
-    try {
-        nas_acl_switch& sw = nas_acl_get_switch(switch_id);
-        sw.process_intf_acl_bind(ifidx, npu_id, npu_port);
-    } catch (nas::base_exception& e) {
-        NAS_ACL_LOG_ERR("Err_code: 0x%x, fn: %s (), %s", e.err_code,
-                        e.err_fn.c_str(), e.err_msg.c_str());
-    } catch (std::exception& e) {
-        NAS_ACL_LOG_ERR("Unknown Err: %s", e.what());
-    }
+    nas_acl_if_mapping_notify(ifidx, npu_id, npu_port);
 
     return true;
 }
@@ -375,14 +396,25 @@ static t_std_error _cps_init ()
     return STD_ERR_OK;
 }
 
-int nas_acl_lock () noexcept
+int nas_acl_lock (const char* site) noexcept
 {
-    return (std_mutex_lock (&nas_acl_mutex));
+    uint64_t start_ns = nas_acl_lock_stats_start ();
+    nas_acl_trace_span wait ("ACL Lock Wait");
+    int rc = std_mutex_lock (&nas_acl_mutex);
+    wait.end ();
+
+    nas_acl_lock_stats_acquired (NAS_ACL_LOCK_ACL, site, start_ns);
+    return rc;
 }
 
 int nas_acl_unlock () noexcept
 {
-    return (std_mutex_unlock (&nas_acl_mutex));
+    auto hold = nas_acl_lock_stats_releasing (NAS_ACL_LOCK_ACL);
+    int rc = std_mutex_unlock (&nas_acl_mutex);
+
+    // Accounted after release so that it does not add to the hold time
+    nas_acl_lock_stats_record (hold);
+    return rc;
 }
 
 extern "C" {
@@ -394,15 +426,41 @@ t_std_error nas_acl_init(void)
     NAS_ACL_LOG_BRIEF ("Initializing NAS-ACL");
 
     do {
+        // Objects replayed after a process restart adopt what is still
+        // in the NPU, there is no snapshot after a cold start
+        nas_acl_warm_snapshot_load (NAS_ACL_WARM_SNAPSHOT_PATH);
+
         if ((rc = _cps_init ()) != STD_ERR_OK) {
             break;
         }
 
+        // Collectors can do without the export, carry on if it fails
+        nas_acl_stats_shm_init ();
+
+        if ((rc = nas_acl_stats_poller_start ()) != STD_ERR_OK) {
+            break;
+        }
+
     } while (0);
 
     return rc;
 }
 
+void nas_acl_deinit(void)
+{
+    static std::atomic<bool> done {false};
+
+    if (done.exchange (true)) {
+        return;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Stopping NAS-ACL");
+
+    nas_acl_stats_poller_stop ();
+    nas_acl_stats_shm_close ();
+    nas_acl_warm_shutdown (NAS_ACL_WARM_SNAPSHOT_PATH);
+}
+
 
 
 }
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_latency.cpp
+ * \brief  Latency histograms of NAS ACL CPS handlers and NDI calls
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_latency.h"
+#include <atomic>
+#include <mutex>
+#include <list>
+#include <new>
+#include <algorithm>
+#include <inttypes.h>
+
+static const char* _lat_op_names [] = {
+    "Table Create",
+    "Table Modify",
+    "Table Delete",
+    "Table Get",
+    "Entry Create",
+    "Entry Modify",
+    "Entry Delete",
+    "Entry Get",
+    "Entry Sync",
+    "Counter Create",
+    "Counter Modify",
+    "Counter Delete",
+    "Counter Get",
+    "Stats Set",
+    "Stats Get",
+    "Interface Event",
+    "NDI Table Create",
+    "NDI Table Delete",
+    "NDI Table Set Priority",
+    "NDI Entry Create",
+    "NDI Entry Delete",
+    "NDI Entry Set Priority",
+    "NDI Entry Set Filter",
+    "NDI Entry Disable Filter",
+    "NDI Entry Set Action",
+    "NDI Entry Disable Action",
+    "NDI Counter Create",
+    "NDI Counter Delete",
+    "NDI Counter Get",
+    "NDI Counter Get Bulk",
+    "NDI Counter Set",
+    "NDI Range Create",
+    "NDI Range Delete",
+};
+
+static_assert (sizeof (_lat_op_names) / sizeof (_lat_op_names[0]) == NAS_ACL_LAT_OP_MAX,
+               "Latency op name missing");
+
+// Histograms of one thread. Only the owner thread writes them, so
+// plain loads and stores suffice and readers see whole values.
+struct nas_acl_lat_hist_t {
+    std::atomic<uint64_t>  buckets [NAS_ACL_LAT_OP_MAX][NAS_ACL_LAT_BUCKETS];
+    std::atomic<uint64_t>  sum_ns [NAS_ACL_LAT_OP_MAX];
+    std::atomic<uint64_t>  max_ns [NAS_ACL_LAT_OP_MAX];
+
+    nas_acl_lat_hist_t () noexcept
+    {
+        for (size_t op = 0; op < NAS_ACL_LAT_OP_MAX; op++) {
+            for (auto& b: buckets[op]) b.store (0, std::memory_order_relaxed);
+            sum_ns[op].store (0, std::memory_order_relaxed);
+            max_ns[op].store (0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Totals of threads that have exited
+struct nas_acl_lat_totals_t {
+    uint64_t  buckets [NAS_ACL_LAT_OP_MAX][NAS_ACL_LAT_BUCKETS];
+    uint64_t  sum_ns [NAS_ACL_LAT_OP_MAX];
+    uint64_t  max_ns [NAS_ACL_LAT_OP_MAX];
+};
+
+static std::mutex                        _lat_mutex;
+static std::list<nas_acl_lat_hist_t*>    _lat_threads;
+static nas_acl_lat_totals_t              _lat_retired;
+
+static void _lat_thread_exit (nas_acl_lat_hist_t* hist) noexcept
+{
+    std::lock_guard<std::mutex> l (_lat_mutex);
+
+    for (size_t op = 0; op < NAS_ACL_LAT_OP_MAX; op++) {
+        for (size_t b = 0; b < NAS_ACL_LAT_BUCKETS; b++) {
+            _lat_retired.buckets[op][b] += hist->buckets[op][b].load (std::memory_order_relaxed);
+        }
+        _lat_retired.sum_ns[op] += hist->sum_ns[op].load (std::memory_order_relaxed);
+        _lat_retired.max_ns[op] = std::max (_lat_retired.max_ns[op],
+                                            hist->max_ns[op].load (std::memory_order_relaxed));
+    }
+
+    _lat_threads.remove (hist);
+    delete hist;
+}
+
+struct nas_acl_lat_thread_t {
+    nas_acl_lat_hist_t*  hist = nullptr;
+
+    ~nas_acl_lat_thread_t ()
+    {
+        if (hist != nullptr) _lat_thread_exit (hist);
+    }
+};
+
+static thread_local nas_acl_lat_thread_t _lat_thread;
+
+static nas_acl_lat_hist_t* _lat_thread_init () noexcept
+{
+    auto hist = new (std::nothrow) nas_acl_lat_hist_t;
+    if (hist == nullptr) return nullptr;
+
+    try {
+        std::lock_guard<std::mutex> l (_lat_mutex);
+        _lat_threads.push_back (hist);
+    } catch (std::exception& e) {
+        delete hist;
+        return nullptr;
+    }
+
+    _lat_thread.hist = hist;
+    return hist;
+}
+
+static inline void _lat_add (std::atomic<uint64_t>& v, uint64_t n) noexcept
+{
+    v.store (v.load (std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+const char* nas_acl_lat_op_name (nas_acl_lat_op_t op) noexcept
+{
+    return (op < NAS_ACL_LAT_OP_MAX) ? _lat_op_names[op] : "Unknown";
+}
+
+void nas_acl_lat_record (nas_acl_lat_op_t op, uint64_t elapsed_ns) noexcept
+{
+    if (op >= NAS_ACL_LAT_OP_MAX) return;
+
+    auto hist = _lat_thread.hist;
+    if (hist == nullptr) {
+        hist = _lat_thread_init ();
+        if (hist == nullptr) return;
+    }
+
+    uint64_t us = elapsed_ns / 1000;
+    size_t bucket = (us == 0) ? 0 :
+        std::min ((size_t) (64 - __builtin_clzll (us)), (size_t) NAS_ACL_LAT_BUCKETS - 1);
+
+    _lat_add (hist->buckets[op][bucket], 1);
+    _lat_add (hist->sum_ns[op], elapsed_ns);
+    if (elapsed_ns > hist->max_ns[op].load (std::memory_order_relaxed)) {
+        hist->max_ns[op].store (elapsed_ns, std::memory_order_relaxed);
+    }
+}
+
+static uint64_t _lat_percentile (const uint64_t* buckets, uint64_t count,
+                                 uint64_t max_us, uint32_t pct) noexcept
+{
+    if (count == 0) return 0;
+
+    uint64_t rank = (count * pct + 99) / 100;
+    uint64_t seen = 0;
+
+    for (size_t b = 0; b < NAS_ACL_LAT_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            if (b == NAS_ACL_LAT_BUCKETS - 1) break;
+            return std::min ((uint64_t) 1 << b, std::max (max_us, (uint64_t) 1));
+        }
+    }
+    return max_us;
+}
+
+void nas_acl_lat_get (nas_acl_lat_op_t op, nas_acl_lat_summary_t* summary_p,
+                      uint64_t* buckets_p) noexcept
+{
+    uint64_t buckets [NAS_ACL_LAT_BUCKETS];
+    uint64_t sum_ns, max_ns;
+
+    *summary_p = {};
+    if (buckets_p != nullptr) {
+        std::fill (buckets_p, buckets_p + NAS_ACL_LAT_BUCKETS, 0);
+    }
+    if (op >= NAS_ACL_LAT_OP_MAX) return;
+
+    {
+        std::lock_guard<std::mutex> l (_lat_mutex);
+
+        std::copy (_lat_retired.buckets[op], _lat_retired.buckets[op] + NAS_ACL_LAT_BUCKETS,
+                   buckets);
+        sum_ns = _lat_retired.sum_ns[op];
+        max_ns = _lat_retired.max_ns[op];
+
+        for (auto hist: _lat_threads) {
+            for (size_t b = 0; b < NAS_ACL_LAT_BUCKETS; b++) {
+                buckets[b] += hist->buckets[op][b].load (std::memory_order_relaxed);
+            }
+            sum_ns += hist->sum_ns[op].load (std::memory_order_relaxed);
+            max_ns = std::max (max_ns, hist->max_ns[op].load (std::memory_order_relaxed));
+        }
+    }
+
+    for (auto n: buckets) summary_p->count += n;
+    summary_p->sum_us = sum_ns / 1000;
+    summary_p->max_us = max_ns / 1000;
+    summary_p->p50_us = _lat_percentile (buckets, summary_p->count, summary_p->max_us, 50);
+    summary_p->p90_us = _lat_percentile (buckets, summary_p->count, summary_p->max_us, 90);
+    summary_p->p99_us = _lat_percentile (buckets, summary_p->count, summary_p->max_us, 99);
+
+    if (buckets_p != nullptr) {
+        std::copy (buckets, buckets + NAS_ACL_LAT_BUCKETS, buckets_p);
+    }
+}
+
+void dump_acl_latency (void)
+{
+    NAS_ACL_LOG_DUMP ("%-26s %10s %10s %10s %10s %10s %10s",
+                      "Operation", "Count", "Avg(us)", "p50(us)", "p90(us)",
+                      "p99(us)", "Max(us)");
+
+    for (size_t op = 0; op < NAS_ACL_LAT_OP_MAX; op++) {
+        nas_acl_lat_summary_t s;
+
+        nas_acl_lat_get ((nas_acl_lat_op_t) op, &s);
+        if (s.count == 0) continue;
+
+        NAS_ACL_LOG_DUMP ("%-26s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+                          " %10" PRIu64 " %10" PRIu64,
+                          _lat_op_names[op], s.count, s.sum_us / s.count,
+                          s.p50_us, s.p90_us, s.p99_us, s.max_us);
+    }
+}
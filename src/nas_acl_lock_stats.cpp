@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_lock_stats.cpp
+ * \brief  Wait and hold time accounting of the NAS ACL locks
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_lock_stats.h"
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <inttypes.h>
+
+typedef std::pair<nas_acl_lock_id_t, const char*> nas_acl_lock_site_key_t;
+
+static std::atomic<bool>   _lock_stats_enabled {true};
+
+// Written only by the current holder of each lock
+static nas_acl_lock_hold_t _lock_holds [NAS_ACL_LOCK_MAX];
+
+// Guards the accounting below, never held while a NAS ACL lock is taken
+static std::mutex          _lock_stats_mutex;
+static std::map<nas_acl_lock_site_key_t, nas_acl_lock_site_stats_t> _lock_sites;
+static nas_acl_lock_hold_t _lock_ring [NAS_ACL_LOCK_RING_SIZE];
+static size_t              _lock_ring_next = 0;
+static size_t              _lock_ring_count = 0;
+
+static inline uint64_t _lock_now_ns () noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+const char* nas_acl_lock_name (nas_acl_lock_id_t lock) noexcept
+{
+    switch (lock) {
+        case NAS_ACL_LOCK_ACL:        return "NAS ACL";
+        case NAS_ACL_LOCK_INTF_BIND:  return "Interface Bind";
+        default:                      return "Unknown";
+    }
+}
+
+uint64_t nas_acl_lock_stats_start (void) noexcept
+{
+    return (_lock_stats_enabled.load (std::memory_order_relaxed)) ? _lock_now_ns () : 0;
+}
+
+void nas_acl_lock_stats_acquired (nas_acl_lock_id_t lock, const char* site,
+                                  uint64_t start_ns) noexcept
+{
+    auto& hold = _lock_holds[lock];
+
+    hold.lock = lock;
+    hold.site = site;
+    hold.start_ns = start_ns;
+    hold.acquired_ns = (start_ns != 0) ? _lock_now_ns () : 0;
+    hold.released_ns = 0;
+}
+
+nas_acl_lock_hold_t nas_acl_lock_stats_releasing (nas_acl_lock_id_t lock) noexcept
+{
+    nas_acl_lock_hold_t hold = _lock_holds[lock];
+
+    if (hold.start_ns != 0) hold.released_ns = _lock_now_ns ();
+    return hold;
+}
+
+void nas_acl_lock_stats_record (const nas_acl_lock_hold_t& hold) noexcept
+{
+    if (hold.start_ns == 0) return;
+
+    uint64_t wait_ns = hold.acquired_ns - hold.start_ns;
+    uint64_t hold_ns = hold.released_ns - hold.acquired_ns;
+
+    try {
+        std::lock_guard<std::mutex> l (_lock_stats_mutex);
+
+        auto& s = _lock_sites[{hold.lock, hold.site}];
+        s.lock = hold.lock;
+        s.site = hold.site;
+        s.count++;
+        s.wait_ns += wait_ns;
+        s.wait_max_ns = std::max (s.wait_max_ns, wait_ns);
+        s.hold_ns += hold_ns;
+        s.hold_max_ns = std::max (s.hold_max_ns, hold_ns);
+
+        if (hold_ns >= NAS_ACL_LOCK_LONG_HOLD_US * 1000) {
+            _lock_ring[_lock_ring_next] = hold;
+            _lock_ring_next = (_lock_ring_next + 1) % NAS_ACL_LOCK_RING_SIZE;
+            _lock_ring_count = std::min (_lock_ring_count + 1, (size_t) NAS_ACL_LOCK_RING_SIZE);
+        }
+    } catch (std::exception& e) {
+        // Site is not accounted, the lock itself is unaffected
+    }
+}
+
+void nas_acl_lock_stats_enable (bool enable) noexcept
+{
+    _lock_stats_enabled.store (enable, std::memory_order_relaxed);
+}
+
+void nas_acl_lock_stats_clear (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_lock_stats_mutex);
+
+    _lock_sites.clear ();
+    _lock_ring_next = 0;
+    _lock_ring_count = 0;
+}
+
+void nas_acl_lock_stats_get (std::vector<nas_acl_lock_site_stats_t>& stats) noexcept
+{
+    stats.clear ();
+
+    try {
+        {
+            std::lock_guard<std::mutex> l (_lock_stats_mutex);
+            for (const auto& kvp: _lock_sites) {
+                stats.push_back (kvp.second);
+            }
+        }
+
+        std::sort (stats.begin (), stats.end (),
+                   [] (const nas_acl_lock_site_stats_t& a,
+                       const nas_acl_lock_site_stats_t& b) {
+                       return a.hold_ns > b.hold_ns;
+                   });
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Lock stats get failed: %s", e.what ());
+        stats.clear ();
+    }
+}
+
+void nas_acl_lock_long_holds_get (std::vector<nas_acl_lock_hold_t>& holds) noexcept
+{
+    holds.clear ();
+
+    try {
+        std::lock_guard<std::mutex> l (_lock_stats_mutex);
+
+        size_t first = (_lock_ring_next + NAS_ACL_LOCK_RING_SIZE - _lock_ring_count)
+                       % NAS_ACL_LOCK_RING_SIZE;
+        for (size_t i = 0; i < _lock_ring_count; i++) {
+            holds.push_back (_lock_ring[(first + i) % NAS_ACL_LOCK_RING_SIZE]);
+        }
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Lock long holds get failed: %s", e.what ());
+        holds.clear ();
+    }
+}
+
+void dump_acl_lock_stats (void)
+{
+    std::vector<nas_acl_lock_site_stats_t> stats;
+    std::vector<nas_acl_lock_hold_t> holds;
+
+    nas_acl_lock_stats_get (stats);
+    nas_acl_lock_long_holds_get (holds);
+
+    NAS_ACL_LOG_DUMP ("%-15s %-40s %10s %12s %12s %12s %12s",
+                      "Lock", "Site", "Count", "Wait(us)", "MaxWait(us)",
+                      "Hold(us)", "MaxHold(us)");
+    for (const auto& s: stats) {
+        NAS_ACL_LOG_DUMP ("%-15s %-40s %10" PRIu64 " %12" PRIu64 " %12" PRIu64
+                          " %12" PRIu64 " %12" PRIu64,
+                          nas_acl_lock_name (s.lock), s.site, s.count,
+                          s.wait_ns / 1000, s.wait_max_ns / 1000,
+                          s.hold_ns / 1000, s.hold_max_ns / 1000);
+    }
+
+    NAS_ACL_LOG_DUMP ("Holds of %d us or longer:", NAS_ACL_LOCK_LONG_HOLD_US);
+    for (const auto& h: holds) {
+        NAS_ACL_LOG_DUMP ("  %-15s %-40s at %" PRIu64 " ms: waited %" PRIu64
+                          " us, held %" PRIu64 " us",
+                          nas_acl_lock_name (h.lock), h.site, h.acquired_ns / 1000000,
+                          (h.acquired_ns - h.start_ns) / 1000,
+                          (h.released_ns - h.acquired_ns) / 1000);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_mem.cpp
+ * \brief  Memory footprint of the NAS ACL object caches
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_switch_list.h"
+#include <inttypes.h>
+
+const char* nas_acl_mem_type_name (nas_acl_mem_type_t type) noexcept
+{
+    switch (type) {
+        case NAS_ACL_MEM_TABLE:       return "Table";
+        case NAS_ACL_MEM_ENTRY:       return "Entry";
+        case NAS_ACL_MEM_FILTER:      return "Filter";
+        case NAS_ACL_MEM_ACTION:      return "Action";
+        case NAS_ACL_MEM_PORT_LIST:   return "Port List";
+        case NAS_ACL_MEM_COUNTER:     return "Counter";
+        case NAS_ACL_MEM_INTF_BIND:   return "Interface Bind";
+        case NAS_ACL_MEM_PBR_CACHE:   return "PBR Cache";
+        case NAS_ACL_MEM_UDF:         return "UDF";
+        default:                      return "Unknown";
+    }
+}
+
+void nas_acl_mem_usage_get (nas_acl_mem_usage_t usage[NAS_ACL_MEM_TYPE_MAX]) noexcept
+{
+    nas_acl_mem_account acct;
+
+    nas_acl_lock ();
+    for (const auto& switch_pair: nas_acl_get_switch_list ()) {
+        switch_pair.second.mem_usage (acct);
+    }
+    nas_acl_unlock ();
+
+    for (int type = 0; type < NAS_ACL_MEM_TYPE_MAX; type++) {
+        usage[type] = acct.usage ((nas_acl_mem_type_t) type);
+    }
+}
+
+void dump_acl_mem_usage (void)
+{
+    nas_acl_mem_usage_t usage[NAS_ACL_MEM_TYPE_MAX];
+    uint64_t total_bytes = 0, total_allocs = 0;
+
+    nas_acl_mem_usage_get (usage);
+
+    NAS_ACL_LOG_DUMP ("%-15s %10s %14s %12s %12s",
+                      "Type", "Objects", "Bytes", "Allocs", "Bytes/Obj");
+    for (int type = 0; type < NAS_ACL_MEM_TYPE_MAX; type++) {
+        const auto& u = usage[type];
+
+        NAS_ACL_LOG_DUMP ("%-15s %10" PRIu64 " %14" PRIu64 " %12" PRIu64 " %12" PRIu64,
+                          nas_acl_mem_type_name ((nas_acl_mem_type_t) type),
+                          u.objs, u.bytes, u.allocs,
+                          (u.objs > 0) ? u.bytes / u.objs : 0);
+        total_bytes += u.bytes;
+        total_allocs += u.allocs;
+    }
+    NAS_ACL_LOG_DUMP ("%-15s %10s %14" PRIu64 " %12" PRIu64,
+                      "Total", "", total_bytes, total_allocs);
+}
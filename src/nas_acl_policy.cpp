@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_policy.cpp
+ * \brief  Binary ACL policy files and their bulk loader
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_common.h"
+#include "nas_acl_policy.h"
+#include "cps_api_object.h"
+#include "cps_api_object_key.h"
+#include "cps_class_map.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Policy file is a header followed by one record per object. A record is
+ * the CPS object as serialized by cps_api_object_array, so it carries its
+ * key and attributes the same way they come in over CPS. Records are
+ * padded to 8 bytes and stored in create order, which lets the loader
+ * walk the mapped file once, front to back, with no lookups.
+ */
+static constexpr uint32_t NAS_ACL_POLICY_MAGIC   = 0x4c50414e;    // "NAPL"
+static constexpr uint16_t NAS_ACL_POLICY_VERSION = 1;
+
+struct nas_acl_policy_hdr_t {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    reserved;
+    uint64_t    count;
+    uint64_t    data_len;   // Bytes of records after the header
+    uint64_t    checksum;   // Over the records
+};
+
+struct nas_acl_policy_rec_t {
+    uint32_t    len;        // Of the serialized object, without padding
+    uint32_t    reserved;
+};
+
+static_assert (sizeof (nas_acl_policy_hdr_t) == 32, "Policy header layout changed");
+static_assert (sizeof (nas_acl_policy_rec_t) == 8, "Policy record layout changed");
+
+static inline size_t _policy_rec_size (size_t len) noexcept
+{
+    return sizeof (nas_acl_policy_rec_t) + ((len + 7) & ~(size_t) 7);
+}
+
+static std::mutex              _policy_mutex;
+static nas_acl_policy_info_t   _policy_info;
+
+/////// Policy save ///////
+
+// Appends every object of one type, as the GET handler returns them
+static bool _policy_collect (cps_api_attr_id_t obj_attr, std::vector<uint8_t>& data,
+                             uint64_t& count) noexcept
+{
+    cps_api_get_params_t params;
+
+    if (cps_api_get_request_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+
+    bool ok = false;
+    cps_api_object_t filter = cps_api_object_list_create_obj_and_append (params.filters);
+    if (filter != NULL &&
+        cps_api_key_from_attr_with_qual (cps_api_object_key (filter), obj_attr,
+                                         cps_api_qualifier_TARGET) &&
+        nas_acl_cps_api_read (NULL, &params, 0) == cps_api_ret_code_OK) {
+
+        ok = true;
+        size_t n = cps_api_object_list_size (params.list);
+        for (size_t ix = 0; ok && ix < n; ix++) {
+            cps_api_object_t obj = cps_api_object_list_get (params.list, ix);
+            nas_acl_policy_rec_t rec {};
+            rec.len = cps_api_object_to_array_len (obj);
+
+            try {
+                size_t off = data.size ();
+                data.resize (off + _policy_rec_size (rec.len), 0);
+                memcpy (&data [off], &rec, sizeof (rec));
+                memcpy (&data [off + sizeof (rec)], cps_api_object_array (obj), rec.len);
+                count++;
+            } catch (...) {
+                ok = false;
+            }
+        }
+    }
+
+    cps_api_get_request_close (&params);
+    return ok;
+}
+
+t_std_error nas_acl_policy_save (const char* path) noexcept
+{
+    // Create order: entries refer to counters and ranges, all to tables
+    static const cps_api_attr_id_t obj_order [] = {
+        BASE_ACL_RANGE_OBJ,
+        BASE_ACL_TABLE_OBJ,
+        BASE_ACL_COUNTER_OBJ,
+        BASE_ACL_ENTRY_OBJ,
+    };
+
+    std::vector<uint8_t> data;
+    uint64_t count = 0;
+
+    for (auto obj_attr: obj_order) {
+        if (!_policy_collect (obj_attr, data, count)) {
+            NAS_ACL_LOG_ERR ("Policy %s: reading objects of type %" PRIu64 " failed",
+                             path, (uint64_t) obj_attr);
+            return NAS_ACL_E_FAIL;
+        }
+    }
+
+    nas_acl_policy_hdr_t hdr {};
+    hdr.magic = NAS_ACL_POLICY_MAGIC;
+    hdr.version = NAS_ACL_POLICY_VERSION;
+    hdr.count = count;
+    hdr.data_len = data.size ();
+    hdr.checksum = nas_acl_hash_bytes (0, data.data (), data.size ());
+
+    std::string tmp_path = std::string {path} + ".tmp";
+    FILE* fp = fopen (tmp_path.c_str (), "wb");
+    if (fp == nullptr) {
+        NAS_ACL_LOG_ERR ("Policy %s open failed: %s", tmp_path.c_str (), strerror (errno));
+        return NAS_ACL_E_FAIL;
+    }
+
+    bool ok = (fwrite (&hdr, sizeof (hdr), 1, fp) == 1) &&
+              (data.empty () || fwrite (data.data (), data.size (), 1, fp) == 1) &&
+              (fflush (fp) == 0) && (fsync (fileno (fp)) == 0);
+    ok = (fclose (fp) == 0) && ok;
+
+    if (!ok || rename (tmp_path.c_str (), path) != 0) {
+        NAS_ACL_LOG_ERR ("Policy %s write failed: %s", path, strerror (errno));
+        unlink (tmp_path.c_str ());
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_NOTICE ("Policy %s saved with %" PRIu64 " objects, %zu bytes",
+                        path, count, data.size ());
+    return NAS_ACL_E_NONE;
+}
+
+/////// Policy load ///////
+
+/*
+ * Creates one batch in one transaction. The write handler fit checks all
+ * entries of the transaction on its first object, so a batch that cannot
+ * fit is refused before anything is programmed.
+ */
+static bool _policy_load_batch (const std::vector<const nas_acl_policy_rec_t*>& recs,
+                                uint64_t& loaded) noexcept
+{
+    cps_api_transaction_params_t params;
+
+    if (cps_api_transaction_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+
+    bool ok = true;
+    for (auto rec: recs) {
+        cps_api_object_t obj = cps_api_object_create ();
+        if (obj == NULL) {
+            ok = false;
+            break;
+        }
+        if (!cps_api_array_to_object (rec + 1, rec->len, obj) ||
+            cps_api_create (&params, obj) != cps_api_ret_code_OK) {
+            cps_api_object_delete (obj);
+            ok = false;
+            break;
+        }
+    }
+
+    size_t done = 0;
+    if (ok) {
+        size_t n = cps_api_object_list_size (params.change_list);
+        for (; done < n; done++) {
+            if (nas_acl_cps_api_write (NULL, &params, done) != cps_api_ret_code_OK) {
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    if (!ok) {
+        // Undo what this batch created, last object first
+        while (done > 0) {
+            nas_acl_cps_api_rollback (NULL, &params, --done);
+        }
+    }
+
+    loaded += ok ? recs.size () : 0;
+    cps_api_transaction_close (&params);
+    return ok;
+}
+
+t_std_error nas_acl_policy_load (const char* path, size_t batch_size,
+                                 nas_acl_policy_info_t* info) noexcept
+{
+    using clock = std::chrono::steady_clock;
+    struct stat st;
+
+    if (batch_size == 0) {
+        batch_size = NAS_ACL_POLICY_BATCH_SIZE;
+    }
+
+    int fd = open (path, O_RDONLY);
+    if (fd < 0) {
+        NAS_ACL_LOG_ERR ("Policy %s open failed: %s", path, strerror (errno));
+        return NAS_ACL_E_KEY_VAL;
+    }
+
+    if (fstat (fd, &st) != 0 || (size_t) st.st_size < sizeof (nas_acl_policy_hdr_t)) {
+        close (fd);
+        NAS_ACL_LOG_ERR ("Policy %s is too short", path);
+        return NAS_ACL_E_FAIL;
+    }
+
+    void* p = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (p == MAP_FAILED) {
+        NAS_ACL_LOG_ERR ("Policy %s map failed: %s", path, strerror (errno));
+        return NAS_ACL_E_FAIL;
+    }
+    madvise (p, st.st_size, MADV_SEQUENTIAL);
+
+    auto hdr = static_cast<const nas_acl_policy_hdr_t*> (p);
+    auto data = reinterpret_cast<const uint8_t*> (hdr + 1);
+    auto end = static_cast<const uint8_t*> (p) + st.st_size;
+
+    bool ok = hdr->magic == NAS_ACL_POLICY_MAGIC && hdr->version == NAS_ACL_POLICY_VERSION &&
+              hdr->data_len == (uint64_t) (end - data) &&
+              hdr->checksum == nas_acl_hash_bytes (0, data, hdr->data_len);
+    if (!ok) {
+        munmap (p, st.st_size);
+        NAS_ACL_LOG_ERR ("Policy %s is not valid", path);
+        return NAS_ACL_E_FAIL;
+    }
+
+    nas_acl_policy_info_t run {};
+    run.file_bytes = st.st_size;
+    run.objs = hdr->count;
+
+    std::vector<const nas_acl_policy_rec_t*> batch;
+    t_std_error rc = NAS_ACL_E_NONE;
+    auto start = clock::now ();
+
+    try {
+        batch.reserve (batch_size);
+        const uint8_t* cur = data;
+
+        for (uint64_t ix = 0; ix < hdr->count; ix++) {
+            auto rec = reinterpret_cast<const nas_acl_policy_rec_t*> (cur);
+            if ((size_t) (end - cur) < sizeof (*rec) ||
+                (size_t) (end - cur) < _policy_rec_size (rec->len)) {
+                NAS_ACL_LOG_ERR ("Policy %s: record %" PRIu64 " runs past the end", path, ix);
+                rc = NAS_ACL_E_FAIL;
+                break;
+            }
+            cur += _policy_rec_size (rec->len);
+            batch.push_back (rec);
+
+            if (batch.size () == batch_size || ix + 1 == hdr->count) {
+                run.batches++;
+                if (!_policy_load_batch (batch, run.loaded)) {
+                    NAS_ACL_LOG_ERR ("Policy %s: batch %" PRIu64 " failed, %" PRIu64
+                                     " of %" PRIu64 " objects loaded",
+                                     path, run.batches, run.loaded, run.objs);
+                    rc = NAS_ACL_E_FAIL;
+                    break;
+                }
+                batch.clear ();
+            }
+        }
+    } catch (...) {
+        NAS_ACL_LOG_ERR ("Policy %s load failed", path);
+        rc = NAS_ACL_E_MEM;
+    }
+
+    run.load_us = std::chrono::duration_cast<std::chrono::microseconds> (
+                      clock::now () - start).count ();
+    run.objs_per_sec = (run.load_us > 0) ? run.loaded * 1000000 / run.load_us : run.loaded;
+    munmap (p, st.st_size);
+
+    if (rc == NAS_ACL_E_NONE) {
+        NAS_ACL_LOG_NOTICE ("Policy %s loaded: %" PRIu64 " objects in %" PRIu64 " batches, %"
+                            PRIu64 " us", path, run.loaded, run.batches, run.load_us);
+    }
+
+    {
+        std::lock_guard<std::mutex> l {_policy_mutex};
+        _policy_info = run;
+    }
+    if (info != NULL) {
+        *info = run;
+    }
+    return rc;
+}
+
+/////// Debug dump routines ///////
+
+void dump_acl_policy (void)
+{
+    nas_acl_policy_info_t info;
+    {
+        std::lock_guard<std::mutex> l {_policy_mutex};
+        info = _policy_info;
+    }
+
+    NAS_ACL_LOG_DUMP ("ACL policy, last load");
+    NAS_ACL_LOG_DUMP ("  File bytes        %" PRIu64, info.file_bytes);
+    NAS_ACL_LOG_DUMP ("  Objects           %" PRIu64, info.objs);
+    NAS_ACL_LOG_DUMP ("  Loaded            %" PRIu64, info.loaded);
+    NAS_ACL_LOG_DUMP ("  Batches           %" PRIu64, info.batches);
+    NAS_ACL_LOG_DUMP ("  Load time         %" PRIu64 " us", info.load_us);
+    NAS_ACL_LOG_DUMP ("  Objects/sec       %" PRIu64, info.objs_per_sec);
+}
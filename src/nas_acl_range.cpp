@@ -23,6 +23,8 @@
 #include "nas_acl_range.h"
 #include "nas_acl_switch.h"
 #include "nas_ndi_acl.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_warm.h"
 
 nas_acl_range::nas_acl_range(nas_acl_switch* switch_p)
     : nas::base_obj_t(switch_p)
@@ -156,7 +158,14 @@ bool nas_acl_range::push_create_obj_to_npu(npu_id_t npu_id, void* ndi_obj)
 
     auto ndi_range_p = static_cast<ndi_acl_range_t*>(ndi_obj);
 
-    rc = ndi_acl_range_create(npu_id, ndi_range_p, &ndi_range_id);
+    if (nas_acl_warm_adopt(*this, npu_id, ndi_range_id)) {
+        // Already in the NPU from before a warm restart
+        _ndi_obj_ids[npu_id] = ndi_range_id;
+        return true;
+    }
+
+    rc = nas_acl_lat_call(NAS_ACL_LAT_NDI_RANGE_CREATE, ndi_acl_range_create,
+                          npu_id, ndi_range_p, &ndi_range_id);
     if (rc != STD_ERR_OK) {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                         std::string {"NDI Fail: ACL Range Create Failed for NPU "}
@@ -172,7 +181,8 @@ bool nas_acl_range::push_delete_obj_to_npu(npu_id_t npu_id)
 {
     t_std_error rc;
 
-    rc = ndi_acl_range_delete(npu_id, _ndi_obj_ids.at (npu_id));
+    rc = nas_acl_lat_call(NAS_ACL_LAT_NDI_RANGE_DELETE, ndi_acl_range_delete,
+                          npu_id, _ndi_obj_ids.at (npu_id));
     if (rc != STD_ERR_OK) {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
                                   std::string {"NDI Fail: ACL Range "}
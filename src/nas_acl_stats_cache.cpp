@@ -0,0 +1,1121 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_stats_cache.cpp
+ * \brief  Cache of ACL counter values refreshed by a background poller
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "nas_acl_log.h"
+#include "nas_acl_switch_list.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_stats.h"
+#include "nas_ndi_acl.h"
+#include "nas_acl_latency.h"
+#include <map>
+#include <set>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <inttypes.h>
+#include <math.h>
+
+struct nas_acl_stats_key_t {
+    nas_switch_id_t switch_id;
+    nas_obj_id_t    table_id;
+    nas_obj_id_t    counter_id;
+    npu_id_t        npu_id;
+
+    bool operator< (const nas_acl_stats_key_t& rhs) const noexcept {
+        if (switch_id != rhs.switch_id) return (switch_id < rhs.switch_id);
+        if (table_id != rhs.table_id) return (table_id < rhs.table_id);
+        if (counter_id != rhs.counter_id) return (counter_id < rhs.counter_id);
+        return (npu_id < rhs.npu_id);
+    }
+};
+
+struct nas_acl_stats_row_t {
+    ndi_obj_id_t ndi_counter_id;
+    bool         valid;       // False once the count was changed in hardware
+    bool         byte_valid;
+    bool         pkt_valid;
+    uint64_t     byte_count;
+    uint64_t     pkt_count;
+    uint64_t     read_ms;     // Time the count was read from NDI
+};
+
+typedef std::map<nas_acl_stats_key_t, nas_acl_stats_row_t> nas_acl_stats_rows_t;
+
+// Last sample and smoothed rates of a counter in one NPU
+struct nas_acl_stats_rate_state_t {
+    uint64_t     byte_count;
+    uint64_t     pkt_count;
+    uint64_t     sample_ms;
+    double       bps;
+    double       pps;
+    bool         has_rate;
+};
+
+typedef std::map<nas_acl_stats_key_t, nas_acl_stats_rate_state_t> nas_acl_stats_rates_t;
+
+// Counts of a counter in one NPU at the time it was cleared
+// in software. Reported counts are hardware minus baseline.
+struct nas_acl_stats_baseline_t {
+    uint64_t     byte_count;
+    uint64_t     pkt_count;
+    uint64_t     read_ms;
+};
+
+typedef std::map<nas_acl_stats_key_t, nas_acl_stats_baseline_t> nas_acl_stats_baselines_t;
+
+// Per counter sums over the NPUs
+struct nas_acl_stats_total_t {
+    uint64_t     byte_count;    // Hardware counts
+    uint64_t     pkt_count;
+    uint64_t     byte_shown;    // Counts less baseline
+    uint64_t     pkt_shown;
+    uint64_t     read_ms;
+};
+
+typedef std::map<nas_acl_stats_key_t, nas_acl_stats_total_t> nas_acl_stats_totals_t;
+
+// Counters that moved in one poll interval
+struct nas_acl_stats_window_slot_t {
+    uint64_t                            interval_ms;
+    std::vector<nas_acl_stats_delta_t>  deltas;
+};
+
+struct nas_acl_stats_window_sum_t {
+    uint64_t     byte_delta;
+    uint64_t     pkt_delta;
+};
+
+typedef std::map<nas_acl_stats_key_t, nas_acl_stats_window_sum_t> nas_acl_stats_window_sums_t;
+
+// The cache has its own lock so that the poller never
+// needs the NAS ACL lock while it talks to the NPU
+static std::mutex                  _stats_cache_mutex;
+static nas_acl_stats_rows_t        _stats_cache;
+static nas_acl_stats_cache_info_t  _stats_cache_info;
+static nas_acl_stats_rates_t       _stats_rates;
+static nas_acl_stats_totals_t      _stats_prev_totals;   // Keyed with NPU 0
+static bool                        _stats_stream_enabled = false;
+static nas_acl_stats_baselines_t   _stats_baselines;
+static bool                        _stats_soft_clear = false;
+
+// Sliding window over the last polls for the top-N query. Only counters
+// that moved are kept, with their sums over the window.
+static std::deque<nas_acl_stats_window_slot_t> _stats_window;
+static nas_acl_stats_window_sums_t _stats_window_sums;
+static uint64_t                    _stats_window_ms = 0;
+static uint64_t                    _stats_last_poll_ms = 0;
+
+static std::mutex                  _poller_mutex;
+static std::condition_variable     _poller_cv;
+static std::thread*                _poller_thread = nullptr;
+static bool                        _poller_running = false;
+static uint32_t                    _poll_interval_ms = NAS_ACL_STATS_POLL_INTERVAL_MS;
+static uint32_t                    _max_age_ms = NAS_ACL_STATS_MAX_AGE_MS;
+
+static uint64_t _stats_now_ms () noexcept
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+static nas_acl_stats_key_t _stats_key (const nas_acl_counter_t& counter,
+                                       npu_id_t npu_id) noexcept
+{
+    return {counter.switch_id (), counter.table_id (), counter.counter_id (), npu_id};
+}
+
+// Cached row can stand in for the counter only if it was read
+// from the same NDI object with the same count types enabled
+static bool _stats_row_matches (const nas_acl_stats_row_t& row,
+                                const nas_acl_counter_t& counter,
+                                npu_id_t npu_id) noexcept
+{
+    return (row.valid &&
+            row.ndi_counter_id == counter.ndi_obj_id (npu_id) &&
+            row.byte_valid == counter.is_byte_count_enabled () &&
+            row.pkt_valid == counter.is_pkt_count_enabled ());
+}
+
+// Fold a new count into the smoothed rates. Samples closer together
+// than the minimum interval are skipped as too noisy.
+// Called with the stats cache lock held.
+static void _stats_rate_update (const nas_acl_stats_key_t& key,
+                                const nas_acl_stats_row_t& row)
+{
+    auto it = _stats_rates.find (key);
+
+    if (it == _stats_rates.end ()) {
+        _stats_rates[key] = {row.byte_count, row.pkt_count, row.read_ms, 0, 0, false};
+        return;
+    }
+
+    auto& st = it->second;
+    if (row.read_ms < st.sample_ms + NAS_ACL_STATS_RATE_MIN_MS) {
+        return;
+    }
+
+    if (row.byte_count < st.byte_count || row.pkt_count < st.pkt_count) {
+        // Count went back, start over from this sample
+        st = {row.byte_count, row.pkt_count, row.read_ms, 0, 0, false};
+        return;
+    }
+
+    double dt = (row.read_ms - st.sample_ms) / 1000.0;
+    double bps = (row.byte_count - st.byte_count) / dt;
+    double pps = (row.pkt_count - st.pkt_count) / dt;
+
+    if (st.has_rate) {
+        // Weight of the new sample depends on how long it covers
+        double alpha = 1.0 - exp (-(dt * 1000.0) / NAS_ACL_STATS_RATE_TAU_MS);
+        st.bps += alpha * (bps - st.bps);
+        st.pps += alpha * (pps - st.pps);
+    } else {
+        st.bps = bps;
+        st.pps = pps;
+        st.has_rate = true;
+    }
+    st.byte_count = row.byte_count;
+    st.pkt_count = row.pkt_count;
+    st.sample_ms = row.read_ms;
+}
+
+// Take the baseline off counts read at read_ms. A count below its
+// baseline that was read after the baseline means the hardware counter
+// was reset, the baseline no longer applies then.
+// Called with the stats cache lock held.
+static void _stats_baseline_apply (const nas_acl_stats_key_t& key, uint64_t read_ms,
+                                   uint64_t& byte_count, uint64_t& pkt_count)
+{
+    auto it = _stats_baselines.find (key);
+    if (it == _stats_baselines.end ()) return;
+
+    const auto& base = it->second;
+    if ((byte_count < base.byte_count || pkt_count < base.pkt_count) &&
+        read_ms > base.read_ms) {
+        _stats_baselines.erase (it);
+        return;
+    }
+
+    byte_count = (byte_count > base.byte_count) ? byte_count - base.byte_count : 0;
+    pkt_count = (pkt_count > base.pkt_count) ? pkt_count - base.pkt_count : 0;
+}
+
+// Called with the stats cache lock held
+static void _stats_store (const nas_acl_stats_key_t& key,
+                          const nas_acl_stats_row_t& new_row)
+{
+    auto& row = _stats_cache[key];
+
+    if (row.read_ms <= new_row.read_ms) {
+        row = new_row;
+        _stats_rate_update (key, new_row);
+    }
+}
+
+struct nas_acl_stats_poll_item_t {
+    nas_acl_stats_key_t key;
+    nas_acl_stats_row_t row;
+};
+
+static void _stats_collect_table (const nas_acl_switch& s,
+                                  nas_obj_id_t table_id,
+                                  std::vector<nas_acl_stats_poll_item_t>& items)
+{
+    for (const auto& cnt_kvp: s.counter_list (table_id)) {
+        const auto& counter = cnt_kvp.second;
+
+        for (auto npu_id: counter.npu_list ()) {
+            if (!counter.is_obj_in_npu (npu_id)) continue;
+
+            items.push_back ({_stats_key (counter, npu_id),
+                              {counter.ndi_obj_id (npu_id), true,
+                               counter.is_byte_count_enabled (),
+                               counter.is_pkt_count_enabled (),
+                               0, 0, 0}});
+        }
+    }
+}
+
+static bool _stats_poll_collect (std::vector<nas_acl_stats_poll_item_t>& items) noexcept
+{
+    bool complete = false;
+
+    nas_acl_lock ();
+
+    try {
+        for (const auto& switch_pair: nas_acl_get_switch_list ()) {
+            const nas_acl_switch& s = switch_pair.second;
+
+            for (const auto& tbl_kvp: s.table_list ()) {
+                _stats_collect_table (s, tbl_kvp.first, items);
+            }
+        }
+        complete = true;
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats poll walk failed: %s", e.what ());
+    }
+
+    nas_acl_unlock ();
+    return complete;
+}
+
+static void _stats_ndi_read_one (nas_acl_stats_poll_item_t& item, uint64_t& errors) noexcept
+{
+    auto& row = item.row;
+
+    row.read_ms = _stats_now_ms ();
+    if (nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_GET, ndi_acl_counter_get_count,
+                          item.key.npu_id, row.ndi_counter_id,
+                          row.byte_valid ? &row.byte_count : nullptr,
+                          row.pkt_valid ? &row.pkt_count : nullptr)
+        != STD_ERR_OK) {
+        // Counter was most likely deleted after the walk
+        row.valid = false;
+        errors++;
+    }
+}
+
+// Read the counts of all items with one NDI request per NPU
+// for each batch. Falls back to reading counters one at a time
+// if NDI has no bulk read or the batch failed.
+static void _stats_ndi_read (std::vector<nas_acl_stats_poll_item_t>& items,
+                             uint64_t& errors)
+{
+    std::map<npu_id_t, std::vector<nas_acl_stats_poll_item_t*>> npu_items;
+    std::vector<ndi_obj_id_t> ids;
+    std::vector<uint64_t> byte_counts, pkt_counts;
+
+    for (auto& item: items) {
+        npu_items[item.key.npu_id].push_back (&item);
+    }
+
+    for (auto& npu_kvp: npu_items) {
+        auto npu_id = npu_kvp.first;
+        auto& batch_items = npu_kvp.second;
+
+        for (size_t start = 0; start < batch_items.size ();
+             start += NAS_ACL_STATS_BULK_SIZE) {
+
+            size_t count = std::min (batch_items.size () - start,
+                                     (size_t) NAS_ACL_STATS_BULK_SIZE);
+
+            if (ndi_acl_counter_get_count_bulk != nullptr) {
+                ids.resize (count);
+                byte_counts.assign (count, 0);
+                pkt_counts.assign (count, 0);
+                for (size_t i = 0; i < count; i++) {
+                    ids[i] = batch_items[start + i]->row.ndi_counter_id;
+                }
+
+                uint64_t read_ms = _stats_now_ms ();
+                if (nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_GET_BULK,
+                                      ndi_acl_counter_get_count_bulk,
+                                      npu_id, count, ids.data (),
+                                      byte_counts.data (), pkt_counts.data ())
+                    == STD_ERR_OK) {
+                    for (size_t i = 0; i < count; i++) {
+                        auto& row = batch_items[start + i]->row;
+                        row.read_ms = read_ms;
+                        if (row.byte_valid) row.byte_count = byte_counts[i];
+                        if (row.pkt_valid) row.pkt_count = pkt_counts[i];
+                    }
+                    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+                    _stats_cache_info.bulk_read_count++;
+                    continue;
+                }
+                NAS_ACL_LOG_DETAIL ("Bulk counter read of %ld failed on NPU %d",
+                                    count, npu_id);
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                _stats_ndi_read_one (*batch_items[start + i], errors);
+            }
+        }
+    }
+}
+
+// Sum the polled counts per counter and find the counters that moved
+// since the previous poll. A counter seen for the first time only sets
+// the reference point. A counter with a failed read in any NPU keeps its
+// previous totals for this poll, a partial sum would look like a reset.
+// Called with the stats cache lock held.
+static void _stats_poll_deltas (const std::vector<nas_acl_stats_poll_item_t>& items,
+                                std::vector<nas_acl_stats_delta_t>& deltas)
+{
+    nas_acl_stats_totals_t totals;
+    std::set<nas_acl_stats_key_t> failed;
+
+    for (const auto& item: items) {
+        if (!item.row.valid) {
+            failed.insert ({item.key.switch_id, item.key.table_id,
+                            item.key.counter_id, 0});
+            continue;
+        }
+
+        uint64_t byte_count = item.row.byte_valid ? item.row.byte_count : 0;
+        uint64_t pkt_count = item.row.pkt_valid ? item.row.pkt_count : 0;
+        uint64_t byte_shown = byte_count, pkt_shown = pkt_count;
+
+        _stats_baseline_apply (item.key, item.row.read_ms, byte_shown, pkt_shown);
+
+        auto key = item.key;
+        key.npu_id = 0;
+
+        auto& total = totals[key];
+        total.read_ms = std::max (total.read_ms, item.row.read_ms);
+        total.byte_count += byte_count;
+        total.pkt_count += pkt_count;
+        total.byte_shown += byte_shown;
+        total.pkt_shown += pkt_shown;
+    }
+
+    for (const auto& key: failed) {
+        totals.erase (key);
+        auto it = _stats_prev_totals.find (key);
+        if (it != _stats_prev_totals.end ()) {
+            totals.emplace (*it);
+        }
+    }
+    _stats_cache_info.delta_skipped += failed.size ();
+
+    for (const auto& kvp: totals) {
+        auto it = _stats_prev_totals.find (kvp.first);
+        if (it == _stats_prev_totals.end ()) continue;
+
+        const auto& cur = kvp.second;
+        const auto& prev = it->second;
+        if (cur.byte_count == prev.byte_count && cur.pkt_count == prev.pkt_count) {
+            continue;
+        }
+
+        // A count that went back was reset, all of it is new
+        deltas.push_back ({kvp.first.switch_id, kvp.first.table_id,
+                           kvp.first.counter_id, cur.byte_shown, cur.pkt_shown,
+                           (cur.byte_count >= prev.byte_count) ?
+                               cur.byte_count - prev.byte_count : cur.byte_count,
+                           (cur.pkt_count >= prev.pkt_count) ?
+                               cur.pkt_count - prev.pkt_count : cur.pkt_count});
+    }
+
+    _stats_cache_info.delta_count += deltas.size ();
+    _stats_prev_totals.swap (totals);
+}
+
+// Slide the window by one poll: add the new deltas to the sums
+// and take off those of the poll that falls out of the window.
+// Called with the stats cache lock held.
+static void _stats_window_update (const std::vector<nas_acl_stats_delta_t>& deltas,
+                                  uint64_t poll_ms)
+{
+    if (_stats_last_poll_ms == 0) {
+        _stats_last_poll_ms = poll_ms;
+        return;
+    }
+
+    uint64_t interval_ms = poll_ms - _stats_last_poll_ms;
+    _stats_last_poll_ms = poll_ms;
+
+    _stats_window.push_back ({interval_ms, deltas});
+    _stats_window_ms += interval_ms;
+
+    for (const auto& delta: deltas) {
+        auto& sum = _stats_window_sums[{delta.switch_id, delta.table_id,
+                                        delta.counter_id, 0}];
+        sum.byte_delta += delta.byte_delta;
+        sum.pkt_delta += delta.pkt_delta;
+    }
+
+    while (_stats_window.size () > NAS_ACL_STATS_TOP_WINDOW) {
+        const auto& slot = _stats_window.front ();
+
+        for (const auto& delta: slot.deltas) {
+            auto it = _stats_window_sums.find ({delta.switch_id, delta.table_id,
+                                                delta.counter_id, 0});
+            if (it == _stats_window_sums.end ()) continue;
+
+            it->second.byte_delta -= std::min (it->second.byte_delta, delta.byte_delta);
+            it->second.pkt_delta -= std::min (it->second.pkt_delta, delta.pkt_delta);
+            if (it->second.byte_delta == 0 && it->second.pkt_delta == 0) {
+                _stats_window_sums.erase (it);
+            }
+        }
+        _stats_window_ms -= slot.interval_ms;
+        _stats_window.pop_front ();
+    }
+}
+
+// Called with the stats cache lock held
+static void _stats_shm_export ()
+{
+    std::vector<nas_acl_stats_shm_rec_t> recs;
+
+    recs.reserve (_stats_prev_totals.size ());
+    for (const auto& kvp: _stats_prev_totals) {
+        recs.push_back ({kvp.first.table_id, kvp.first.counter_id,
+                         kvp.second.pkt_shown, kvp.second.byte_shown,
+                         kvp.second.read_ms});
+    }
+
+    nas_acl_stats_shm_publish (recs.data (), recs.size (), recs.size (),
+                               _stats_now_ms ());
+}
+
+void nas_acl_stats_poll_now (void) noexcept
+{
+    std::vector<nas_acl_stats_poll_item_t> items;
+    uint64_t errors = 0;
+    uint64_t start_ms = _stats_now_ms ();
+    std::vector<nas_acl_stats_delta_t> deltas;
+    bool stream = false;
+
+    // Only the walk of the counter DB needs the NAS ACL lock
+    bool complete = _stats_poll_collect (items);
+
+    try {
+        nas_acl_stats_rows_t rows;
+
+        _stats_ndi_read (items, errors);
+
+        for (const auto& item: items) {
+            if (item.row.valid) rows.emplace (item.key, item.row);
+        }
+
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        for (const auto& item: items) {
+            if (item.row.valid) _stats_rate_update (item.key, item.row);
+        }
+
+        _stats_poll_deltas (items, deltas);
+        _stats_window_update (deltas, start_ms);
+        stream = _stats_stream_enabled;
+
+        if (nas_acl_stats_shm_is_open ()) {
+            _stats_shm_export ();
+        }
+
+        // Keep rows written after this poll read the hardware
+        // (GET reads and count changes), drop deleted counters
+        for (const auto& old_kvp: _stats_cache) {
+            if (old_kvp.second.read_ms == 0) continue;
+
+            auto it = rows.find (old_kvp.first);
+            if (it != rows.end () && old_kvp.second.read_ms >= it->second.read_ms) {
+                it->second = old_kvp.second;
+            } else if (it == rows.end () && !old_kvp.second.valid &&
+                       old_kvp.second.read_ms >= start_ms) {
+                rows.emplace (old_kvp.first, old_kvp.second);
+            }
+        }
+
+        _stats_cache.swap (rows);
+
+        for (auto it = _stats_rates.begin (); it != _stats_rates.end ();) {
+            if (_stats_cache.find (it->first) == _stats_cache.end ()) {
+                it = _stats_rates.erase (it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (complete) {
+            // Baselines of counters that are gone
+            std::set<nas_acl_stats_key_t> walked;
+            for (const auto& item: items) {
+                walked.insert (item.key);
+            }
+            for (auto it = _stats_baselines.begin (); it != _stats_baselines.end ();) {
+                if (walked.find (it->first) == walked.end ()) {
+                    it = _stats_baselines.erase (it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        _stats_cache_info.poll_count++;
+        _stats_cache_info.poll_errors += errors;
+
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats poll update failed: %s", e.what ());
+    }
+
+    NAS_ACL_LOG_DETAIL ("Stats poll read %ld counts, %" PRIu64 " failed, %ld changed",
+                        items.size (), errors, deltas.size ());
+
+    if (stream && !deltas.empty ()) {
+        // Events go out after all locks are released
+        auto published = nas_acl_stats_publish_deltas (deltas);
+
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+        _stats_cache_info.stream_events += published;
+    }
+}
+
+t_std_error nas_acl_stats_stream_enable (bool enable) noexcept
+{
+    if (enable) {
+        t_std_error rc = nas_acl_stats_event_connect ();
+        if (rc != NAS_ACL_E_NONE) {
+            return rc;
+        }
+    }
+
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    _stats_stream_enabled = enable;
+    return NAS_ACL_E_NONE;
+}
+
+static void _stats_poller_main (void) noexcept
+{
+    std::unique_lock<std::mutex> l (_poller_mutex);
+
+    while (_poller_running) {
+        uint32_t interval_ms = _poll_interval_ms;
+
+        if (interval_ms == 0) {
+            _poller_cv.wait (l);
+            continue;
+        }
+
+        auto deadline = std::chrono::steady_clock::now () +
+                        std::chrono::milliseconds (interval_ms);
+
+        if (_poller_cv.wait_until (l, deadline, [interval_ms] {
+                return (!_poller_running || _poll_interval_ms != interval_ms);
+            })) {
+            // Stopped or given a new interval
+            continue;
+        }
+
+        l.unlock ();
+        nas_acl_stats_poll_now ();
+        l.lock ();
+    }
+}
+
+t_std_error nas_acl_stats_poller_start (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_poller_mutex);
+
+    if (_poller_running) {
+        return NAS_ACL_E_NONE;
+    }
+
+    try {
+        _poller_running = true;
+        _poller_thread = new std::thread (_stats_poller_main);
+    } catch (std::exception& e) {
+        _poller_running = false;
+        NAS_ACL_LOG_ERR ("Could not start stats poller: %s", e.what ());
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Stats poller started, interval %d ms", _poll_interval_ms);
+    if (ndi_acl_counter_get_count_bulk == nullptr) {
+        NAS_ACL_LOG_NOTICE ("NDI has no bulk counter read, counters are read one at a time");
+    }
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_stats_poller_stop (void) noexcept
+{
+    std::thread* thread_p;
+
+    {
+        std::lock_guard<std::mutex> l (_poller_mutex);
+
+        if (!_poller_running) return;
+
+        _poller_running = false;
+        thread_p = _poller_thread;
+        _poller_thread = nullptr;
+    }
+
+    _poller_cv.notify_all ();
+    thread_p->join ();
+    delete thread_p;
+}
+
+void nas_acl_stats_poll_interval_set (uint32_t interval_ms) noexcept
+{
+    {
+        std::lock_guard<std::mutex> l (_poller_mutex);
+        _poll_interval_ms = interval_ms;
+    }
+    _poller_cv.notify_all ();
+}
+
+void nas_acl_stats_max_age_set (uint32_t max_age_ms) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    _max_age_ms = max_age_ms;
+}
+
+uint32_t nas_acl_stats_max_age_get (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    return _max_age_ms;
+}
+
+uint64_t nas_acl_stats_now_ms (void) noexcept
+{
+    return _stats_now_ms ();
+}
+
+uint32_t nas_acl_stats_req_max_age (uint64_t since_ms) noexcept
+{
+    uint64_t max_age_ms = nas_acl_stats_max_age_get ();
+
+    if (since_ms != 0) {
+        max_age_ms = std::max (max_age_ms, _stats_now_ms () - since_ms);
+    }
+    return (uint32_t) std::min (max_age_ms, (uint64_t) UINT32_MAX);
+}
+
+t_std_error nas_acl_stats_cached_get (const nas_acl_counter_t& counter,
+                                      npu_id_t  npu_id,
+                                      uint32_t  max_age_ms,
+                                      bool&     byte_valid,
+                                      uint64_t* byte_count_p,
+                                      bool&     pkt_valid,
+                                      uint64_t* pkt_count_p) noexcept
+{
+    if (byte_count_p == nullptr || pkt_count_p == nullptr) {
+        NAS_ACL_LOG_ERR ("NULL pointer was not accepted as input argument");
+        return NAS_ACL_E_ATTR_VAL;
+    }
+
+    if (!counter.is_obj_in_npu (npu_id)) {
+        // Let the NDI read report the error
+        return counter.get_count_ndi (npu_id, byte_valid, byte_count_p,
+                                      pkt_valid, pkt_count_p);
+    }
+
+    auto key = _stats_key (counter, npu_id);
+
+    try {
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        auto it = _stats_cache.find (key);
+        if (it != _stats_cache.end () &&
+            _stats_row_matches (it->second, counter, npu_id) &&
+            _stats_now_ms () - it->second.read_ms <= max_age_ms) {
+
+            uint64_t byte_count = it->second.byte_count;
+            uint64_t pkt_count = it->second.pkt_count;
+
+            _stats_baseline_apply (key, it->second.read_ms, byte_count, pkt_count);
+
+            byte_valid = it->second.byte_valid;
+            pkt_valid = it->second.pkt_valid;
+            if (byte_valid) *byte_count_p = byte_count;
+            if (pkt_valid) *pkt_count_p = pkt_count;
+            _stats_cache_info.hit_count++;
+            return NAS_ACL_E_NONE;
+        }
+        _stats_cache_info.miss_count++;
+
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats cache lookup failed: %s", e.what ());
+    }
+
+    uint64_t read_ms = _stats_now_ms ();
+    auto rc = counter.get_count_ndi (npu_id, byte_valid, byte_count_p,
+                                     pkt_valid, pkt_count_p);
+    if (rc != NAS_ACL_E_NONE) {
+        return rc;
+    }
+
+    uint64_t byte_count = byte_valid ? *byte_count_p : 0;
+    uint64_t pkt_count = pkt_valid ? *pkt_count_p : 0;
+
+    try {
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        _stats_store (key, {counter.ndi_obj_id (npu_id), true, byte_valid, pkt_valid,
+                            byte_count, pkt_count, read_ms});
+
+        _stats_baseline_apply (key, read_ms, byte_count, pkt_count);
+        if (byte_valid) *byte_count_p = byte_count;
+        if (pkt_valid) *pkt_count_p = pkt_count;
+
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats cache update failed: %s", e.what ());
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_stats_soft_clear_set (bool enable) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    _stats_soft_clear = enable;
+}
+
+bool nas_acl_stats_soft_clear_get (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    return _stats_soft_clear;
+}
+
+t_std_error nas_acl_stats_counter_clear (const nas_acl_counter_t& counter,
+                                         const nas::npu_set_t& npu_list,
+                                         bool clear_pkt, bool clear_byte) noexcept
+{
+    const nas::npu_set_t& loop_npu = (npu_list.empty ()) ? counter.npu_list () : npu_list;
+
+    for (auto npu_id: loop_npu) {
+        uint64_t byte_count = 0, pkt_count = 0;
+        bool byte_valid, pkt_valid;
+
+        uint64_t read_ms = _stats_now_ms ();
+        auto rc = counter.get_count_ndi (npu_id, byte_valid, &byte_count,
+                                         pkt_valid, &pkt_count);
+        if (rc != NAS_ACL_E_NONE) {
+            return rc;
+        }
+
+        if ((clear_pkt && !pkt_valid) || (clear_byte && !byte_valid)) {
+            return NAS_ACL_E_INCONSISTENT;
+        }
+
+        try {
+            std::lock_guard<std::mutex> l (_stats_cache_mutex);
+            auto key = _stats_key (counter, npu_id);
+
+            _stats_store (key, {counter.ndi_obj_id (npu_id), true, byte_valid, pkt_valid,
+                                byte_count, pkt_count, read_ms});
+
+            auto& base = _stats_baselines[key];
+            if (clear_byte) base.byte_count = byte_count;
+            if (clear_pkt) base.pkt_count = pkt_count;
+            base.read_ms = read_ms;
+
+        } catch (std::exception& e) {
+            NAS_ACL_LOG_ERR ("Stats baseline update failed: %s", e.what ());
+            return NAS_ACL_E_MEM;
+        }
+    }
+
+    NAS_ACL_LOG_BRIEF ("Counter %ld cleared in software", counter.counter_id ());
+    return NAS_ACL_E_NONE;
+}
+
+t_std_error nas_acl_stats_table_clear (const nas_acl_table& table) noexcept
+{
+    std::vector<nas_acl_stats_poll_item_t> items;
+    size_t missed = 0;
+
+    // Fresh counts of the whole table first, with bulk reads
+    auto rc = nas_acl_stats_table_refresh (table, 0);
+    if (rc != NAS_ACL_E_NONE) {
+        return rc;
+    }
+
+    try {
+        _stats_collect_table (table.get_switch (), table.table_id (), items);
+
+        // All baselines change in one go so that
+        // no reader sees the table half cleared
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        for (const auto& item: items) {
+            auto it = _stats_cache.find (item.key);
+            if (it == _stats_cache.end () || !it->second.valid ||
+                it->second.ndi_counter_id != item.row.ndi_counter_id) {
+                missed++;
+                continue;
+            }
+
+            _stats_baselines[item.key] = {it->second.byte_count, it->second.pkt_count,
+                                          it->second.read_ms};
+        }
+
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        return e.err_code;
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats clear of Table %ld failed: %s",
+                         table.table_id (), e.what ());
+        return NAS_ACL_E_MEM;
+    }
+
+    if (missed > 0) {
+        NAS_ACL_LOG_ERR ("Table %ld: %ld counts could not be cleared",
+                         table.table_id (), missed);
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Table %ld: %ld counts cleared in software",
+                       table.table_id (), items.size ());
+    return NAS_ACL_E_NONE;
+}
+
+t_std_error nas_acl_stats_table_refresh (const nas_acl_table& table,
+                                         uint32_t max_age_ms) noexcept
+{
+    std::vector<nas_acl_stats_poll_item_t> items;
+    uint64_t errors = 0;
+
+    try {
+        _stats_collect_table (table.get_switch (), table.table_id (), items);
+
+        {
+            // Cached counts that are fresh enough need no read
+            std::lock_guard<std::mutex> l (_stats_cache_mutex);
+            uint64_t now_ms = _stats_now_ms ();
+
+            auto stale = [now_ms, max_age_ms] (const nas_acl_stats_poll_item_t& item) {
+                auto it = _stats_cache.find (item.key);
+                return (it == _stats_cache.end () ||
+                        !it->second.valid ||
+                        it->second.ndi_counter_id != item.row.ndi_counter_id ||
+                        it->second.byte_valid != item.row.byte_valid ||
+                        it->second.pkt_valid != item.row.pkt_valid ||
+                        now_ms - it->second.read_ms > max_age_ms);
+            };
+            items.erase (std::remove_if (items.begin (), items.end (),
+                                         [&stale] (const nas_acl_stats_poll_item_t& item) {
+                                             return !stale (item);
+                                         }),
+                         items.end ());
+        }
+
+        if (items.empty ()) {
+            return NAS_ACL_E_NONE;
+        }
+
+        _stats_ndi_read (items, errors);
+
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        for (const auto& item: items) {
+            if (item.row.valid) _stats_store (item.key, item.row);
+        }
+
+    } catch (nas::base_exception& e) {
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s", e.err_code,
+                         e.err_fn.c_str (), e.err_msg.c_str ());
+        return e.err_code;
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats refresh of Table %ld failed: %s",
+                         table.table_id (), e.what ());
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_DETAIL ("Table %ld: read %ld counts, %" PRIu64 " failed",
+                        table.table_id (), items.size (), errors);
+
+    return (errors == 0) ? NAS_ACL_E_NONE : NAS_ACL_E_FAIL;
+}
+
+void nas_acl_stats_cache_forget (const nas_acl_counter_t& counter) noexcept
+{
+    uint64_t now_ms = _stats_now_ms ();
+
+    try {
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        // Leave a marker newer than any poll that may be in flight
+        // so that the old count is not put back by the poller
+        for (auto npu_id: counter.npu_list ()) {
+            auto key = _stats_key (counter, npu_id);
+            _stats_cache[key] = {0, false, false, false, 0, 0, now_ms};
+            _stats_rates.erase (key);
+            _stats_baselines.erase (key);
+        }
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats cache update failed: %s", e.what ());
+    }
+}
+
+t_std_error nas_acl_stats_rate_get (const nas_acl_counter_t& counter,
+                                    double* bps_p, double* pps_p) noexcept
+{
+    double bps = 0, pps = 0;
+
+    {
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        for (auto npu_id: counter.npu_list ()) {
+            auto it = _stats_rates.find (_stats_key (counter, npu_id));
+            if (it == _stats_rates.end () || !it->second.has_rate) continue;
+
+            bps += it->second.bps;
+            pps += it->second.pps;
+        }
+    }
+
+    if (bps_p) *bps_p = counter.is_byte_count_enabled () ? bps : 0;
+    if (pps_p) *pps_p = counter.is_pkt_count_enabled () ? pps : 0;
+    return NAS_ACL_E_NONE;
+}
+
+t_std_error nas_acl_stats_top_get (size_t count, bool by_bytes,
+                                   std::vector<nas_acl_stats_top_t>& top) noexcept
+{
+    auto rate_less = [by_bytes] (const nas_acl_stats_top_t& a,
+                                 const nas_acl_stats_top_t& b) {
+        return (by_bytes) ? (a.bps > b.bps) : (a.pps > b.pps);
+    };
+
+    top.clear ();
+
+    try {
+        // Min-heap of the count best so far, its top is the one to beat
+        std::priority_queue<nas_acl_stats_top_t, std::vector<nas_acl_stats_top_t>,
+                            decltype (rate_less)> heap (rate_less);
+
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+
+        if (_stats_window_ms == 0 || count == 0) {
+            return NAS_ACL_E_NONE;
+        }
+
+        double secs = _stats_window_ms / 1000.0;
+
+        for (const auto& kvp: _stats_window_sums) {
+            if ((by_bytes ? kvp.second.byte_delta : kvp.second.pkt_delta) == 0) {
+                continue;
+            }
+
+            nas_acl_stats_top_t cand {kvp.first.switch_id, kvp.first.table_id,
+                                      kvp.first.counter_id,
+                                      kvp.second.pkt_delta / secs,
+                                      kvp.second.byte_delta / secs};
+
+            if (heap.size () < count) {
+                heap.push (cand);
+            } else if (rate_less (cand, heap.top ())) {
+                heap.pop ();
+                heap.push (cand);
+            }
+        }
+
+        top.resize (heap.size ());
+        for (auto i = top.size (); i > 0; i--) {
+            top[i - 1] = heap.top ();
+            heap.pop ();
+        }
+
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Stats top query failed: %s", e.what ());
+        return NAS_ACL_E_MEM;
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_stats_cache_info_get (nas_acl_stats_cache_info_t* info_p) noexcept
+{
+    std::lock_guard<std::mutex> l (_stats_cache_mutex);
+    *info_p = _stats_cache_info;
+    info_p->baselines = _stats_baselines.size ();
+}
+
+void dump_stats_cache (void)
+{
+    nas_acl_stats_cache_info_t info;
+    size_t rows;
+    uint32_t interval_ms;
+
+    {
+        std::lock_guard<std::mutex> l (_poller_mutex);
+        interval_ms = _poll_interval_ms;
+    }
+    {
+        std::lock_guard<std::mutex> l (_stats_cache_mutex);
+        info = _stats_cache_info;
+        info.baselines = _stats_baselines.size ();
+        rows = _stats_cache.size ();
+    }
+
+    NAS_ACL_LOG_DUMP ("Stats cache rows: %ld, poll interval: %d ms, max age: %d ms",
+                      rows, interval_ms, nas_acl_stats_max_age_get ());
+    NAS_ACL_LOG_DUMP ("Polls: %" PRIu64 " (NDI errors %" PRIu64 ")",
+                      info.poll_count, info.poll_errors);
+    NAS_ACL_LOG_DUMP ("Hits: %" PRIu64 ", Misses: %" PRIu64 ", Bulk reads: %" PRIu64 "%s",
+                      info.hit_count, info.miss_count, info.bulk_read_count,
+                      (ndi_acl_counter_get_count_bulk == nullptr) ?
+                          " (not supported by NDI)" : "");
+    NAS_ACL_LOG_DUMP ("Change events: %" PRIu64 ", Changed: %" PRIu64 ", Skipped: %" PRIu64,
+                      info.stream_events, info.delta_count, info.delta_skipped);
+    NAS_ACL_LOG_DUMP ("Software cleared counts: %" PRIu64, info.baselines);
+}
+
+void dump_stats_rates (void)
+{
+    double bps, pps;
+
+    nas_acl_lock ();
+
+    for (const auto& switch_pair: nas_acl_get_switch_list ()) {
+        const nas_acl_switch& s = switch_pair.second;
+
+        for (const auto& tbl_kvp: s.table_list ()) {
+            for (const auto& cnt_kvp: s.counter_list (tbl_kvp.first)) {
+                nas_acl_stats_rate_get (cnt_kvp.second, &bps, &pps);
+                NAS_ACL_LOG_DUMP ("Switch %d Table %ld Counter %ld: %.1f pkts/s, %.1f bytes/s",
+                                  s.id (), tbl_kvp.first, cnt_kvp.first, pps, bps);
+            }
+        }
+    }
+
+    nas_acl_unlock ();
+}
+
+void dump_stats_top (size_t count)
+{
+    std::vector<nas_acl_stats_top_t> top;
+
+    nas_acl_lock ();
+
+    nas_acl_stats_top_get (count, false, top);
+    for (const auto& t: top) {
+        std::string entries;
+
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (t.switch_id);
+            for (auto entry_id: s.get_counter (t.table_id, t.counter_id).refs ()) {
+                entries += " " + std::to_string (entry_id);
+            }
+        } catch (nas::base_exception& e) {
+            entries = " (counter deleted)";
+        }
+
+        NAS_ACL_LOG_DUMP ("Table %ld Counter %ld: %.1f pkts/s, %.1f bytes/s, Entries:%s",
+                          t.table_id, t.counter_id, t.pps, t.bps, entries.c_str ());
+    }
+
+    nas_acl_unlock ();
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_stats_shm.cpp
+ * \brief  Writer of the shared memory ACL counter export
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "std_error_codes.h"
+#include "nas_acl_log.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_stats.h"
+#include "nas_acl_stats_shm.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <string>
+#include <mutex>
+#include <algorithm>
+
+static std::mutex                _shm_mutex;
+static nas_acl_stats_shm_hdr_t*  _shm_hdr = nullptr;
+static size_t                    _shm_size = 0;
+static std::string               _shm_name;
+static uint32_t                  _shm_capacity = NAS_ACL_STATS_SHM_CAPACITY;
+static gid_t                     _shm_gid = (gid_t) -1;
+
+static void _shm_unmap () noexcept
+{
+    if (_shm_hdr == nullptr) return;
+
+    munmap (_shm_hdr, _shm_size);
+    shm_unlink (_shm_name.c_str ());
+    _shm_hdr = nullptr;
+    _shm_size = 0;
+}
+
+t_std_error nas_acl_stats_shm_open (const char* name, uint32_t capacity) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+
+    _shm_unmap ();
+
+    size_t size = NAS_ACL_STATS_SHM_SIZE (capacity);
+
+    // Start from a fresh region so that readers of an
+    // earlier one never see it change layout
+    shm_unlink (name);
+    int fd = shm_open (name, O_CREAT | O_EXCL | O_RDWR, NAS_ACL_STATS_SHM_MODE);
+    if (fd < 0) {
+        NAS_ACL_LOG_ERR ("Stats export %s open failed: %s", name, strerror (errno));
+        return NAS_ACL_E_FAIL;
+    }
+
+    // Readable by the collector group only, never by everyone
+    if (_shm_gid != (gid_t) -1 && fchown (fd, (uid_t) -1, _shm_gid) != 0) {
+        NAS_ACL_LOG_ERR ("Stats export %s group %d failed: %s", name, (int) _shm_gid,
+                         strerror (errno));
+        close (fd);
+        shm_unlink (name);
+        return NAS_ACL_E_FAIL;
+    }
+
+    if (ftruncate (fd, size) != 0) {
+        NAS_ACL_LOG_ERR ("Stats export %s resize failed: %s", name, strerror (errno));
+        close (fd);
+        shm_unlink (name);
+        return NAS_ACL_E_MEM;
+    }
+
+    void* p = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close (fd);
+    if (p == MAP_FAILED) {
+        NAS_ACL_LOG_ERR ("Stats export %s map failed: %s", name, strerror (errno));
+        shm_unlink (name);
+        return NAS_ACL_E_MEM;
+    }
+
+    try {
+        _shm_name = name;
+    } catch (std::exception& e) {
+        munmap (p, size);
+        shm_unlink (name);
+        return NAS_ACL_E_MEM;
+    }
+
+    _shm_hdr = static_cast<nas_acl_stats_shm_hdr_t*> (p);
+    _shm_size = size;
+
+    _shm_hdr->version = NAS_ACL_STATS_SHM_VERSION;
+    _shm_hdr->capacity = capacity;
+    _shm_hdr->seq = 0;
+    _shm_hdr->count = 0;
+    _shm_hdr->total = 0;
+    _shm_hdr->update_ms = 0;
+    __atomic_store_n (&_shm_hdr->magic, NAS_ACL_STATS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    NAS_ACL_LOG_BRIEF ("Stats export %s open for %d counters", name, capacity);
+    return NAS_ACL_E_NONE;
+}
+
+void nas_acl_stats_shm_capacity_set (uint32_t capacity) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+    _shm_capacity = capacity;
+}
+
+void nas_acl_stats_shm_group_set (gid_t gid) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+    _shm_gid = gid;
+}
+
+t_std_error nas_acl_stats_shm_init (void) noexcept
+{
+    uint32_t capacity;
+
+    {
+        std::lock_guard<std::mutex> l (_shm_mutex);
+        capacity = _shm_capacity;
+    }
+
+    if (capacity == 0) {
+        NAS_ACL_LOG_BRIEF ("Stats export not turned on");
+        return NAS_ACL_E_NONE;
+    }
+    return nas_acl_stats_shm_open (NAS_ACL_STATS_SHM_NAME, capacity);
+}
+
+void nas_acl_stats_shm_close (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+    _shm_unmap ();
+}
+
+bool nas_acl_stats_shm_is_open (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+    return (_shm_hdr != nullptr);
+}
+
+void nas_acl_stats_shm_publish (const nas_acl_stats_shm_rec_t* recs,
+                                size_t count, size_t total,
+                                uint64_t update_ms) noexcept
+{
+    std::lock_guard<std::mutex> l (_shm_mutex);
+
+    if (_shm_hdr == nullptr) return;
+
+    auto hdr = _shm_hdr;
+    auto shm_recs = reinterpret_cast<nas_acl_stats_shm_rec_t*> (hdr + 1);
+    uint32_t seq = hdr->seq;
+
+    count = std::min (count, (size_t) hdr->capacity);
+
+    // Odd seq tells readers to retry until the records are whole again
+    __atomic_store_n (&hdr->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence (__ATOMIC_RELEASE);
+
+    memcpy (shm_recs, recs, count * sizeof (nas_acl_stats_shm_rec_t));
+    hdr->count = count;
+    hdr->total = std::min (total, (size_t) UINT32_MAX);
+    hdr->update_ms = update_ms;
+
+    __atomic_store_n (&hdr->seq, seq + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_stats_shm_reader.cpp
+ * \brief  Reader of the shared memory ACL counter export
+ * \date   10-2026
+ */
+
+#include "nas_acl_stats_shm.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+
+struct _nas_acl_stats_shm_reader_t {
+    const nas_acl_stats_shm_hdr_t* hdr;
+    const nas_acl_stats_shm_rec_t* recs;
+    size_t                         size;
+};
+
+extern "C" {
+
+nas_acl_stats_shm_reader_t* nas_acl_stats_shm_reader_open (const char* name)
+{
+    struct stat st;
+
+    int fd = shm_open (name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat (fd, &st) != 0 ||
+        (size_t) st.st_size < sizeof (nas_acl_stats_shm_hdr_t)) {
+        close (fd);
+        return NULL;
+    }
+
+    void* p = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    auto hdr = static_cast<const nas_acl_stats_shm_hdr_t*> (p);
+
+    // Magic is written last by NAS-ACL once the header is complete
+    if (__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != NAS_ACL_STATS_SHM_MAGIC ||
+        hdr->version != NAS_ACL_STATS_SHM_VERSION ||
+        (size_t) st.st_size < NAS_ACL_STATS_SHM_SIZE (hdr->capacity)) {
+        munmap (p, st.st_size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    auto reader = new (std::nothrow) nas_acl_stats_shm_reader_t;
+    if (reader == NULL) {
+        munmap (p, st.st_size);
+        return NULL;
+    }
+
+    reader->hdr = hdr;
+    reader->recs = reinterpret_cast<const nas_acl_stats_shm_rec_t*> (hdr + 1);
+    reader->size = st.st_size;
+    return reader;
+}
+
+void nas_acl_stats_shm_reader_close (nas_acl_stats_shm_reader_t* reader)
+{
+    if (reader == NULL) return;
+
+    munmap (const_cast<nas_acl_stats_shm_hdr_t*> (reader->hdr), reader->size);
+    delete reader;
+}
+
+int nas_acl_stats_shm_reader_read (nas_acl_stats_shm_reader_t* reader,
+                                   nas_acl_stats_shm_rec_t* recs,
+                                   size_t max_recs,
+                                   uint64_t* update_ms_p)
+{
+    auto hdr = reader->hdr;
+
+    for (size_t retry = 0; retry < NAS_ACL_STATS_SHM_READ_RETRIES; retry++) {
+        uint32_t seq = __atomic_load_n (&hdr->seq, __ATOMIC_ACQUIRE);
+
+        if (seq & 1) {
+            // Update in progress
+            sched_yield ();
+            continue;
+        }
+
+        size_t count = std::min ((size_t) std::min (hdr->count, hdr->capacity), max_recs);
+        memcpy (recs, reader->recs, count * sizeof (nas_acl_stats_shm_rec_t));
+        uint64_t update_ms = hdr->update_ms;
+
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+        if (__atomic_load_n (&hdr->seq, __ATOMIC_RELAXED) == seq) {
+            if (update_ms_p) *update_ms_p = update_ms;
+            return (int) count;
+        }
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+}
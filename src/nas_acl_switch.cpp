@@ -23,19 +23,51 @@
 #include "nas_base_utils.h"
 #include "nas_acl_switch.h"
 #include "nas_acl_switch_list.h"
+#include "nas_acl_cps.h"
 #include "event_log.h"
 #include "hal_if_mapping.h"
 #include "std_mutex_lock.h"
+#include "nas_acl_lock_stats.h"
+#include "nas_acl_trace.h"
 #include <string>
+#include <algorithm>
 #include <inttypes.h>
 
 static std_mutex_lock_create_static_init_rec(port_bind_mutex);
 
+// Nesting of the recursive bind mutex in this thread, only the
+// outermost hold is accounted
+static thread_local uint32_t _bind_depth = 0;
+
 auto nas_acl_intf_bind_mutex() noexcept ->decltype(port_bind_mutex)&
 {
     return port_bind_mutex;
 }
 
+nas_acl_intf_bind_guard::nas_acl_intf_bind_guard (const char* site) noexcept
+{
+    uint64_t start_ns = (_bind_depth == 0) ? nas_acl_lock_stats_start () : 0;
+    nas_acl_trace_span wait ("Intf Bind Wait");
+
+    std_mutex_lock (&port_bind_mutex);
+    wait.end ();
+    if (_bind_depth++ == 0) {
+        nas_acl_lock_stats_acquired (NAS_ACL_LOCK_INTF_BIND, site, start_ns);
+    }
+}
+
+nas_acl_intf_bind_guard::~nas_acl_intf_bind_guard ()
+{
+    if (--_bind_depth > 0) {
+        std_mutex_unlock (&port_bind_mutex);
+        return;
+    }
+
+    auto hold = nas_acl_lock_stats_releasing (NAS_ACL_LOCK_INTF_BIND);
+    std_mutex_unlock (&port_bind_mutex);
+    nas_acl_lock_stats_record (hold);
+}
+
 nas_acl_table& nas_acl_switch::get_table (nas_obj_id_t tbl_id)
 {
     try {
@@ -311,6 +343,127 @@ void nas_acl_switch::remove_table (nas_obj_id_t table_id) noexcept
     _tableid_gen.release_id (table_id);
 }
 
+nas_obj_id_t nas_acl_switch::shadow_table_owner (nas_obj_id_t shadow_id) const noexcept
+{
+    auto it = _shadow_tables.find (shadow_id);
+    if (it == _shadow_tables.end ()) return 0;
+
+    return it->second;
+}
+
+void nas_acl_switch::rebind_table_container (nas_obj_id_t table_id) noexcept
+{
+    // This is an internal function - Table ID cannot be invalid
+    const nas_acl_table* table_p = &_tables.at (table_id);
+    auto& container = _table_containers.at (table_id);
+
+    for (auto& entry_pair: container._acl_entries) {
+        entry_pair.second.rebind_table (table_p);
+    }
+    for (auto& counter_pair: container._acl_counters) {
+        counter_pair.second.rebind_table (table_p);
+    }
+}
+
+void nas_acl_switch::swap_table_generation (nas_obj_id_t live_id,
+                                            nas_obj_id_t shadow_id) noexcept
+{
+    /* Shadow table was cloned from the live table, so only the NPU tables
+     * and the entry/counter containers change hands. Table ID, name and
+     * all table attributes seen by the application stay with the live ID.
+     * Nothing is written to NPU here: the shadow entries were installed
+     * just before, and both generations stay programmed until the old
+     * one, now under the shadow ID, is retired.
+     */
+    auto& live_table = _tables.at (live_id);
+    auto& shadow_table = _tables.at (shadow_id);
+
+    live_table.swap_ndi_obj_ids (shadow_table);
+    std::swap (_table_containers.at (live_id), _table_containers.at (shadow_id));
+
+    rebind_table_container (live_id);
+    rebind_table_container (shadow_id);
+
+    auto swap_id = [live_id, shadow_id] (nas_obj_id_t& tbl_id) {
+        if (tbl_id == live_id) {
+            tbl_id = shadow_id;
+        } else if (tbl_id == shadow_id) {
+            tbl_id = live_id;
+        }
+    };
+
+    for (auto& pbr_entry: _cached_pbr_entries) {
+        swap_id (pbr_entry.tbl_id);
+    }
+
+    nas_acl_intf_bind_guard bind_guard;
+    for (auto& bind_pair: _intf_acl_bind_map) {
+        for (auto& item: bind_pair.second) {
+            swap_id (item.table_id);
+        }
+    }
+
+    del_shadow_table (shadow_id);
+
+    NAS_ACL_LOG_BRIEF ("Switch %d: Table %ld now live with generation from table %ld",
+                       id(), live_id, shadow_id);
+}
+
+t_std_error nas_acl_switch::retire_table_generation (nas_obj_id_t table_id,
+                                                     size_t max_objs,
+                                                     bool* pending_p) noexcept
+{
+    *pending_p = false;
+
+    auto it_tbl = _table_containers.find (table_id);
+    if (it_tbl == _table_containers.end ()) return NAS_ACL_E_NONE;
+
+    auto& container = it_tbl->second;
+    size_t count = 0;
+
+    try {
+        nas_acl_intf_bind_guard bind_guard;
+
+        while (!container._acl_entries.empty () && count < max_objs) {
+            auto& entry = container._acl_entries.begin ()->second;
+            auto entry_id = entry.entry_id ();
+
+            entry.commit_delete (false);
+            remove_entry_from_table (table_id, entry_id);
+            count++;
+        }
+
+        while (!container._acl_counters.empty () && count < max_objs) {
+            auto& counter = container._acl_counters.begin ()->second;
+            auto counter_id = counter.counter_id ();
+
+            counter.commit_delete (false);
+            remove_counter_from_table (table_id, counter_id);
+            count++;
+        }
+
+        if (count >= max_objs) {
+            *pending_p = true;
+            return NAS_ACL_E_NONE;
+        }
+
+        get_table (table_id).commit_delete (false);
+        remove_table (table_id);
+
+        NAS_ACL_LOG_BRIEF ("Switch %d: Retired table generation %ld",
+                           id(), table_id);
+    } catch (nas::base_exception& e) {
+        // Leave the rest of the generation in cache, still tied to the
+        // hardware it holds, so that the teardown can be tried again
+        NAS_ACL_LOG_ERR ("Failed to retire table %ld - Err_code: 0x%x, fn: %s (), %s",
+                         table_id, e.err_code, e.err_fn.c_str (), e.err_msg.c_str ());
+        *pending_p = true;
+        return e.err_code;
+    }
+
+    return NAS_ACL_E_NONE;
+}
+
 void nas_acl_switch::remove_entry_from_table (nas_obj_id_t table_id,
                                               nas_obj_id_t entry_id) noexcept
 {
@@ -722,7 +875,8 @@ void nas_acl_switch::del_intf_acl_bind(hal_ifindex_t ifindex, const acl_rule_ite
 
 void nas_acl_switch::if_delete_notify(hal_ifindex_t ifindex)
 {
-    std_mutex_simple_lock_guard mutex(&port_bind_mutex);
+    nas_acl_trace_span trace ("Intf Delete", ifindex);
+    nas_acl_intf_bind_guard bind_guard;
 
     NAS_ACL_LOG_BRIEF("Delete ACL interface binding for ifindex %d",
                       ifindex);
@@ -735,7 +889,7 @@ void nas_acl_switch::if_delete_notify(hal_ifindex_t ifindex)
             // update NPU to exclude the delete port
             auto& acl_entry = get_entry(item.table_id, item.entry_id);
             if (item.is_match) {
-                NAS_ACL_LOG_BRIEF(" Delete ifindex %d with match type %d", ifindex, item.match_type);
+                NAS_ACL_LOG_BRIEF_RL(" Delete ifindex %d with match type %d", ifindex, item.match_type);
                 if (!acl_entry.filter_intf_delete(item.match_type, ifindex)) {
                     NAS_ACL_LOG_ERR("Failed to delete interface %d with match type %d",
                                     ifindex,
@@ -743,7 +897,7 @@ void nas_acl_switch::if_delete_notify(hal_ifindex_t ifindex)
                     return;
                 }
             } else {
-                NAS_ACL_LOG_BRIEF(" Delete ifindex %d with action type %d", ifindex, item.action_type);
+                NAS_ACL_LOG_BRIEF_RL(" Delete ifindex %d with action type %d", ifindex, item.action_type);
                 if (!acl_entry.action_intf_delete(item.action_type, ifindex)) {
                     NAS_ACL_LOG_ERR("Failed to delete interface %d with action type %d",
                                     ifindex,
@@ -753,7 +907,7 @@ void nas_acl_switch::if_delete_notify(hal_ifindex_t ifindex)
             }
 
         } catch (nas::base_exception& ex) {
-            NAS_ACL_LOG_ERR("Failed to get entry: %s", ex.err_msg.c_str());
+            NAS_ACL_LOG_ERR_RL("Failed to get entry: %s", ex.err_msg.c_str());
         }
 
     }
@@ -761,7 +915,8 @@ void nas_acl_switch::if_delete_notify(hal_ifindex_t ifindex)
 void nas_acl_switch::process_intf_acl_bind(hal_ifindex_t ifindex,
                                            npu_id_t npu_id, npu_port_t npu_port)
 {
-    std_mutex_simple_lock_guard mutex(&port_bind_mutex);
+    nas_acl_trace_span trace ("Intf Bind Process", ifindex);
+    nas_acl_intf_bind_guard bind_guard;
 
     NAS_ACL_LOG_BRIEF("Process ACL interface binding for ifindex %d",
                       ifindex);
@@ -773,14 +928,14 @@ void nas_acl_switch::process_intf_acl_bind(hal_ifindex_t ifindex,
         try {
             auto& acl_entry = get_entry(item.table_id, item.entry_id);
             if (item.is_match) {
-                NAS_ACL_LOG_BRIEF(" Update mapping of match type %d", item.match_type);
+                NAS_ACL_LOG_BRIEF_RL(" Update mapping of match type %d", item.match_type);
                 if (!acl_entry.filter_intf_mapping_update(item.match_type, ifindex, npu_id)) {
                     NAS_ACL_LOG_ERR("Failed to update interface mapping on match %d",
                                     item.match_type);
                     return;
                 }
             } else {
-                NAS_ACL_LOG_BRIEF(" Update mapping of action type %d", item.action_type);
+                NAS_ACL_LOG_BRIEF_RL(" Update mapping of action type %d", item.action_type);
                 if (!acl_entry.action_intf_mapping_update(item.action_type, ifindex, npu_id)) {
                     NAS_ACL_LOG_ERR("Failed to update interface mapping on action %d",
                                     item.action_type);
@@ -788,7 +943,7 @@ void nas_acl_switch::process_intf_acl_bind(hal_ifindex_t ifindex,
                 }
             }
         } catch (nas::base_exception& ex) {
-            NAS_ACL_LOG_ERR("Failed to get entry: %s", ex.err_msg.c_str());
+            NAS_ACL_LOG_ERR_RL("Failed to get entry: %s", ex.err_msg.c_str());
             continue;
         }
     }
@@ -802,6 +957,8 @@ void nas_acl_switch::update_intf_match_bind(const nas_acl_entry& entry,
         return;
     }
 
+    nas_acl_trace_span trace ("Intf Match Bind Update", entry.entry_id ());
+
     auto f_type = old_match != nullptr ? old_match->filter_type() :
                                          new_match->filter_type();
 
@@ -816,7 +973,7 @@ void nas_acl_switch::update_intf_match_bind(const nas_acl_entry& entry,
     NAS_ACL_LOG_DETAIL("Update interface ACL bind for match type %s",
                        nas_acl_filter_t::type_name(f_type));
 
-    std_mutex_simple_lock_guard mutex(&port_bind_mutex);
+    nas_acl_intf_bind_guard bind_guard;
 
     for (auto ifidx: del_ifs) {
         NAS_ACL_LOG_DETAIL(" Interface to be deleted: ifindex=%d", ifidx);
@@ -840,6 +997,8 @@ void nas_acl_switch::update_intf_action_bind(const nas_acl_entry& entry,
         return;
     }
 
+    nas_acl_trace_span trace ("Intf Action Bind Update", entry.entry_id ());
+
     auto a_type = old_action != nullptr ? old_action->action_type() :
                                           new_action->action_type();
 
@@ -854,7 +1013,7 @@ void nas_acl_switch::update_intf_action_bind(const nas_acl_entry& entry,
     NAS_ACL_LOG_DETAIL("Update interface ACL bind for action type %s",
                         nas_acl_action_t::type_name(a_type));
 
-    std_mutex_simple_lock_guard mutex(&port_bind_mutex);
+    nas_acl_intf_bind_guard bind_guard;
 
     for (auto ifidx: del_ifs) {
         NAS_ACL_LOG_DETAIL(" Interface to be deleted: ifindex=%d", ifidx);
@@ -887,6 +1046,182 @@ void nas_acl_switch::dump_rule_intf_bind(void) const noexcept
     }
 }
 
+size_t nas_acl_switch::check_invariants (std::vector<std::string>& violations) const noexcept
+{
+    size_t count = 0;
+
+    auto violation = [&] (const std::string& msg) {
+        count++;
+        try {
+            violations.push_back (msg);
+        } catch (std::exception& e) {
+        }
+    };
+
+    try {
+        for (const auto& tbl_pair: _tables) {
+            if (_table_containers.find (tbl_pair.first) == _table_containers.end ()) {
+                violation ("Table " + std::to_string (tbl_pair.first) +
+                           " has no entry container");
+            }
+        }
+
+        for (const auto& cont_pair: _table_containers) {
+            auto table_id = cont_pair.first;
+            const auto& container = cont_pair.second;
+
+            if (_tables.find (table_id) == _tables.end ()) {
+                violation ("Entry container of deleted table " + std::to_string (table_id));
+            }
+
+            for (const auto& entry_pair: container._acl_entries) {
+                const auto& entry = entry_pair.second;
+                std::string name = "Table " + std::to_string (table_id) +
+                                   " Entry " + std::to_string (entry_pair.first);
+
+                if (entry.entry_id () != entry_pair.first ||
+                    entry.table_id () != table_id) {
+                    violation (name + " is saved under a different key");
+                }
+
+                auto counter_id = entry.counter_id ();
+                if (counter_id == 0) continue;
+
+                auto it_cnt = container._acl_counters.find (counter_id);
+                if (it_cnt == container._acl_counters.end ()) {
+                    violation (name + " refers to missing Counter " +
+                               std::to_string (counter_id));
+                } else if (it_cnt->second.refs ().count (entry_pair.first) == 0) {
+                    violation (name + " is not referenced by its Counter " +
+                               std::to_string (counter_id));
+                }
+            }
+
+            for (const auto& counter_pair: container._acl_counters) {
+                for (auto entry_id: counter_pair.second.refs ()) {
+                    auto it_entry = container._acl_entries.find (entry_id);
+                    if (it_entry == container._acl_entries.end () ||
+                        it_entry->second.counter_id () != counter_pair.first) {
+                        violation ("Table " + std::to_string (table_id) +
+                                   " Counter " + std::to_string (counter_pair.first) +
+                                   " has stale reference to Entry " +
+                                   std::to_string (entry_id));
+                    }
+                }
+            }
+        }
+
+        nas_acl_intf_bind_guard bind_guard;
+
+        for (const auto& bind_pair: _intf_acl_bind_map) {
+            auto ifindex = bind_pair.first;
+
+            for (const auto& item: bind_pair.second) {
+                std::string name = "Interface " + std::to_string (ifindex) +
+                                   " binding to Table " + std::to_string (item.table_id) +
+                                   " Entry " + std::to_string (item.entry_id);
+
+                auto it_cont = _table_containers.find (item.table_id);
+                if (it_cont == _table_containers.end () ||
+                    it_cont->second._acl_entries.find (item.entry_id) ==
+                        it_cont->second._acl_entries.end ()) {
+                    violation (name + " is dangling");
+                    continue;
+                }
+
+                const auto& entry = it_cont->second._acl_entries.at (item.entry_id);
+                const nas::ifindex_list_t* if_list = nullptr;
+
+                if (item.is_match) {
+                    auto it = entry.get_filter_list ().find ({item.match_type, 0});
+                    if (it != entry.get_filter_list ().end ()) {
+                        if_list = &it->second.get_filter_if_list ();
+                    }
+                } else {
+                    auto it = entry.get_action_list ().find (item.action_type);
+                    if (it != entry.get_action_list ().end ()) {
+                        if_list = &it->second.get_action_if_list ();
+                    }
+                }
+
+                if (if_list == nullptr ||
+                    std::find (if_list->begin (), if_list->end (), ifindex) == if_list->end ()) {
+                    violation (name + " does not match its " +
+                               ((item.is_match) ? "filter" : "action"));
+                }
+            }
+        }
+    } catch (std::exception& e) {
+        violation (std::string {"Check aborted: "} + e.what ());
+    }
+
+    return count;
+}
+
+void nas_acl_switch::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add (NAS_ACL_MEM_TABLE, _tables);
+    for (const auto& tbl_pair: _tables) {
+        tbl_pair.second.mem_usage (acct);
+    }
+
+    // Containers are counted with the tables, their contents by type
+    acct.add (NAS_ACL_MEM_TABLE, _table_containers);
+    for (const auto& cont_pair: _table_containers) {
+        const auto& container = cont_pair.second;
+
+        acct.add (NAS_ACL_MEM_ENTRY, container._acl_entries);
+        for (const auto& entry_pair: container._acl_entries) {
+            entry_pair.second.mem_usage (acct);
+        }
+
+        acct.add (NAS_ACL_MEM_COUNTER, container._acl_counters);
+        for (const auto& counter_pair: container._acl_counters) {
+            counter_pair.second.mem_usage (acct);
+        }
+    }
+
+    acct.add (NAS_ACL_MEM_PBR_CACHE, _cached_pbr_entries);
+    acct.add_obj (NAS_ACL_MEM_PBR_CACHE, _cached_pbr_entries.size ());
+
+    acct.add (NAS_ACL_MEM_UDF, _udf_groups);
+    for (const auto& grp_pair: _udf_groups) {
+        grp_pair.second.mem_usage (acct);
+    }
+    acct.add (NAS_ACL_MEM_UDF, _udf_matches);
+    for (const auto& match_pair: _udf_matches) {
+        match_pair.second.mem_usage (acct);
+    }
+    acct.add (NAS_ACL_MEM_UDF, _udf_objs);
+    for (const auto& udf_pair: _udf_objs) {
+        udf_pair.second.mem_usage (acct);
+    }
+
+    nas_acl_intf_bind_guard bind_guard;
+
+    acct.add (NAS_ACL_MEM_INTF_BIND, _intf_acl_bind_map);
+    for (const auto& bind_pair: _intf_acl_bind_map) {
+        acct.add (NAS_ACL_MEM_INTF_BIND, bind_pair.second);
+        acct.add_obj (NAS_ACL_MEM_INTF_BIND, bind_pair.second.size ());
+    }
+}
+
+void dump_acl_invariants (void)
+{
+    std::vector<std::string> violations;
+
+    nas_acl_lock ();
+    for (const auto& switch_pair: nas_acl_get_switch_list()) {
+        switch_pair.second.check_invariants (violations);
+    }
+    nas_acl_unlock ();
+
+    NAS_ACL_LOG_DUMP ("%ld invariant violations", violations.size ());
+    for (const auto& v: violations) {
+        NAS_ACL_LOG_DUMP ("  %s", v.c_str ());
+    }
+}
+
 void dump_all_intf_bind(void)
 {
     for (const auto& switch_pair: nas_acl_get_switch_list()) {
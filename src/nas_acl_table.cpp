@@ -25,6 +25,9 @@
 #include "nas_acl_filter.h"
 #include "nas_ndi_acl.h"
 #include "nas_acl_log.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_warm.h"
 #include <inttypes.h>
 
 nas_acl_table::nas_acl_table (nas_acl_switch* switch_p)
@@ -337,6 +340,12 @@ bool nas_acl_table::push_create_obj_to_npu (npu_id_t npu_id,
 
     auto ndi_tbl_p = static_cast<ndi_acl_table_t*> (ndi_obj);
 
+    if (nas_acl_warm_adopt (*this, npu_id, ndi_tbl_id)) {
+        // Already in the NPU from before a warm restart
+        _ndi_obj_ids[npu_id] = ndi_tbl_id;
+        return true;
+    }
+
     std::vector<ndi_obj_id_t> npu_grp_id_list;
     if (_udf_group_list.size() > 0) {
         ndi_tbl_p->udf_grp_count = _udf_group_list.size();
@@ -353,7 +362,8 @@ bool nas_acl_table::push_create_obj_to_npu (npu_id_t npu_id,
         ndi_tbl_p->udf_grp_id_list = npu_grp_id_list.data();
     }
 
-    if ((rc = ndi_acl_table_create (npu_id, ndi_tbl_p, &ndi_tbl_id))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_TABLE_CREATE, ndi_acl_table_create,
+                                npu_id, ndi_tbl_p, &ndi_tbl_id))
             != STD_ERR_OK)
     {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -380,11 +390,22 @@ ndi_obj_id_t  nas_acl_table::get_ndi_obj_id (npu_id_t  npu_id) const
     }
 }
 
+void nas_acl_table::mem_usage (nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj (NAS_ACL_MEM_TABLE);
+    acct.add (NAS_ACL_MEM_TABLE, _table_name);
+    acct.add (NAS_ACL_MEM_TABLE, _allowed_filters);
+    acct.add (NAS_ACL_MEM_TABLE, _allowed_actions);
+    acct.add (NAS_ACL_MEM_TABLE, _udf_group_list);
+    acct.add (NAS_ACL_MEM_TABLE, _ndi_obj_ids);
+}
+
 bool nas_acl_table::push_delete_obj_to_npu (npu_id_t npu_id)
 {
     t_std_error rc;
 
-    if ((rc = ndi_acl_table_delete (npu_id, _ndi_obj_ids.at (npu_id)))
+    if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_TABLE_DELETE, ndi_acl_table_delete,
+                                npu_id, _ndi_obj_ids.at (npu_id)))
         != STD_ERR_OK)
     {
         throw nas::base_exception {rc, __PRETTY_FUNCTION__,
@@ -428,8 +449,10 @@ bool nas_acl_table::push_leaf_attr_to_npu (nas_attr_id_t attr_id,
     switch (attr_id)
     {
         case BASE_ACL_TABLE_PRIORITY:
-            if ((rc = ndi_acl_table_set_priority (npu_id, _ndi_obj_ids.at(npu_id),
-                                                    priority()))
+            if ((rc = nas_acl_lat_call (NAS_ACL_LAT_NDI_TABLE_SET_PRIORITY,
+                                        ndi_acl_table_set_priority,
+                                        npu_id, _ndi_obj_ids.at(npu_id),
+                                        priority()))
                 != STD_ERR_OK)
             {
                 throw nas::base_exception {rc, __PRETTY_FUNCTION__,
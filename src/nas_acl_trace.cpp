@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_trace.cpp
+ * \brief  Timestamped trace of ACL object lifecycle steps
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_trace.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <inttypes.h>
+#include <mutex>
+#include <list>
+#include <vector>
+#include <new>
+#include <algorithm>
+
+std::atomic<bool> g_nas_acl_trace_enabled {false};
+
+struct nas_acl_trace_event_t {
+    const char*  name;
+    uint64_t     start_ns;
+    uint64_t     dur_ns;
+    uint64_t     id;
+};
+
+// Only the owner thread writes a ring. Readers copy it between two
+// loads of head and drop the slots that were overwritten meanwhile.
+struct nas_acl_trace_ring_t {
+    std::atomic<uint64_t>   head {0};
+    pid_t                   tid = 0;
+    bool                    exited = false;
+    nas_acl_trace_event_t   events [NAS_ACL_TRACE_RING_SIZE];
+};
+
+// Guards the list of rings, not their content
+static std::mutex                         _trace_mutex;
+static std::list<nas_acl_trace_ring_t*>   _trace_rings;
+static uint64_t                           _trace_clear_ns = 0;
+
+static void _trace_thread_exit (nas_acl_trace_ring_t* ring) noexcept
+{
+    std::lock_guard<std::mutex> l (_trace_mutex);
+
+    ring->exited = true;
+
+    size_t exited = 0;
+    for (auto r: _trace_rings) {
+        if (r->exited) exited++;
+    }
+
+    for (auto it = _trace_rings.begin ();
+         it != _trace_rings.end () && exited > NAS_ACL_TRACE_MAX_EXITED; ) {
+        if ((*it)->exited) {
+            delete *it;
+            it = _trace_rings.erase (it);
+            exited--;
+        } else {
+            ++it;
+        }
+    }
+}
+
+struct nas_acl_trace_thread_t {
+    nas_acl_trace_ring_t*  ring = nullptr;
+
+    ~nas_acl_trace_thread_t ()
+    {
+        if (ring != nullptr) _trace_thread_exit (ring);
+    }
+};
+
+static thread_local nas_acl_trace_thread_t _trace_thread;
+
+static nas_acl_trace_ring_t* _trace_thread_init () noexcept
+{
+    auto ring = new (std::nothrow) nas_acl_trace_ring_t;
+    if (ring == nullptr) return nullptr;
+
+    ring->tid = syscall (SYS_gettid);
+
+    try {
+        std::lock_guard<std::mutex> l (_trace_mutex);
+        _trace_rings.push_back (ring);
+    } catch (std::exception& e) {
+        delete ring;
+        return nullptr;
+    }
+
+    _trace_thread.ring = ring;
+    return ring;
+}
+
+void nas_acl_trace_enable (bool enable) noexcept
+{
+    g_nas_acl_trace_enabled.store (enable, std::memory_order_relaxed);
+    NAS_ACL_LOG_BRIEF ("Entry lifecycle trace %s", (enable) ? "enabled" : "disabled");
+}
+
+void nas_acl_trace_clear (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_trace_mutex);
+
+    // Rings of live threads are only written by their owner,
+    // so they are dropped by moving the start of the dump instead
+    for (auto it = _trace_rings.begin (); it != _trace_rings.end (); ) {
+        if ((*it)->exited) {
+            delete *it;
+            it = _trace_rings.erase (it);
+        } else {
+            ++it;
+        }
+    }
+    _trace_clear_ns = nas_acl_trace_now_ns ();
+}
+
+void nas_acl_trace_record (const char* name, uint64_t start_ns, uint64_t dur_ns,
+                           uint64_t id) noexcept
+{
+    auto ring = _trace_thread.ring;
+    if (ring == nullptr) {
+        ring = _trace_thread_init ();
+        if (ring == nullptr) return;
+    }
+
+    uint64_t head = ring->head.load (std::memory_order_relaxed);
+    auto& ev = ring->events[head % NAS_ACL_TRACE_RING_SIZE];
+
+    ev.name = name;
+    ev.start_ns = start_ns;
+    ev.dur_ns = dur_ns;
+    ev.id = id;
+
+    ring->head.store (head + 1, std::memory_order_release);
+}
+
+// Copy the events of the ring that were not overwritten during the copy
+static void _trace_ring_copy (const nas_acl_trace_ring_t* ring,
+                              std::vector<nas_acl_trace_event_t>& events)
+{
+    uint64_t head = ring->head.load (std::memory_order_acquire);
+    uint64_t first = (head > NAS_ACL_TRACE_RING_SIZE) ? head - NAS_ACL_TRACE_RING_SIZE : 0;
+
+    events.clear ();
+    for (uint64_t i = first; i < head; i++) {
+        events.push_back (ring->events[i % NAS_ACL_TRACE_RING_SIZE]);
+    }
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    uint64_t new_head = ring->head.load (std::memory_order_relaxed);
+    if (new_head >= first + NAS_ACL_TRACE_RING_SIZE) {
+        // Writer wrapped over the oldest slots while they were copied.
+        // Slot of new_head can be half written before head moves past it.
+        size_t lost = std::min<uint64_t> (new_head - NAS_ACL_TRACE_RING_SIZE - first + 1,
+                                          events.size ());
+        events.erase (events.begin (), events.begin () + lost);
+    }
+}
+
+bool nas_acl_trace_dump (const char* path) noexcept
+{
+    FILE* fp = fopen (path, "w");
+    if (fp == NULL) {
+        NAS_ACL_LOG_ERR ("Trace dump to %s failed: %s", path, strerror (errno));
+        return false;
+    }
+
+    size_t count = 0;
+    bool   first = true;
+    pid_t  pid = getpid ();
+
+    fprintf (fp, "{\"traceEvents\":[\n");
+
+    try {
+        std::vector<nas_acl_trace_event_t> events;
+        std::lock_guard<std::mutex> l (_trace_mutex);
+
+        for (auto ring: _trace_rings) {
+            _trace_ring_copy (ring, events);
+
+            for (const auto& ev: events) {
+                if (ev.start_ns < _trace_clear_ns) continue;
+
+                fprintf (fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64 ".%03" PRIu64
+                         ",\"dur\":%" PRIu64 ".%03" PRIu64 ",\"pid\":%d,\"tid\":%d",
+                         (first) ? "" : ",\n", ev.name,
+                         ev.start_ns / 1000, ev.start_ns % 1000,
+                         ev.dur_ns / 1000, ev.dur_ns % 1000, pid, ring->tid);
+                if (ev.id != 0) {
+                    fprintf (fp, ",\"args\":{\"id\":%" PRIu64 "}", ev.id);
+                }
+                fprintf (fp, "}");
+                first = false;
+                count++;
+            }
+        }
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Trace dump to %s failed: %s", path, e.what ());
+    }
+
+    fprintf (fp, "\n]}\n");
+
+    if (fclose (fp) != 0) {
+        NAS_ACL_LOG_ERR ("Trace dump to %s failed: %s", path, strerror (errno));
+        return false;
+    }
+
+    NAS_ACL_LOG_BRIEF ("Trace dump of %ld events written to %s", count, path);
+    return true;
+}
@@ -27,6 +27,8 @@
 #include "nas_acl_utl.h"
 #include "nas_base_utils.h"
 #include "nas_acl_switch.h"
+#include "nas_acl_trace.h"
+#include "nas_acl_log.h"
 
 static bool _get_ifinfo (hal_ifindex_t ifindex, interface_ctrl_t *intf_ctrl_p)
 {
@@ -38,6 +40,8 @@ static bool _get_ifinfo (hal_ifindex_t ifindex, interface_ctrl_t *intf_ctrl_p)
 
 void nas_acl_utl_ifidx_to_ndi_port (hal_ifindex_t ifindex, interface_ctrl_t *intf_ctrl_p)
 {
+    nas_acl_trace_span trace ("Intf Lookup", ifindex);
+
     if (!_get_ifinfo (ifindex, intf_ctrl_p)) {
         throw nas::base_exception {NAS_ACL_E_ATTR_VAL, __PRETTY_FUNCTION__,
                                    std::string {"Invalid IfIndex "} +
@@ -127,3 +131,17 @@ nas_acl_id_guard_t::~nas_acl_id_guard_t () noexcept
             break;
     }
 }
+
+std::atomic<int> g_nas_acl_log_level {NAS_ACL_LOG_MAX_LEVEL};
+
+void nas_acl_log_level_set (int level) noexcept
+{
+    // Errors are never silenced
+    if (level < NAS_ACL_LOG_LVL_ERR) {
+        level = NAS_ACL_LOG_LVL_ERR;
+    } else if (level > NAS_ACL_LOG_MAX_LEVEL) {
+        level = NAS_ACL_LOG_MAX_LEVEL;
+    }
+    g_nas_acl_log_level.store (level, std::memory_order_relaxed);
+    EV_LOGGING (ACL, NOTICE, "NAS-ACL", "Log level set to %d", level);
+}
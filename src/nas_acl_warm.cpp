@@ -0,0 +1,729 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*!
+ * \file   nas_acl_warm.cpp
+ * \brief  Warm restart snapshot and reconcile of the NAS ACL hardware objects
+ * \date   10-2026
+ */
+
+#include "event_log.h"
+#include "nas_acl_log.h"
+#include "nas_acl_cps.h"
+#include "nas_acl_common.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_switch_list.h"
+#include "nas_acl_warm.h"
+#include "nas_ndi_acl.h"
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <map>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+ * Snapshot file is a header followed by one fixed size record per object
+ * per NPU. Objects are matched on their NAS ids, which the application
+ * replays with the config, and then on a fingerprint of their content.
+ * Deps hashes the NDI ids of the parents, so an entry is only adopted if
+ * its table, counter and ranges have been adopted as well.
+ */
+static constexpr uint32_t NAS_ACL_WARM_MAGIC   = 0x5741434e;    // "NCAW"
+static constexpr uint16_t NAS_ACL_WARM_VERSION = 2;
+
+// Count types of a counter record, so that it can be read back from NDI
+static constexpr uint32_t NAS_ACL_WARM_FLAG_PKT  = 0x1;
+static constexpr uint32_t NAS_ACL_WARM_FLAG_BYTE = 0x2;
+
+struct nas_acl_warm_hdr_t {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    rec_size;
+    uint64_t    count;
+    uint64_t    checksum;   // Over the records
+};
+
+struct nas_acl_warm_rec_t {
+    uint32_t    type;       // nas_acl_warm_obj_t
+    uint32_t    switch_id;
+    uint32_t    npu_id;
+    uint32_t    flags;
+    uint64_t    table_id;
+    uint64_t    obj_id;
+    uint64_t    fingerprint;
+    uint64_t    deps;
+    uint64_t    ndi_obj_id;
+};
+
+static_assert (sizeof (nas_acl_warm_hdr_t) == 24, "Snapshot header layout changed");
+static_assert (sizeof (nas_acl_warm_rec_t) == 56, "Snapshot record layout changed");
+
+struct nas_acl_warm_key_t {
+    uint32_t    type;
+    uint32_t    switch_id;
+    uint32_t    npu_id;
+    uint64_t    table_id;
+    uint64_t    obj_id;
+
+    bool operator== (const nas_acl_warm_key_t& k) const noexcept
+    {
+        return type == k.type && switch_id == k.switch_id && npu_id == k.npu_id &&
+               table_id == k.table_id && obj_id == k.obj_id;
+    }
+};
+
+struct nas_acl_warm_key_hash_t {
+    size_t operator() (const nas_acl_warm_key_t& k) const noexcept
+    {
+        uint64_t h = nas_acl_hash_combine (k.type, k.switch_id);
+        h = nas_acl_hash_combine (h, k.npu_id);
+        h = nas_acl_hash_combine (h, k.table_id);
+        return nas_acl_hash_combine (h, k.obj_id);
+    }
+};
+
+struct nas_acl_warm_slot_t {
+    nas_acl_warm_rec_t  rec;
+    bool                verified = true;    // NDI backs it, so it may be adopted
+    bool                adopted = false;
+};
+
+std::atomic<bool> g_nas_acl_warm_reconciling {false};
+
+static std::mutex _warm_mutex;
+static std::unordered_map<nas_acl_warm_key_t, nas_acl_warm_slot_t,
+                          nas_acl_warm_key_hash_t> _warm_objs;
+static nas_acl_warm_info_t _warm_info {};
+
+// Ends reconcile if the application does not. The timer has its own lock,
+// it is never held together with the NAS ACL lock or the warm lock.
+static std::mutex               _warm_timer_mutex;
+static std::condition_variable  _warm_timer_cv;
+static std::thread*             _warm_timer_thread = nullptr;
+static bool                     _warm_timer_stop = false;
+static uint32_t                 _warm_idle_ms = NAS_ACL_WARM_REPLAY_IDLE_MS;
+static uint32_t                 _warm_max_ms = NAS_ACL_WARM_REPLAY_MAX_MS;
+static std::atomic<uint64_t>    _warm_last_replay_ms {0};
+
+static uint64_t _warm_now_ms () noexcept
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds> (steady_clock::now ().time_since_epoch ()).count ();
+}
+
+/////// Content of each object type ///////
+// Each returns false if the object cannot be carried over a restart
+
+static bool _warm_sig (const nas_acl_table& table, npu_id_t npu_id,
+                       uint64_t& fingerprint, uint64_t& deps) noexcept
+{
+    // UDF groups are not in the snapshot, so their NDI ids are unknown
+    if (table.udf_group_list_count () > 0) {
+        return false;
+    }
+
+    fingerprint = nas_acl_hash_combine (0, table.stage ());
+    fingerprint = nas_acl_hash_combine (fingerprint, table.priority ());
+    fingerprint = nas_acl_hash_combine (fingerprint, table.table_size ());
+    for (auto f_type: table.allowed_filters ()) {
+        fingerprint = nas_acl_hash_combine (fingerprint, f_type);
+    }
+    fingerprint = nas_acl_hash_combine (fingerprint, table.allowed_actions_count ());
+    for (auto a_type: table.allowed_actions ()) {
+        fingerprint = nas_acl_hash_combine (fingerprint, a_type);
+    }
+    deps = 0;
+    return true;
+}
+
+static bool _warm_sig (const nas_acl_counter_t& counter, npu_id_t npu_id,
+                       uint64_t& fingerprint, uint64_t& deps) noexcept
+{
+    try {
+        fingerprint = nas_acl_hash_combine (counter.is_pkt_count_enabled (),
+                                            counter.is_byte_count_enabled ());
+        deps = nas_acl_hash_combine (0, counter.get_table ().get_ndi_obj_id (npu_id));
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+static bool _warm_sig (const nas_acl_range& range, npu_id_t npu_id,
+                       uint64_t& fingerprint, uint64_t& deps) noexcept
+{
+    fingerprint = nas_acl_hash_combine (0, range.type ());
+    fingerprint = nas_acl_hash_combine (fingerprint, range.limit_min ());
+    fingerprint = nas_acl_hash_combine (fingerprint, range.limit_max ());
+    deps = 0;
+    return true;
+}
+
+static bool _warm_sig (const nas_acl_entry& entry, npu_id_t npu_id,
+                       uint64_t& fingerprint, uint64_t& deps) noexcept
+{
+    try {
+        fingerprint = entry.fingerprint ();
+        deps = nas_acl_hash_combine (0, entry.get_table ().get_ndi_obj_id (npu_id));
+
+        auto counter_p = entry.get_counter ();
+        if (counter_p != nullptr) {
+            deps = nas_acl_hash_combine (deps, counter_p->ndi_obj_id (npu_id));
+        }
+
+        std::vector<nas_acl_range*> range_list;
+        entry.get_range_list (range_list);
+        for (auto range_p: range_list) {
+            deps = nas_acl_hash_combine (deps, range_p->get_ndi_obj_id (npu_id));
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+static nas_acl_warm_key_t _warm_key (nas_acl_warm_obj_t type, nas_switch_id_t switch_id,
+                                     nas_obj_id_t table_id, nas_obj_id_t obj_id,
+                                     npu_id_t npu_id) noexcept
+{
+    return nas_acl_warm_key_t {(uint32_t) type, (uint32_t) switch_id, (uint32_t) npu_id,
+                               table_id, obj_id};
+}
+
+/////// Snapshot save ///////
+
+template <typename T>
+static void _warm_rec_add (std::vector<nas_acl_warm_rec_t>& recs, const T& obj,
+                           nas_acl_warm_obj_t type, nas_switch_id_t switch_id,
+                           nas_obj_id_t table_id, nas_obj_id_t obj_id,
+                           npu_id_t npu_id, ndi_obj_id_t ndi_obj_id)
+{
+    nas_acl_warm_rec_t rec {};
+
+    if (!_warm_sig (obj, npu_id, rec.fingerprint, rec.deps)) {
+        return;
+    }
+    rec.type = type;
+    rec.switch_id = switch_id;
+    rec.npu_id = npu_id;
+    rec.table_id = table_id;
+    rec.obj_id = obj_id;
+    rec.ndi_obj_id = ndi_obj_id;
+    recs.push_back (rec);
+}
+
+// Tables and ranges may be on some of their NPUs only after a failed create
+template <typename T>
+static bool _warm_ndi_obj_id (const T& obj, npu_id_t npu_id, ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    try {
+        ndi_obj_id = obj.get_ndi_obj_id (npu_id);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+static void _warm_collect (const nas_acl_switch& s, std::vector<nas_acl_warm_rec_t>& recs)
+{
+    auto switch_id = s.id ();
+    ndi_obj_id_t ndi_obj_id = 0;
+
+    for (const auto& range_pair: s.range_obj_list ()) {
+        const auto& range = range_pair.second;
+        for (auto npu_id: range.npu_list ()) {
+            if (!_warm_ndi_obj_id (range, npu_id, ndi_obj_id)) continue;
+            _warm_rec_add (recs, range, NAS_ACL_WARM_OBJ_RANGE, switch_id, 0,
+                           range.range_id (), npu_id, ndi_obj_id);
+        }
+    }
+
+    for (const auto& tbl_pair: s.table_list ()) {
+        const auto& table = tbl_pair.second;
+        auto table_id = table.table_id ();
+
+        for (auto npu_id: table.npu_list ()) {
+            if (!_warm_ndi_obj_id (table, npu_id, ndi_obj_id)) continue;
+            _warm_rec_add (recs, table, NAS_ACL_WARM_OBJ_TABLE, switch_id, table_id,
+                           table_id, npu_id, ndi_obj_id);
+        }
+
+        for (const auto& cntr_pair: s.counter_list (table_id)) {
+            const auto& counter = cntr_pair.second;
+            uint32_t flags = (counter.is_pkt_count_enabled () ? NAS_ACL_WARM_FLAG_PKT : 0) |
+                             (counter.is_byte_count_enabled () ? NAS_ACL_WARM_FLAG_BYTE : 0);
+            for (auto npu_id: counter.npu_list ()) {
+                if (!counter.is_obj_in_npu (npu_id)) continue;
+                size_t count = recs.size ();
+                _warm_rec_add (recs, counter, NAS_ACL_WARM_OBJ_COUNTER, switch_id, table_id,
+                               counter.counter_id (), npu_id, counter.ndi_obj_id (npu_id));
+                if (recs.size () > count) recs.back ().flags = flags;
+            }
+        }
+
+        for (const auto& entry_pair: s.entry_list (table_id)) {
+            const auto& entry = entry_pair.second;
+            // Entries are not in every NPU of their list, see is_eligible_for_install
+            for (const auto& ndi_pair: entry.ndi_entry_ids) {
+                _warm_rec_add (recs, entry, NAS_ACL_WARM_OBJ_ENTRY, switch_id, table_id,
+                               entry.entry_id (), ndi_pair.first, ndi_pair.second);
+            }
+        }
+    }
+}
+
+t_std_error nas_acl_warm_snapshot_save (const char* path) noexcept
+{
+    std::vector<nas_acl_warm_rec_t> recs;
+
+    nas_acl_lock ();
+    try {
+        for (const auto& switch_pair: nas_acl_get_switch_list ()) {
+            _warm_collect (switch_pair.second, recs);
+        }
+    } catch (nas::base_exception& e) {
+        nas_acl_unlock ();
+        NAS_ACL_LOG_ERR ("Err_code: 0x%x, fn: %s (), %s",
+                         e.err_code, e.err_fn.c_str (), e.err_msg.c_str ());
+        return e.err_code;
+    } catch (...) {
+        nas_acl_unlock ();
+        NAS_ACL_LOG_ERR ("Warm snapshot collect failed");
+        return NAS_ACL_E_FAIL;
+    }
+    nas_acl_unlock ();
+
+    nas_acl_warm_hdr_t hdr {};
+    hdr.magic = NAS_ACL_WARM_MAGIC;
+    hdr.version = NAS_ACL_WARM_VERSION;
+    hdr.rec_size = sizeof (nas_acl_warm_rec_t);
+    hdr.count = recs.size ();
+    hdr.checksum = nas_acl_hash_bytes (0, recs.data (), recs.size () * sizeof (nas_acl_warm_rec_t));
+
+    std::string tmp_path = std::string {path} + ".tmp";
+    FILE* fp = fopen (tmp_path.c_str (), "wb");
+    if (fp == nullptr) {
+        NAS_ACL_LOG_ERR ("Warm snapshot %s open failed: %s", tmp_path.c_str (), strerror (errno));
+        return NAS_ACL_E_FAIL;
+    }
+
+    bool ok = (fwrite (&hdr, sizeof (hdr), 1, fp) == 1) &&
+              (recs.empty () ||
+               fwrite (recs.data (), sizeof (nas_acl_warm_rec_t), recs.size (), fp) == recs.size ()) &&
+              (fflush (fp) == 0) && (fsync (fileno (fp)) == 0);
+    ok = (fclose (fp) == 0) && ok;
+
+    if (!ok || rename (tmp_path.c_str (), path) != 0) {
+        NAS_ACL_LOG_ERR ("Warm snapshot %s write failed: %s", path, strerror (errno));
+        unlink (tmp_path.c_str ());
+        return NAS_ACL_E_FAIL;
+    }
+
+    NAS_ACL_LOG_NOTICE ("Warm snapshot %s saved with %zu objects", path, recs.size ());
+    return NAS_ACL_E_NONE;
+}
+
+/////// Reconcile timer ///////
+
+static void _warm_timer_main (uint64_t start_ms) noexcept
+{
+    std::unique_lock<std::mutex> l (_warm_timer_mutex);
+
+    while (!_warm_timer_stop && nas_acl_warm_reconciling ()) {
+        uint64_t now_ms = _warm_now_ms ();
+        uint64_t idle_ms = now_ms - _warm_last_replay_ms.load (std::memory_order_relaxed);
+
+        if (idle_ms >= _warm_idle_ms || now_ms - start_ms >= _warm_max_ms) {
+            l.unlock ();
+            NAS_ACL_LOG_NOTICE ("Warm reconcile ended by timer, replay idle for %" PRIu64
+                                " ms", idle_ms);
+            nas_acl_warm_reconcile_end ();
+            return;
+        }
+
+        // Reconcile end by the application is seen on the next wake up
+        _warm_timer_cv.wait_for (l, std::chrono::milliseconds (
+                                     std::min<uint32_t> (_warm_idle_ms, 1000)));
+    }
+}
+
+static void _warm_timer_start (void) noexcept
+{
+    std::lock_guard<std::mutex> l (_warm_timer_mutex);
+
+    uint64_t start_ms = _warm_now_ms ();
+    _warm_last_replay_ms.store (start_ms, std::memory_order_relaxed);
+    _warm_timer_stop = false;
+
+    try {
+        _warm_timer_thread = new std::thread (_warm_timer_main, start_ms);
+    } catch (std::exception& e) {
+        NAS_ACL_LOG_ERR ("Could not start warm reconcile timer: %s", e.what ());
+    }
+}
+
+static void _warm_timer_join (void) noexcept
+{
+    std::thread* thread_p;
+
+    {
+        std::lock_guard<std::mutex> l (_warm_timer_mutex);
+
+        _warm_timer_stop = true;
+        thread_p = _warm_timer_thread;
+        _warm_timer_thread = nullptr;
+    }
+
+    if (thread_p != nullptr) {
+        _warm_timer_cv.notify_all ();
+        thread_p->join ();
+        delete thread_p;
+    }
+}
+
+void nas_acl_warm_replay_timeout_set (uint32_t idle_ms, uint32_t max_ms) noexcept
+{
+    {
+        std::lock_guard<std::mutex> l (_warm_timer_mutex);
+        _warm_idle_ms = idle_ms;
+        _warm_max_ms = max_ms;
+    }
+    _warm_timer_cv.notify_all ();
+}
+
+/////// Snapshot load and reconcile ///////
+
+enum nas_acl_warm_check_t {
+    NAS_ACL_WARM_CHECK_OK,
+    NAS_ACL_WARM_CHECK_UNVERIFIED,  // May be in the NPU, deleted at reconcile end
+    NAS_ACL_WARM_CHECK_GONE,        // Not in the NPU, dropped
+};
+
+/*
+ * NDI ids in the snapshot are only as good as the NPU state they were
+ * saved from. A table or counter NDI cannot read back is gone, and so is
+ * all that was in a gone table. An entry cannot be read back, so the
+ * entries of a table are trusted only while NDI counts at least as many
+ * entries in that table as the snapshot has.
+ */
+static std::vector<nas_acl_warm_check_t>
+_warm_validate (const std::vector<nas_acl_warm_rec_t>& recs) noexcept
+{
+    typedef std::tuple<uint32_t, uint32_t, uint64_t> tbl_key_t;     // Switch, NPU, Table
+    struct tbl_state_t {
+        bool        gone = true;
+        bool        has_used = false;
+        uint64_t    used = 0;
+        uint64_t    entries = 0;
+    };
+
+    std::vector<nas_acl_warm_check_t> checks (recs.size (), NAS_ACL_WARM_CHECK_OK);
+    std::map<tbl_key_t, tbl_state_t> tables;
+
+    for (const auto& rec: recs) {
+        if (rec.type != NAS_ACL_WARM_OBJ_TABLE) continue;
+
+        ndi_acl_table_attr_t table_attr;
+        std::vector<uint32_t> used_count, avail_count;
+        auto& state = tables[tbl_key_t {rec.switch_id, rec.npu_id, rec.table_id}];
+
+        if (!nas_acl_read_ndi_table_usage (rec.npu_id, rec.ndi_obj_id, table_attr,
+                                           used_count, avail_count)) {
+            continue;
+        }
+        state.gone = false;
+        state.has_used = (table_attr.acl_table_used_entry_list_count > 0);
+        for (size_t i = 0; i < table_attr.acl_table_used_entry_list_count; i++) {
+            state.used += used_count[i];
+        }
+    }
+
+    for (const auto& rec: recs) {
+        if (rec.type == NAS_ACL_WARM_OBJ_ENTRY) {
+            tables[tbl_key_t {rec.switch_id, rec.npu_id, rec.table_id}].entries++;
+        }
+    }
+
+    for (size_t ix = 0; ix < recs.size (); ix++) {
+        const auto& rec = recs[ix];
+        if (rec.type == NAS_ACL_WARM_OBJ_RANGE) continue;
+
+        const auto& state = tables[tbl_key_t {rec.switch_id, rec.npu_id, rec.table_id}];
+        if (state.gone) {
+            checks[ix] = NAS_ACL_WARM_CHECK_GONE;
+
+        } else if (rec.type == NAS_ACL_WARM_OBJ_COUNTER) {
+            uint64_t byte_count = 0, pkt_count = 0;
+            if (nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_GET, ndi_acl_counter_get_count,
+                                  (npu_id_t) rec.npu_id, rec.ndi_obj_id,
+                                  (rec.flags & NAS_ACL_WARM_FLAG_BYTE) ? &byte_count : nullptr,
+                                  (rec.flags & NAS_ACL_WARM_FLAG_PKT) ? &pkt_count : nullptr)
+                != STD_ERR_OK) {
+                checks[ix] = NAS_ACL_WARM_CHECK_GONE;
+            }
+
+        } else if (rec.type == NAS_ACL_WARM_OBJ_ENTRY) {
+            if (state.has_used && state.used < state.entries) {
+                checks[ix] = NAS_ACL_WARM_CHECK_UNVERIFIED;
+            }
+        }
+    }
+
+    return checks;
+}
+
+t_std_error nas_acl_warm_snapshot_load (const char* path) noexcept
+{
+    FILE* fp = fopen (path, "rb");
+    if (fp == nullptr) {
+        // Cold start, nothing to reconcile
+        NAS_ACL_LOG_BRIEF ("No warm snapshot %s: %s", path, strerror (errno));
+        return NAS_ACL_E_KEY_VAL;
+    }
+
+    nas_acl_warm_hdr_t hdr {};
+    std::vector<nas_acl_warm_rec_t> recs;
+    bool ok = (fread (&hdr, sizeof (hdr), 1, fp) == 1) &&
+              hdr.magic == NAS_ACL_WARM_MAGIC && hdr.version == NAS_ACL_WARM_VERSION &&
+              hdr.rec_size == sizeof (nas_acl_warm_rec_t);
+    if (ok) {
+        try {
+            recs.resize (hdr.count);
+        } catch (...) {
+            ok = false;
+        }
+    }
+    ok = ok && (recs.empty () ||
+                fread (recs.data (), sizeof (nas_acl_warm_rec_t), recs.size (), fp) == recs.size ());
+    ok = ok && (hdr.checksum ==
+                nas_acl_hash_bytes (0, recs.data (), recs.size () * sizeof (nas_acl_warm_rec_t)));
+    fclose (fp);
+    unlink (path);
+
+    if (!ok) {
+        NAS_ACL_LOG_ERR ("Warm snapshot %s is not valid, all objects will be reprogrammed", path);
+        return NAS_ACL_E_FAIL;
+    }
+
+    auto checks = _warm_validate (recs);
+
+    _warm_timer_join ();
+
+    std::lock_guard<std::mutex> l {_warm_mutex};
+    _warm_objs.clear ();
+    _warm_info = {};
+    for (size_t ix = 0; ix < recs.size (); ix++) {
+        const auto& rec = recs[ix];
+        if (checks[ix] != NAS_ACL_WARM_CHECK_OK) {
+            NAS_ACL_LOG_BRIEF ("Snapshot object type %d id %" PRIu64 " in NPU %d NDI ID 0x%"
+                               PRIx64 " is %s in NDI", rec.type, rec.obj_id, rec.npu_id,
+                               rec.ndi_obj_id, (checks[ix] == NAS_ACL_WARM_CHECK_GONE) ?
+                               "not" : "not verified");
+            _warm_info.rejected++;
+            if (checks[ix] == NAS_ACL_WARM_CHECK_GONE) continue;
+        }
+        nas_acl_warm_key_t key {rec.type, rec.switch_id, rec.npu_id, rec.table_id, rec.obj_id};
+        auto& slot = _warm_objs[key];
+        slot.rec = rec;
+        slot.verified = (checks[ix] == NAS_ACL_WARM_CHECK_OK);
+    }
+    _warm_info.loaded = recs.size ();
+    _warm_info.reconciling = !_warm_objs.empty ();
+    g_nas_acl_warm_reconciling.store (_warm_info.reconciling, std::memory_order_relaxed);
+
+    NAS_ACL_LOG_NOTICE ("Warm snapshot %s loaded with %zu objects, %" PRIu64 " rejected",
+                        path, recs.size (), _warm_info.rejected);
+
+    if (_warm_info.reconciling) {
+        _warm_timer_start ();
+    }
+    return NAS_ACL_E_NONE;
+}
+
+template <typename T>
+static bool _warm_adopt (const T& obj, nas_acl_warm_obj_t type, nas_switch_id_t switch_id,
+                         nas_obj_id_t table_id, nas_obj_id_t obj_id,
+                         npu_id_t npu_id, ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    uint64_t fingerprint = 0, deps = 0;
+    bool has_sig = _warm_sig (obj, npu_id, fingerprint, deps);
+
+    std::lock_guard<std::mutex> l {_warm_mutex};
+    if (!_warm_info.reconciling) {
+        return false;
+    }
+    _warm_last_replay_ms.store (_warm_now_ms (), std::memory_order_relaxed);
+
+    auto it = _warm_objs.find (_warm_key (type, switch_id, table_id, obj_id, npu_id));
+    if (!has_sig || it == _warm_objs.end () || it->second.adopted || !it->second.verified ||
+        it->second.rec.fingerprint != fingerprint || it->second.rec.deps != deps) {
+        // Changed while NAS was down, the stale one is deleted at reconcile end
+        _warm_info.programmed++;
+        return false;
+    }
+
+    it->second.adopted = true;
+    ndi_obj_id = it->second.rec.ndi_obj_id;
+    _warm_info.adopted++;
+
+    NAS_ACL_LOG_DETAIL ("Switch %d Table %" PRIu64 ": adopted object type %d id %" PRIu64
+                        " in NPU %d; NDI ID 0x%" PRIx64,
+                        switch_id, table_id, type, obj_id, npu_id, ndi_obj_id);
+    return true;
+}
+
+bool nas_acl_warm_adopt (const nas_acl_table& table, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    if (!nas_acl_warm_reconciling ()) return false;
+    return _warm_adopt (table, NAS_ACL_WARM_OBJ_TABLE, table.get_switch ().id (),
+                        table.table_id (), table.table_id (), npu_id, ndi_obj_id);
+}
+
+bool nas_acl_warm_adopt (const nas_acl_counter_t& counter, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    if (!nas_acl_warm_reconciling ()) return false;
+    return _warm_adopt (counter, NAS_ACL_WARM_OBJ_COUNTER, counter.get_switch ().id (),
+                        counter.table_id (), counter.counter_id (), npu_id, ndi_obj_id);
+}
+
+bool nas_acl_warm_adopt (const nas_acl_range& range, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    if (!nas_acl_warm_reconciling ()) return false;
+    return _warm_adopt (range, NAS_ACL_WARM_OBJ_RANGE, range.get_switch ().id (),
+                        0, range.range_id (), npu_id, ndi_obj_id);
+}
+
+bool nas_acl_warm_adopt (const nas_acl_entry& entry, npu_id_t npu_id,
+                         ndi_obj_id_t& ndi_obj_id) noexcept
+{
+    if (!nas_acl_warm_reconciling ()) return false;
+    return _warm_adopt (entry, NAS_ACL_WARM_OBJ_ENTRY, entry.get_table ().get_switch ().id (),
+                        entry.table_id (), entry.entry_id (), npu_id, ndi_obj_id);
+}
+
+static t_std_error _warm_ndi_delete (const nas_acl_warm_rec_t& rec) noexcept
+{
+    npu_id_t npu_id = rec.npu_id;
+
+    switch (rec.type) {
+        case NAS_ACL_WARM_OBJ_ENTRY:
+            return nas_acl_lat_call (NAS_ACL_LAT_NDI_ENTRY_DELETE, ndi_acl_entry_delete,
+                                     npu_id, rec.ndi_obj_id);
+        case NAS_ACL_WARM_OBJ_COUNTER:
+            return nas_acl_lat_call (NAS_ACL_LAT_NDI_COUNTER_DELETE, ndi_acl_counter_delete,
+                                     npu_id, rec.ndi_obj_id);
+        case NAS_ACL_WARM_OBJ_RANGE:
+            return nas_acl_lat_call (NAS_ACL_LAT_NDI_RANGE_DELETE, ndi_acl_range_delete,
+                                     npu_id, rec.ndi_obj_id);
+        case NAS_ACL_WARM_OBJ_TABLE:
+            return nas_acl_lat_call (NAS_ACL_LAT_NDI_TABLE_DELETE, ndi_acl_table_delete,
+                                     npu_id, rec.ndi_obj_id);
+        default:
+            return NAS_ACL_E_FAIL;
+    }
+}
+
+t_std_error nas_acl_warm_reconcile_end (void) noexcept
+{
+    // Children go before the tables holding them
+    static const nas_acl_warm_obj_t del_order[] = {
+        NAS_ACL_WARM_OBJ_ENTRY, NAS_ACL_WARM_OBJ_COUNTER,
+        NAS_ACL_WARM_OBJ_RANGE, NAS_ACL_WARM_OBJ_TABLE,
+    };
+
+    // Keeps CPS requests, which could adopt, out until the map is cleared
+    nas_acl_lock ();
+    std::lock_guard<std::mutex> l {_warm_mutex};
+
+    if (!_warm_info.reconciling) {
+        nas_acl_unlock ();
+        return NAS_ACL_E_NONE;
+    }
+    _warm_info.reconciling = false;
+    g_nas_acl_warm_reconciling.store (false, std::memory_order_relaxed);
+
+    for (auto type: del_order) {
+        for (const auto& obj_pair: _warm_objs) {
+            const auto& slot = obj_pair.second;
+            if (slot.adopted || slot.rec.type != (uint32_t) type) continue;
+
+            t_std_error rc = _warm_ndi_delete (slot.rec);
+            if (rc != STD_ERR_OK) {
+                NAS_ACL_LOG_ERR_RL ("Stale object type %d id %" PRIu64 " delete failed in NPU %d"
+                                    " NDI ID 0x%" PRIx64 ", rc 0x%x", type, slot.rec.obj_id,
+                                    slot.rec.npu_id, slot.rec.ndi_obj_id, rc);
+                _warm_info.stale_failed++;
+            } else {
+                _warm_info.stale_deleted++;
+            }
+        }
+    }
+    _warm_objs.clear ();
+    nas_acl_unlock ();
+
+    NAS_ACL_LOG_NOTICE ("Warm reconcile done: %" PRIu64 " adopted, %" PRIu64 " programmed, "
+                        "%" PRIu64 " stale deleted, %" PRIu64 " stale delete failed",
+                        _warm_info.adopted, _warm_info.programmed,
+                        _warm_info.stale_deleted, _warm_info.stale_failed);
+    return (_warm_info.stale_failed > 0) ? NAS_ACL_E_FAIL : NAS_ACL_E_NONE;
+}
+
+t_std_error nas_acl_warm_shutdown (const char* path) noexcept
+{
+    // Timer may be ending reconcile, it is done before the save
+    _warm_timer_join ();
+
+    if (nas_acl_warm_reconciling ()) {
+        // Unclaimed objects are in no cache and would stay in the NPU
+        nas_acl_warm_reconcile_end ();
+    }
+
+    return nas_acl_warm_snapshot_save (path);
+}
+
+void nas_acl_warm_info_get (nas_acl_warm_info_t* info) noexcept
+{
+    std::lock_guard<std::mutex> l {_warm_mutex};
+    *info = _warm_info;
+}
+
+void dump_acl_warm (void)
+{
+    nas_acl_warm_info_t info;
+
+    nas_acl_warm_info_get (&info);
+
+    NAS_ACL_LOG_DUMP ("Warm reconcile %s", info.reconciling ? "in progress" : "not active");
+    NAS_ACL_LOG_DUMP ("  Loaded         %" PRIu64, info.loaded);
+    NAS_ACL_LOG_DUMP ("  Rejected       %" PRIu64, info.rejected);
+    NAS_ACL_LOG_DUMP ("  Adopted        %" PRIu64, info.adopted);
+    NAS_ACL_LOG_DUMP ("  Programmed     %" PRIu64, info.programmed);
+    NAS_ACL_LOG_DUMP ("  Stale deleted  %" PRIu64, info.stale_deleted);
+    NAS_ACL_LOG_DUMP ("  Stale failed   %" PRIu64, info.stale_failed);
+}
@@ -24,6 +24,7 @@
 #include "nas_acl_switch.h"
 #include "nas_ndi_udf.h"
 #include "nas_acl_log.h"
+#include "nas_acl_mem.h"
 
 nas_udf::nas_udf(nas_acl_switch* switch_p)
     : nas::base_obj_t(switch_p)
@@ -50,6 +51,13 @@ void nas_udf::hash_mask(uint8_t* byte_list, size_t& byte_cnt) const noexcept
     byte_cnt = _hash_mask.size();
 }
 
+void nas_udf::mem_usage(nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj(NAS_ACL_MEM_UDF);
+    acct.add(NAS_ACL_MEM_UDF, _hash_mask);
+    acct.add(NAS_ACL_MEM_UDF, _ndi_obj_ids);
+}
+
 void nas_udf::set_base(uint_t base)
 {
     if (is_created_in_ndi()) {
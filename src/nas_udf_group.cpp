@@ -24,6 +24,7 @@
 #include "nas_acl_switch.h"
 #include "nas_ndi_udf.h"
 #include "nas_acl_log.h"
+#include "nas_acl_mem.h"
 
 nas_udf_group::nas_udf_group(nas_acl_switch* switch_p)
     : nas::base_obj_t(switch_p)
@@ -46,6 +47,13 @@ ndi_obj_id_t nas_udf_group::get_ndi_obj_id (npu_id_t npu_id) const
     }
 }
 
+void nas_udf_group::mem_usage(nas_acl_mem_account& acct) const noexcept
+{
+    acct.add_obj(NAS_ACL_MEM_UDF);
+    acct.add(NAS_ACL_MEM_UDF, _udf_ids);
+    acct.add(NAS_ACL_MEM_UDF, _ndi_obj_ids);
+}
+
 void nas_udf_group::set_type(uint_t type)
 {
     if (is_created_in_ndi()) {
@@ -0,0 +1,650 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * nas_acl_bench.cpp
+ *
+ * Scale benchmark of the NAS ACL CPS handlers against the NDI stub.
+ * Built and linked like the unit test, with this file in place of
+ * nas_acl_cps_ut.cpp. Each phase commits one object per transaction and
+ * prints one JSON line:
+ *
+ *   nas_acl_bench [-s 1000,10000,100000] [-t tables] [-o file]
+ *                 [-L] [-c capacity] [-f fail_rate] [-l log_level]
+ *
+ * -L delays the stub NDI calls like a hardware SDK, -c limits the entries
+ * of each table and -f fails that share of the NDI entry creates.
+ * -l sets the NAS ACL runtime log level, runs at 1 (errors only) and at
+ * the default level give the cost of logging per operation.
+ * With all entries loaded the memory footprint per object type and the
+ * bytes per entry, counting its filters, actions and port lists, follow.
+ * The loaded config is then saved as a binary policy and, once everything
+ * is deleted, loaded back in one policy_load line whose ops_per_sec counts
+ * objects, to compare against the per object create phases.
+ */
+
+#include "nas_acl_cps_ut.h"
+#include "nas_acl_db_ut.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_policy.h"
+#include "cps_api_object_key.h"
+#include "cps_class_map.h"
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#define NAS_ACL_BENCH_DEF_TABLES          4
+#define NAS_ACL_BENCH_ENTRIES_PER_RANGE   100  // Ranges are scarce in hardware
+#define NAS_ACL_BENCH_TABLE_PRIO_BASE     500
+#define NAS_ACL_BENCH_POLICY_PATH         "/tmp/nas_acl_bench.policy"
+
+typedef struct _nas_acl_bench_table_t {
+    nas_obj_id_t               table_id;
+    std::vector<nas_obj_id_t>  entry_ids;
+    std::vector<nas_obj_id_t>  counter_ids;
+} nas_acl_bench_table_t;
+
+static FILE*                               _bench_out = stdout;
+static std::vector<nas_acl_bench_table_t>  _bench_tables;
+static std::vector<nas_obj_id_t>           _bench_range_ids;
+
+static inline uint64_t _bench_now_ns ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+static long _bench_peak_rss_kb ()
+{
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+    return usage.ru_maxrss;
+}
+
+static uint64_t _bench_percentile (const std::vector<uint64_t>& sorted, uint_t pct)
+{
+    if (sorted.empty ()) return 0;
+
+    size_t rank = (sorted.size () * pct + 99) / 100;
+    return sorted [(rank > 0) ? rank - 1 : 0];
+}
+
+/*
+ * Run op count times, op returns false on failure. Failed calls are
+ * timed as well, they still went through the handler.
+ */
+static void _bench_phase (size_t scale, const char* name, size_t count,
+                          const std::function<bool (size_t, uint64_t&)>& op)
+{
+    std::vector<uint64_t> samples;
+    size_t   errors = 0;
+    uint64_t total_ns = 0;
+
+    samples.reserve (count);
+
+    for (size_t ix = 0; ix < count; ix++) {
+        uint64_t elapsed_ns = 0;
+
+        if (!op (ix, elapsed_ns)) {
+            errors++;
+        }
+        samples.push_back (elapsed_ns);
+        total_ns += elapsed_ns;
+    }
+
+    std::sort (samples.begin (), samples.end ());
+
+    double ops_per_sec = (total_ns > 0) ? (count * 1e9) / total_ns : 0;
+
+    fprintf (_bench_out,
+             "{\"bench\":\"nas_acl\",\"scale\":%zu,\"op\":\"%s\",\"count\":%zu,"
+             "\"errors\":%zu,\"total_ms\":%.3f,\"ops_per_sec\":%.1f,"
+             "\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f,"
+             "\"peak_rss_kb\":%ld}\n",
+             scale, name, count, errors, total_ns / 1e6, ops_per_sec,
+             _bench_percentile (samples, 50) / 1e3,
+             _bench_percentile (samples, 90) / 1e3,
+             _bench_percentile (samples, 99) / 1e3,
+             (samples.empty ()) ? 0 : samples.back () / 1e3,
+             _bench_peak_rss_kb ());
+    fflush (_bench_out);
+}
+
+/*
+ * Commit one object in its own transaction, only the handler is timed.
+ * The key of the committed object is returned in key_id when asked for.
+ */
+static bool _bench_commit (cps_api_object_t obj, cps_api_operation_types_t op,
+                           uint64_t& elapsed_ns,
+                           cps_api_attr_id_t key_attr = 0, nas_obj_id_t* key_id = NULL)
+{
+    cps_api_transaction_params_t params;
+
+    if (cps_api_transaction_init (&params) != cps_api_ret_code_OK) {
+        cps_api_object_delete (obj);
+        return false;
+    }
+
+    switch (op) {
+        case cps_api_oper_CREATE: cps_api_create (&params, obj); break;
+        case cps_api_oper_SET:    cps_api_set (&params, obj); break;
+        default:                  cps_api_delete (&params, obj); break;
+    }
+
+    uint64_t start_ns = _bench_now_ns ();
+    bool rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+    elapsed_ns = _bench_now_ns () - start_ns;
+
+    if (rc && key_id != NULL) {
+        auto attr = cps_api_get_key_data (obj, key_attr);
+        rc = (attr != NULL);
+        if (rc) *key_id = cps_api_object_attr_data_u64 (attr);
+    }
+
+    cps_api_transaction_close (&params);
+    return rc;
+}
+
+static bool _bench_get (cps_api_attr_id_t obj_attr,
+                        const std::vector<std::pair<cps_api_attr_id_t, nas_obj_id_t>>& keys,
+                        uint64_t& elapsed_ns)
+{
+    cps_api_get_params_t params;
+
+    if (cps_api_get_request_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append (params.filters);
+    cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_attr,
+                                     cps_api_qualifier_TARGET);
+    for (auto& key: keys) {
+        cps_api_set_key_data (obj, key.first, cps_api_object_ATTR_T_U64,
+                              &key.second, sizeof (uint64_t));
+    }
+
+    uint64_t start_ns = _bench_now_ns ();
+    bool rc = (nas_acl_ut_cps_api_get (&params, 0) == cps_api_ret_code_OK);
+    elapsed_ns = _bench_now_ns () - start_ns;
+
+    rc = rc && (cps_api_object_list_size (params.list) == 1);
+
+    cps_api_get_request_close (&params);
+    return rc;
+}
+
+static cps_api_object_t _bench_obj_create (cps_api_attr_id_t obj_attr)
+{
+    cps_api_object_t obj = cps_api_object_create ();
+
+    if (obj != NULL) {
+        cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_attr,
+                                         cps_api_qualifier_TARGET);
+    }
+    return obj;
+}
+
+static bool _bench_table_create (size_t ix, uint64_t& elapsed_ns)
+{
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_TABLE_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_STAGE, BASE_ACL_STAGE_INGRESS);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_PRIORITY,
+                                 NAS_ACL_BENCH_TABLE_PRIO_BASE + ix);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_ALLOWED_MATCH_FIELDS,
+                                 BASE_ACL_MATCH_TYPE_IP_PROTOCOL);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_ALLOWED_MATCH_FIELDS,
+                                 BASE_ACL_MATCH_TYPE_L4_DST_PORT);
+    for (npu_id_t npu = 0; npu < NAS_ACL_UT_MAX_NPUS; npu++) {
+        cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_NPU_ID_LIST, npu);
+    }
+
+    nas_acl_bench_table_t table {};
+    if (!_bench_commit (obj, cps_api_oper_CREATE, elapsed_ns,
+                        BASE_ACL_TABLE_ID, &table.table_id)) {
+        return false;
+    }
+    _bench_tables.push_back (table);
+    return true;
+}
+
+static bool _bench_table_delete (size_t ix, uint64_t& elapsed_ns)
+{
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_TABLE_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &_bench_tables [ix].table_id, sizeof (uint64_t));
+
+    return _bench_commit (obj, cps_api_oper_DELETE, elapsed_ns);
+}
+
+static bool _bench_range_create (size_t ix, uint64_t& elapsed_ns)
+{
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_RANGE_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_RANGE_TYPE, BASE_ACL_RANGE_TYPE_L4_DST_PORT);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_RANGE_LIMIT_MIN, 1024 + ix);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_RANGE_LIMIT_MAX, 2048 + ix);
+
+    nas_obj_id_t range_id = 0;
+    if (!_bench_commit (obj, cps_api_oper_CREATE, elapsed_ns, BASE_ACL_RANGE_ID, &range_id)) {
+        return false;
+    }
+    _bench_range_ids.push_back (range_id);
+    return true;
+}
+
+static bool _bench_range_get (size_t ix, uint64_t& elapsed_ns)
+{
+    return _bench_get (BASE_ACL_RANGE_OBJ, {{BASE_ACL_RANGE_ID, _bench_range_ids [ix]}},
+                       elapsed_ns);
+}
+
+static bool _bench_range_delete (size_t ix, uint64_t& elapsed_ns)
+{
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_RANGE_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_RANGE_ID, cps_api_object_ATTR_T_U64,
+                          &_bench_range_ids [ix], sizeof (uint64_t));
+
+    return _bench_commit (obj, cps_api_oper_DELETE, elapsed_ns);
+}
+
+// Objects of index ix are spread round robin over the tables
+static inline nas_acl_bench_table_t& _bench_table_of (size_t ix)
+{
+    return _bench_tables [ix % _bench_tables.size ()];
+}
+
+static inline size_t _bench_slot_of (size_t ix)
+{
+    return ix / _bench_tables.size ();
+}
+
+static bool _bench_counter_create (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_COUNTER_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_COUNTER_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_COUNTER_TYPES, BASE_ACL_COUNTER_TYPE_PACKET);
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_COUNTER_TYPES, BASE_ACL_COUNTER_TYPE_BYTE);
+
+    nas_obj_id_t counter_id = 0;
+    if (!_bench_commit (obj, cps_api_oper_CREATE, elapsed_ns,
+                        BASE_ACL_COUNTER_ID, &counter_id)) {
+        // Keep the slots of the table aligned with the entries
+        table.counter_ids.push_back (0);
+        return false;
+    }
+    table.counter_ids.push_back (counter_id);
+    return true;
+}
+
+static bool _bench_counter_get (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+
+    return _bench_get (BASE_ACL_COUNTER_OBJ,
+                       {{BASE_ACL_COUNTER_TABLE_ID, table.table_id},
+                        {BASE_ACL_COUNTER_ID, table.counter_ids [_bench_slot_of (ix)]}},
+                       elapsed_ns);
+}
+
+static bool _bench_counter_delete (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_COUNTER_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_COUNTER_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    cps_api_set_key_data (obj, BASE_ACL_COUNTER_ID, cps_api_object_ATTR_T_U64,
+                          &table.counter_ids [_bench_slot_of (ix)], sizeof (uint64_t));
+
+    return _bench_commit (obj, cps_api_oper_DELETE, elapsed_ns);
+}
+
+// TCP to a distinct destination port per entry, counted
+static void _bench_fill_entry (ut_entry_t& entry, size_t ix, nas_obj_id_t counter_id,
+                               BASE_ACL_PACKET_ACTION_TYPE_t pkt_action)
+{
+    ut_filter_t filter;
+    filter.type = BASE_ACL_MATCH_TYPE_IP_PROTOCOL;
+    filter.val_list = {6, 1, 0xff};
+    entry.filter_list.insert (filter);
+
+    filter.type = BASE_ACL_MATCH_TYPE_L4_DST_PORT;
+    filter.val_list = {ix % 0xffff, 1, 0xffff};
+    entry.filter_list.insert (filter);
+
+    ut_action_t action;
+    action.type = BASE_ACL_ACTION_TYPE_PACKET_ACTION;
+    action.val_list = {(uint64_t) pkt_action};
+    entry.action_list.insert (action);
+
+    if (counter_id != 0) {
+        action.type = BASE_ACL_ACTION_TYPE_SET_COUNTER;
+        action.val_list = {counter_id};
+        entry.action_list.insert (action);
+    }
+}
+
+static bool _bench_entry_create (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+    size_t slot = _bench_slot_of (ix);
+
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_ENTRY_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, (ix % 1000) + 1);
+
+    ut_entry_t entry {};
+    nas_obj_id_t counter_id = (slot < table.counter_ids.size ()) ? table.counter_ids [slot] : 0;
+    _bench_fill_entry (entry, ix, counter_id, BASE_ACL_PACKET_ACTION_TYPE_DROP);
+
+    if (!ut_fill_entry_match (obj, entry) || !ut_fill_entry_action (obj, entry)) {
+        cps_api_object_delete (obj);
+        table.entry_ids.push_back (0);
+        return false;
+    }
+
+    nas_obj_id_t entry_id = 0;
+    bool rc = _bench_commit (obj, cps_api_oper_CREATE, elapsed_ns,
+                             BASE_ACL_ENTRY_ID, &entry_id);
+    table.entry_ids.push_back (entry_id);
+    return rc;
+}
+
+// New priority and a full action list replacing the old one
+static bool _bench_entry_modify (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+    size_t slot = _bench_slot_of (ix);
+
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_ENTRY_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                          &table.entry_ids [slot], sizeof (uint64_t));
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, (ix % 1000) + 1001);
+
+    ut_entry_t entry {};
+    nas_obj_id_t counter_id = (slot < table.counter_ids.size ()) ? table.counter_ids [slot] : 0;
+    _bench_fill_entry (entry, ix, counter_id, BASE_ACL_PACKET_ACTION_TYPE_FORWARD);
+
+    if (!ut_fill_entry_action (obj, entry)) {
+        cps_api_object_delete (obj);
+        return false;
+    }
+
+    return _bench_commit (obj, cps_api_oper_SET, elapsed_ns);
+}
+
+static bool _bench_entry_get (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+
+    return _bench_get (BASE_ACL_ENTRY_OBJ,
+                       {{BASE_ACL_ENTRY_TABLE_ID, table.table_id},
+                        {BASE_ACL_ENTRY_ID, table.entry_ids [_bench_slot_of (ix)]}},
+                       elapsed_ns);
+}
+
+static bool _bench_entry_delete (size_t ix, uint64_t& elapsed_ns)
+{
+    auto& table = _bench_table_of (ix);
+
+    cps_api_object_t obj = _bench_obj_create (BASE_ACL_ENTRY_OBJ);
+    if (obj == NULL) return false;
+
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                          &table.entry_ids [_bench_slot_of (ix)], sizeof (uint64_t));
+
+    return _bench_commit (obj, cps_api_oper_DELETE, elapsed_ns);
+}
+
+// NDI time as seen by the handlers, from the latency histograms
+static void _bench_ndi_summary (size_t scale, nas_acl_lat_summary_t* base)
+{
+    for (int op = NAS_ACL_LAT_NDI_TABLE_CREATE; op < NAS_ACL_LAT_OP_MAX; op++) {
+        nas_acl_lat_summary_t cur;
+        nas_acl_lat_get ((nas_acl_lat_op_t) op, &cur);
+
+        uint64_t count = cur.count - base [op].count;
+        if (count == 0) continue;
+
+        fprintf (_bench_out,
+                 "{\"bench\":\"nas_acl\",\"scale\":%zu,\"ndi\":\"%s\",\"count\":%" PRIu64
+                 ",\"avg_us\":%.3f,\"p99_us_bound\":%" PRIu64 "}\n",
+                 scale, nas_acl_lat_op_name ((nas_acl_lat_op_t) op), count,
+                 (double) (cur.sum_us - base [op].sum_us) / count, cur.p99_us);
+    }
+    fflush (_bench_out);
+}
+
+// Footprint added since base was taken
+static void _bench_mem_summary (size_t scale, const nas_acl_mem_usage_t* base)
+{
+    nas_acl_mem_usage_t cur [NAS_ACL_MEM_TYPE_MAX];
+    uint64_t entry_bytes = 0, entry_allocs = 0;
+
+    nas_acl_mem_usage_get (cur);
+
+    for (int type = 0; type < NAS_ACL_MEM_TYPE_MAX; type++) {
+        uint64_t objs = cur [type].objs - base [type].objs;
+        uint64_t bytes = cur [type].bytes - base [type].bytes;
+        uint64_t allocs = cur [type].allocs - base [type].allocs;
+
+        fprintf (_bench_out,
+                 "{\"bench\":\"nas_acl\",\"scale\":%zu,\"mem\":\"%s\",\"objs\":%" PRIu64
+                 ",\"bytes\":%" PRIu64 ",\"allocs\":%" PRIu64 "}\n",
+                 scale, nas_acl_mem_type_name ((nas_acl_mem_type_t) type),
+                 objs, bytes, allocs);
+
+        if (type == NAS_ACL_MEM_ENTRY || type == NAS_ACL_MEM_FILTER ||
+            type == NAS_ACL_MEM_ACTION || type == NAS_ACL_MEM_PORT_LIST) {
+            entry_bytes += bytes;
+            entry_allocs += allocs;
+        }
+    }
+
+    uint64_t entries = cur [NAS_ACL_MEM_ENTRY].objs - base [NAS_ACL_MEM_ENTRY].objs;
+    if (entries > 0) {
+        fprintf (_bench_out,
+                 "{\"bench\":\"nas_acl\",\"scale\":%zu,\"entries\":%" PRIu64
+                 ",\"bytes_per_entry\":%.1f,\"allocs_per_entry\":%.2f}\n",
+                 scale, entries, (double) entry_bytes / entries,
+                 (double) entry_allocs / entries);
+    }
+    fflush (_bench_out);
+}
+
+static void _bench_policy_load (size_t scale)
+{
+    nas_acl_policy_info_t info {};
+    t_std_error rc = nas_acl_policy_load (NAS_ACL_BENCH_POLICY_PATH,
+                                          NAS_ACL_POLICY_BATCH_SIZE, &info);
+    unlink (NAS_ACL_BENCH_POLICY_PATH);
+
+    fprintf (_bench_out,
+             "{\"bench\":\"nas_acl\",\"scale\":%zu,\"op\":\"policy_load\",\"count\":%" PRIu64
+             ",\"errors\":%" PRIu64 ",\"total_ms\":%.3f,\"ops_per_sec\":%" PRIu64
+             ",\"batches\":%" PRIu64 ",\"file_bytes\":%" PRIu64 ",\"peak_rss_kb\":%ld}\n",
+             scale, info.objs, (rc == STD_ERR_OK) ? 0 : info.objs - info.loaded,
+             info.load_us / 1e3, info.objs_per_sec, info.batches, info.file_bytes,
+             _bench_peak_rss_kb ());
+    fflush (_bench_out);
+
+    // Objects come back with their saved IDs, delete them the same way
+    uint64_t elapsed_ns;
+    for (size_t ix = 0; ix < scale; ix++) _bench_entry_delete (ix, elapsed_ns);
+    for (size_t ix = 0; ix < scale; ix++) _bench_counter_delete (ix, elapsed_ns);
+    for (size_t ix = 0; ix < _bench_range_ids.size (); ix++) _bench_range_delete (ix, elapsed_ns);
+    for (size_t ix = 0; ix < _bench_tables.size (); ix++) _bench_table_delete (ix, elapsed_ns);
+}
+
+static void _bench_run (size_t scale, size_t num_tables)
+{
+    size_t num_ranges = std::max<size_t> (scale / NAS_ACL_BENCH_ENTRIES_PER_RANGE, 1);
+    nas_acl_lat_summary_t base [NAS_ACL_LAT_OP_MAX];
+    nas_acl_mem_usage_t mem_base [NAS_ACL_MEM_TYPE_MAX];
+
+    for (int op = 0; op < NAS_ACL_LAT_OP_MAX; op++) {
+        nas_acl_lat_get ((nas_acl_lat_op_t) op, &base [op]);
+    }
+
+    _bench_tables.clear ();
+    _bench_range_ids.clear ();
+
+    _bench_phase (scale, "table_create", num_tables, _bench_table_create);
+    if (_bench_tables.empty ()) {
+        fprintf (stderr, "No table could be created, scale %zu skipped\n", scale);
+        return;
+    }
+
+    nas_acl_mem_usage_get (mem_base);
+
+    _bench_phase (scale, "range_create", num_ranges, _bench_range_create);
+    _bench_phase (scale, "counter_create", scale, _bench_counter_create);
+    _bench_phase (scale, "entry_create", scale, _bench_entry_create);
+    _bench_mem_summary (scale, mem_base);
+    _bench_phase (scale, "entry_modify", scale, _bench_entry_modify);
+    _bench_phase (scale, "entry_get", scale, _bench_entry_get);
+    _bench_phase (scale, "counter_get", scale, _bench_counter_get);
+    _bench_phase (scale, "range_get", _bench_range_ids.size (), _bench_range_get);
+    bool policy_saved = (nas_acl_policy_save (NAS_ACL_BENCH_POLICY_PATH) == STD_ERR_OK);
+    _bench_phase (scale, "entry_delete", scale, _bench_entry_delete);
+    _bench_phase (scale, "counter_delete", scale, _bench_counter_delete);
+    _bench_phase (scale, "range_delete", _bench_range_ids.size (), _bench_range_delete);
+    _bench_phase (scale, "table_delete", _bench_tables.size (), _bench_table_delete);
+    if (policy_saved) {
+        _bench_policy_load (scale);
+    }
+
+    _bench_ndi_summary (scale, base);
+}
+
+static bool _bench_parse_scales (const char* arg, std::vector<size_t>& scales)
+{
+    std::string s (arg);
+    size_t pos = 0;
+
+    scales.clear ();
+    while (pos <= s.size ()) {
+        size_t next = s.find (',', pos);
+        if (next == std::string::npos) next = s.size ();
+
+        char* end = NULL;
+        unsigned long val = strtoul (s.substr (pos, next - pos).c_str (), &end, 10);
+        if (val == 0 || end == NULL || *end != '\0') return false;
+
+        scales.push_back (val);
+        pos = next + 1;
+    }
+    return !scales.empty ();
+}
+
+int main (int argc, char **argv)
+{
+    std::vector<size_t> scales = {1000, 10000, 100000};
+    size_t num_tables = NAS_ACL_BENCH_DEF_TABLES;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "s:t:o:Lc:f:l:")) != -1) {
+        switch (opt) {
+            case 's':
+                if (!_bench_parse_scales (optarg, scales)) {
+                    fprintf (stderr, "Invalid scale list %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                num_tables = strtoul (optarg, NULL, 10);
+                if (num_tables == 0) {
+                    fprintf (stderr, "Invalid table count %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'o':
+                _bench_out = fopen (optarg, "w");
+                if (_bench_out == NULL) {
+                    fprintf (stderr, "Cannot open %s: %s\n", optarg, strerror (errno));
+                    return 1;
+                }
+                break;
+            case 'L':
+                ut_simulate_ndi_sdk_profile ();
+                break;
+            case 'c':
+                ut_simulate_ndi_table_capacity () = strtoul (optarg, NULL, 10);
+                break;
+            case 'f':
+                ut_simulate_ndi_call_profile (NAS_ACL_LAT_NDI_ENTRY_CREATE).fail_rate =
+                    strtod (optarg, NULL);
+                break;
+            case 'l':
+                nas_acl_log_level_set (strtol (optarg, NULL, 10));
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-s scale,...] [-t tables] [-o file] "
+                         "[-L] [-c capacity] [-f fail_rate] [-l log_level]\n", argv [0]);
+                return 1;
+        }
+    }
+
+    nas_acl_ut_env_init ();
+
+    // Stub NDI prints every call otherwise
+    ut_print_set_status (false);
+
+    for (auto scale: scales) {
+        _bench_run (scale, num_tables);
+    }
+
+    if (_bench_out != stdout) {
+        fclose (_bench_out);
+    }
+    return 0;
+}
@@ -3174,6 +3174,15 @@ static inline void ut_add_nh_action(ut_entry_t& entry, ut_action_t& action,
     entry.action_list.insert(action);
 }
 
+void nas_acl_ut_add_nh_redirect(ut_entry_t& entry, ndi_obj_id_t nh_id)
+{
+    ut_action_t action;
+
+    action.type = BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP;
+    entry.action_list.erase(action);
+    ut_add_nh_action(entry, action, 0, AF_INET, "30.0.0.5", nh_id);
+}
+
 const char *nh_dest_ip = "30.0.0.5";
 const char *nh_mac_addr = "01:02:03:04:05:06";
 const char *local_if_name = "e101-028-0";
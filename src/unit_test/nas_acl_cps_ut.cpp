@@ -15,6 +15,30 @@
  */
 
 #include "nas_acl_cps_ut.h"
+#include "nas_acl_db_ut.h"
+#include "nas_acl_latency.h"
+#include "nas_acl_lock_stats.h"
+#include "nas_acl_mem.h"
+#include "nas_acl_trace.h"
+#include "nas_acl_warm.h"
+#include "nas_acl_audit.h"
+#include "nas_acl_policy.h"
+#include "nas_acl_stats.h"
+#include "nas_acl_cps_key.h"
+#include "nas_acl_switch_list.h"
+#include "cps_api_object_tools.h"
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <atomic>
 
 #define NAS_ACL_UT_BREAK_ON_FAILURE(_rc) if(!rc) { \
     ut_printf("*** Failed at line %d ***\n", __LINE__); \
@@ -60,6 +84,148 @@ TEST (nas_acl_table, delete_test)
     ASSERT_TRUE (rc);
 }
 
+// Entries the NDI stub holds in the NPU tables of a table
+static size_t _ut_ndi_entries (nas_switch_id_t switch_id, nas_obj_id_t table_id,
+                               std::vector<ndi_obj_id_t>* ndi_ids = NULL)
+{
+    size_t count = 0;
+
+    nas_acl_lock ();
+    try {
+        auto& table = nas_acl_get_switch (switch_id).get_table (table_id);
+
+        for (auto npu_id: table.npu_list ()) {
+            ndi_obj_id_t ndi_id = table.get_ndi_obj_id (npu_id);
+            count += ut_simulate_ndi_table_used (ndi_id);
+            if (ndi_ids != NULL) ndi_ids->push_back (ndi_id);
+        }
+    } catch (nas::base_exception& e) {
+    }
+    nas_acl_unlock ();
+    return count;
+}
+
+TEST (nas_acl_table, shadow_reload_test)
+{
+    bool rc;
+    nas_obj_id_t shadow_id = 0;
+    std::vector<ndi_obj_id_t> old_ndi_ids;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    nas_obj_id_t live_id = table.table_id;
+
+    do {
+        rc = (nas_acl_table_shadow_create (table.switch_id, live_id,
+                                           &shadow_id) == STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Populate the shadow generation through regular CPS requests
+        table.table_id = shadow_id;
+        rc = nas_acl_ut_entry_create_test (table);
+        table.table_id = live_id;
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Shadow entries stay out of hardware while it fills
+        size_t expected = 0;
+        npu_id_t first_npu = UT_RESET_NPU;
+        nas_acl_lock ();
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (table.switch_id);
+            for (const auto& entry_pair: s.entry_list (shadow_id)) {
+                expected += entry_pair.second.npu_list ().size ();
+            }
+            for (auto npu_id: s.get_table (shadow_id).npu_list ()) {
+                first_npu = npu_id;
+                break;
+            }
+        } catch (nas::base_exception& e) {
+        }
+        nas_acl_unlock ();
+        rc = (expected > 0 && first_npu != UT_RESET_NPU &&
+              _ut_ndi_entries (table.switch_id, shadow_id) == 0 &&
+              _ut_ndi_entries (table.switch_id, live_id, &old_ndi_ids) == 0 &&
+              !old_ndi_ids.empty ());
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Failed install leaves the shadow staged and out of hardware
+        ut_simulate_ndi_entry_create_error () = first_npu;
+        rc = (nas_acl_table_shadow_commit (table.switch_id, shadow_id) != STD_ERR_OK &&
+              _ut_ndi_entries (table.switch_id, shadow_id) == 0);
+        ut_simulate_ndi_entry_create_error () = UT_RESET_NPU;
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        rc = (nas_acl_table_shadow_commit (table.switch_id, shadow_id) == STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Live ID now maps to the filled NPU tables and the old ones are gone
+        std::vector<ndi_obj_id_t> new_ndi_ids;
+        rc = (_ut_ndi_entries (table.switch_id, live_id, &new_ndi_ids) == expected &&
+              new_ndi_ids != old_ndi_ids);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_lock ();
+        rc = (nas_acl_get_switch (table.switch_id).find_table (shadow_id) == nullptr);
+        nas_acl_unlock ();
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Shadow ID cannot be committed twice
+        rc = (nas_acl_table_shadow_commit (table.switch_id, shadow_id) != STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Entries are now live under the original Table ID
+        for (auto& entry_pair: table.entries) {
+            entry_pair.second.table_id = live_id;
+        }
+        rc = nas_acl_ut_entry_get_by_table_test (table);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+    } while (0);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (table);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
+TEST (nas_acl_table, fit_check_test)
+{
+    bool rc;
+    size_t free_cnt = 0;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+
+    nas_acl_lock ();
+    do {
+        rc = (nas_acl_table_fit_check (table.switch_id, table.table_id,
+                                       1, &free_cnt) == STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Shrinking pool is picked up before the request is rejected
+        ut_simulate_ndi_table_avail_count () = 2;
+        rc = (nas_acl_table_fit_check (table.switch_id, table.table_id,
+                                       UT_DEF_TABLE_AVAIL + 1, &free_cnt) != STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        rc = (free_cnt == 2);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        rc = (nas_acl_table_fit_check (table.switch_id, table.table_id,
+                                       2, &free_cnt) == STD_ERR_OK);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+    } while (0);
+    nas_acl_unlock ();
+
+    /* Cleanup */
+    ut_simulate_ndi_table_avail_count () = UT_DEF_TABLE_AVAIL;
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
 TEST (nas_acl_entry, create_test)
 {
     bool rc;
@@ -148,6 +314,481 @@ TEST (nas_acl_entry_get, get_bulk)
     ut_printf ("********** ACL Entry Get BULK Test PASSED **********\r\n");
 }
 
+// Ids of one GET of the table's Entries or Counters, limited to count objects
+// if set. With a cursor it is a get-next from that object of the table, which
+// may go on into later tables; *returned_p counts the objects of all tables.
+static bool _ut_get_page (BASE_ACL_OBJECTS_t obj_type, nas_obj_id_t table_id,
+                          size_t count, const nas_obj_id_t* cursor_id,
+                          std::vector<nas_obj_id_t>& ids, size_t* returned_p)
+{
+    nas_attr_id_t table_attr = (obj_type == BASE_ACL_ENTRY_OBJ) ?
+        BASE_ACL_ENTRY_TABLE_ID : BASE_ACL_COUNTER_TABLE_ID;
+    nas_attr_id_t id_attr = (obj_type == BASE_ACL_ENTRY_OBJ) ?
+        BASE_ACL_ENTRY_ID : BASE_ACL_COUNTER_ID;
+    cps_api_get_params_t params;
+    bool rc = true;
+
+    if (cps_api_get_request_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append (params.filters);
+    rc = (obj != NULL);
+    if (rc) {
+        cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_type,
+                                         cps_api_qualifier_TARGET);
+        cps_api_set_key_data (obj, table_attr, cps_api_object_ATTR_T_U64,
+                              &table_id, sizeof (uint64_t));
+        if (count != 0) {
+            cps_api_filter_set_count (obj, count);
+        }
+        if (cursor_id != NULL) {
+            cps_api_set_key_data (obj, id_attr, cps_api_object_ATTR_T_U64,
+                                  cursor_id, sizeof (uint64_t));
+            cps_api_filter_set_getnext (obj);
+        }
+        rc = (nas_acl_ut_cps_api_get (&params, 0) == cps_api_ret_code_OK);
+    }
+    *returned_p = 0;
+    for (size_t ix = 0; rc && ix < cps_api_object_list_size (params.list); ix++) {
+        nas_obj_id_t resp_table_id, id;
+        cps_api_object_t resp = cps_api_object_list_get (params.list, ix);
+
+        rc = nas_acl_cps_key_get_obj_id (resp, table_attr, &resp_table_id) &&
+             nas_acl_cps_key_get_obj_id (resp, id_attr, &id);
+        if (rc && resp_table_id == table_id) ids.push_back (id);
+        (*returned_p)++;
+    }
+    cps_api_get_request_close (&params);
+    return rc;
+}
+
+TEST (nas_acl_entry_get, get_paged)
+{
+    static const size_t limit = 2;
+    bool rc;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    if (!nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0])) {
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    for (auto obj_type: {BASE_ACL_ENTRY_OBJ, BASE_ACL_COUNTER_OBJ}) {
+        nas_obj_id_t table_id = g_nas_acl_ut_tables [0].table_id;
+        std::vector<nas_obj_id_t> all, paged;
+        size_t returned = 0, page_ids;
+
+        rc = _ut_get_page (obj_type, table_id, 0, NULL, all, &returned) &&
+             all.size () > limit;
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Pages of at most limit objects resume after the last one given,
+        // until a short page or one that went past the table
+        do {
+            page_ids = paged.size ();
+            rc = _ut_get_page (obj_type, table_id, limit,
+                               paged.empty () ? NULL : &paged.back (), paged, &returned) &&
+                 returned <= limit;
+            page_ids = paged.size () - page_ids;
+        } while (rc && returned == limit && page_ids == returned);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        rc = (paged == all);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Get-next needs the full key of the last object
+        {
+            cps_api_get_params_t params;
+
+            rc = (cps_api_get_request_init (&params) == cps_api_ret_code_OK);
+            NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+            cps_api_object_t obj = cps_api_object_list_create_obj_and_append (params.filters);
+            cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_type,
+                                             cps_api_qualifier_TARGET);
+            cps_api_filter_set_getnext (obj);
+            rc = (nas_acl_ut_cps_api_get (&params, 0) != cps_api_ret_code_OK);
+            cps_api_get_request_close (&params);
+            NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        }
+    }
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_counter_delete (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
+TEST (nas_acl_entry, batch_prepare_test)
+{
+    static const size_t min_creates = 128;      // Well above the parallel parse threshold
+    static const nas_obj_id_t id_step = 256;    // Copy IDs stay below the entry ID limit
+    bool rc;
+    size_t copies = 0, same = 0;
+    nas_acl_write_stats_t before, after;
+    cps_api_transaction_params_t params;
+    std::vector<std::pair<nas_obj_id_t, nas_obj_id_t>> copy_ids;   // Copy, original
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    if (!nas_acl_ut_entry_create_test (table) || table.entries.empty () ||
+        cps_api_transaction_init (&params) != cps_api_ret_code_OK) {
+        nas_acl_ut_entry_delete_test (table);
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    // Copies of the entries created one by one, all in one transaction
+    for (nas_obj_id_t round = 1; rc && copy_ids.size () < min_creates; round++) {
+        for (const auto& entry_pair: table.entries) {
+            const ut_entry_t& entry = entry_pair.second;
+            nas_obj_id_t copy_id = entry.entry_id + round * id_step;
+
+            cps_api_object_t obj = cps_api_object_create ();
+            cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_ENTRY_OBJ,
+                                             cps_api_qualifier_TARGET);
+            cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                                  &table.table_id, sizeof (uint64_t));
+            cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                                  &copy_id, sizeof (uint64_t));
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, entry.priority);
+            for (auto npu: entry.npu_list) {
+                cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_NPU_ID_LIST, npu);
+            }
+            rc = ut_fill_entry_match (obj, entry) && ut_fill_entry_action (obj, entry);
+            cps_api_create (&params, obj);
+            copy_ids.push_back ({copy_id, entry.entry_id});
+        }
+    }
+
+    nas_acl_entry_write_stats_get (&before);
+    rc = rc && (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+    nas_acl_entry_write_stats_get (&after);
+    cps_api_transaction_close (&params);
+
+    // Entries parsed ahead must come out the same as those parsed in the handler
+    nas_acl_lock ();
+    for (const auto& ids: copy_ids) {
+        auto copy_p = sw.find_entry (table.table_id, ids.first);
+        auto orig_p = sw.find_entry (table.table_id, ids.second);
+        if (copy_p == NULL) continue;
+        copies++;
+        if (orig_p != NULL && copy_p->is_same_rule (*orig_p)) same++;
+    }
+    nas_acl_unlock ();
+
+    /* Cleanup */
+    if (cps_api_transaction_init (&params) == cps_api_ret_code_OK) {
+        for (const auto& ids: copy_ids) {
+            cps_api_object_t obj = cps_api_object_create ();
+            cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_ENTRY_OBJ,
+                                             cps_api_qualifier_TARGET);
+            cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                                  &table.table_id, sizeof (uint64_t));
+            cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                                  &ids.first, sizeof (uint64_t));
+            cps_api_delete (&params, obj);
+        }
+        nas_acl_ut_cps_api_commit (&params, false);
+        cps_api_transaction_close (&params);
+    }
+    nas_acl_ut_entry_delete_test (table);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_EQ (copies, copy_ids.size ());
+    ASSERT_EQ (same, copies);
+    // UDF filters need the table and are left to the handler
+    ASSERT_TRUE (after.create_prepared > before.create_prepared);
+    ASSERT_TRUE (after.create_prepared - before.create_prepared <= copies);
+}
+
+// Entry sync object for a table. Without an entry it only marks the table.
+static void _ut_sync_add (cps_api_transaction_params_t* params, nas_obj_id_t table_id,
+                          const ut_entry_t* entry_p, bool with_id, uint32_t priority)
+{
+    cps_api_object_t obj = cps_api_object_create ();
+    cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_ENTRY_OBJ,
+                                     cps_api_qualifier_TARGET);
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table_id, sizeof (uint64_t));
+    if (entry_p != NULL) {
+        if (with_id) {
+            cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                                  &entry_p->entry_id, sizeof (uint64_t));
+        }
+        cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, priority);
+        for (auto npu: entry_p->npu_list) {
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_NPU_ID_LIST, npu);
+        }
+        ut_fill_entry_match (obj, *entry_p);
+        ut_fill_entry_action (obj, *entry_p);
+    }
+    cps_api_action (params, obj);
+}
+
+typedef std::map<nas_obj_id_t, nas_acl_entry> ut_entry_snapshot_t;
+
+static ut_entry_snapshot_t _ut_entry_snapshot (nas_obj_id_t table_id)
+{
+    ut_entry_snapshot_t snapshot;
+
+    nas_acl_lock ();
+    for (const auto& entry_pair:
+             nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID).entry_list (table_id)) {
+        snapshot.insert (entry_pair);
+    }
+    nas_acl_unlock ();
+
+    return snapshot;
+}
+
+static bool _ut_same_snapshot (const ut_entry_snapshot_t& a, const ut_entry_snapshot_t& b)
+{
+    if (a.size () != b.size ()) return false;
+
+    for (const auto& entry_pair: a) {
+        auto it = b.find (entry_pair.first);
+        if (it == b.end () || !entry_pair.second.is_same_rule (it->second)) return false;
+    }
+    return true;
+}
+
+TEST (nas_acl_entry, table_sync_test)
+{
+    bool rc;
+    size_t ndi_before;
+    nas_obj_id_t missing_id = 0xfff0;
+    ndi_obj_id_t redir_nh_id = 0x77;
+    nas_acl_write_stats_t before, after;
+    cps_api_transaction_params_t params;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    if (!nas_acl_ut_entry_create_test (table) || table.entries.size () < 3) {
+        nas_acl_ut_entry_delete_test (table);
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    // Desired set: first entry as is, second one with a new priority,
+    // a new entry with the rule of the first one, and no other entries
+    const ut_entry_t& keep = table.entries.begin ()->second;
+    const ut_entry_t& change = std::next (table.entries.begin ())->second;
+    auto fill_sync = [&] (cps_api_transaction_params_t* p) {
+        _ut_sync_add (p, table.table_id, &keep, true, keep.priority);
+        _ut_sync_add (p, table.table_id, &change, true, change.priority + 1);
+        _ut_sync_add (p, table.table_id, &keep, false, keep.priority + 1000);
+    };
+
+    ut_entry_snapshot_t orig = _ut_entry_snapshot (table.table_id);
+    ndi_before = _ut_ndi_entries (NAS_ACL_UT_DEF_SWITCH_ID, table.table_id);
+
+    // Sync followed by an object that fails - the rollback of the
+    // transaction must put back what the sync created, changed and deleted
+    rc = (cps_api_transaction_init (&params) == cps_api_ret_code_OK);
+    if (rc) {
+        fill_sync (&params);
+
+        cps_api_object_t obj = cps_api_object_create ();
+        cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_ENTRY_OBJ,
+                                         cps_api_qualifier_TARGET);
+        cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                              &table.table_id, sizeof (uint64_t));
+        cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                              &missing_id, sizeof (uint64_t));
+        cps_api_delete (&params, obj);
+
+        rc = (nas_acl_ut_cps_api_commit (&params, false) != cps_api_ret_code_OK);
+
+        // The UT commit does not roll back, undo what was written
+        for (size_t ix = 3; ix > 0; ix--) {
+            nas_acl_cps_api_rollback (NULL, &params, ix - 1);
+        }
+        cps_api_transaction_close (&params);
+    }
+    bool rolled_back = rc && _ut_same_snapshot (orig, _ut_entry_snapshot (table.table_id)) &&
+        _ut_ndi_entries (NAS_ACL_UT_DEF_SWITCH_ID, table.table_id) == ndi_before;
+
+    // Sync on its own goes through
+    rc = (cps_api_transaction_init (&params) == cps_api_ret_code_OK);
+    if (rc) {
+        fill_sync (&params);
+        rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+        cps_api_transaction_close (&params);
+    }
+
+    ut_entry_snapshot_t synced = _ut_entry_snapshot (table.table_id);
+    bool applied = rc && synced.size () == 3 &&
+        synced.count (keep.entry_id) == 1 &&
+        synced.at (keep.entry_id).is_same_rule (orig.at (keep.entry_id)) &&
+        synced.count (change.entry_id) == 1 &&
+        synced.at (change.entry_id).priority () == change.priority + 1;
+
+    // Same desired set again must not change anything
+    nas_acl_entry_write_stats_get (&before);
+    rc = (cps_api_transaction_init (&params) == cps_api_ret_code_OK);
+    if (rc) {
+        fill_sync (&params);
+        rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+        cps_api_transaction_close (&params);
+    }
+    nas_acl_entry_write_stats_get (&after);
+    bool converged = rc && _ut_same_snapshot (synced, _ut_entry_snapshot (table.table_id));
+
+    // A next-hop redirect created by the sync is found when the next hop goes away
+    ut_entry_t redir = keep;
+    nas_acl_ut_add_nh_redirect (redir, redir_nh_id);
+    rc = (cps_api_transaction_init (&params) == cps_api_ret_code_OK);
+    if (rc) {
+        fill_sync (&params);
+        _ut_sync_add (&params, table.table_id, &redir, false, keep.priority + 2000);
+        rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+        cps_api_transaction_close (&params);
+    }
+    nas_obj_id_t redir_id = 0;
+    for (const auto& entry_pair: _ut_entry_snapshot (table.table_id)) {
+        if (synced.count (entry_pair.first) == 0) redir_id = entry_pair.first;
+    }
+    bool redir_removed = false;
+    if (rc && redir_id != 0) {
+        nas_acl_lock ();
+        nas_acl_switch& s = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+        s.delete_pbr_action_by_nh_obj (redir_nh_id);
+        const nas_acl_entry* entry_p = s.find_entry (table.table_id, redir_id);
+        redir_removed = (entry_p != nullptr &&
+                         entry_p->get_action_list ().count (BASE_ACL_ACTION_TYPE_REDIRECT_IP_NEXTHOP) == 0);
+        nas_acl_unlock ();
+    }
+
+    /* Cleanup - sync to an empty set */
+    rc = (cps_api_transaction_init (&params) == cps_api_ret_code_OK);
+    if (rc) {
+        _ut_sync_add (&params, table.table_id, NULL, false, 0);
+        rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+        cps_api_transaction_close (&params);
+    }
+    bool emptied = rc && _ut_entry_snapshot (table.table_id).empty ();
+    table.entries.clear ();
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rolled_back);
+    ASSERT_TRUE (applied);
+    ASSERT_TRUE (converged);
+    ASSERT_EQ (after.create_count, before.create_count);
+    ASSERT_EQ (after.modify_count - before.modify_count, 3UL);
+    ASSERT_EQ (after.modify_elided - before.modify_elided, 3UL);
+    ASSERT_TRUE (redir_removed);
+    ASSERT_TRUE (emptied);
+}
+
+// Entry Create or Set with an explicit ID. Without the rule only the
+// priority is sent.
+static cps_api_object_t _ut_entry_write_obj (nas_obj_id_t table_id, const ut_entry_t& entry,
+                                             bool with_rule, uint32_t priority)
+{
+    cps_api_object_t obj = cps_api_object_create ();
+    cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_ENTRY_OBJ,
+                                     cps_api_qualifier_TARGET);
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table_id, sizeof (uint64_t));
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                          &entry.entry_id, sizeof (uint64_t));
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, priority);
+    if (with_rule) {
+        for (auto npu: entry.npu_list) {
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_NPU_ID_LIST, npu);
+        }
+        ut_fill_entry_match (obj, entry);
+        ut_fill_entry_action (obj, entry);
+    }
+    return obj;
+}
+
+TEST (nas_acl_entry, write_elide_test)
+{
+    bool rc;
+    bool elided = false, dup_rejected = false, modified = false;
+    nas_acl_write_stats_t before, mid, after;
+    cps_api_transaction_params_t params;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    if (!nas_acl_ut_entry_create_test (table) || table.entries.empty ()) {
+        nas_acl_ut_entry_delete_test (table);
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    const ut_entry_t& entry = table.entries.begin ()->second;
+    ut_entry_snapshot_t orig = _ut_entry_snapshot (table.table_id);
+
+    // Repeating the entry as a Create and as a Set must not reach NDI
+    nas_acl_entry_write_stats_get (&before);
+    const auto& npus = orig.at (entry.entry_id).npu_list ();
+    ut_simulate_ndi_entry_create_error () = npus.empty () ? UT_RESET_NPU : *npus.begin ();
+    if (cps_api_transaction_init (&params) == cps_api_ret_code_OK) {
+        cps_api_create (&params, _ut_entry_write_obj (table.table_id, entry, true,
+                                                      entry.priority));
+        cps_api_set (&params, _ut_entry_write_obj (table.table_id, entry, false,
+                                                   entry.priority));
+        elided = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK) &&
+            _ut_same_snapshot (orig, _ut_entry_snapshot (table.table_id));
+        cps_api_transaction_close (&params);
+    }
+    ut_simulate_ndi_entry_create_error () = UT_RESET_NPU;
+    nas_acl_entry_write_stats_get (&mid);
+
+    // A Create that differs from the existing entry is still refused
+    if (cps_api_transaction_init (&params) == cps_api_ret_code_OK) {
+        cps_api_create (&params, _ut_entry_write_obj (table.table_id, entry, true,
+                                                      entry.priority + 1));
+        dup_rejected = (nas_acl_ut_cps_api_commit (&params, false) != cps_api_ret_code_OK);
+        cps_api_transaction_close (&params);
+    }
+
+    // A Set that changes the priority goes through and keeps the rule
+    if (cps_api_transaction_init (&params) == cps_api_ret_code_OK) {
+        cps_api_set (&params, _ut_entry_write_obj (table.table_id, entry, false,
+                                                   entry.priority + 1));
+        if (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK) {
+            ut_entry_snapshot_t changed = _ut_entry_snapshot (table.table_id);
+            const nas_acl_entry& old_entry = orig.at (entry.entry_id);
+            const nas_acl_entry& new_entry = changed.at (entry.entry_id);
+            modified = new_entry.priority () == entry.priority + 1 &&
+                new_entry.is_same_filter_list (old_entry) &&
+                new_entry.is_same_action_list (old_entry);
+        }
+        cps_api_transaction_close (&params);
+    }
+    nas_acl_entry_write_stats_get (&after);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (table);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (elided);
+    ASSERT_EQ (mid.create_count - before.create_count, 1UL);
+    ASSERT_EQ (mid.create_elided - before.create_elided, 1UL);
+    ASSERT_EQ (mid.modify_count - before.modify_count, 1UL);
+    ASSERT_EQ (mid.modify_elided - before.modify_elided, 1UL);
+    ASSERT_TRUE (dup_rejected);
+    ASSERT_EQ (after.create_elided, mid.create_elided);
+    ASSERT_TRUE (modified);
+    ASSERT_EQ (after.modify_count - mid.modify_count, 1UL);
+    ASSERT_EQ (after.modify_elided, mid.modify_elided);
+}
+
 TEST (nas_acl_entry, stats_test)
 {
     bool rc;
@@ -177,6 +818,894 @@ TEST (nas_acl_entry, stats_test)
     ASSERT_TRUE (rc);
 }
 
+TEST (nas_acl_entry, stats_cache_test)
+{
+    bool rc;
+    nas_acl_stats_cache_info_t before, after;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    if (!nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0])) {
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    do {
+        rc = nas_acl_ut_entry_count_enable (g_nas_acl_ut_tables [0], true, false);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // By default GET reads hardware even right after a poll
+        nas_acl_stats_poll_now ();
+        nas_acl_stats_cache_info_get (&before);
+        rc = nas_acl_ut_stats_get_test (g_nas_acl_ut_tables [0]);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&after);
+        rc = (after.miss_count > before.miss_count);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // With a max age, freshly polled counts are served without reading hardware
+        nas_acl_stats_max_age_set (NAS_ACL_STATS_POLL_INTERVAL_MS);
+        nas_acl_stats_poll_now ();
+        nas_acl_stats_cache_info_get (&before);
+        rc = nas_acl_ut_stats_get_test (g_nas_acl_ut_tables [0]);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&after);
+        rc = (after.hit_count > before.hit_count &&
+              after.miss_count == before.miss_count);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Setting the count drops it from the cache
+        rc = nas_acl_ut_stats_set_test (g_nas_acl_ut_tables [0]);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&before);
+        rc = nas_acl_ut_stats_get_test (g_nas_acl_ut_tables [0]);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&after);
+        rc = (after.miss_count > before.miss_count);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Whole table is read back with bulk NDI requests
+        rc = nas_acl_ut_stats_set_test (g_nas_acl_ut_tables [0]);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&before);
+        nas_acl_lock ();
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (g_nas_acl_ut_tables [0].switch_id);
+            auto& table = s.get_table (g_nas_acl_ut_tables [0].table_id);
+            rc = (nas_acl_stats_table_refresh (table, NAS_ACL_STATS_MAX_AGE_MS)
+                  == STD_ERR_OK);
+        } catch (nas::base_exception& e) {
+            rc = false;
+        }
+        nas_acl_unlock ();
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&after);
+        rc = (after.bulk_read_count > before.bulk_read_count);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Two polls apart give the counter a rate
+        nas_acl_stats_poll_now ();
+        sleep (1);
+        nas_acl_stats_poll_now ();
+        nas_acl_lock ();
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (g_nas_acl_ut_tables [0].switch_id);
+            double bps = 0, pps = 0;
+
+            for (const auto& cnt_kvp: s.counter_list (g_nas_acl_ut_tables [0].table_id)) {
+                nas_acl_stats_rate_get (cnt_kvp.second, &bps, &pps);
+                rc = (bps > 0 || pps > 0);
+                if (!rc) break;
+            }
+        } catch (nas::base_exception& e) {
+            rc = false;
+        }
+        nas_acl_unlock ();
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+    } while (0);
+    nas_acl_stats_max_age_set (NAS_ACL_STATS_MAX_AGE_MS);
+
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_counter_delete (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
+// Poll as many times as the top-N window holds, a little apart
+static void _ut_stats_poll_window ()
+{
+    for (size_t ix = 0; ix <= NAS_ACL_STATS_TOP_WINDOW; ix++) {
+        usleep (10 * 1000);
+        nas_acl_stats_poll_now ();
+    }
+}
+
+// Rates of the top list, each no higher than the one before
+static bool _ut_stats_top_ordered (const std::vector<nas_acl_stats_top_t>& top,
+                                   bool by_bytes)
+{
+    for (size_t ix = 0; ix + 1 < top.size (); ix++) {
+        double rate = (by_bytes) ? top[ix].bps : top[ix].pps;
+        double next = (by_bytes) ? top[ix+1].bps : top[ix+1].pps;
+        if (rate < next) return false;
+    }
+    return true;
+}
+
+// Stats GET with the top-N attribute, returns the number of objects
+static bool _ut_stats_get_top (uint32_t count, bool by_bytes, size_t* returned_p)
+{
+    cps_api_get_params_t params;
+    bool rc;
+
+    if (cps_api_get_request_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append (params.filters);
+    rc = (obj != NULL);
+    if (rc) {
+        cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_STATS_OBJ,
+                                         cps_api_qualifier_TARGET);
+        cps_api_object_attr_add_u32 (obj, (by_bytes) ? NAS_ACL_STATS_TOP_BYTES_ATTR :
+                                     NAS_ACL_STATS_TOP_PKTS_ATTR, count);
+        rc = (nas_acl_ut_cps_api_get (&params, 0) == cps_api_ret_code_OK);
+    }
+    *returned_p = (rc) ? cps_api_object_list_size (params.list) : 0;
+    cps_api_get_request_close (&params);
+    return rc;
+}
+
+TEST (nas_acl_stats, top_test)
+{
+    bool   rc;
+    size_t counters = 0, returned = 0;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    if (!nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0])) {
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    do {
+        rc = nas_acl_ut_entry_count_enable (g_nas_acl_ut_tables [0], true, true);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        nas_acl_lock ();
+        try {
+            nas_acl_switch& s = nas_acl_get_switch (g_nas_acl_ut_tables [0].switch_id);
+            counters = s.counter_list (g_nas_acl_ut_tables [0].table_id).size ();
+        } catch (nas::base_exception& e) {
+        }
+        nas_acl_unlock ();
+        rc = (counters >= 2);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // A full window of moving counters, counters of earlier tests have left it
+        _ut_stats_poll_window ();
+
+        std::vector<nas_acl_stats_top_t> top;
+
+        // Every moving counter ranks, highest rate first
+        for (bool by_bytes: {false, true}) {
+            top.clear ();
+            rc = (nas_acl_stats_top_get (counters + 10, by_bytes, top) == STD_ERR_OK &&
+                  top.size () == counters && _ut_stats_top_ordered (top, by_bytes));
+            if (!rc) break;
+            for (const auto& t: top) {
+                rc = (t.pps > 0 && t.bps > 0 &&
+                      t.table_id == g_nas_acl_ut_tables [0].table_id);
+                if (!rc) break;
+            }
+            if (!rc) break;
+        }
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Rates differ by counter, so the order means something
+        rc = (top.front ().bps > top.back ().bps);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Capped at N, keeping the highest
+        std::vector<nas_acl_stats_top_t> top2;
+        rc = (nas_acl_stats_top_get (2, true, top2) == STD_ERR_OK &&
+              top2.size () == 2 && top2[0].bps == top[0].bps &&
+              top2[1].bps == top[1].bps);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Same through a CPS GET, by either rate
+        rc = _ut_stats_get_top (2, false, &returned) && returned == 2 &&
+             _ut_stats_get_top (2, true, &returned) && returned == 2;
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // Counters that stop moving leave once the window has passed
+        ut_simulate_ndi_counter_hold () = true;
+        _ut_stats_poll_window ();
+        top.clear ();
+        rc = (nas_acl_stats_top_get (counters + 10, false, top) == STD_ERR_OK &&
+              top.empty ());
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        rc = _ut_stats_get_top (2, false, &returned) && returned == 0;
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+    } while (0);
+    ut_simulate_ndi_counter_hold () = false;
+
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_counter_delete (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
+// Stats SET with the Table key only, optionally with a zero packet count
+static bool _ut_stats_table_set (nas_obj_id_t table_id, bool zero_pkt)
+{
+    cps_api_transaction_params_t params;
+
+    if (cps_api_transaction_init (&params) != cps_api_ret_code_OK) {
+        return false;
+    }
+
+    cps_api_object_t obj = cps_api_object_create ();
+    cps_api_key_from_attr_with_qual (cps_api_object_key (obj), BASE_ACL_STATS_OBJ,
+                                     cps_api_qualifier_TARGET);
+    cps_api_set_key_data (obj, BASE_ACL_STATS_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table_id, sizeof (uint64_t));
+    if (zero_pkt) {
+        cps_api_object_attr_add_u64 (obj, BASE_ACL_STATS_MATCHED_PACKETS, 0);
+    }
+    cps_api_set (&params, obj);
+
+    bool rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+    cps_api_transaction_close (&params);
+    return rc;
+}
+
+TEST (nas_acl_stats, soft_clear_test)
+{
+    bool rc;
+    nas_acl_stats_cache_info_t before, no_count, hw_cleared, cleared, deleted;
+    nas_acl_lat_summary_t hw_before, hw_after;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    if (!nas_acl_ut_entry_create_test (table)) {
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    do {
+        rc = nas_acl_ut_entry_count_enable (table, true, false);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&before);
+
+        // Table key without any count is not a clear
+        rc = !_ut_stats_table_set (table.table_id, false);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&no_count);
+
+        // Without software clear the counters are zeroed in hardware
+        nas_acl_lat_get (NAS_ACL_LAT_NDI_COUNTER_SET, &hw_before);
+        rc = _ut_stats_table_set (table.table_id, true);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_lat_get (NAS_ACL_LAT_NDI_COUNTER_SET, &hw_after);
+        nas_acl_stats_cache_info_get (&hw_cleared);
+
+        // Zero count given clears all counters of the table in software
+        nas_acl_stats_soft_clear_set (true);
+        rc = _ut_stats_table_set (table.table_id, true);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&cleared);
+
+        // Baselines go with the counters
+        rc = nas_acl_ut_entry_delete_test (table) && nas_acl_ut_counter_delete (table);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_stats_cache_info_get (&deleted);
+    } while (0);
+    nas_acl_stats_soft_clear_set (false);
+
+    /* Cleanup */
+    if (!rc) {
+        nas_acl_ut_entry_delete_test (table);
+        nas_acl_ut_counter_delete (table);
+    }
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_EQ (no_count.baselines, before.baselines);
+    ASSERT_EQ (hw_cleared.baselines, before.baselines);
+    ASSERT_TRUE (hw_after.count > hw_before.count);
+    ASSERT_TRUE (cleared.baselines > before.baselines);
+    ASSERT_EQ (deleted.baselines, before.baselines);
+}
+
+TEST (nas_acl_stats, poll_delta_test)
+{
+    bool rc;
+    size_t counters = 0, fail_counters = 0;
+    npu_id_t fail_npu = UT_RESET_NPU;
+    nas_acl_stats_cache_info_t ref, moved, failed, recovered;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    if (!nas_acl_ut_entry_create_test (table)) {
+        nas_acl_ut_table_delete ();
+        ASSERT_TRUE (false);
+    }
+
+    do {
+        rc = nas_acl_ut_entry_count_enable (table, true, true);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        nas_acl_lock ();
+        for (const auto& cnt_kvp: nas_acl_get_switch (table.switch_id).
+                                      counter_list (table.table_id)) {
+            const auto& npus = cnt_kvp.second.npu_list ();
+            if (fail_npu == UT_RESET_NPU && !npus.empty ()) {
+                fail_npu = *npus.begin ();
+            }
+            if (npus.find (fail_npu) != npus.end ()) fail_counters++;
+            counters++;
+        }
+        nas_acl_unlock ();
+        rc = (counters > 0 && fail_counters > 0);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+
+        // First poll sets the reference, the stub counts grow on each read
+        nas_acl_stats_poll_now ();
+        nas_acl_stats_cache_info_get (&ref);
+        nas_acl_stats_poll_now ();
+        nas_acl_stats_cache_info_get (&moved);
+
+        // Counters not read in full this time are left out
+        ut_simulate_ndi_counter_get_error () = fail_npu;
+        nas_acl_stats_poll_now ();
+        ut_simulate_ndi_counter_get_error () = UT_RESET_NPU;
+        nas_acl_stats_cache_info_get (&failed);
+
+        // and come back against the reference from before the failure
+        nas_acl_stats_poll_now ();
+        nas_acl_stats_cache_info_get (&recovered);
+    } while (0);
+    ut_simulate_ndi_counter_get_error () = UT_RESET_NPU;
+
+    nas_acl_ut_entry_delete_test (table);
+    nas_acl_ut_counter_delete (table);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_EQ (moved.delta_count - ref.delta_count, counters);
+    ASSERT_EQ (failed.delta_skipped - moved.delta_skipped, fail_counters);
+    ASSERT_EQ (failed.delta_count - moved.delta_count, counters - fail_counters);
+    ASSERT_EQ (recovered.delta_skipped, failed.delta_skipped);
+    ASSERT_EQ (recovered.delta_count - failed.delta_count, counters);
+}
+
+TEST (nas_acl_stats, shm_reader_test)
+{
+    const char* name = "/nas_acl_stats_ut";
+    const size_t count = 1000;
+    std::vector<nas_acl_stats_shm_rec_t> recs (count);
+    std::atomic<bool> reader_done {false};
+    bool reader_ok = false;
+
+    ASSERT_TRUE (nas_acl_stats_shm_open (name, count) == STD_ERR_OK);
+
+    // Not readable by others
+    struct stat st;
+    int fd = shm_open (name, O_RDONLY, 0);
+    bool private_mode = (fd >= 0 && fstat (fd, &st) == 0 && (st.st_mode & S_IRWXO) == 0);
+    if (fd >= 0) close (fd);
+
+    for (size_t i = 0; i < count; i++) {
+        recs[i] = {1, i + 1, 0, 0, 0};
+    }
+    nas_acl_stats_shm_publish (recs.data (), count, count, 0);
+
+    // Reader maps the region on its own and reads all counters with no
+    // CPS request. Every snapshot must come from a single update.
+    std::thread reader_thread ([&] {
+        std::vector<nas_acl_stats_shm_rec_t> out (count);
+        auto reader = nas_acl_stats_shm_reader_open (name);
+        bool ok = (reader != NULL);
+
+        for (int loop = 0; loop < 1000 && ok; loop++) {
+            if (nas_acl_stats_shm_reader_read (reader, out.data (), count, NULL)
+                != (int) count) {
+                ok = false;
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (out[i].counter_id != i + 1 ||
+                    out[i].pkt_count != out[0].pkt_count ||
+                    out[i].byte_count != out[i].pkt_count * 64) {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if (reader != NULL) nas_acl_stats_shm_reader_close (reader);
+        reader_ok = ok;
+        reader_done = true;
+    });
+
+    // Keep rewriting the counters while the reader runs
+    for (uint64_t gen = 1; !reader_done; gen++) {
+        for (auto& rec: recs) {
+            rec.pkt_count = gen;
+            rec.byte_count = gen * 64;
+            rec.timestamp_ms = gen;
+        }
+        nas_acl_stats_shm_publish (recs.data (), count, count, gen);
+    }
+    reader_thread.join ();
+
+    nas_acl_stats_shm_close ();
+
+    ASSERT_TRUE (private_mode);
+    ASSERT_TRUE (reader_ok);
+}
+
+TEST (nas_acl_latency, ndi_call_test)
+{
+    bool rc;
+    nas_acl_lat_summary_t before, after;
+
+    nas_acl_lat_get (NAS_ACL_LAT_NDI_ENTRY_CREATE, &before);
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    nas_acl_lat_get (NAS_ACL_LAT_NDI_ENTRY_CREATE, &after);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+    ASSERT_TRUE (after.count > before.count);
+    ASSERT_TRUE (after.p50_us <= after.p99_us);
+}
+
+TEST (nas_acl_latency, ndi_stub_injection_test)
+{
+    bool rc;
+    size_t free_cnt = 0;
+    nas_acl_lat_summary_t lat;
+
+    ut_simulate_ndi_call_profile (NAS_ACL_LAT_NDI_ENTRY_CREATE) =
+        {UT_NDI_DELAY_FIXED, 0, 2000, 0, 0, 0};
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+
+    do {
+        rc = nas_acl_ut_entry_create_test (table);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_lat_get (NAS_ACL_LAT_NDI_ENTRY_CREATE, &lat);
+        rc = (lat.max_us >= 2000);
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        nas_acl_ut_entry_delete_test (table);
+
+        // Capacity of the NDI table is reported as its free count
+        ut_simulate_ndi_table_capacity () = 5;
+        nas_acl_lock ();
+        rc = (nas_acl_table_fit_check (table.switch_id, table.table_id,
+                                       6, &free_cnt) != STD_ERR_OK);
+        nas_acl_unlock ();
+        NAS_ACL_UT_BREAK_ON_FAILURE (rc);
+        rc = (free_cnt == 5);
+    } while (0);
+
+    /* Cleanup */
+    ut_simulate_ndi_table_capacity () = 0;
+    ut_simulate_ndi_profile_reset ();
+    nas_acl_ut_table_delete ();
+
+    ASSERT_TRUE (rc);
+}
+
+TEST (nas_acl_lock, contention_stats_test)
+{
+    std::vector<nas_acl_lock_site_stats_t> stats;
+
+    nas_acl_lock_stats_clear ();
+
+    nas_acl_lock ();
+    nas_acl_unlock ();
+
+    nas_acl_lock_stats_get (stats);
+
+    // Taker is accounted under its own function name
+    bool found = false;
+    for (const auto& s: stats) {
+        if (s.lock == NAS_ACL_LOCK_ACL && s.count == 1 &&
+            strstr (s.site, "TestBody") != NULL) {
+            found = true;
+        }
+    }
+    ASSERT_TRUE (found);
+}
+
+TEST (nas_acl_trace, entry_lifecycle_test)
+{
+    bool rc;
+    const char* path = "/tmp/nas_acl_trace_ut.json";
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_trace_clear ();
+    nas_acl_trace_enable (true);
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    nas_acl_trace_enable (false);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_TRUE (nas_acl_trace_dump (path));
+
+    std::string json;
+    char buf [4096];
+    FILE* fp = fopen (path, "r");
+    ASSERT_TRUE (fp != NULL);
+    for (size_t n; (n = fread (buf, 1, sizeof (buf), fp)) > 0; ) {
+        json.append (buf, n);
+    }
+    fclose (fp);
+    unlink (path);
+
+    ASSERT_TRUE (json.find ("\"traceEvents\"") != std::string::npos);
+    ASSERT_TRUE (json.find ("\"Entry Commit\"") != std::string::npos);
+    ASSERT_TRUE (json.find ("\"NDI Entry Create\"") != std::string::npos);
+}
+
+TEST (nas_acl_mem, entry_footprint_test)
+{
+    bool rc;
+    nas_acl_mem_usage_t base [NAS_ACL_MEM_TYPE_MAX];
+    nas_acl_mem_usage_t loaded [NAS_ACL_MEM_TYPE_MAX];
+    nas_acl_mem_usage_t after [NAS_ACL_MEM_TYPE_MAX];
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_mem_usage_get (base);
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    nas_acl_mem_usage_get (loaded);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_mem_usage_get (after);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_TRUE (loaded [NAS_ACL_MEM_ENTRY].objs > base [NAS_ACL_MEM_ENTRY].objs);
+    ASSERT_TRUE (loaded [NAS_ACL_MEM_FILTER].bytes > base [NAS_ACL_MEM_FILTER].bytes);
+    ASSERT_TRUE (loaded [NAS_ACL_MEM_ACTION].bytes > base [NAS_ACL_MEM_ACTION].bytes);
+
+    // Nothing is left accounted once the entries are gone
+    ASSERT_EQ (after [NAS_ACL_MEM_ENTRY].objs, base [NAS_ACL_MEM_ENTRY].objs);
+    ASSERT_EQ (after [NAS_ACL_MEM_FILTER].objs, base [NAS_ACL_MEM_FILTER].objs);
+    ASSERT_EQ (after [NAS_ACL_MEM_ACTION].objs, base [NAS_ACL_MEM_ACTION].objs);
+}
+
+TEST (nas_acl_switch, invariant_check_test)
+{
+    bool rc;
+    std::vector<std::string> violations;
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    if (rc) {
+        nas_acl_lock ();
+        rc = (sw.check_invariants (violations) == 0);
+        nas_acl_unlock ();
+    }
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+
+    for (const auto& v: violations) {
+        ut_printf ("%s\r\n", v.c_str ());
+    }
+    ASSERT_TRUE (rc);
+
+    nas_acl_lock ();
+    rc = (sw.check_invariants (violations) == 0);
+    nas_acl_unlock ();
+    ASSERT_TRUE (rc);
+}
+
+// Replays the cached objects against the loaded snapshot, as a restart would
+static void _ut_warm_adopt_all (size_t& objs, size_t& adopted)
+{
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    nas_acl_lock ();
+    for (const auto& range_pair: sw.range_obj_list ()) {
+        const auto& range = range_pair.second;
+        for (auto npu_id: range.npu_list ()) {
+            ndi_obj_id_t ndi_obj_id = 0;
+            objs++;
+            if (nas_acl_warm_adopt (range, npu_id, ndi_obj_id) &&
+                ndi_obj_id == range.get_ndi_obj_id (npu_id)) {
+                adopted++;
+            }
+        }
+    }
+    for (const auto& tbl_pair: sw.table_list ()) {
+        const auto& table = tbl_pair.second;
+        for (auto npu_id: table.npu_list ()) {
+            ndi_obj_id_t ndi_obj_id = 0;
+            if (table.udf_group_list_count () > 0) continue;
+            objs++;
+            if (nas_acl_warm_adopt (table, npu_id, ndi_obj_id) &&
+                ndi_obj_id == table.get_ndi_obj_id (npu_id)) {
+                adopted++;
+            }
+        }
+        for (const auto& cntr_pair: sw.counter_list (table.table_id ())) {
+            const auto& counter = cntr_pair.second;
+            for (auto npu_id: counter.npu_list ()) {
+                ndi_obj_id_t ndi_obj_id = 0;
+                if (!counter.is_obj_in_npu (npu_id)) continue;
+                objs++;
+                if (nas_acl_warm_adopt (counter, npu_id, ndi_obj_id) &&
+                    ndi_obj_id == counter.ndi_obj_id (npu_id)) {
+                    adopted++;
+                }
+            }
+        }
+        for (const auto& entry_pair: sw.entry_list (table.table_id ())) {
+            const auto& entry = entry_pair.second;
+            for (const auto& ndi_pair: entry.ndi_entry_ids) {
+                ndi_obj_id_t ndi_obj_id = 0;
+                objs++;
+                if (nas_acl_warm_adopt (entry, ndi_pair.first, ndi_obj_id) &&
+                    ndi_obj_id == ndi_pair.second) {
+                    adopted++;
+                }
+            }
+        }
+    }
+    nas_acl_unlock ();
+}
+
+TEST (nas_acl_warm, snapshot_reconcile_test)
+{
+    static const char* path = "/tmp/nas_acl_ut_warm.snap";
+    bool rc;
+    size_t objs = 0, adopted = 0;
+    nas_acl_warm_info_t info;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    rc = rc && (nas_acl_warm_snapshot_save (path) == STD_ERR_OK);
+    rc = rc && (nas_acl_warm_snapshot_load (path) == STD_ERR_OK);
+
+    if (rc) {
+        // Replay of the same config adopts every object saved
+        _ut_warm_adopt_all (objs, adopted);
+    }
+    nas_acl_warm_info_get (&info);
+
+    // Nothing is stale, so nothing is deleted from the NPU
+    rc = rc && (nas_acl_warm_reconcile_end () == STD_ERR_OK);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_TRUE (info.reconciling);
+    ASSERT_TRUE (objs > 0);
+    ASSERT_EQ (adopted, objs);
+    ASSERT_EQ (info.adopted, adopted);
+    ASSERT_EQ (info.rejected, 0u);
+    ASSERT_TRUE (access (path, F_OK) != 0);
+
+    nas_acl_warm_info_get (&info);
+    ASSERT_FALSE (info.reconciling);
+    ASSERT_EQ (info.stale_deleted, 0u);
+}
+
+TEST (nas_acl_warm, snapshot_validate_test)
+{
+    static const char* path = "/tmp/nas_acl_ut_warm.snap";
+    bool rc;
+    size_t objs = 0, adopted = 0, lost_npu_entries = 0;
+    nas_acl_warm_info_t info, end_info;
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    nas_acl_ut_table_t& table = g_nas_acl_ut_tables [0];
+    rc = nas_acl_ut_entry_create_test (table);
+    rc = rc && (nas_acl_warm_snapshot_save (path) == STD_ERR_OK);
+
+    // NPU loses an entry while NAS is down. None of the entries of
+    // that table in that NPU can be trusted any more.
+    nas_acl_lock ();
+    for (const auto& entry_pair: sw.entry_list (table.table_id)) {
+        const auto& entry = entry_pair.second;
+        if (entry.ndi_entry_ids.empty ()) continue;
+
+        auto lost = *entry.ndi_entry_ids.begin ();
+        for (const auto& other_pair: sw.entry_list (table.table_id)) {
+            if (other_pair.second.ndi_entry_ids.count (lost.first) > 0) lost_npu_entries++;
+        }
+        ndi_acl_entry_delete (lost.first, lost.second);
+        break;
+    }
+    nas_acl_unlock ();
+
+    // Reconcile ends on its own once the replay is idle
+    nas_acl_warm_replay_timeout_set (200, 5000);
+    rc = rc && lost_npu_entries > 0 && (nas_acl_warm_snapshot_load (path) == STD_ERR_OK);
+    if (rc) {
+        _ut_warm_adopt_all (objs, adopted);
+    }
+    nas_acl_warm_info_get (&info);
+
+    for (int wait = 0; wait < 100 && nas_acl_warm_reconciling (); wait++) {
+        usleep (50 * 1000);
+    }
+    nas_acl_warm_info_get (&end_info);
+    nas_acl_warm_replay_timeout_set (NAS_ACL_WARM_REPLAY_IDLE_MS, NAS_ACL_WARM_REPLAY_MAX_MS);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (table);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_TRUE (info.reconciling);
+    ASSERT_EQ (info.rejected, lost_npu_entries);
+    ASSERT_EQ (adopted, objs - lost_npu_entries);
+
+    // Entries that were not adopted are removed from the NPU
+    ASSERT_FALSE (end_info.reconciling);
+    ASSERT_EQ (end_info.stale_deleted, lost_npu_entries);
+}
+
+TEST (nas_acl_audit, entry_drift_test)
+{
+    bool rc;
+    std::vector<nas_acl_audit_mismatch_t> clean, drift, held, repair, after;
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+    npu_id_t forgot_npu = 0;
+    ndi_obj_id_t forgot_ndi_id = 0;
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    rc = rc && (nas_acl_audit_run (NAS_ACL_AUDIT_REPORT, 4, &clean) == STD_ERR_OK);
+
+    // Make the cache forget one NPU of an entry
+    nas_acl_lock ();
+    for (const auto& entry_pair: sw.entry_list (g_nas_acl_ut_tables [0].table_id)) {
+        auto entry_p = sw.find_entry (entry_pair.second.table_id (), entry_pair.first);
+        if (!entry_p->ndi_entry_ids.empty ()) {
+            forgot_npu = entry_p->ndi_entry_ids.begin ()->first;
+            forgot_ndi_id = entry_p->ndi_entry_ids.begin ()->second;
+            entry_p->ndi_entry_ids.erase (entry_p->ndi_entry_ids.begin ());
+            break;
+        }
+    }
+    nas_acl_unlock ();
+
+    // The stub NPU still has the entry, so its count disagrees with the
+    // cache and repair must leave the entry alone
+    rc = rc && (nas_acl_audit_run (NAS_ACL_AUDIT_REPORT, 4, &drift) == STD_ERR_OK);
+    rc = rc && (nas_acl_audit_run (NAS_ACL_AUDIT_REPAIR, 4, &held) == STD_ERR_OK);
+
+    // Once the NPU really lost it too, the counts agree and repair recreates it
+    rc = rc && (ndi_acl_entry_delete (forgot_npu, forgot_ndi_id) == STD_ERR_OK);
+    rc = rc && (nas_acl_audit_run (NAS_ACL_AUDIT_REPAIR, 4, &repair) == STD_ERR_OK);
+    rc = rc && (nas_acl_audit_run (NAS_ACL_AUDIT_REPORT, 4, &after) == STD_ERR_OK);
+
+    /* Cleanup */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    auto count_type = [] (const std::vector<nas_acl_audit_mismatch_t>& list,
+                          nas_acl_audit_mismatch_type_t type, bool repaired) -> size_t {
+        size_t count = 0;
+        for (const auto& m: list) {
+            if (m.type == type && m.repaired == repaired) count++;
+        }
+        return count;
+    };
+
+    ASSERT_EQ (count_type (clean, NAS_ACL_AUDIT_ENTRY_MISSING, false), 0u);
+    ASSERT_EQ (count_type (drift, NAS_ACL_AUDIT_ENTRY_MISSING, false), 1u);
+    ASSERT_TRUE (count_type (drift, NAS_ACL_AUDIT_TABLE_COUNT, false) > 0);
+    ASSERT_EQ (count_type (held, NAS_ACL_AUDIT_ENTRY_MISSING, false), 1u);
+    ASSERT_EQ (count_type (held, NAS_ACL_AUDIT_ENTRY_MISSING, true), 0u);
+    ASSERT_EQ (count_type (repair, NAS_ACL_AUDIT_ENTRY_MISSING, true), 1u);
+    ASSERT_EQ (count_type (after, NAS_ACL_AUDIT_ENTRY_MISSING, false), 0u);
+
+    nas_acl_audit_info_t info;
+    nas_acl_audit_info_get (&info);
+    ASSERT_TRUE (info.entries_checked > 0);
+    ASSERT_TRUE (info.batches > 1);
+}
+
+TEST (nas_acl_policy, save_load_test)
+{
+    static const char* path = "/tmp/nas_acl_ut.policy";
+    bool rc;
+    size_t tables = 0, entries = 0, counters = 0;
+    size_t cleared = 0, restored_tables = 0, restored_entries = 0, restored_counters = 0;
+    nas_acl_policy_info_t info {};
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    auto count_objs = [&sw] (size_t& t, size_t& e, size_t& c) {
+        nas_acl_lock ();
+        t = sw.table_list ().size ();
+        e = c = 0;
+        for (const auto& tbl_pair: sw.table_list ()) {
+            e += sw.entry_list (tbl_pair.first).size ();
+            c += sw.counter_list (tbl_pair.first).size ();
+        }
+        nas_acl_unlock ();
+    };
+
+    rc = nas_acl_ut_table_create ();
+    ASSERT_TRUE (rc);
+
+    rc = nas_acl_ut_entry_create_test (g_nas_acl_ut_tables [0]);
+    count_objs (tables, entries, counters);
+    rc = rc && (nas_acl_policy_save (path) == STD_ERR_OK);
+
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+    nas_acl_lock ();
+    cleared = sw.table_list ().size ();
+    nas_acl_unlock ();
+
+    // Small batches so that the load spans several transactions
+    rc = rc && (nas_acl_policy_load (path, 4, &info) == STD_ERR_OK);
+    count_objs (restored_tables, restored_entries, restored_counters);
+    unlink (path);
+
+    /* Cleanup, the objects come back with the IDs they were saved with */
+    nas_acl_ut_entry_delete_test (g_nas_acl_ut_tables [0]);
+    nas_acl_ut_table_delete ();
+    ASSERT_TRUE (rc);
+
+    ASSERT_EQ (cleared, 0u);
+    ASSERT_TRUE (entries > 0);
+    ASSERT_EQ (restored_tables, tables);
+    ASSERT_EQ (restored_entries, entries);
+    ASSERT_EQ (restored_counters, counters);
+    ASSERT_EQ (info.loaded, info.objs);
+    ASSERT_TRUE (info.batches > 1);
+}
+
 TEST (nas_acl_entry, incr_modify_test)
 {
     bool rc;
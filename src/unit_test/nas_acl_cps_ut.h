@@ -131,6 +131,7 @@ bool nas_acl_ut_entry_incr_modify_test (nas_acl_ut_table_t& table);
 bool nas_acl_ut_entry_get_by_table_test (nas_acl_ut_table_t& table);
 bool nas_acl_ut_entry_get_by_switch_test (nas_switch_id_t switch_id);
 bool nas_acl_ut_entry_get_all_test ();
+bool ut_fill_entry_match (cps_api_object_t obj, const ut_entry_t& entry);
 bool ut_fill_entry_action (cps_api_object_t obj, const ut_entry_t& entry);
 
 void nas_acl_ut_init_tables ();
@@ -169,5 +170,6 @@ bool nas_acl_ut_route_dst_hit_entry_create(nas_acl_ut_table_t& table,
                                            int priority);
 bool nas_acl_ut_nh_redir_entry_create(nas_acl_ut_table_t& table,
                                       int priority);
+void nas_acl_ut_add_nh_redirect(ut_entry_t& entry, ndi_obj_id_t nh_id);
 bool nas_acl_ut_table_entry_delete(nas_acl_ut_table_t& table);
 bool nas_acl_ut_nh_redir_entry_delete(nas_acl_ut_table_t& table);
@@ -18,10 +18,13 @@
 #define _NAS_ACL_DB_UT_H_
 
 #include "nas_ndi_obj_id_table.h"
+#include "nas_acl_latency.h"
+#include <stddef.h>
 
 #define UT_RESET_NPU  100
 #define UT_RESET_FTYPE 100
 #define UT_RESET_ATYPE 100
+#define UT_DEF_TABLE_AVAIL 4096
 int& ut_simulate_ndi_entry_create_error ();
 int& ut_simulate_ndi_entry_delete_error();
 int& ut_simulate_ndi_entry_priority_error();
@@ -29,4 +32,40 @@ int& ut_simulate_ndi_entry_filter_error_npu();
 int& ut_simulate_ndi_entry_filter_error_ftype();
 int& ut_simulate_ndi_entry_action_error_npu();
 int& ut_simulate_ndi_entry_action_error_atype ();
+int& ut_simulate_ndi_counter_get_error ();
+bool& ut_simulate_ndi_counter_hold ();
+int& ut_simulate_ndi_table_avail_count ();
+
+/*
+ * Latency and failure injection of the NDI stub calls, indexed by the
+ * NAS_ACL_LAT_NDI_* ops. Defaults to instant and always successful.
+ */
+typedef enum {
+    UT_NDI_DELAY_NONE,
+    UT_NDI_DELAY_FIXED,         // median_us
+    UT_NDI_DELAY_UNIFORM,       // Between min_us and max_us
+    UT_NDI_DELAY_LOGNORMAL,     // Around median_us, clamped to min_us..max_us
+} ut_ndi_delay_t;
+
+typedef struct _ut_ndi_call_profile_t {
+    ut_ndi_delay_t  delay;
+    uint32_t        min_us;
+    uint32_t        median_us;
+    uint32_t        max_us;
+    double          sigma;          // Spread of the lognormal delay
+    double          fail_rate;      // Probability of an NPU failure, 0 to 1
+} ut_ndi_call_profile_t;
+
+ut_ndi_call_profile_t& ut_simulate_ndi_call_profile (nas_acl_lat_op_t op);
+void ut_simulate_ndi_sdk_profile ();   // Delays measured on a hardware SDK
+void ut_simulate_ndi_profile_reset ();
+void ut_simulate_ndi_seed (uint64_t seed);
+
+/*
+ * Entries each NDI table can hold, 0 for no limit. A full table fails
+ * entry create and reports its remaining room as available count.
+ */
+size_t& ut_simulate_ndi_table_capacity ();
+void ut_simulate_ndi_table_capacity_set (ndi_obj_id_t ndi_table_id, size_t capacity);
+size_t ut_simulate_ndi_table_used (ndi_obj_id_t ndi_table_id);
 #endif
@@ -0,0 +1,706 @@
+/*
+ * Copyright (c) 2018 Dell Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License. You may obtain
+ * a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ * CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ * LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ * FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ * See the Apache Version 2.0 License for specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * nas_acl_stress.cpp
+ *
+ * Concurrency stress of the NAS ACL CPS handlers against the NDI stub.
+ * Built and linked like the unit test, with this file in place of
+ * nas_acl_cps_ut.cpp.
+ *
+ *   nas_acl_stress [-d seconds] [-w writers] [-r readers] [-p pollers]
+ *                  [-i intf_threads] [-n slots] [-x intf_delete_pct]
+ *                  [-L] [-o file]
+ *
+ * Each writer owns a table and creates, modifies and deletes entries
+ * matching an input port in a fixed set of slots. Readers get entries and
+ * whole tables, pollers refresh and read the stats, interface threads
+ * replay port mapping changes and interface deletes, 5% of them deletes
+ * unless -x gives another share.
+ * A checker validates the switch invariants while the load runs. After
+ * the run all objects are drained and checked for leaked IDs and counter
+ * references. Results are JSON lines, the exit code is 2 on a violation.
+ */
+
+#include "nas_acl_cps_ut.h"
+#include "nas_acl_db_ut.h"
+#include "nas_acl_switch_list.h"
+#include "nas_acl_stats.h"
+#include "cps_api_object_key.h"
+#include "cps_class_map.h"
+#include "dell-base-if.h"
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#define NAS_ACL_STRESS_CHECK_INTERVAL_MS  100
+#define NAS_ACL_STRESS_MAX_REPORTED       20    // Violation messages kept
+#define NAS_ACL_STRESS_NUM_IFINDEX        (NAS_ACL_UT_MAX_NPUS * NAS_ACL_UT_NUM_PORTS_PER_NPU)
+
+typedef enum {
+    STRESS_ENTRY_CREATE,
+    STRESS_ENTRY_MODIFY,
+    STRESS_ENTRY_DELETE,
+    STRESS_ENTRY_GET,
+    STRESS_TABLE_GET,
+    STRESS_STATS_POLL,
+    STRESS_STATS_GET,
+    STRESS_INTF_MAP,
+    STRESS_INTF_DELETE,
+    STRESS_CHECK,
+    STRESS_CLASS_MAX,
+} nas_acl_stress_class_t;
+
+static const char* _stress_class_name [STRESS_CLASS_MAX] = {
+    "entry_create", "entry_modify", "entry_delete", "entry_get", "table_get",
+    "stats_poll", "stats_get", "intf_map", "intf_delete", "invariant_check",
+};
+
+typedef struct _nas_acl_stress_result_t {
+    uint64_t               ops [STRESS_CLASS_MAX] = {};
+    uint64_t               errors [STRESS_CLASS_MAX] = {};
+    std::vector<uint64_t>  samples [STRESS_CLASS_MAX];
+} nas_acl_stress_result_t;
+
+// Table owned by one writer. Slot entry IDs are cleared before the
+// entry delete is sent, so an ID seen by a reader exists until it changes.
+typedef struct _nas_acl_stress_table_t {
+    nas_obj_id_t                                  table_id = 0;
+    std::vector<nas_obj_id_t>                     counter_ids;
+    std::unique_ptr<std::atomic<nas_obj_id_t>[]>  entry_ids;
+    std::set<nas_obj_id_t>                        used_entry_ids;  // Writer only
+} nas_acl_stress_table_t;
+
+static size_t            _stress_slots = 256;
+static uint_t            _stress_intf_delete_pct = 5;
+static FILE*             _stress_out = stdout;
+static std::atomic<bool> _stress_stop {false};
+
+static std::vector<nas_acl_stress_table_t>  _stress_tables;
+
+static std::mutex                _stress_violation_mutex;
+static std::set<std::string>     _stress_violation_msgs;
+static uint64_t                  _stress_violations = 0;
+
+static inline uint64_t _stress_now_ns ()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+static void _stress_violation_add (const std::vector<std::string>& violations)
+{
+    std::lock_guard<std::mutex> l (_stress_violation_mutex);
+
+    _stress_violations += violations.size ();
+    for (const auto& v: violations) {
+        if (_stress_violation_msgs.size () >= NAS_ACL_STRESS_MAX_REPORTED) break;
+        _stress_violation_msgs.insert (v);
+    }
+}
+
+template <typename F>
+static bool _stress_timed (nas_acl_stress_result_t& res, nas_acl_stress_class_t cls, F fn)
+{
+    uint64_t start_ns = _stress_now_ns ();
+    bool rc = fn ();
+
+    res.ops [cls]++;
+    if (!rc) res.errors [cls]++;
+    res.samples [cls].push_back (_stress_now_ns () - start_ns);
+    return rc;
+}
+
+static bool _stress_commit (cps_api_object_t obj, cps_api_operation_types_t op,
+                            cps_api_attr_id_t key_attr = 0, nas_obj_id_t* key_id = NULL)
+{
+    cps_api_transaction_params_t params;
+
+    if (cps_api_transaction_init (&params) != cps_api_ret_code_OK) {
+        cps_api_object_delete (obj);
+        return false;
+    }
+
+    switch (op) {
+        case cps_api_oper_CREATE: cps_api_create (&params, obj); break;
+        case cps_api_oper_SET:    cps_api_set (&params, obj); break;
+        default:                  cps_api_delete (&params, obj); break;
+    }
+
+    bool rc = (nas_acl_ut_cps_api_commit (&params, false) == cps_api_ret_code_OK);
+
+    if (rc && key_id != NULL) {
+        auto attr = cps_api_get_key_data (obj, key_attr);
+        rc = (attr != NULL);
+        if (rc) *key_id = cps_api_object_attr_data_u64 (attr);
+    }
+
+    cps_api_transaction_close (&params);
+    return rc;
+}
+
+// Returns the number of objects read, -1 on failure
+static int _stress_get (cps_api_attr_id_t obj_attr,
+                        const std::vector<std::pair<cps_api_attr_id_t, nas_obj_id_t>>& keys)
+{
+    cps_api_get_params_t params;
+
+    if (cps_api_get_request_init (&params) != cps_api_ret_code_OK) {
+        return -1;
+    }
+
+    cps_api_object_t obj = cps_api_object_list_create_obj_and_append (params.filters);
+    cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_attr,
+                                     cps_api_qualifier_TARGET);
+    for (auto& key: keys) {
+        cps_api_set_key_data (obj, key.first, cps_api_object_ATTR_T_U64,
+                              &key.second, sizeof (uint64_t));
+    }
+
+    int count = -1;
+    if (nas_acl_ut_cps_api_get (&params, 0) == cps_api_ret_code_OK) {
+        count = cps_api_object_list_size (params.list);
+    }
+
+    cps_api_get_request_close (&params);
+    return count;
+}
+
+static cps_api_object_t _stress_obj_create (cps_api_attr_id_t obj_attr)
+{
+    cps_api_object_t obj = cps_api_object_create ();
+
+    if (obj != NULL) {
+        cps_api_key_from_attr_with_qual (cps_api_object_key (obj), obj_attr,
+                                         cps_api_qualifier_TARGET);
+    }
+    return obj;
+}
+
+// TCP to a port on one input port, counted. Input port drives the
+// interface binding of the entry.
+static bool _stress_fill_entry (cps_api_object_t obj, size_t slot, nas_obj_id_t counter_id,
+                                uint32_t ifindex, uint32_t priority)
+{
+    ut_entry_t entry {};
+    ut_filter_t filter;
+    ut_action_t action;
+
+    cps_api_object_attr_add_u32 (obj, BASE_ACL_ENTRY_PRIORITY, priority);
+
+    filter.type = BASE_ACL_MATCH_TYPE_IP_PROTOCOL;
+    filter.val_list = {6, 1, 0xff};
+    entry.filter_list.insert (filter);
+
+    filter.type = BASE_ACL_MATCH_TYPE_L4_DST_PORT;
+    filter.val_list = {slot % 0xffff, 1, 0xffff};
+    entry.filter_list.insert (filter);
+
+    action.type = BASE_ACL_ACTION_TYPE_PACKET_ACTION;
+    action.val_list = {(uint64_t) BASE_ACL_PACKET_ACTION_TYPE_DROP};
+    entry.action_list.insert (action);
+
+    action.type = BASE_ACL_ACTION_TYPE_SET_COUNTER;
+    action.val_list = {counter_id};
+    entry.action_list.insert (action);
+
+    if (!ut_fill_entry_match (obj, entry) || !ut_fill_entry_action (obj, entry)) {
+        return false;
+    }
+
+    cps_api_attr_id_t list_index = entry.filter_list.size ();
+    uint32_t match_type = BASE_ACL_MATCH_TYPE_IN_PORT;
+    cps_api_attr_id_t type_ids [] = {BASE_ACL_ENTRY_MATCH, list_index, BASE_ACL_ENTRY_MATCH_TYPE};
+    cps_api_attr_id_t val_ids [] = {BASE_ACL_ENTRY_MATCH, list_index,
+                                    BASE_ACL_ENTRY_MATCH_IN_PORT_VALUE};
+
+    return (cps_api_object_e_add (obj, type_ids, 3, cps_api_object_ATTR_T_U32,
+                                  &match_type, sizeof (uint32_t)) &&
+            cps_api_object_e_add (obj, val_ids, 3, cps_api_object_ATTR_T_U32,
+                                  &ifindex, sizeof (uint32_t)));
+}
+
+static cps_api_object_t _stress_entry_obj (const nas_acl_stress_table_t& table,
+                                           nas_obj_id_t entry_id)
+{
+    cps_api_object_t obj = _stress_obj_create (BASE_ACL_ENTRY_OBJ);
+    if (obj == NULL) return NULL;
+
+    cps_api_set_key_data (obj, BASE_ACL_ENTRY_TABLE_ID, cps_api_object_ATTR_T_U64,
+                          &table.table_id, sizeof (uint64_t));
+    if (entry_id != 0) {
+        cps_api_set_key_data (obj, BASE_ACL_ENTRY_ID, cps_api_object_ATTR_T_U64,
+                              &entry_id, sizeof (uint64_t));
+    }
+    return obj;
+}
+
+static bool _stress_entry_delete (nas_acl_stress_table_t& table, nas_obj_id_t entry_id)
+{
+    cps_api_object_t obj = _stress_entry_obj (table, entry_id);
+    if (obj == NULL) return false;
+
+    return _stress_commit (obj, cps_api_oper_DELETE);
+}
+
+static void _stress_writer (size_t w, nas_acl_stress_result_t& res)
+{
+    auto& table = _stress_tables [w];
+    std::mt19937_64 rng (w + 1);
+
+    while (!_stress_stop) {
+        size_t slot = rng () % _stress_slots;
+        uint32_t ifindex = 1 + (rng () % NAS_ACL_STRESS_NUM_IFINDEX);
+        uint32_t priority = 1 + (rng () % 1000);
+        nas_obj_id_t entry_id = table.entry_ids [slot];
+
+        if (entry_id == 0) {
+            _stress_timed (res, STRESS_ENTRY_CREATE, [&] () -> bool {
+                cps_api_object_t obj = _stress_entry_obj (table, 0);
+                if (obj == NULL) return false;
+                if (!_stress_fill_entry (obj, slot, table.counter_ids [slot], ifindex, priority)) {
+                    cps_api_object_delete (obj);
+                    return false;
+                }
+                nas_obj_id_t new_id = 0;
+                if (!_stress_commit (obj, cps_api_oper_CREATE, BASE_ACL_ENTRY_ID, &new_id)) {
+                    return false;
+                }
+                table.used_entry_ids.insert (new_id);
+                table.entry_ids [slot] = new_id;
+                return true;
+            });
+        } else if (rng () % 3 == 0) {
+            _stress_timed (res, STRESS_ENTRY_DELETE, [&] () -> bool {
+                table.entry_ids [slot] = 0;
+                if (!_stress_entry_delete (table, entry_id)) {
+                    table.entry_ids [slot] = entry_id;
+                    return false;
+                }
+                return true;
+            });
+        } else {
+            // Full filter list, moves the entry to another input port
+            _stress_timed (res, STRESS_ENTRY_MODIFY, [&] () -> bool {
+                cps_api_object_t obj = _stress_entry_obj (table, entry_id);
+                if (obj == NULL) return false;
+                if (!_stress_fill_entry (obj, slot, table.counter_ids [slot], ifindex, priority)) {
+                    cps_api_object_delete (obj);
+                    return false;
+                }
+                return _stress_commit (obj, cps_api_oper_SET);
+            });
+        }
+    }
+}
+
+static void _stress_reader (size_t r, nas_acl_stress_result_t& res)
+{
+    std::mt19937_64 rng (1000 + r);
+
+    for (uint64_t n = 0; !_stress_stop; n++) {
+        auto& table = _stress_tables [rng () % _stress_tables.size ()];
+
+        if (n % 16 == 0) {
+            _stress_timed (res, STRESS_TABLE_GET, [&] () -> bool {
+                return (_stress_get (BASE_ACL_ENTRY_OBJ,
+                                     {{BASE_ACL_ENTRY_TABLE_ID, table.table_id}}) >= 0);
+            });
+            continue;
+        }
+
+        size_t slot = rng () % _stress_slots;
+        nas_obj_id_t entry_id = table.entry_ids [slot];
+        if (entry_id == 0) continue;
+
+        _stress_timed (res, STRESS_ENTRY_GET, [&] () -> bool {
+            if (_stress_get (BASE_ACL_ENTRY_OBJ,
+                             {{BASE_ACL_ENTRY_TABLE_ID, table.table_id},
+                              {BASE_ACL_ENTRY_ID, entry_id}}) == 1) {
+                return true;
+            }
+            // Not a failure if the writer deleted it meanwhile
+            return (table.entry_ids [slot] != entry_id);
+        });
+    }
+}
+
+static void _stress_poller (size_t p, nas_acl_stress_result_t& res)
+{
+    std::mt19937_64 rng (2000 + p);
+
+    while (!_stress_stop) {
+        _stress_timed (res, STRESS_STATS_POLL, [] () -> bool {
+            nas_acl_stats_poll_now ();
+            return true;
+        });
+
+        for (int ix = 0; ix < 8 && !_stress_stop; ix++) {
+            auto& table = _stress_tables [rng () % _stress_tables.size ()];
+            nas_obj_id_t counter_id = table.counter_ids [rng () % _stress_slots];
+
+            _stress_timed (res, STRESS_STATS_GET, [&] () -> bool {
+                return (_stress_get (BASE_ACL_STATS_OBJ,
+                                     {{BASE_ACL_STATS_TABLE_ID, table.table_id},
+                                      {BASE_ACL_STATS_COUNTER_ID, counter_id}}) == 1);
+            });
+        }
+    }
+}
+
+/*
+ * Deletes go through the CPS interface event handler. The mapping change
+ * marker of a SET event is owned by the interface manager library, so
+ * mapping changes enter where the handler hands them on, with its locking.
+ */
+static void _stress_intf (size_t i, nas_acl_stress_result_t& res)
+{
+    std::mt19937_64 rng (3000 + i);
+
+    while (!_stress_stop) {
+        uint32_t ifindex = 1 + (rng () % NAS_ACL_STRESS_NUM_IFINDEX);
+
+        if (rng () % 100 < _stress_intf_delete_pct) {
+            _stress_timed (res, STRESS_INTF_DELETE, [&] () -> bool {
+                cps_api_object_t obj = cps_api_object_create ();
+                if (obj == NULL) return false;
+                cps_api_object_guard g (obj);
+
+                cps_api_key_from_attr_with_qual (cps_api_object_key (obj),
+                                                 DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_OBJ,
+                                                 cps_api_qualifier_OBSERVED);
+                cps_api_object_set_type_operation (cps_api_object_key (obj),
+                                                   cps_api_oper_DELETE);
+                cps_api_set_key_data (obj, DELL_BASE_IF_CMN_IF_INTERFACES_INTERFACE_IF_INDEX,
+                                      cps_api_object_ATTR_T_U32, &ifindex, sizeof (uint32_t));
+                return nas_acl_if_set_handler (obj, NULL);
+            });
+        } else {
+            _stress_timed (res, STRESS_INTF_MAP, [&] () -> bool {
+                npu_id_t npu = (ifindex - 1) / NAS_ACL_UT_NUM_PORTS_PER_NPU;
+                nas_acl_if_mapping_notify (ifindex, npu,
+                                           ifindex - (npu * NAS_ACL_UT_NUM_PORTS_PER_NPU));
+                return true;
+            });
+        }
+
+        // Interface events are far rarer than rule changes
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+}
+
+static bool _stress_check (void)
+{
+    std::vector<std::string> violations;
+
+    nas_acl_lock ();
+    try {
+        nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID).check_invariants (violations);
+    } catch (std::exception& e) {
+        violations.push_back (std::string {"Switch lookup failed: "} + e.what ());
+    }
+    nas_acl_unlock ();
+
+    _stress_violation_add (violations);
+    return violations.empty ();
+}
+
+static void _stress_checker (nas_acl_stress_result_t& res)
+{
+    while (!_stress_stop) {
+        _stress_timed (res, STRESS_CHECK, _stress_check);
+        std::this_thread::sleep_for (std::chrono::milliseconds (NAS_ACL_STRESS_CHECK_INTERVAL_MS));
+    }
+}
+
+static bool _stress_setup (size_t num_writers)
+{
+    _stress_tables.resize (num_writers);
+
+    for (size_t w = 0; w < num_writers; w++) {
+        auto& table = _stress_tables [w];
+
+        cps_api_object_t obj = _stress_obj_create (BASE_ACL_TABLE_OBJ);
+        if (obj == NULL) return false;
+
+        cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_STAGE, BASE_ACL_STAGE_INGRESS);
+        cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_PRIORITY, 600 + w);
+        for (auto f: {BASE_ACL_MATCH_TYPE_IP_PROTOCOL, BASE_ACL_MATCH_TYPE_L4_DST_PORT,
+                      BASE_ACL_MATCH_TYPE_IN_PORT}) {
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_ALLOWED_MATCH_FIELDS, f);
+        }
+        for (npu_id_t npu = 0; npu < NAS_ACL_UT_MAX_NPUS; npu++) {
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_TABLE_NPU_ID_LIST, npu);
+        }
+
+        if (!_stress_commit (obj, cps_api_oper_CREATE, BASE_ACL_TABLE_ID, &table.table_id)) {
+            fprintf (stderr, "Table create failed for writer %zu\n", w);
+            return false;
+        }
+
+        table.entry_ids.reset (new std::atomic<nas_obj_id_t> [_stress_slots]);
+        for (size_t slot = 0; slot < _stress_slots; slot++) {
+            table.entry_ids [slot] = 0;
+
+            obj = _stress_obj_create (BASE_ACL_COUNTER_OBJ);
+            if (obj == NULL) return false;
+
+            cps_api_set_key_data (obj, BASE_ACL_COUNTER_TABLE_ID, cps_api_object_ATTR_T_U64,
+                                  &table.table_id, sizeof (uint64_t));
+            cps_api_object_attr_add_u32 (obj, BASE_ACL_COUNTER_TYPES,
+                                         BASE_ACL_COUNTER_TYPE_PACKET);
+
+            nas_obj_id_t counter_id = 0;
+            if (!_stress_commit (obj, cps_api_oper_CREATE, BASE_ACL_COUNTER_ID, &counter_id)) {
+                fprintf (stderr, "Counter create failed for writer %zu\n", w);
+                return false;
+            }
+            table.counter_ids.push_back (counter_id);
+        }
+    }
+    return true;
+}
+
+typedef struct _nas_acl_stress_leaks_t {
+    uint64_t  entry_ids = 0;
+    uint64_t  table_ids = 0;
+    uint64_t  counter_refs = 0;
+    uint64_t  drain_errors = 0;
+} nas_acl_stress_leaks_t;
+
+// Delete everything the run created and look for what was left behind
+static void _stress_drain (nas_acl_stress_leaks_t& leaks)
+{
+    auto& sw = nas_acl_get_switch (NAS_ACL_UT_DEF_SWITCH_ID);
+
+    for (auto& table: _stress_tables) {
+        for (size_t slot = 0; slot < _stress_slots; slot++) {
+            nas_obj_id_t entry_id = table.entry_ids [slot];
+            if (entry_id == 0) continue;
+
+            if (!_stress_entry_delete (table, entry_id)) leaks.drain_errors++;
+            table.entry_ids [slot] = 0;
+        }
+
+        nas_acl_lock ();
+        try {
+            // Every ID handed out must be free again
+            for (auto entry_id: table.used_entry_ids) {
+                if (sw.reserve_entry_id_in_table (table.table_id, entry_id)) {
+                    sw.release_entry_id_in_table (table.table_id, entry_id);
+                } else {
+                    leaks.entry_ids++;
+                }
+            }
+            for (auto counter_id: table.counter_ids) {
+                auto counter_p = sw.find_counter (table.table_id, counter_id);
+                if (counter_p != nullptr && !counter_p->refs ().empty ()) {
+                    leaks.counter_refs += counter_p->refs ().size ();
+                }
+            }
+        } catch (std::exception& e) {
+            leaks.drain_errors++;
+        }
+        nas_acl_unlock ();
+
+        for (auto counter_id: table.counter_ids) {
+            cps_api_object_t obj = _stress_obj_create (BASE_ACL_COUNTER_OBJ);
+            if (obj == NULL) continue;
+
+            cps_api_set_key_data (obj, BASE_ACL_COUNTER_TABLE_ID, cps_api_object_ATTR_T_U64,
+                                  &table.table_id, sizeof (uint64_t));
+            cps_api_set_key_data (obj, BASE_ACL_COUNTER_ID, cps_api_object_ATTR_T_U64,
+                                  &counter_id, sizeof (uint64_t));
+            if (!_stress_commit (obj, cps_api_oper_DELETE)) leaks.drain_errors++;
+        }
+
+        cps_api_object_t obj = _stress_obj_create (BASE_ACL_TABLE_OBJ);
+        if (obj == NULL) continue;
+
+        cps_api_set_key_data (obj, BASE_ACL_TABLE_ID, cps_api_object_ATTR_T_U64,
+                              &table.table_id, sizeof (uint64_t));
+        if (!_stress_commit (obj, cps_api_oper_DELETE)) leaks.drain_errors++;
+    }
+
+    nas_acl_lock ();
+    for (auto& table: _stress_tables) {
+        try {
+            if (sw.reserve_table_id (table.table_id)) {
+                sw.release_table_id (table.table_id);
+            } else {
+                leaks.table_ids++;
+            }
+        } catch (std::exception& e) {
+            leaks.table_ids++;
+        }
+    }
+    nas_acl_unlock ();
+
+    // Bindings of the deleted entries must be gone as well
+    _stress_check ();
+}
+
+static uint64_t _stress_percentile (const std::vector<uint64_t>& sorted, uint_t pct)
+{
+    if (sorted.empty ()) return 0;
+
+    size_t rank = (sorted.size () * pct + 99) / 100;
+    return sorted [(rank > 0) ? rank - 1 : 0];
+}
+
+static void _stress_report (std::vector<nas_acl_stress_result_t>& results,
+                            double duration_s, const nas_acl_stress_leaks_t& leaks)
+{
+    for (int cls = 0; cls < STRESS_CLASS_MAX; cls++) {
+        std::vector<uint64_t> samples;
+        uint64_t ops = 0, errors = 0;
+
+        for (auto& res: results) {
+            ops += res.ops [cls];
+            errors += res.errors [cls];
+            samples.insert (samples.end (), res.samples [cls].begin (), res.samples [cls].end ());
+        }
+        if (ops == 0) continue;
+
+        std::sort (samples.begin (), samples.end ());
+
+        fprintf (_stress_out,
+                 "{\"stress\":\"nas_acl\",\"class\":\"%s\",\"ops\":%" PRIu64
+                 ",\"errors\":%" PRIu64 ",\"ops_per_sec\":%.1f,\"p50_us\":%.3f"
+                 ",\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}\n",
+                 _stress_class_name [cls], ops, errors, ops / duration_s,
+                 _stress_percentile (samples, 50) / 1e3,
+                 _stress_percentile (samples, 90) / 1e3,
+                 _stress_percentile (samples, 99) / 1e3,
+                 samples.back () / 1e3);
+    }
+
+    struct rusage usage {};
+    getrusage (RUSAGE_SELF, &usage);
+
+    fprintf (_stress_out,
+             "{\"stress\":\"nas_acl\",\"invariant_violations\":%" PRIu64
+             ",\"leaked_entry_ids\":%" PRIu64 ",\"leaked_table_ids\":%" PRIu64
+             ",\"stale_counter_refs\":%" PRIu64 ",\"drain_errors\":%" PRIu64
+             ",\"peak_rss_kb\":%ld}\n",
+             _stress_violations, leaks.entry_ids, leaks.table_ids,
+             leaks.counter_refs, leaks.drain_errors, usage.ru_maxrss);
+    fflush (_stress_out);
+
+    for (const auto& msg: _stress_violation_msgs) {
+        fprintf (stderr, "Violation: %s\n", msg.c_str ());
+    }
+}
+
+int main (int argc, char **argv)
+{
+    size_t duration_s = 10, writers = 2, readers = 2, pollers = 1, intfs = 1;
+    int opt;
+
+    while ((opt = getopt (argc, argv, "d:w:r:p:i:n:x:Lo:")) != -1) {
+        switch (opt) {
+            case 'd': duration_s = strtoul (optarg, NULL, 10); break;
+            case 'w': writers = strtoul (optarg, NULL, 10); break;
+            case 'r': readers = strtoul (optarg, NULL, 10); break;
+            case 'p': pollers = strtoul (optarg, NULL, 10); break;
+            case 'i': intfs = strtoul (optarg, NULL, 10); break;
+            case 'n': _stress_slots = strtoul (optarg, NULL, 10); break;
+            case 'x': _stress_intf_delete_pct = strtoul (optarg, NULL, 10); break;
+            case 'L': ut_simulate_ndi_sdk_profile (); break;
+            case 'o':
+                _stress_out = fopen (optarg, "w");
+                if (_stress_out == NULL) {
+                    fprintf (stderr, "Cannot open %s: %s\n", optarg, strerror (errno));
+                    return 1;
+                }
+                break;
+            default:
+                fprintf (stderr, "Usage: %s [-d seconds] [-w writers] [-r readers] "
+                         "[-p pollers] [-i intf_threads] [-n slots] [-x intf_delete_pct] "
+                         "[-L] [-o file]\n", argv [0]);
+                return 1;
+        }
+    }
+
+    if (writers == 0 || _stress_slots == 0 || duration_s == 0) {
+        fprintf (stderr, "Writers, slots and duration must be non zero\n");
+        return 1;
+    }
+
+    nas_acl_ut_env_init ();
+    ut_print_set_status (false);
+
+    if (!_stress_setup (writers)) {
+        return 1;
+    }
+
+    size_t num_threads = writers + readers + pollers + intfs + 1;
+    std::vector<nas_acl_stress_result_t> results (num_threads);
+    std::vector<std::thread> threads;
+    size_t ix = 0;
+
+    for (size_t w = 0; w < writers; w++, ix++) {
+        threads.emplace_back (_stress_writer, w, std::ref (results [ix]));
+    }
+    for (size_t r = 0; r < readers; r++, ix++) {
+        threads.emplace_back (_stress_reader, r, std::ref (results [ix]));
+    }
+    for (size_t p = 0; p < pollers; p++, ix++) {
+        threads.emplace_back (_stress_poller, p, std::ref (results [ix]));
+    }
+    for (size_t i = 0; i < intfs; i++, ix++) {
+        threads.emplace_back (_stress_intf, i, std::ref (results [ix]));
+    }
+    threads.emplace_back (_stress_checker, std::ref (results [ix]));
+
+    uint64_t start_ns = _stress_now_ns ();
+    std::this_thread::sleep_for (std::chrono::seconds (duration_s));
+    _stress_stop = true;
+
+    for (auto& t: threads) {
+        t.join ();
+    }
+    double elapsed_s = (_stress_now_ns () - start_ns) / 1e9;
+
+    _stress_check ();
+
+    nas_acl_stress_leaks_t leaks;
+    _stress_drain (leaks);
+
+    _stress_report (results, elapsed_s, leaks);
+
+    if (_stress_out != stdout) {
+        fclose (_stress_out);
+    }
+
+    bool failed = (_stress_violations > 0 || leaks.entry_ids > 0 || leaks.table_ids > 0 ||
+                   leaks.counter_refs > 0);
+    return (failed) ? 2 : 0;
+}
@@ -27,6 +27,15 @@
 #include <stdio.h>
 #include <netinet/in.h>
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
 
 int& ut_simulate_ndi_entry_create_error ()
 {
@@ -63,26 +72,206 @@ int& ut_simulate_ndi_entry_action_error_atype ()
     static int _ut_simulate_ndi_entry_action_error_atype = UT_RESET_ATYPE;
     return _ut_simulate_ndi_entry_action_error_atype;
 }
+// Not reset after one failure, a poll reads every counter of the NPU
+int& ut_simulate_ndi_counter_get_error ()
+{
+    static int _ut_simulate_ndi_counter_get_error = UT_RESET_NPU;
+    return _ut_simulate_ndi_counter_get_error;
+}
+// Counts stop moving while held
+bool& ut_simulate_ndi_counter_hold ()
+{
+    static bool _ut_simulate_ndi_counter_hold = false;
+    return _ut_simulate_ndi_counter_hold;
+}
+int& ut_simulate_ndi_table_avail_count ()
+{
+    static int _ut_simulate_ndi_table_avail_count = UT_DEF_TABLE_AVAIL;
+    return _ut_simulate_ndi_table_avail_count;
+}
+
+// Last slot takes the ops that are not NDI calls
+static ut_ndi_call_profile_t _ut_ndi_profiles [NAS_ACL_LAT_OP_MAX + 1];
+static std::atomic<uint64_t> _ut_ndi_seed {1};
+static std::atomic<uint64_t> _ut_ndi_seed_gen {1};
+static std::atomic<uint64_t> _ut_ndi_threads {0};
+
+ut_ndi_call_profile_t& ut_simulate_ndi_call_profile (nas_acl_lat_op_t op)
+{
+    if (op < NAS_ACL_LAT_NDI_TABLE_CREATE || op >= NAS_ACL_LAT_OP_MAX) {
+        return _ut_ndi_profiles [NAS_ACL_LAT_OP_MAX];
+    }
+    return _ut_ndi_profiles [op];
+}
+
+static void _ut_ndi_profile_set (nas_acl_lat_op_t op, uint32_t min_us,
+                                 uint32_t median_us, uint32_t max_us)
+{
+    auto& p = ut_simulate_ndi_call_profile (op);
+
+    p.delay = UT_NDI_DELAY_LOGNORMAL;
+    p.min_us = min_us;
+    p.median_us = median_us;
+    p.max_us = max_us;
+    p.sigma = 0.8;
+}
+
+void ut_simulate_ndi_sdk_profile ()
+{
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_TABLE_CREATE,        500, 2000, 20000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_TABLE_DELETE,        200, 1000, 10000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_TABLE_SET_PRIORITY,   50,  200,  2000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_CREATE,        100,  400,  5000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_DELETE,         50,  200,  2000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_SET_PRIORITY,   30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_SET_FILTER,     30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_DISABLE_FILTER, 30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_SET_ACTION,     30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_ENTRY_DISABLE_ACTION, 30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_COUNTER_CREATE,       50,  150,  1500);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_COUNTER_DELETE,       30,  100,  1000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_COUNTER_GET,          10,   30,   500);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_COUNTER_GET_BULK,     50,  200,  2000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_COUNTER_SET,          10,   30,   500);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_RANGE_CREATE,        100,  300,  3000);
+    _ut_ndi_profile_set (NAS_ACL_LAT_NDI_RANGE_DELETE,         50,  200,  2000);
+}
+
+void ut_simulate_ndi_profile_reset ()
+{
+    for (auto& p: _ut_ndi_profiles) {
+        p = ut_ndi_call_profile_t {};
+    }
+}
+
+void ut_simulate_ndi_seed (uint64_t seed)
+{
+    _ut_ndi_seed = seed;
+    _ut_ndi_seed_gen++;
+}
+
+// Each thread draws from its own generator, reseeded when the seed changes
+static std::mt19937_64& _ut_ndi_rng ()
+{
+    static thread_local std::mt19937_64 rng;
+    static thread_local uint64_t        seed_gen = 0;
+    static thread_local uint64_t        thread_ix = _ut_ndi_threads++;
+
+    if (seed_gen != _ut_ndi_seed_gen) {
+        seed_gen = _ut_ndi_seed_gen;
+        rng.seed (_ut_ndi_seed + thread_ix * 0x9e3779b97f4a7c15ULL);
+    }
+    return rng;
+}
+
+static uint64_t _ut_ndi_delay_us (const ut_ndi_call_profile_t& p)
+{
+    auto& rng = _ut_ndi_rng ();
+    double us = 0;
+
+    switch (p.delay) {
+        case UT_NDI_DELAY_FIXED:
+            return p.median_us;
+        case UT_NDI_DELAY_UNIFORM:
+            return std::uniform_int_distribution<uint32_t> (
+                    p.min_us, std::max (p.min_us, p.max_us)) (rng);
+        case UT_NDI_DELAY_LOGNORMAL:
+            us = std::lognormal_distribution<double> (
+                    std::log (std::max<uint32_t> (p.median_us, 1)), p.sigma) (rng);
+            us = std::max<double> (us, p.min_us);
+            if (p.max_us > 0) us = std::min<double> (us, p.max_us);
+            return (uint64_t) us;
+        default:
+            return 0;
+    }
+}
+
+// Delay the calling thread like the SDK would, then roll for a failure
+static t_std_error _ut_ndi_call (nas_acl_lat_op_t op)
+{
+    const auto& p = ut_simulate_ndi_call_profile (op);
+
+    if (p.delay == UT_NDI_DELAY_NONE && p.fail_rate <= 0) {
+        return STD_ERR_OK;
+    }
+
+    uint64_t delay_us = _ut_ndi_delay_us (p);
+    if (delay_us > 0) {
+        std::this_thread::sleep_for (std::chrono::microseconds (delay_us));
+    }
+
+    if (p.fail_rate > 0 &&
+        std::uniform_real_distribution<double> (0, 1) (_ut_ndi_rng ()) < p.fail_rate) {
+        ut_printf (" >>> Simulate %s NDI failure\r\n", nas_acl_lat_op_name (op));
+        return STD_ERR (NPU, FAIL, 0);
+    }
+    return STD_ERR_OK;
+}
+
+static std::mutex _ut_ndi_table_mutex;
+static std::unordered_map<ndi_obj_id_t, size_t>       _ut_ndi_table_capacity;
+static std::unordered_map<ndi_obj_id_t, size_t>       _ut_ndi_table_used;
+static std::unordered_map<ndi_obj_id_t, ndi_obj_id_t> _ut_ndi_entry_table;
+static std::unordered_set<ndi_obj_id_t>               _ut_ndi_tables;
+
+size_t& ut_simulate_ndi_table_capacity ()
+{
+    static size_t _ut_simulate_ndi_table_capacity = 0;
+    return _ut_simulate_ndi_table_capacity;
+}
+
+void ut_simulate_ndi_table_capacity_set (ndi_obj_id_t ndi_table_id, size_t capacity)
+{
+    std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+    _ut_ndi_table_capacity [ndi_table_id] = capacity;
+}
+
+static size_t _ut_ndi_table_capacity_get (ndi_obj_id_t ndi_table_id)
+{
+    auto it = _ut_ndi_table_capacity.find (ndi_table_id);
+    return (it != _ut_ndi_table_capacity.end ()) ? it->second
+                                                 : ut_simulate_ndi_table_capacity ();
+}
+
+size_t ut_simulate_ndi_table_used (ndi_obj_id_t ndi_table_id)
+{
+    std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+    auto it = _ut_ndi_table_used.find (ndi_table_id);
+    return (it != _ut_ndi_table_used.end ()) ? it->second : 0;
+}
 
 t_std_error ndi_acl_table_create (npu_id_t npu, const ndi_acl_table_t* t,
                                   ndi_obj_id_t* id)
 {
-    static int count = 0;
-    count ++;
+    static std::atomic<int> count {0};
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_TABLE_CREATE);
+    if (rc != STD_ERR_OK) return rc;
+    int table_id = ++count;
     ut_printf ("%s: npu %d, filter count %ld table prio %d returned id %d\n", __FUNCTION__,
-           npu, t->filter_count, t->priority, count);
-    *id = count;
+           npu, t->filter_count, t->priority, table_id);
+    *id = table_id;
+
+    std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+    _ut_ndi_tables.insert (table_id);
     return STD_ERR_OK;
 }
 t_std_error ndi_acl_table_delete (npu_id_t npu, ndi_obj_id_t id)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_TABLE_DELETE);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, table id %ld\n", __FUNCTION__, npu, id);
+
+    std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+    _ut_ndi_table_used.erase (id);
+    _ut_ndi_tables.erase (id);
     return STD_ERR_OK;
 }
 t_std_error ndi_acl_table_set_priority (npu_id_t npu,
                                         ndi_obj_id_t id,
                                         uint_t prio)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_TABLE_SET_PRIORITY);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, table id %ld prio %d\n", __FUNCTION__, npu, id, prio);
     if (npu == 4 && id == 12) {
         ut_printf (" >>> Simulate NDI Error\n");
@@ -94,16 +283,32 @@ t_std_error ndi_acl_table_set_priority (npu_id_t npu,
 t_std_error ndi_acl_entry_create (npu_id_t npu, const ndi_acl_entry_t* e,
                                   ndi_obj_id_t* id)
 {
-    static int count = 0;
-    count ++;
+    static std::atomic<int> count {0};
+    int entry_id = ++count;
     if (ut_simulate_ndi_entry_create_error() == npu) {
         ut_printf (" >>> Simulate Entry Create NDI failure for NPU %d\r\n", npu);
         ut_simulate_ndi_entry_create_error() = UT_RESET_NPU;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_CREATE);
+    if (rc != STD_ERR_OK) return rc;
+
+    {
+        std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+        size_t capacity = _ut_ndi_table_capacity_get (e->table_id);
+        size_t& used = _ut_ndi_table_used [e->table_id];
+        if (capacity > 0 && used >= capacity) {
+            ut_printf (" >>> Simulate table %ld full at %ld entries\r\n",
+                       e->table_id, capacity);
+            return STD_ERR (NPU, FAIL, 0);
+        }
+        used++;
+        _ut_ndi_entry_table [entry_id] = e->table_id;
+    }
+
     ut_printf ("%s: npu %d, filter count %ld entry prio %d return id %d\n", __FUNCTION__,
-            npu, e->filter_count, e->priority, count);
-    *id = count;
+            npu, e->filter_count, e->priority, entry_id);
+    *id = entry_id;
     return STD_ERR_OK;
 }
 
@@ -114,7 +319,17 @@ t_std_error ndi_acl_entry_delete (npu_id_t npu, ndi_obj_id_t id)
         ut_simulate_ndi_entry_delete_error() = UT_RESET_NPU;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_DELETE);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld\n", __FUNCTION__, npu, id);
+
+    std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+    auto it = _ut_ndi_entry_table.find (id);
+    if (it != _ut_ndi_entry_table.end ()) {
+        auto used = _ut_ndi_table_used.find (it->second);
+        if (used != _ut_ndi_table_used.end () && used->second > 0) used->second--;
+        _ut_ndi_entry_table.erase (it);
+    }
     return STD_ERR_OK;
 }
 t_std_error ndi_acl_entry_set_priority (npu_id_t npu,
@@ -126,6 +341,8 @@ t_std_error ndi_acl_entry_set_priority (npu_id_t npu,
         ut_simulate_ndi_entry_priority_error() = UT_RESET_NPU;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_SET_PRIORITY);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld prio %d\n", __FUNCTION__, npu, id, prio);
     return STD_ERR_OK;
 }
@@ -143,6 +360,8 @@ t_std_error ndi_acl_entry_set_filter (npu_id_t npu,
         ut_simulate_ndi_entry_filter_error_ftype() = 0;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_SET_FILTER);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld filter %s\n", __FUNCTION__, npu, id,
                nas_acl_filter_type_name (filter_p->filter_type));
 
@@ -166,6 +385,8 @@ t_std_error ndi_acl_entry_disable_filter (npu_id_t npu,
         ut_simulate_ndi_entry_filter_error_ftype() = 0;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_DISABLE_FILTER);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld filter %s\n", __FUNCTION__, npu, id,
                nas_acl_filter_type_name (filter_id));
     return STD_ERR_OK;
@@ -185,6 +406,8 @@ t_std_error ndi_acl_entry_set_action (npu_id_t npu_id,
         ut_simulate_ndi_entry_action_error_atype() = 0;
         return STD_ERR (NPU, FAIL, 0);
     }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_SET_ACTION);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld action %s\n", __FUNCTION__, npu_id, ndi_entry_id,
                nas_acl_action_type_name (action_p->action_type));
     return STD_ERR_OK;
@@ -212,6 +435,8 @@ t_std_error ndi_acl_entry_disable_action (npu_id_t npu_id,
                                           ndi_obj_id_t ndi_entry_id,
                                           BASE_ACL_ACTION_TYPE_t action_id)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_ENTRY_DISABLE_ACTION);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, entry id %ld action %s\n", __FUNCTION__, npu_id, ndi_entry_id,
                nas_acl_action_type_name (action_id));
     return STD_ERR_OK;
@@ -230,17 +455,21 @@ t_std_error ndi_acl_counter_create (npu_id_t npu_id,
                                     const ndi_acl_counter_t* ndi_counter_p,
                                     ndi_obj_id_t* ndi_counter_id_p)
 {
-    static size_t counter_count = 0;
+    static std::atomic<size_t> counter_count {0};
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_CREATE);
+    if (rc != STD_ERR_OK) return rc;
     *ndi_counter_id_p = ++counter_count;
     ut_printf ("%s: npu %d, pkt count %d byte count %d id %ld\n", __FUNCTION__,
             npu_id, ndi_counter_p->enable_pkt_count,
                     ndi_counter_p->enable_byte_count,
-                    counter_count);
+                    *ndi_counter_id_p);
     return STD_ERR_OK;
 }
 t_std_error ndi_acl_counter_delete (npu_id_t npu_id,
                                     ndi_obj_id_t ndi_counter_id)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_DELETE);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, id %ld\n", __FUNCTION__,
             npu_id, ndi_counter_id);
     return STD_ERR_OK;
@@ -272,9 +501,36 @@ t_std_error ndi_acl_counter_get_count (npu_id_t npu_id,
                                             uint64_t* pkt_count_p)
 {
     static uint64_t count = 0;
+    if (ut_simulate_ndi_counter_get_error () == npu_id) {
+        return STD_ERR (NPU, FAIL, 0);
+    }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_GET);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, id %ld\n", __FUNCTION__, npu_id, ndi_counter_id);
-    count += 2000;
-    *byte_count_p = count;
+    if (!ut_simulate_ndi_counter_hold ()) count += 2000;
+    if (byte_count_p) *byte_count_p = count;
+    if (pkt_count_p) *pkt_count_p = count / 100;
+    return STD_ERR_OK;
+}
+
+t_std_error ndi_acl_counter_get_count_bulk (npu_id_t npu_id, size_t count,
+                                            const ndi_obj_id_t* ndi_counter_ids,
+                                            uint64_t* byte_counts,
+                                            uint64_t* pkt_counts)
+{
+    static uint64_t count_base = 0;
+    if (ut_simulate_ndi_counter_get_error () == npu_id) {
+        return STD_ERR (NPU, FAIL, 0);
+    }
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_GET_BULK);
+    if (rc != STD_ERR_OK) return rc;
+    ut_printf ("%s: npu %d, %ld counters\n", __FUNCTION__, npu_id, count);
+    if (!ut_simulate_ndi_counter_hold ()) count_base += 2000;
+    // Counters with a higher id move faster
+    for (size_t i = 0; i < count; i++) {
+        byte_counts[i] = count_base * (1 + ndi_counter_ids[i] % 1024) + i;
+        pkt_counts[i] = byte_counts[i] / 100;
+    }
     return STD_ERR_OK;
 }
 
@@ -282,6 +538,8 @@ t_std_error ndi_acl_counter_set_pkt_count (npu_id_t npu_id,
                                            ndi_obj_id_t ndi_counter_id,
                                            uint64_t pkt_count)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_SET);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, id %ld val %ld\n", __FUNCTION__, npu_id,
             ndi_counter_id, pkt_count);
     return STD_ERR_OK;
@@ -290,6 +548,8 @@ t_std_error ndi_acl_counter_set_byte_count (npu_id_t npu_id,
                                             ndi_obj_id_t ndi_counter_id,
                                             uint64_t byte_count)
 {
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_COUNTER_SET);
+    if (rc != STD_ERR_OK) return rc;
     ut_printf ("%s: npu %d, id %ld val %ld\n", __FUNCTION__, npu_id,
             ndi_counter_id, byte_count);
     return STD_ERR_OK;
@@ -353,12 +613,16 @@ t_std_error ndi_udf_set_hash_mask(npu_id_t npu_id, ndi_obj_id_t udf_id,
 t_std_error ndi_acl_range_create(npu_id_t npu_id, const ndi_acl_range_t *acl_range_p,
                                  ndi_obj_id_t *ndi_range_id_p)
 {
+    static std::atomic<ndi_obj_id_t> range_count {0};
+    t_std_error rc = _ut_ndi_call (NAS_ACL_LAT_NDI_RANGE_CREATE);
+    if (rc != STD_ERR_OK) return rc;
+    *ndi_range_id_p = ++range_count;
     return STD_ERR_OK;
 }
 
 t_std_error ndi_acl_range_delete(npu_id_t npu_id, ndi_obj_id_t ndi_range_id)
 {
-    return STD_ERR_OK;
+    return _ut_ndi_call (NAS_ACL_LAT_NDI_RANGE_DELETE);
 }
 
 
@@ -412,5 +676,30 @@ t_std_error ndi_acl_get_slice_attribute (npu_id_t npu_id, ndi_obj_id_t slice_id,
 t_std_error ndi_acl_get_acl_table_attribute (npu_id_t npu_id, ndi_obj_id_t table_id,
                                              ndi_acl_table_attr_t *table_attr)
 {
+    // Single pipeline, sized by the simulated capacity when one is set
+    uint32_t used = 0;
+    uint32_t avail = ut_simulate_ndi_table_avail_count ();
+    {
+        std::lock_guard<std::mutex> l (_ut_ndi_table_mutex);
+        if (_ut_ndi_tables.count (table_id) == 0) {
+            return STD_ERR (NPU, FAIL, 0);
+        }
+        auto it = _ut_ndi_table_used.find (table_id);
+        used = (it != _ut_ndi_table_used.end ()) ? it->second : 0;
+
+        size_t capacity = _ut_ndi_table_capacity_get (table_id);
+        if (capacity > 0) {
+            avail = (capacity > used) ? capacity - used : 0;
+        }
+    }
+
+    if (table_attr->acl_table_used_entry_list_count > 0) {
+        table_attr->acl_table_used_entry_list[0] = used;
+        table_attr->acl_table_used_entry_list_count = 1;
+    }
+    if (table_attr->acl_table_avail_entry_list_count > 0) {
+        table_attr->acl_table_avail_entry_list[0] = avail;
+        table_attr->acl_table_avail_entry_list_count = 1;
+    }
     return STD_ERR_OK;
 }